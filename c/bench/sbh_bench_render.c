@@ -0,0 +1,557 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      End-to-end benchmarks for full renders. Fixed scenes are rendered     *
+ *      with each engine and tolerance at several resolutions, and compared   *
+ *      with a high accuracy reference, so integrator settings can be chosen  *
+ *      by speed and error together.                                          *
+ ******************************************************************************
+ *  Usage:                                                                    *
+ *      cc -O2 -march=native sbh_bench_render.c -o sbh_bench_render -lm \     *
+ *          -lpthread                                                         *
+ *      ./sbh_bench_render [max_width [threads]]                              *
+ *                                                                            *
+ *      The width doubles from 64 to max_width, default 128, and the height   *
+ *      is 9 / 16 of the width. threads defaults to one per processor.        *
+ ******************************************************************************
+ *  Scenes:                                                                   *
+ *      far:    An observer at r = 200M with a 9 degree field of view, the    *
+ *              shadow and photon ring fill the middle third of the image.    *
+ *      near:   An observer at r = 2.5M, inside the photon sphere, with a 90  *
+ *              degree field of view centered 45 degrees from the outward     *
+ *              direction. The edge of the escape cone crosses the image, and *
+ *              the rays that escape are strongly bent.                       *
+ *      disk:   An observer at r = 30M in the plane of a 6M to 20M disk, with *
+ *              a 60 degree field of view, the disk seen edge-on.             *
+ ******************************************************************************
+ *  Output:                                                                   *
+ *      One JSON object per line (JSON Lines), as in sbh_bench_vec4. The      *
+ *      first line describes the run, every other line is one render:         *
+ *                                                                            *
+ *          {"scene": name, "engine": name, "width": w, "height": h,          *
+ *           "seconds": t, "rays_per_sec": r, "steps_per_ray": s,             *
+ *           "heap_bytes": b, "max_rss_kb": k, "status_mismatch": m,          *
+ *           "direction_error_max": e, "direction_error_mean": a,             *
+ *           "direction_error_pixels": p, "disk_radius_error_max": d}         *
+ *                                                                            *
+ *      seconds is the fastest of several repetitions. heap_bytes counts the  *
+ *      buffers the render needs, the per-pixel results and any table, and    *
+ *      max_rss_kb is the peak resident size of the process so far, -1 where  *
+ *      getrusage is not available. The errors compare each pixel with the    *
+ *      reference render of the same scene and size. status_mismatch is the   *
+ *      fraction of pixels whose rays had a different fate. The direction     *
+ *      errors are the angles, in radians, between the final directions of    *
+ *      pixels that escaped in both, and direction_error_pixels is the        *
+ *      largest of them in units of the angular size of a pixel.              *
+ *      disk_radius_error_max is the largest difference, in M, between the    *
+ *      radii where pixels hit the disk in both.                              *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Every scene, ray, and setting is fixed, so two runs on one machine    *
+ *      give the same errors and step counts, and only the times change. The  *
+ *      reference is DP45 with a tolerance of 1E-12. Engines that ignore the  *
+ *      disk, planar and table, are not run on the disk scene, and the table  *
+ *      is not run inside the photon sphere, where it cannot be built.        *
+ *      float keeps the struct sbh_ray_fresult of each pixel, and its errors  *
+ *      are measured from the single precision directions and radii stored    *
+ *      there, to show the cost of single precision output.                   *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  clock_gettime is POSIX, request it before any system header.              */
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "../sbh_camera.h"
+#include "../sbh_engine.h"
+#include "../sbh_render.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define SBH_BENCH_HAS_RUSAGE 1
+#else
+#define SBH_BENCH_HAS_RUSAGE 0
+#endif
+
+/*  Number of timed repetitions per render, the fastest one is kept.          */
+#define SBH_BENCH_REPEATS (3)
+
+/*  A fixed scene, see the notes at the top of the file. The camera is at     *
+ *  phi = 0 with the z axis up, and view is the angle between the line of     *
+ *  sight and the direction to the black hole, turned towards +y.             */
+struct sbh_bench_scene {
+    const char *name;
+    double radius, theta, view, fov;
+    int disk;
+};
+
+static const struct sbh_bench_scene sbh_bench_scenes[] = {
+    {"far", 200.0, 1.4, 0.0, 0.15707963267948966, 0},
+    {"near", 2.5, 1.2, 2.356194490192345, 1.5707963267948966, 0},
+    {"disk", 30.0, 1.5707963267948966, 0.0, 1.0471975511965976, 1}
+};
+
+/*  An engine with its settings.                                              */
+struct sbh_bench_engine {
+    const char *name;
+    enum sbh_engine_type type;
+    enum sbh_geodesic_method method;
+
+    /*  The tolerance for DP45, the step for RK4 and the planar engine.       */
+    double setting;
+
+    /*  Non-zero to round the results through struct sbh_ray_fresult.         */
+    int single;
+};
+
+static const struct sbh_bench_engine sbh_bench_engines[] = {
+    {"dp45_1e-6", SBH_ENGINE_GEODESIC, SBH_GEODESIC_DP45, 1.0E-06, 0},
+    {"dp45_1e-8", SBH_ENGINE_GEODESIC, SBH_GEODESIC_DP45, 1.0E-08, 0},
+    {"dp45_1e-10", SBH_ENGINE_GEODESIC, SBH_GEODESIC_DP45, 1.0E-10, 0},
+    {"dp45_1e-8_float", SBH_ENGINE_GEODESIC, SBH_GEODESIC_DP45, 1.0E-08, 1},
+    {"rk4_0.1", SBH_ENGINE_GEODESIC, SBH_GEODESIC_RK4, 0.1, 0},
+    {"planar_0.01", SBH_ENGINE_PLANAR, SBH_GEODESIC_DP45, 0.01, 0},
+    {"planar_0.001", SBH_ENGINE_PLANAR, SBH_GEODESIC_DP45, 0.001, 0},
+    {"table", SBH_ENGINE_TABLE, SBH_GEODESIC_DP45, 0.0, 0},
+    {"analytic", SBH_ENGINE_ANALYTIC, SBH_GEODESIC_DP45, 0.0, 0}
+};
+
+/*  The state shared by the tiles of a render.                                */
+struct sbh_bench_frame {
+    const struct sbh_camera *camera;
+    const struct sbh_engine *engine;
+    int single;
+
+    /*  The result of each pixel, and the disk radius of pixels that hit it.  */
+    struct sbh_ray_result *results;
+    double *radii;
+
+    /*  The same in single precision, written only if single is set.          */
+    struct sbh_ray_fresult *fresults;
+    float *fradii;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_seconds                                                     *
+ *  Purpose:                                                                  *
+ *      Returns a monotonic wall clock time in seconds.                       *
+ ******************************************************************************/
+static double sbh_bench_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + 1.0E-09 * (double)now.tv_nsec;
+#else
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+/*  End of sbh_bench_seconds.                                                 */
+
+/*  Returns the peak resident size of the process in kB, or -1.               */
+static long sbh_bench_max_rss(void)
+{
+#if SBH_BENCH_HAS_RUSAGE
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1L;
+
+#if defined(__APPLE__)
+    return (long)(usage.ru_maxrss / 1024);
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#else
+    return -1L;
+#endif
+}
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_tile                                                        *
+ *  Purpose:                                                                  *
+ *      Traces the rays through the centers of the pixels of a tile.          *
+ ******************************************************************************/
+static void
+sbh_bench_tile(const struct sbh_render_tile *tile,
+               unsigned int thread,
+               void *data)
+{
+    const struct sbh_bench_frame *frame = (const struct sbh_bench_frame *)data;
+    const size_t width = frame->camera->width;
+    size_t i, j;
+
+    (void)thread;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t index = j * width + i;
+            const struct sbh_geodesic ray =
+                sbh_camera_ray(frame->camera, (double)i + 0.5, (double)j + 0.5);
+            struct sbh_disk_hit hit;
+            struct sbh_ray_result result;
+
+            hit.radius = 0.0;
+            result = sbh_engine_trace(frame->engine, &ray, &hit);
+
+            if (frame->single)
+            {
+                frame->fresults[index] = sbh_ray_result_to_float(&result);
+                frame->fradii[index] = (float)hit.radius;
+            }
+
+            frame->results[index] = result;
+            frame->radii[index] = hit.radius;
+        }
+    }
+}
+/*  End of sbh_bench_tile.                                                    */
+
+/*  Returns the angle between two unit vectors, accurate for small angles.    */
+static double
+sbh_bench_angle(const struct sbh_vec4 *p, const struct sbh_vec4 *q)
+{
+    const struct sbh_vec4 cross = sbh_vec4_spatial_cross(p, q);
+    const double sine = sqrt(sbh_vec4_spatial_dot(&cross, &cross));
+    return atan2(sine, sbh_vec4_spatial_dot(p, q));
+}
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_render                                                      *
+ *  Purpose:                                                                  *
+ *      Renders a frame, keeping the fastest time.                            *
+ ******************************************************************************/
+static int
+sbh_bench_render(const struct sbh_render_params *render,
+                 struct sbh_bench_frame *frame,
+                 int repeats,
+                 double *seconds)
+{
+    double best = -1.0;
+    int repeat;
+
+    for (repeat = 0; repeat < repeats; ++repeat)
+    {
+        const double start = sbh_bench_seconds();
+        double elapsed;
+
+        if (!sbh_render_frame(render, sbh_bench_tile, frame))
+            return 0;
+
+        elapsed = sbh_bench_seconds() - start;
+
+        if (best < 0.0 || elapsed < best)
+            best = elapsed;
+    }
+
+    *seconds = best;
+    return 1;
+}
+/*  End of sbh_bench_render.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_report                                                      *
+ *  Purpose:                                                                  *
+ *      Compares a render with the reference and prints the result.           *
+ ******************************************************************************/
+static void
+sbh_bench_report(const char *scene, const char *engine,
+                 const struct sbh_camera *camera, double fov,
+                 const struct sbh_bench_frame *frame,
+                 const struct sbh_bench_frame *reference,
+                 double seconds, size_t heap_bytes)
+{
+    const size_t pixels = camera->width * camera->height;
+    const double pixel_angle = fov / (double)camera->width;
+    double steps = 0.0, error_max = 0.0, error_sum = 0.0, radius_max = 0.0;
+    size_t n, mismatch = 0, escaped = 0;
+
+    for (n = 0; n < pixels; ++n)
+    {
+        const struct sbh_ray_result *a = frame->results + n;
+        const struct sbh_ray_result *b = reference->results + n;
+
+        steps += (double)a->steps;
+
+        if (a->status != b->status)
+            ++mismatch;
+
+        else if (a->status == SBH_RAY_ESCAPED)
+        {
+            struct sbh_vec4 direction = a->direction;
+            double error;
+            int k;
+
+            /*  Measure what single precision output stores, not the doubles. */
+            if (frame->single)
+            {
+                const struct sbh_fvec4 *rounded = &frame->fresults[n].direction;
+
+                for (k = 0; k < 4; ++k)
+                    direction.dat[k] = (double)rounded->dat[k];
+            }
+
+            error = sbh_bench_angle(&direction, &b->direction);
+            ++escaped;
+            error_sum += error;
+
+            if (error > error_max)
+                error_max = error;
+        }
+
+        else if (a->status == SBH_RAY_DISK)
+        {
+            const double radius =
+                (frame->single ? (double)frame->fradii[n] : frame->radii[n]);
+            const double error = fabs(radius - reference->radii[n]);
+
+            if (error > radius_max)
+                radius_max = error;
+        }
+    }
+
+    printf("{\"scene\": \"%s\", \"engine\": \"%s\", \"width\": %lu, "
+           "\"height\": %lu, \"seconds\": %.6f, \"rays_per_sec\": %.6e, "
+           "\"steps_per_ray\": %.2f, \"heap_bytes\": %lu, "
+           "\"max_rss_kb\": %ld, \"status_mismatch\": %.6e, "
+           "\"direction_error_max\": %.6e, \"direction_error_mean\": %.6e, "
+           "\"direction_error_pixels\": %.6e, "
+           "\"disk_radius_error_max\": %.6e}\n",
+           scene, engine, (unsigned long)camera->width,
+           (unsigned long)camera->height, seconds,
+           (double)pixels / seconds, steps / (double)pixels,
+           (unsigned long)heap_bytes, sbh_bench_max_rss(),
+           (double)mismatch / (double)pixels, error_max,
+           (escaped ? error_sum / (double)escaped : 0.0),
+           error_max / pixel_angle, radius_max);
+    fflush(stdout);
+}
+/*  End of sbh_bench_report.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_engine_setup                                                *
+ *  Purpose:                                                                  *
+ *      Creates an engine for a scene, building its table if it has one.      *
+ *  Outputs:                                                                  *
+ *      use (int):                                                            *
+ *          1 if the engine runs on the scene, 0 if it is skipped.            *
+ ******************************************************************************/
+static int
+sbh_bench_engine_setup(const struct sbh_bench_engine *entry,
+                       const struct sbh_bench_scene *scene,
+                       const struct sbh_disk *disk,
+                       struct sbh_engine *engine,
+                       struct sbh_deflection_table *table,
+                       size_t *table_bytes)
+{
+    *engine = sbh_engine_create(entry->type, 1.0);
+    engine->disk = (scene->disk ? disk : NULL);
+    *table_bytes = 0;
+
+    if (scene->disk && (entry->type == SBH_ENGINE_PLANAR ||
+                        entry->type == SBH_ENGINE_TABLE))
+        return 0;
+
+    switch (entry->type)
+    {
+        case SBH_ENGINE_GEODESIC:
+            engine->geodesic.method = entry->method;
+
+            if (entry->method == SBH_GEODESIC_RK4)
+                engine->geodesic.step = entry->setting;
+            else
+                engine->geodesic.tolerance = entry->setting;
+
+            return 1;
+
+        case SBH_ENGINE_PLANAR:
+            engine->planar.step = entry->setting;
+            engine->planar.max_steps = 1000000UL;
+            return 1;
+
+        case SBH_ENGINE_TABLE:
+        {
+            const struct sbh_deflection_table_params params =
+                sbh_deflection_table_default_params(1.0, scene->radius);
+
+            if (!sbh_deflection_table_init(table, &params))
+                return 0;
+
+            engine->table = table;
+            *table_bytes = 2 * sizeof(*table->psi) * table->size;
+            return 1;
+        }
+
+        default:
+            return 1;
+    }
+}
+/*  End of sbh_bench_engine_setup.                                            */
+
+int main(int argc, char **argv)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t scenes = sizeof(sbh_bench_scenes) /
+                          sizeof(sbh_bench_scenes[0]);
+    const size_t engines = sizeof(sbh_bench_engines) /
+                           sizeof(sbh_bench_engines[0]);
+    const struct sbh_disk disk = sbh_disk_default(1.0);
+    const struct sbh_vec4 up = sbh_vec4_rect(0.0, 0.0, 1.0, 0.0);
+    struct sbh_bench_frame frame, reference;
+    size_t max_width = 128, width, s, e;
+    unsigned int threads = 0U;
+
+    if (argc > 1)
+        max_width = (size_t)strtoul(argv[1], NULL, 10);
+
+    if (argc > 2)
+        threads = (unsigned int)strtoul(argv[2], NULL, 10);
+
+    if (max_width < 64)
+        max_width = 64;
+
+    printf("{\"suite\": \"sbh_bench_render\", \"threads\": %u, "
+           "\"repeats\": %d, \"reference\": \"dp45_1e-12\"}\n",
+           (threads ? threads : sbh_render_hardware_threads()),
+           SBH_BENCH_REPEATS);
+
+    for (s = 0; s < scenes; ++s)
+    {
+        const struct sbh_bench_scene *scene = sbh_bench_scenes + s;
+        const struct sbh_vec4 position =
+            sbh_vec4_rect(scene->radius, 0.0, scene->theta, 0.0);
+        const double x = sin(scene->theta), z = cos(scene->theta);
+        const double inward = scene->radius - cos(scene->view);
+        const struct sbh_vec4 target =
+            sbh_vec4_rect(inward * x, sin(scene->view), inward * z, 0.0);
+
+        for (width = 64; width <= max_width; width *= 2)
+        {
+            const size_t height = width * 9 / 16;
+            const size_t pixels = width * height;
+            const size_t bytes = (sizeof(*frame.results) +
+                                  sizeof(*frame.radii)) * pixels;
+            const size_t fbytes = (sizeof(*frame.fresults) +
+                                   sizeof(*frame.fradii)) * pixels;
+            struct sbh_render_params render =
+                sbh_render_default_params(width, height);
+            struct sbh_engine engine;
+            struct sbh_camera camera;
+            double seconds;
+
+            render.threads = threads;
+
+            if (!sbh_camera_init(&camera, 1.0, &position, &target, &up,
+                                 scene->fov, width, height))
+            {
+                fputs("sbh_bench_render: invalid camera\n", stderr);
+                return EXIT_FAILURE;
+            }
+
+            frame.camera = reference.camera = &camera;
+            frame.single = reference.single = 0;
+            frame.results = (struct sbh_ray_result *)malloc(bytes);
+            reference.results = (struct sbh_ray_result *)malloc(bytes);
+            frame.fresults = (struct sbh_ray_fresult *)malloc(fbytes);
+            frame.radii = (double *)(frame.results + pixels);
+            reference.radii = (double *)(reference.results + pixels);
+            frame.fradii = (float *)(frame.fresults + pixels);
+            reference.fresults = NULL;
+            reference.fradii = NULL;
+
+            if (!frame.results || !reference.results || !frame.fresults)
+            {
+                fputs("sbh_bench_render: out of memory\n", stderr);
+                return EXIT_FAILURE;
+            }
+
+            /*  The reference, timed once. It is its own baseline.            */
+            engine = sbh_engine_create(SBH_ENGINE_GEODESIC, 1.0);
+            engine.geodesic.tolerance = 1.0E-12;
+            engine.geodesic.min_step = 1.0E-14;
+            engine.geodesic.max_steps = 10000000UL;
+            engine.disk = (scene->disk ? &disk : NULL);
+            reference.engine = &engine;
+
+            if (!sbh_bench_render(&render, &reference, 1, &seconds))
+            {
+                fputs("sbh_bench_render: render failed\n", stderr);
+                return EXIT_FAILURE;
+            }
+
+            sbh_bench_report(scene->name, "reference", &camera, scene->fov,
+                             &reference, &reference, seconds, bytes);
+
+            for (e = 0; e < engines; ++e)
+            {
+                const struct sbh_bench_engine *entry = sbh_bench_engines + e;
+                struct sbh_deflection_table table;
+                size_t table_bytes;
+                int success;
+
+                table.psi = table.direction = NULL;
+
+                if (!sbh_bench_engine_setup(entry, scene, &disk, &engine,
+                                            &table, &table_bytes))
+                    continue;
+
+                frame.engine = &engine;
+                frame.single = entry->single;
+                success = sbh_bench_render(&render, &frame,
+                                           SBH_BENCH_REPEATS, &seconds);
+
+                if (success)
+                    sbh_bench_report(scene->name, entry->name, &camera,
+                                     scene->fov, &frame, &reference, seconds,
+                                     bytes + table_bytes +
+                                     (entry->single ? fbytes : 0));
+
+                sbh_deflection_table_destroy(&table);
+
+                if (!success)
+                {
+                    fputs("sbh_bench_render: render failed\n", stderr);
+                    return EXIT_FAILURE;
+                }
+            }
+
+            free(frame.results);
+            free(frame.fresults);
+            free(reference.results);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
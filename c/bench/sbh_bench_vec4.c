@@ -0,0 +1,418 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Micro-benchmarks for the vec4 constructors and coordinate             *
+ *      conversions, scalar and batched, from L1 sized to DRAM sized inputs.  *
+ ******************************************************************************
+ *  Usage:                                                                    *
+ *      cc -O2 -march=native sbh_bench_vec4.c -o sbh_bench_vec4 -lm           *
+ *      ./sbh_bench_vec4 [max_points]                                         *
+ *                                                                            *
+ *      The number of points goes up by factors of 4 from 256 (8 kB for each  *
+ *      array of struct sbh_vec4) to max_points, default 4194304 (128 MB).    *
+ ******************************************************************************
+ *  Output:                                                                   *
+ *      One JSON object per line (JSON Lines), so results can be diffed or    *
+ *      loaded directly between releases. The first line describes the run,   *
+ *      every other line is one measurement:                                  *
+ *                                                                            *
+ *          {"benchmark": name, "points": n, "bytes": working set,            *
+ *           "ns_per_op": t, "ops_per_sec": r}                                *
+ *                                                                            *
+ *      One op is one point. Each measurement is the fastest of several       *
+ *      repetitions, each of which processes at least 2^20 points.            *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  clock_gettime is POSIX, request it before any system header.              */
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "../sbh_vec4.h"
+#include "../sbh_vec4_array.h"
+#include "../sbh_sincos.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*  Number of timed repetitions per measurement, the fastest one is kept.     */
+#define SBH_BENCH_REPEATS (5)
+
+/*  Each repetition processes at least this many points in total.             */
+#define SBH_BENCH_MIN_OPS (1UL << 20)
+
+/*  Accumulates results so the compiler cannot remove the benchmarked work.   */
+static volatile double sbh_bench_sink;
+
+/*  The buffers shared by all benchmarks, allocated for the largest size.     */
+struct sbh_bench_data {
+    struct sbh_vec4 *in, *out;
+    struct sbh_vec4_array soa_in, soa_out;
+};
+
+/*  The signature of a benchmark. It processes the first n points once.       */
+typedef void (*sbh_bench_function)(struct sbh_bench_data *data, size_t n);
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_seconds                                                     *
+ *  Purpose:                                                                  *
+ *      Returns a monotonic wall clock time in seconds.                       *
+ ******************************************************************************/
+static double sbh_bench_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + 1.0E-09 * (double)now.tv_nsec;
+#else
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+/*  End of sbh_bench_seconds.                                                 */
+
+/*  The benchmarks. Each mirrors how the function is used in a render loop.   */
+static void sbh_bench_rect(struct sbh_bench_data *data, size_t n)
+{
+    size_t k;
+
+    for (k = 0; k < n; ++k)
+        data->out[k] = sbh_vec4_rect(
+            data->in[k].dat[0], data->in[k].dat[1],
+            data->in[k].dat[2], data->in[k].dat[3]
+        );
+}
+
+static void
+sbh_bench_rect_from_schwarzschild(struct sbh_bench_data *data, size_t n)
+{
+    size_t k;
+
+    for (k = 0; k < n; ++k)
+        data->out[k] = sbh_vec4_rect_from_schwarzschild(
+            data->in[k].dat[0], data->in[k].dat[1],
+            data->in[k].dat[2], data->in[k].dat[3]
+        );
+}
+
+static void
+sbh_bench_schwarzschild_to_rect(struct sbh_bench_data *data, size_t n)
+{
+    size_t k;
+
+    for (k = 0; k < n; ++k)
+        data->out[k] = sbh_vec4_schwarzschild_to_rect(data->in + k);
+}
+
+/*  The in-place conversions work on the output buffers, which are reset to   *
+ *  the input before every pass, outside of the timed region.                 */
+static void
+sbh_bench_convert_schwarzschild_to_rect(struct sbh_bench_data *data, size_t n)
+{
+    size_t k;
+
+    for (k = 0; k < n; ++k)
+        sbh_vec4_convert_schwarzschild_to_rect(data->out + k);
+}
+
+static void
+sbh_bench_array_rect_from_schwarzschild(struct sbh_bench_data *data, size_t n)
+{
+    sbh_vec4_array_rect_from_schwarzschild(&data->soa_out, &data->soa_in, n);
+}
+
+static void
+sbh_bench_array_convert_schwarzschild_to_rect(struct sbh_bench_data *data,
+                                              size_t n)
+{
+    sbh_vec4_array_convert_schwarzschild_to_rect(&data->soa_out, n);
+}
+
+/*  The inverse conversions. The inputs are read as (x, y, z, t) here.       */
+static void
+sbh_bench_schwarzschild_from_rect(struct sbh_bench_data *data, size_t n)
+{
+    size_t k;
+
+    for (k = 0; k < n; ++k)
+        data->out[k] = sbh_vec4_schwarzschild_from_rect(
+            data->in[k].dat[0], data->in[k].dat[1],
+            data->in[k].dat[2], data->in[k].dat[3]
+        );
+}
+
+static void
+sbh_bench_convert_rect_to_schwarzschild(struct sbh_bench_data *data, size_t n)
+{
+    size_t k;
+
+    for (k = 0; k < n; ++k)
+        sbh_vec4_convert_rect_to_schwarzschild(data->out + k);
+}
+
+static void
+sbh_bench_array_schwarzschild_from_rect(struct sbh_bench_data *data, size_t n)
+{
+    sbh_vec4_array_schwarzschild_from_rect(&data->soa_out, &data->soa_in, n);
+}
+
+static void
+sbh_bench_array_convert_rect_to_schwarzschild(struct sbh_bench_data *data,
+                                              size_t n)
+{
+    sbh_vec4_array_convert_rect_to_schwarzschild(&data->soa_out, n);
+}
+
+/*  The full AoS round trip, transpose in and out around the SoA conversion.  */
+static void
+sbh_bench_array_load_convert_store(struct sbh_bench_data *data, size_t n)
+{
+    sbh_vec4_array_load(&data->soa_out, data->in, n);
+    sbh_vec4_array_convert_schwarzschild_to_rect(&data->soa_out, n);
+    sbh_vec4_array_store(data->out, &data->soa_out, n);
+}
+
+/*  The list of benchmarks, with the bytes they touch per point.              */
+struct sbh_bench_entry {
+    const char *name;
+    sbh_bench_function function;
+    size_t bytes_per_point;
+
+    /*  Non-zero if the benchmark overwrites its input.                       */
+    int in_place;
+};
+
+static const struct sbh_bench_entry sbh_bench_entries[] = {
+    {"vec4_rect", sbh_bench_rect, 64, 0},
+    {"vec4_rect_from_schwarzschild", sbh_bench_rect_from_schwarzschild, 64, 0},
+    {"vec4_schwarzschild_to_rect", sbh_bench_schwarzschild_to_rect, 64, 0},
+    {
+        "vec4_convert_schwarzschild_to_rect",
+        sbh_bench_convert_schwarzschild_to_rect, 32, 1
+    },
+    {
+        "vec4_array_rect_from_schwarzschild",
+        sbh_bench_array_rect_from_schwarzschild, 64, 0
+    },
+    {
+        "vec4_array_convert_schwarzschild_to_rect",
+        sbh_bench_array_convert_schwarzschild_to_rect, 32, 1
+    },
+    {
+        "vec4_array_load_convert_store",
+        sbh_bench_array_load_convert_store, 96, 0
+    },
+    {"vec4_schwarzschild_from_rect", sbh_bench_schwarzschild_from_rect, 64, 0},
+    {
+        "vec4_convert_rect_to_schwarzschild",
+        sbh_bench_convert_rect_to_schwarzschild, 32, 1
+    },
+    {
+        "vec4_array_schwarzschild_from_rect",
+        sbh_bench_array_schwarzschild_from_rect, 64, 0
+    },
+    {
+        "vec4_array_convert_rect_to_schwarzschild",
+        sbh_bench_array_convert_rect_to_schwarzschild, 32, 1
+    }
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_reset                                                       *
+ *  Purpose:                                                                  *
+ *      Copies the inputs into the output buffers for in-place benchmarks.    *
+ ******************************************************************************/
+static void sbh_bench_reset(struct sbh_bench_data *data, size_t n)
+{
+    size_t k;
+
+    memcpy(data->out, data->in, sizeof(*data->out) * n);
+
+    for (k = 0; k < 4; ++k)
+        memcpy(data->soa_out.dat[k], data->soa_in.dat[k],
+               sizeof(*data->soa_out.dat[k]) * n);
+}
+/*  End of sbh_bench_reset.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_checksum                                                    *
+ *  Purpose:                                                                  *
+ *      Adds one value from each output buffer to the sink.                   *
+ ******************************************************************************/
+static void sbh_bench_checksum(const struct sbh_bench_data *data, size_t n)
+{
+    const size_t last = n - 1;
+
+    sbh_bench_sink += data->out[last].dat[0] + data->out[last].dat[2] +
+                      data->soa_out.dat[0][last] + data->soa_out.dat[2][last];
+}
+/*  End of sbh_bench_checksum.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_bench_run                                                         *
+ *  Purpose:                                                                  *
+ *      Times one benchmark at one size and prints the result.                *
+ ******************************************************************************/
+static void
+sbh_bench_run(const struct sbh_bench_entry *entry,
+              struct sbh_bench_data *data, size_t n)
+{
+    const size_t passes = (n < SBH_BENCH_MIN_OPS ? SBH_BENCH_MIN_OPS / n : 1);
+    double best = -1.0, ns_per_op;
+    size_t pass;
+    int repeat;
+
+    /*  One untimed pass to fault in the pages and warm the caches.           */
+    sbh_bench_reset(data, n);
+    entry->function(data, n);
+
+    for (repeat = 0; repeat < SBH_BENCH_REPEATS; ++repeat)
+    {
+        double elapsed = 0.0;
+
+        /*  In-place passes are timed one by one so the resets do not count.  *
+         *  The clock costs tens of ns, against microseconds for a pass.      */
+        if (entry->in_place)
+        {
+            for (pass = 0; pass < passes; ++pass)
+            {
+                double start;
+
+                sbh_bench_reset(data, n);
+                start = sbh_bench_seconds();
+                entry->function(data, n);
+                elapsed += sbh_bench_seconds() - start;
+            }
+        }
+        else
+        {
+            const double start = sbh_bench_seconds();
+
+            for (pass = 0; pass < passes; ++pass)
+                entry->function(data, n);
+
+            elapsed = sbh_bench_seconds() - start;
+        }
+
+        if (best < 0.0 || elapsed < best)
+            best = elapsed;
+    }
+
+    sbh_bench_checksum(data, n);
+    ns_per_op = 1.0E+09 * best / ((double)passes * (double)n);
+
+    printf("{\"benchmark\": \"%s\", \"points\": %lu, \"bytes\": %lu, "
+           "\"ns_per_op\": %.4f, \"ops_per_sec\": %.6e}\n",
+           entry->name, (unsigned long)n,
+           (unsigned long)(n * entry->bytes_per_point),
+           ns_per_op, 1.0E+09 / ns_per_op);
+    fflush(stdout);
+}
+/*  End of sbh_bench_run.                                                     */
+
+/*  Returns the name of the sincos kernel the batch routines dispatch to.     */
+static const char *sbh_bench_kernel_name(enum sbh_sincos_kernel kernel)
+{
+    switch (kernel)
+    {
+        case SBH_SINCOS_KERNEL_AVX512:
+            return "avx512";
+        case SBH_SINCOS_KERNEL_AVX2:
+            return "avx2";
+        case SBH_SINCOS_KERNEL_SSE2:
+            return "sse2";
+        case SBH_SINCOS_KERNEL_NEON:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t entries = sizeof(sbh_bench_entries) /
+                           sizeof(sbh_bench_entries[0]);
+    size_t max_points = 4194304UL;
+    struct sbh_bench_data data;
+    double *buffers;
+    size_t n, k;
+
+    if (argc > 1)
+        max_points = (size_t)strtoul(argv[1], NULL, 10);
+
+    if (max_points < 256)
+        max_points = 256;
+
+    data.in = (struct sbh_vec4 *)malloc(sizeof(*data.in) * max_points);
+    data.out = (struct sbh_vec4 *)malloc(sizeof(*data.out) * max_points);
+    buffers = (double *)malloc(sizeof(*buffers) * 8 * max_points);
+
+    if (!data.in || !data.out || !buffers)
+    {
+        fputs("sbh_bench_vec4: out of memory\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    data.soa_in = sbh_vec4_array_create(
+        buffers, buffers + max_points,
+        buffers + 2 * max_points, buffers + 3 * max_points
+    );
+
+    data.soa_out = sbh_vec4_array_create(
+        buffers + 4 * max_points, buffers + 5 * max_points,
+        buffers + 6 * max_points, buffers + 7 * max_points
+    );
+
+    /*  Points spread over a shell, with angles covering their full ranges.   */
+    for (k = 0; k < max_points; ++k)
+    {
+        const double u = (double)k / (double)max_points;
+
+        data.in[k].dat[0] = 10.0 + 990.0 * u;
+        data.in[k].dat[1] = 6.283185307179586 * (double)((k * 7919UL) % 1000) *
+                            1.0E-03;
+        data.in[k].dat[2] = 3.141592653589793 * (double)((k * 104729UL) % 997) /
+                            997.0;
+        data.in[k].dat[3] = u;
+    }
+
+    sbh_vec4_array_load(&data.soa_in, data.in, max_points);
+
+    printf("{\"suite\": \"sbh_bench_vec4\", \"sincos_kernel\": \"%s\", "
+           "\"repeats\": %d}\n",
+           sbh_bench_kernel_name(sbh_sincos_best_kernel()), SBH_BENCH_REPEATS);
+
+    for (k = 0; k < entries; ++k)
+        for (n = 256; n <= max_points; n *= 4)
+            sbh_bench_run(sbh_bench_entries + k, &data, n);
+
+    free(data.in);
+    free(data.out);
+    free(buffers);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,748 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides an optional C++ layer over sbh_geodesic.h that specializes   *
+ *      the integrator at compile time on the step method, the precision,     *
+ *      and the termination predicate.                                        *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      sbh_geodesic_advance reads params->method on every step, and the      *
+ *      status check is a fixed function. Here the method and the predicate   *
+ *      are template parameters, policy classes with static or inline member  *
+ *      functions, so the compiler sees the whole inner loop: the tableau     *
+ *      coefficients are constants, the stage loops have fixed trip counts,   *
+ *      and there is no function pointer or method switch left per step.      *
+ *                                                                            *
+ *      The precision is a template parameter too. double works on            *
+ *      struct sbh_vec4 with the same tableaux and step control as the C      *
+ *      integrator, and float works on struct sbh_fvec4. The C integrator     *
+ *      takes sin(theta) and cos(theta) from the trig cache of                *
+ *      sbh_geodesic.h, which differs from direct evaluation in the last      *
+ *      bits, while this layer evaluates them on every stage. The step        *
+ *      controller amplifies the difference, so sbh::trace<sbh::dp45, double> *
+ *      agrees with sbh_geodesic_trace to within the integrator tolerance,    *
+ *      not bit for bit.                                                      *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      This file is C++ only and needs nothing newer than C++98. The C       *
+ *      headers remain the reference, this layer only adds entry points.      *
+ *      Predicates are any type with                                          *
+ *                                                                            *
+ *          enum sbh_ray_status operator()(const sbh::geodesic<Real> &) const *
+ *                                                                            *
+ *      returning SBH_RAY_INCOMPLETE while integration should go on. Combine  *
+ *      them with sbh::either.                                                *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_GEODESIC_HPP
+#define SBH_GEODESIC_HPP
+
+#include "../sbh_vec4.h"
+#include "../sbh_fvec4.h"
+#include "../sbh_sincos.h"
+#include "../sbh_ray.h"
+#include "../sbh_geodesic.h"
+#include <cmath>
+
+namespace sbh {
+
+/*  The vector type and the elementary functions for each precision.          */
+template <typename Real>
+struct precision;
+
+template <>
+struct precision<double> {
+    typedef struct sbh_vec4 vec4;
+
+    static inline void sincos(double x, double *sin_x, double *cos_x)
+    {
+        sbh_sincos(x, sin_x, cos_x);
+    }
+
+    static inline double pow(double x, double y)
+    {
+        return std::pow(x, y);
+    }
+};
+
+template <>
+struct precision<float> {
+    typedef struct sbh_fvec4 vec4;
+
+    static inline void sincos(float x, float *sin_x, float *cos_x)
+    {
+        *sin_x = std::sin(x);
+        *cos_x = std::cos(x);
+    }
+
+    static inline float pow(float x, float y)
+    {
+        return std::pow(x, y);
+    }
+};
+
+/*  The state of a ray, as struct sbh_geodesic but in the given precision.    */
+template <typename Real>
+struct geodesic {
+    typename precision<Real>::vec4 p, v;
+};
+
+/*  The integrator parameters in the given precision. The method is the       *
+ *  template parameter of integrate, and the horizon and escape checks are    *
+ *  the predicate, so neither appears here.                                   */
+template <typename Real>
+struct params {
+    Real mass, step, tolerance, min_step, max_step, max_lambda;
+    unsigned long int max_steps;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::params_create                                                    *
+ *  Purpose:                                                                  *
+ *      Converts the parameters of the C integrator.                          *
+ *  Arguments:                                                                *
+ *      c_params (const struct sbh_geodesic_params &):                        *
+ *          The parameters. The method, horizon_epsilon, and escape_radius    *
+ *          are not used.                                                     *
+ *  Outputs:                                                                  *
+ *      out (sbh::params<Real>):                                              *
+ *          The parameters in precision Real.                                 *
+ ******************************************************************************/
+template <typename Real>
+inline params<Real>
+params_create(const struct sbh_geodesic_params &c_params)
+{
+    /*  Declare necessary variables.                                          */
+    params<Real> out;
+
+    out.mass = static_cast<Real>(c_params.mass);
+    out.step = static_cast<Real>(c_params.step);
+    out.tolerance = static_cast<Real>(c_params.tolerance);
+    out.min_step = static_cast<Real>(c_params.min_step);
+    out.max_step = static_cast<Real>(c_params.max_step);
+    out.max_lambda = static_cast<Real>(c_params.max_lambda);
+    out.max_steps = c_params.max_steps;
+    return out;
+}
+/*  End of sbh::params_create.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::geodesic_create                                                  *
+ *  Purpose:                                                                  *
+ *      Converts a ray from the C integrator.                                 *
+ *  Arguments:                                                                *
+ *      ray (const struct sbh_geodesic &):                                    *
+ *          The ray.                                                          *
+ *  Outputs:                                                                  *
+ *      out (sbh::geodesic<Real>):                                            *
+ *          The ray in precision Real.                                        *
+ ******************************************************************************/
+template <typename Real>
+inline geodesic<Real> geodesic_create(const struct sbh_geodesic &ray)
+{
+    /*  Declare necessary variables.                                          */
+    geodesic<Real> out;
+    unsigned int n;
+
+    for (n = 0U; n < 4U; ++n)
+    {
+        out.p.dat[n] = static_cast<Real>(ray.p.dat[n]);
+        out.v.dat[n] = static_cast<Real>(ray.v.dat[n]);
+    }
+
+    return out;
+}
+/*  End of sbh::geodesic_create.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::geodesic_to_c                                                    *
+ *  Purpose:                                                                  *
+ *      Converts a ray back to the C integrator.                              *
+ *  Arguments:                                                                *
+ *      ray (const sbh::geodesic<Real> &):                                    *
+ *          The ray.                                                          *
+ *  Outputs:                                                                  *
+ *      out (struct sbh_geodesic):                                            *
+ *          The ray in double precision.                                      *
+ ******************************************************************************/
+template <typename Real>
+inline struct sbh_geodesic geodesic_to_c(const geodesic<Real> &ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic out;
+    unsigned int n;
+
+    for (n = 0U; n < 4U; ++n)
+    {
+        out.p.dat[n] = static_cast<double>(ray.p.dat[n]);
+        out.v.dat[n] = static_cast<double>(ray.v.dat[n]);
+    }
+
+    return out;
+}
+/*  End of sbh::geodesic_to_c.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::derivative                                                       *
+ *  Purpose:                                                                  *
+ *      Computes the right-hand side of the geodesic equation.                *
+ *  Arguments:                                                                *
+ *      mass (Real):                                                          *
+ *          The mass of the black hole.                                       *
+ *      ray (const sbh::geodesic<Real> &):                                    *
+ *          The current state.                                                *
+ *  Outputs:                                                                  *
+ *      d (sbh::geodesic<Real>):                                              *
+ *          The derivative, see sbh_geodesic_derivative.                      *
+ ******************************************************************************/
+template <typename Real>
+inline geodesic<Real> derivative(Real mass, const geodesic<Real> &ray)
+{
+    /*  Declare necessary variables.                                          */
+    geodesic<Real> d;
+    Real sin_theta, cos_theta;
+    const Real r = ray.p.dat[0];
+    const Real rcpr_r = Real(1) / r;
+    const Real f = Real(1) - Real(2) * mass * rcpr_r;
+    const Real m_by_r_sq = mass * rcpr_r * rcpr_r;
+    const Real vr = ray.v.dat[0];
+    const Real vphi = ray.v.dat[1];
+    const Real vtheta = ray.v.dat[2];
+    const Real vt = ray.v.dat[3];
+
+    precision<Real>::sincos(ray.p.dat[2], &sin_theta, &cos_theta);
+
+    /*  The same expressions as sbh_geodesic_derivative, term for term.       */
+    d.p = ray.v;
+    d.v.dat[0] = -m_by_r_sq * f * vt * vt + m_by_r_sq / f * vr * vr +
+                 r * f * (vtheta*vtheta + sin_theta*sin_theta*vphi*vphi);
+    d.v.dat[1] = Real(-2) * vphi * (vr*rcpr_r + cos_theta/sin_theta*vtheta);
+    d.v.dat[2] = Real(-2) * vr * vtheta * rcpr_r +
+                 sin_theta * cos_theta * vphi * vphi;
+    d.v.dat[3] = Real(-2) * m_by_r_sq / f * vt * vr;
+    return d;
+}
+/*  End of sbh::derivative.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::combine                                                          *
+ *  Purpose:                                                                  *
+ *      Computes y + h sum_n c_n k_n with the number of stages fixed at       *
+ *      compile time.                                                         *
+ *  Arguments:                                                                *
+ *      y (const sbh::geodesic<Real> &):                                      *
+ *          The base state.                                                   *
+ *      h (Real):                                                             *
+ *          The step size.                                                    *
+ *      c (const Real (&)[N]):                                                *
+ *          The coefficients.                                                 *
+ *      k (const sbh::geodesic<Real> *):                                      *
+ *          The first N stage derivatives.                                    *
+ *  Outputs:                                                                  *
+ *      out (sbh::geodesic<Real>):                                            *
+ *          The combined state.                                               *
+ *  Notes:                                                                    *
+ *      Zero coefficients are skipped as in sbh_geodesic_combine. With the    *
+ *      coefficients constant the compiler removes those branches.            *
+ ******************************************************************************/
+template <unsigned int N, typename Real>
+inline geodesic<Real>
+combine(const geodesic<Real> &y, Real h, const Real (&c)[N],
+        const geodesic<Real> *k)
+{
+    /*  Declare necessary variables.                                          */
+    geodesic<Real> out = y;
+    unsigned int stage, n;
+
+    for (stage = 0U; stage < N; ++stage)
+    {
+        const Real hc = h * c[stage];
+
+        if (c[stage] == Real(0))
+            continue;
+
+        for (n = 0U; n < 4U; ++n)
+        {
+            out.p.dat[n] += hc * k[stage].p.dat[n];
+            out.v.dat[n] += hc * k[stage].v.dat[n];
+        }
+    }
+
+    return out;
+}
+/*  End of sbh::combine.                                                      */
+
+/*  Classic fourth order Runge-Kutta with a fixed step, SBH_GEODESIC_RK4.     */
+struct rk4 {
+
+    /*  RK4 does not carry the derivative between steps.                      */
+    static const bool first_same_as_last = false;
+
+    /**************************************************************************
+     *  Function:                                                             *
+     *      sbh::rk4::step                                                    *
+     *  Purpose:                                                              *
+     *      Performs one step, see sbh_geodesic_rk4_step.                     *
+     *  Arguments:                                                            *
+     *      p (const sbh::params<Real> &):                                    *
+     *          The parameters. Only the mass is used.                        *
+     *      ray (sbh::geodesic<Real> &):                                      *
+     *          The ray, advanced by h in place.                              *
+     *      k1 (sbh::geodesic<Real> &):                                       *
+     *          Unused, for the same signature as sbh::dp45::step.            *
+     *      h (Real &):                                                       *
+     *          The step size, unchanged.                                     *
+     *  Outputs:                                                              *
+     *      accepted (bool):                                                  *
+     *          Always true.                                                  *
+     **************************************************************************/
+    template <typename Real>
+    static inline bool
+    step(const params<Real> &p, geodesic<Real> &ray, geodesic<Real> &k1,
+         Real &h)
+    {
+        /*  The weights for the final combination, and for the midpoints.     */
+        const Real weights[4] = {
+            Real(1.0/6.0), Real(1.0/3.0), Real(1.0/3.0), Real(1.0/6.0)
+        };
+        const Real half[1] = {Real(0.5)};
+        const Real one[1] = {Real(1)};
+
+        /*  Declare necessary variables.                                      */
+        geodesic<Real> k[4], tmp;
+
+        (void)k1;
+
+        k[0] = derivative(p.mass, ray);
+        tmp = combine(ray, h, half, k);
+        k[1] = derivative(p.mass, tmp);
+        tmp = combine(ray, h, half, k + 1);
+        k[2] = derivative(p.mass, tmp);
+        tmp = combine(ray, h, one, k + 2);
+        k[3] = derivative(p.mass, tmp);
+        ray = combine(ray, h, weights, k);
+        return true;
+    }
+    /*  End of sbh::rk4::step.                                                */
+};
+
+/*  Dormand-Prince 5(4) with adaptive step control, SBH_GEODESIC_DP45.        */
+struct dp45 {
+
+    /*  The last stage of a step is the first stage of the next.              */
+    static const bool first_same_as_last = true;
+
+    /**************************************************************************
+     *  Function:                                                             *
+     *      sbh::dp45::step                                                   *
+     *  Purpose:                                                              *
+     *      Attempts one step, see sbh_geodesic_dp45_step.                    *
+     *  Arguments:                                                            *
+     *      p (const sbh::params<Real> &):                                    *
+     *          The parameters.                                               *
+     *      ray (sbh::geodesic<Real> &):                                      *
+     *          The ray, advanced in place if the step is accepted.           *
+     *      k1 (sbh::geodesic<Real> &):                                       *
+     *          The derivative at the current state, updated on acceptance.   *
+     *      h (Real &):                                                       *
+     *          On input the step to try, on output the step to try next.     *
+     *  Outputs:                                                              *
+     *      accepted (bool):                                                  *
+     *          True if the step was accepted.                                *
+     **************************************************************************/
+    template <typename Real>
+    static inline bool
+    step(const params<Real> &p, geodesic<Real> &ray, geodesic<Real> &k1,
+         Real &h)
+    {
+        /*  The Dormand-Prince tableau, as in sbh_geodesic_dp45_step.         */
+        const Real a2[1] = {Real(1.0/5.0)};
+        const Real a3[2] = {Real(3.0/40.0), Real(9.0/40.0)};
+        const Real a4[3] = {
+            Real(44.0/45.0), Real(-56.0/15.0), Real(32.0/9.0)
+        };
+        const Real a5[4] = {
+            Real(19372.0/6561.0), Real(-25360.0/2187.0),
+            Real(64448.0/6561.0), Real(-212.0/729.0)
+        };
+        const Real a6[5] = {
+            Real(9017.0/3168.0), Real(-355.0/33.0), Real(46732.0/5247.0),
+            Real(49.0/176.0), Real(-5103.0/18656.0)
+        };
+        const Real b[6] = {
+            Real(35.0/384.0), Real(0), Real(500.0/1113.0),
+            Real(125.0/192.0), Real(-2187.0/6784.0), Real(11.0/84.0)
+        };
+        const Real e[7] = {
+            Real(71.0/57600.0), Real(0), Real(-71.0/16695.0),
+            Real(71.0/1920.0), Real(-17253.0/339200.0), Real(22.0/525.0),
+            Real(-1.0/40.0)
+        };
+
+        /*  Declare necessary variables.                                      */
+        geodesic<Real> k[7], tmp, next, err;
+        Real err_max = Real(0);
+        Real factor;
+        unsigned int n;
+
+        k[0] = k1;
+        tmp = combine(ray, h, a2, k);
+        k[1] = derivative(p.mass, tmp);
+        tmp = combine(ray, h, a3, k);
+        k[2] = derivative(p.mass, tmp);
+        tmp = combine(ray, h, a4, k);
+        k[3] = derivative(p.mass, tmp);
+        tmp = combine(ray, h, a5, k);
+        k[4] = derivative(p.mass, tmp);
+        tmp = combine(ray, h, a6, k);
+        k[5] = derivative(p.mass, tmp);
+        next = combine(ray, h, b, k);
+        k[6] = derivative(p.mass, next);
+
+        for (n = 0U; n < 4U; ++n)
+        {
+            err.p.dat[n] = Real(0);
+            err.v.dat[n] = Real(0);
+        }
+
+        err = combine(err, h, e, k);
+
+        for (n = 0U; n < 4U; ++n)
+        {
+            const Real ep = std::fabs(err.p.dat[n]) /
+                            (Real(1) + std::fabs(next.p.dat[n]));
+            const Real ev = std::fabs(err.v.dat[n]) /
+                            (Real(1) + std::fabs(next.v.dat[n]));
+
+            if (ep > err_max)
+                err_max = ep;
+
+            if (ev > err_max)
+                err_max = ev;
+        }
+
+        err_max /= p.tolerance;
+
+        /*  The same step size control, NaN counts as a huge error.           */
+        if (err_max == Real(0))
+            factor = Real(5);
+        else if (!(err_max == err_max))
+            factor = Real(0.2);
+        else
+        {
+            factor = Real(0.9) * precision<Real>::pow(err_max, Real(-0.2));
+
+            if (factor < Real(0.2))
+                factor = Real(0.2);
+            else if (factor > Real(5))
+                factor = Real(5);
+        }
+
+        if (err_max <= Real(1) || std::fabs(h) <= p.min_step)
+        {
+            ray = next;
+            k1 = k[6];
+            h *= factor;
+
+            if (std::fabs(h) > p.max_step)
+                h = (h < Real(0) ? -p.max_step : p.max_step);
+
+            return true;
+        }
+
+        h *= factor;
+
+        if (std::fabs(h) < p.min_step)
+            h = (h < Real(0) ? -p.min_step : p.min_step);
+
+        return false;
+    }
+    /*  End of sbh::dp45::step.                                               */
+};
+
+/*  Captured once r < radius, see sbh_geodesic_status.                        */
+template <typename Real>
+struct horizon {
+    Real radius;
+
+    inline enum sbh_ray_status operator()(const geodesic<Real> &ray) const
+    {
+        /*  NaN counts as captured.                                           */
+        if (!(ray.p.dat[0] >= radius))
+            return SBH_RAY_CAPTURED;
+
+        return SBH_RAY_INCOMPLETE;
+    }
+};
+
+/*  Escaped once r > radius heading outwards, see sbh_geodesic_status.        */
+template <typename Real>
+struct escape {
+    Real radius;
+
+    inline enum sbh_ray_status operator()(const geodesic<Real> &ray) const
+    {
+        if (ray.p.dat[0] > radius && ray.v.dat[0] > Real(0))
+            return SBH_RAY_ESCAPED;
+
+        return SBH_RAY_INCOMPLETE;
+    }
+};
+
+/*  Stops when either predicate does, with the fate given by the first.       */
+template <class First, class Second>
+struct either {
+    First first;
+    Second second;
+
+    template <typename Real>
+    inline enum sbh_ray_status operator()(const geodesic<Real> &ray) const
+    {
+        const enum sbh_ray_status status = first(ray);
+
+        if (status != SBH_RAY_INCOMPLETE)
+            return status;
+
+        return second(ray);
+    }
+};
+
+/*  The checks of sbh_geodesic_status.                                        */
+template <typename Real>
+struct standard {
+    typedef either<horizon<Real>, escape<Real> > type;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::either_create                                                    *
+ *  Purpose:                                                                  *
+ *      Combines two predicates.                                              *
+ *  Arguments:                                                                *
+ *      first (const First &):                                                *
+ *          Checked first.                                                    *
+ *      second (const Second &):                                              *
+ *          Checked if first returns SBH_RAY_INCOMPLETE.                      *
+ *  Outputs:                                                                  *
+ *      stop (sbh::either<First, Second>):                                    *
+ *          The combined predicate.                                           *
+ ******************************************************************************/
+template <class First, class Second>
+inline either<First, Second>
+either_create(const First &first, const Second &second)
+{
+    /*  Declare necessary variables.                                          */
+    either<First, Second> stop;
+
+    stop.first = first;
+    stop.second = second;
+    return stop;
+}
+/*  End of sbh::either_create.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::standard_create                                                  *
+ *  Purpose:                                                                  *
+ *      Creates the predicate matching sbh_geodesic_status.                   *
+ *  Arguments:                                                                *
+ *      c_params (const struct sbh_geodesic_params &):                        *
+ *          The parameters of the C integrator.                               *
+ *  Outputs:                                                                  *
+ *      stop (sbh::standard<Real>::type):                                     *
+ *          Captured below 2M + horizon_epsilon, escaped heading outwards     *
+ *          beyond escape_radius. An escape radius of zero never escapes, as  *
+ *          for the C integrator.                                             *
+ ******************************************************************************/
+template <typename Real>
+inline typename standard<Real>::type
+standard_create(const struct sbh_geodesic_params &c_params)
+{
+    /*  Declare necessary variables.                                          */
+    horizon<Real> inner;
+    escape<Real> outer;
+    const double radius = (c_params.escape_radius > 0.0 ?
+                           c_params.escape_radius : HUGE_VAL);
+
+    inner.radius = static_cast<Real>(2.0 * c_params.mass +
+                                     c_params.horizon_epsilon);
+    outer.radius = static_cast<Real>(radius);
+    return either_create(inner, outer);
+}
+/*  End of sbh::standard_create.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::integrate                                                        *
+ *  Purpose:                                                                  *
+ *      Integrates a single ray with a compile-time method and predicate.     *
+ *  Arguments:                                                                *
+ *      p (const sbh::params<Real> &):                                        *
+ *          The parameters.                                                   *
+ *      stop (const Predicate &):                                             *
+ *          Integration stops once this returns anything but                  *
+ *          SBH_RAY_INCOMPLETE.                                               *
+ *      ray (sbh::geodesic<Real> &):                                          *
+ *          The ray. On output it holds the final state.                      *
+ *      steps (unsigned long int &):                                          *
+ *          Set to the number of steps, including rejected DP45 steps.        *
+ *      lambda (Real &):                                                      *
+ *          Set to the affine parameter of the final state.                   *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          The value of the predicate on the final state.                    *
+ *  Method:                                                                   *
+ *      The loop of sbh_geodesic_integrate and sbh_geodesic_advance, with the *
+ *      method and the predicate inlined.                                     *
+ ******************************************************************************/
+template <class Method, typename Real, class Predicate>
+inline enum sbh_ray_status
+integrate(const params<Real> &p, const Predicate &stop,
+          geodesic<Real> &ray, unsigned long int &steps, Real &lambda)
+{
+    /*  Declare necessary variables.                                          */
+    enum sbh_ray_status status = stop(ray);
+    geodesic<Real> k1;
+    Real h = p.step;
+
+    steps = 0UL;
+    lambda = Real(0);
+
+    if (status != SBH_RAY_INCOMPLETE)
+        return status;
+
+    /*  As for sbh_geodesic_stepper_create, RK4 does not use k1.              */
+    if (Method::first_same_as_last)
+        k1 = derivative(p.mass, ray);
+    else
+        k1 = ray;
+
+    while (steps < p.max_steps && lambda < p.max_lambda)
+    {
+        Real step = h;
+
+        /*  Shorten the step so we land exactly on max_lambda.                */
+        if (lambda + step > p.max_lambda)
+            step = p.max_lambda - lambda;
+
+        ++steps;
+        h = step;
+
+        if (!Method::step(p, ray, k1, h))
+            continue;
+
+        lambda += step;
+        status = stop(ray);
+
+        if (status != SBH_RAY_INCOMPLETE)
+            break;
+
+        /*  RK4 keeps the step it was given, restore it if it was shortened.  */
+        if (!Method::first_same_as_last)
+            h = p.step;
+    }
+
+    return status;
+}
+/*  End of sbh::integrate.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::trace                                                            *
+ *  Purpose:                                                                  *
+ *      Traces a light ray, as sbh_geodesic_trace, with a compile-time        *
+ *      method, precision, and predicate.                                     *
+ *  Arguments:                                                                *
+ *      p (const sbh::params<Real> &):                                        *
+ *          The parameters.                                                   *
+ *      stop (const Predicate &):                                             *
+ *          The termination predicate.                                        *
+ *      ray (const struct sbh_geodesic &):                                    *
+ *          The initial position and velocity of the ray.                     *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          The fate, final position, and final direction of the ray, in      *
+ *          double precision as for the other engines. Rejected steps are     *
+ *          included in the steps but not counted separately.                 *
+ ******************************************************************************/
+template <class Method, typename Real, class Predicate>
+inline struct sbh_ray_result
+trace(const params<Real> &p, const Predicate &stop,
+      const struct sbh_geodesic &ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_result result;
+    geodesic<Real> state = geodesic_create<Real>(ray);
+    struct sbh_geodesic final_state;
+    struct sbh_vec4 velocity;
+    Real lambda;
+
+    result.status = integrate<Method>(p, stop, state, result.steps, lambda);
+    result.rejected = 0UL;
+    final_state = geodesic_to_c(state);
+    result.time = final_state.p.dat[3] - ray.p.dat[3];
+    result.lambda = static_cast<double>(lambda);
+    result.position = sbh_vec4_schwarzschild_to_rect(&final_state.p);
+    velocity = sbh_vec4_rect_velocity_from_schwarzschild(&final_state.p,
+                                                         &final_state.v);
+    result.direction = sbh_vec4_spatial_normalize(&velocity);
+    return result;
+}
+/*  End of sbh::trace.                                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh::trace                                                            *
+ *  Purpose:                                                                  *
+ *      Traces a light ray with the parameters and termination checks of the  *
+ *      C integrator, but a compile-time method and precision.                *
+ *  Arguments:                                                                *
+ *      c_params (const struct sbh_geodesic_params &):                        *
+ *          The parameters. The method field is ignored.                      *
+ *      ray (const struct sbh_geodesic &):                                    *
+ *          The initial position and velocity of the ray.                     *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          As for sbh_geodesic_trace.                                        *
+ ******************************************************************************/
+template <class Method, typename Real>
+inline struct sbh_ray_result
+trace(const struct sbh_geodesic_params &c_params,
+      const struct sbh_geodesic &ray)
+{
+    return trace<Method>(params_create<Real>(c_params),
+                         standard_create<Real>(c_params), ray);
+}
+/*  End of sbh::trace.                                                        */
+
+}
+/*  End of namespace sbh.                                                     */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,386 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a CUDA backend that traces whole frames on the GPU, one      *
+ *      thread per pixel, into a geometry buffer.                             *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      Under nvcc, SBH_INLINE marks every function __host__ __device__, see  *
+ *      sbh_inline.h, so the camera, the engines and the disk are compiled    *
+ *      for the GPU from the same source as the CPU path. The CPU path stays  *
+ *      the reference: a frame traced here is the same, up to floating point  *
+ *      contraction, as sbh_gbuffer_build with the same engine.               *
+ *                                                                            *
+ *      The GPU fills the samples and copies them to a struct sbh_gbuffer on  *
+ *      the host, which is shaded with sbh_gbuffer_shade as usual. Only the   *
+ *      geometry crosses the bus, the textures stay on the host.              *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Include this file from a .cu file and compile with nvcc, for example  *
+ *                                                                            *
+ *          nvcc -O3 -arch=native main.cu -o main                             *
+ *                                                                            *
+ *      The translation unit that includes this file is built without SIMD    *
+ *      and without threads, SBH_NO_SIMD and SBH_NO_THREADS, since the device *
+ *      pass has neither x86 intrinsics nor pthreads.                         *
+ *                                                                            *
+ *      The engines are double precision. Consumer GPUs run double at a small *
+ *      fraction of their float rate, and the RK engines take hundreds of     *
+ *      steps per ray. For interactive frame rates use the deflection table   *
+ *      engine, which costs one table lookup per pixel, or for disk scenes    *
+ *      the analytic engines, which cost a few elliptic functions per pixel.  *
+ *      The geodesic and disk engines are for checking the others.            *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_CUDA_CUH
+#define SBH_CUDA_CUH
+
+/*  The device pass cannot use x86 intrinsics or pthreads.                    */
+#ifndef SBH_NO_SIMD
+#define SBH_NO_SIMD
+#endif
+
+#ifndef SBH_NO_THREADS
+#define SBH_NO_THREADS
+#endif
+
+#include "../sbh_inline.h"
+#include "../sbh_camera.h"
+#include "../sbh_geodesic.h"
+#include "../sbh_disk.h"
+#include "../sbh_deflection_table.h"
+#include "../sbh_analytic.h"
+#include "../sbh_gbuffer.h"
+#include <cuda_runtime.h>
+#include <stddef.h>
+#include <string.h>
+
+/*  The threads per block along each axis. 16 x 16 keeps neighboring rays of  *
+ *  similar cost in the same warp.                                            */
+#ifndef SBH_CUDA_BLOCK_SIZE
+#define SBH_CUDA_BLOCK_SIZE 16
+#endif
+
+/*  The engine used to trace rays on the GPU.                                 */
+enum sbh_cuda_engine {
+
+    /*  sbh_geodesic_trace.                                                   */
+    SBH_CUDA_ENGINE_GEODESIC,
+
+    /*  sbh_disk_trace.                                                       */
+    SBH_CUDA_ENGINE_DISK,
+
+    /*  sbh_deflection_table_trace, see sbh_cuda_set_table.                   */
+    SBH_CUDA_ENGINE_TABLE,
+
+    /*  sbh_analytic_trace.                                                   */
+    SBH_CUDA_ENGINE_ANALYTIC,
+
+    /*  sbh_analytic_disk_trace.                                              */
+    SBH_CUDA_ENGINE_ANALYTIC_DISK
+};
+
+/*  What the kernel needs to trace a ray, passed by value to the GPU.         */
+struct sbh_cuda_scene {
+    enum sbh_cuda_engine engine;
+    struct sbh_geodesic_params geodesic;
+    struct sbh_analytic_params analytic;
+    struct sbh_disk disk;
+
+    /*  A copy of the host table with its arrays in device memory.            */
+    struct sbh_deflection_table table;
+};
+
+/*  The device memory of a frame.                                             */
+struct sbh_cuda_renderer {
+    size_t width, height;
+
+    /*  width * height samples in device memory.                              */
+    struct sbh_gbuffer_sample *samples;
+
+    /*  The table arrays in device memory, or NULL if no table was set.       */
+    sbh_deflection_sample *psi;
+    sbh_deflection_sample *direction;
+    struct sbh_deflection_table table;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_cuda_trace_kernel                                                 *
+ *  Purpose:                                                                  *
+ *      Traces the ray through the center of one pixel.                       *
+ *  Arguments:                                                                *
+ *      camera (struct sbh_camera):                                           *
+ *          The camera.                                                       *
+ *      scene (struct sbh_cuda_scene):                                        *
+ *          The engine and its parameters.                                    *
+ *      samples (struct sbh_gbuffer_sample *):                                *
+ *          The output, one sample per pixel in row-major order.              *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+static __global__ void
+sbh_cuda_trace_kernel(struct sbh_camera camera,
+                      struct sbh_cuda_scene scene,
+                      struct sbh_gbuffer_sample *samples)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t i = (size_t)blockIdx.x * blockDim.x + threadIdx.x;
+    const size_t j = (size_t)blockIdx.y * blockDim.y + threadIdx.y;
+    struct sbh_geodesic ray;
+    struct sbh_ray_result result;
+    struct sbh_disk_hit hit;
+
+    if (i >= camera.width || j >= camera.height)
+        return;
+
+    ray = sbh_camera_ray(&camera, (double)i + 0.5, (double)j + 0.5);
+
+    switch (scene.engine)
+    {
+        case SBH_CUDA_ENGINE_DISK:
+            result = sbh_disk_trace(&scene.geodesic, &scene.disk, &ray, &hit);
+            break;
+
+        case SBH_CUDA_ENGINE_TABLE:
+            result = sbh_deflection_table_trace(&scene.table, &ray);
+            break;
+
+        case SBH_CUDA_ENGINE_ANALYTIC:
+            result = sbh_analytic_trace(&scene.analytic, &ray);
+            break;
+
+        case SBH_CUDA_ENGINE_ANALYTIC_DISK:
+            result = sbh_analytic_disk_trace(&scene.analytic, &scene.disk,
+                                             &ray, &hit);
+            break;
+
+        default:
+            result = sbh_geodesic_trace(&scene.geodesic, &ray);
+            break;
+    }
+
+    samples[j * camera.width + i] =
+        sbh_gbuffer_sample_from_result(&result, &hit);
+}
+/*  End of sbh_cuda_trace_kernel.                                             */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_cuda_init                                                         *
+ *  Purpose:                                                                  *
+ *      Allocates the device memory for frames of a given size.               *
+ *  Arguments:                                                                *
+ *      renderer (struct sbh_cuda_renderer *):                                *
+ *          The renderer to initialize.                                       *
+ *      width (size_t):                                                       *
+ *          The width of the frames in pixels.                                *
+ *      height (size_t):                                                      *
+ *          The height of the frames in pixels.                               *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if device memory could not be allocated. The      *
+ *          renderer may be passed to sbh_cuda_destroy either way.            *
+ ******************************************************************************/
+static inline int
+sbh_cuda_init(struct sbh_cuda_renderer *renderer, size_t width, size_t height)
+{
+    /*  Declare necessary variables.                                          */
+    void *samples = NULL;
+    cudaError_t error;
+
+    renderer->width = width;
+    renderer->height = height;
+    renderer->samples = NULL;
+    renderer->psi = NULL;
+    renderer->direction = NULL;
+    memset(&renderer->table, 0, sizeof(renderer->table));
+
+    error = cudaMalloc(&samples, sizeof(*renderer->samples)*width*height + 1);
+
+    if (error != cudaSuccess)
+        return 0;
+
+    renderer->samples = (struct sbh_gbuffer_sample *)samples;
+    return 1;
+}
+/*  End of sbh_cuda_init.                                                     */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_cuda_destroy                                                      *
+ *  Purpose:                                                                  *
+ *      Frees the device memory of a renderer.                                *
+ *  Arguments:                                                                *
+ *      renderer (struct sbh_cuda_renderer *):                                *
+ *          The renderer.                                                     *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+static inline void sbh_cuda_destroy(struct sbh_cuda_renderer *renderer)
+{
+    cudaFree(renderer->samples);
+    cudaFree(renderer->psi);
+    cudaFree(renderer->direction);
+    renderer->samples = NULL;
+    renderer->psi = NULL;
+    renderer->direction = NULL;
+}
+/*  End of sbh_cuda_destroy.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_cuda_set_table                                                    *
+ *  Purpose:                                                                  *
+ *      Copies a deflection table to the device for SBH_CUDA_ENGINE_TABLE.    *
+ *  Arguments:                                                                *
+ *      renderer (struct sbh_cuda_renderer *):                                *
+ *          The renderer.                                                     *
+ *      table (const struct sbh_deflection_table *):                          *
+ *          The table, built on the host with sbh_deflection_table_init.      *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if device memory could not be allocated.          *
+ *  Notes:                                                                    *
+ *      The table is only valid for cameras at its observer radius, and must  *
+ *      be set again when the camera moves radially.                          *
+ ******************************************************************************/
+static inline int
+sbh_cuda_set_table(struct sbh_cuda_renderer *renderer,
+                   const struct sbh_deflection_table *table)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t bytes = sizeof(*table->psi) * table->size;
+    void *psi = NULL;
+    void *direction = NULL;
+
+    cudaFree(renderer->psi);
+    cudaFree(renderer->direction);
+    renderer->psi = NULL;
+    renderer->direction = NULL;
+
+    if (cudaMalloc(&psi, bytes) != cudaSuccess)
+        return 0;
+
+    if (cudaMalloc(&direction, bytes) != cudaSuccess)
+    {
+        cudaFree(psi);
+        return 0;
+    }
+
+    renderer->psi = (sbh_deflection_sample *)psi;
+    renderer->direction = (sbh_deflection_sample *)direction;
+
+    if (cudaMemcpy(psi, table->psi, bytes,
+                   cudaMemcpyHostToDevice) != cudaSuccess ||
+        cudaMemcpy(direction, table->direction, bytes,
+                   cudaMemcpyHostToDevice) != cudaSuccess)
+        return 0;
+
+    /*  The same table with the arrays replaced by their device copies.       */
+    renderer->table = *table;
+    renderer->table.psi = renderer->psi;
+    renderer->table.direction = renderer->direction;
+    return 1;
+}
+/*  End of sbh_cuda_set_table.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_cuda_render                                                       *
+ *  Purpose:                                                                  *
+ *      Traces a frame on the GPU into a geometry buffer on the host.         *
+ *  Arguments:                                                                *
+ *      renderer (struct sbh_cuda_renderer *):                                *
+ *          The renderer, the same size as the camera.                        *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      engine (enum sbh_cuda_engine):                                        *
+ *          The engine. SBH_CUDA_ENGINE_TABLE needs sbh_cuda_set_table.       *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters, for the geodesic and disk engines. The *
+ *          analytic engines use its mass and escape radius.                  *
+ *      disk (const struct sbh_disk *):                                       *
+ *          The disk, for the disk engines. May be NULL for the others.       *
+ *      gbuffer (struct sbh_gbuffer *):                                       *
+ *          The output, initialized with one sample per pixel, grid = 1.      *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if the sizes do not match, no table was set for   *
+ *          the table engine, or a CUDA call failed.                          *
+ ******************************************************************************/
+static inline int
+sbh_cuda_render(struct sbh_cuda_renderer *renderer,
+                const struct sbh_camera *camera,
+                enum sbh_cuda_engine engine,
+                const struct sbh_geodesic_params *params,
+                const struct sbh_disk *disk,
+                struct sbh_gbuffer *gbuffer)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t count = renderer->width * renderer->height;
+    const unsigned int size = SBH_CUDA_BLOCK_SIZE;
+    struct sbh_cuda_scene scene;
+    dim3 block(size, size);
+    dim3 grid;
+
+    if (camera->width != renderer->width ||
+        camera->height != renderer->height ||
+        gbuffer->width != renderer->width ||
+        gbuffer->height != renderer->height || gbuffer->grid != 1U)
+        return 0;
+
+    if (engine == SBH_CUDA_ENGINE_TABLE && !renderer->psi)
+        return 0;
+
+    if ((engine == SBH_CUDA_ENGINE_DISK ||
+         engine == SBH_CUDA_ENGINE_ANALYTIC_DISK) && !disk)
+        return 0;
+
+    scene.engine = engine;
+    scene.geodesic = *params;
+    scene.analytic = sbh_analytic_default_params(params->mass);
+    scene.analytic.escape_radius = params->escape_radius;
+    scene.table = renderer->table;
+
+    scene.disk = (disk ? *disk : sbh_disk_default(params->mass));
+
+    grid.x = (unsigned int)((renderer->width + size - 1) / size);
+    grid.y = (unsigned int)((renderer->height + size - 1) / size);
+    grid.z = 1U;
+
+    sbh_cuda_trace_kernel<<<grid, block>>>(*camera, scene, renderer->samples);
+
+    if (cudaGetLastError() != cudaSuccess)
+        return 0;
+
+    /*  cudaMemcpy waits for the kernel to finish.                            */
+    return cudaMemcpy(gbuffer->samples, renderer->samples,
+                      sizeof(*gbuffer->samples) * count,
+                      cudaMemcpyDeviceToHost) == cudaSuccess;
+}
+/*  End of sbh_cuda_render.                                                   */
+
+#endif
+/*  End of include guard.                                                     */
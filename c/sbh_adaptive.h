@@ -0,0 +1,423 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides adaptive antialiasing. Every pixel is traced once, and only  *
+ *      pixels that differ from a neighbor are supersampled.                  *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The frame is rendered in three passes with sbh_render_frame.          *
+ *                                                                            *
+ *          1.) Trace one ray through the center of every pixel, keeping the  *
+ *              color and the fate of the ray (escaped, captured, disk).      *
+ *          2.) Mark every pixel whose ray had a different fate than one of   *
+ *              its four neighbors, or whose color differs from a neighbor's  *
+ *              by more than a threshold in some channel.                     *
+ *          3.) Replace each marked pixel by the mean of an n x n stratified  *
+ *              grid of samples.                                              *
+ *                                                                            *
+ *      Each pass reads only what the previous pass wrote, so the tiles of a  *
+ *      pass can run on any thread, in any order. The marks are symmetric, if *
+ *      a pixel differs from a neighbor both are refined, so an edge is       *
+ *      smoothed on both of its sides.                                        *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Outside the shadow edge, the photon ring and the disk rims the sky    *
+ *      varies slowly, so the marked pixels form a thin band and the ray      *
+ *      count is close to one per pixel. Star fields with single-pixel stars  *
+ *      will mark every star, since it differs from its neighbors.            *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_ADAPTIVE_H
+#define SBH_ADAPTIVE_H
+
+#include "sbh_inline.h"
+#include "sbh_ray.h"
+#include "sbh_render.h"
+#include <stddef.h>
+#include <stdlib.h>
+
+/*  Computes the color of the ray through the point (x, y) of the image, in   *
+ *  pixel coordinates as in sbh_camera.h, and returns its fate. thread is the *
+ *  index of the calling render thread, for per-thread scratch space.         */
+typedef enum sbh_ray_status
+(*sbh_adaptive_sample)(double x, double y, unsigned int thread,
+                       float *rgb, void *data);
+
+/*  Parameters for adaptive antialiasing.                                     */
+struct sbh_adaptive_params {
+
+    /*  Refined pixels use a grid x grid array of samples.                    */
+    unsigned int grid;
+
+    /*  Pixels are refined if some channel differs from a neighbor by more.   */
+    float threshold;
+};
+
+/*  The state shared by the tiles of the three passes.                        */
+struct sbh_adaptive_frame {
+    const struct sbh_adaptive_params *params;
+    const struct sbh_render_params *render;
+    sbh_adaptive_sample sample;
+    void *data;
+
+    /*  The output image, width * height RGB triples, row-major.              */
+    float *rgb;
+
+    /*  The fate of the center ray of each pixel, and the refinement marks.   */
+    unsigned char *status;
+    unsigned char *marks;
+
+    /*  The number of rays traced for each tile in the last pass.             */
+    unsigned long *tile_rays;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_adaptive_default_params                                           *
+ *  Purpose:                                                                  *
+ *      Returns the default parameters, 4 x 4 samples for refined pixels and  *
+ *      a threshold of 0.05, about a tenth of the midtones of an 8-bit image. *
+ *  Arguments:                                                                *
+ *      None (void).                                                          *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_adaptive_params):                                  *
+ *          The default parameters.                                           *
+ ******************************************************************************/
+SBH_INLINE struct sbh_adaptive_params sbh_adaptive_default_params(void)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_adaptive_params params;
+
+    params.grid = 4U;
+    params.threshold = 0.05F;
+    return params;
+}
+/*  End of sbh_adaptive_default_params.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_adaptive_differs                                                  *
+ *  Purpose:                                                                  *
+ *      Checks if two pixels of the first pass disagree.                      *
+ *  Arguments:                                                                *
+ *      frame (const struct sbh_adaptive_frame *):                            *
+ *          The frame.                                                        *
+ *      a (size_t):                                                           *
+ *          The index of the first pixel.                                     *
+ *      b (size_t):                                                           *
+ *          The index of the second pixel.                                    *
+ *  Outputs:                                                                  *
+ *      differs (int):                                                        *
+ *          1 if the rays had different fates or some channel differs by      *
+ *          more than the threshold, and 0 otherwise.                         *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_adaptive_differs(const struct sbh_adaptive_frame *frame, size_t a, size_t b)
+{
+    /*  Declare necessary variables.                                          */
+    const float *p = frame->rgb + 3 * a;
+    const float *q = frame->rgb + 3 * b;
+    const float threshold = frame->params->threshold;
+    int n;
+
+    if (frame->status[a] != frame->status[b])
+        return 1;
+
+    for (n = 0; n < 3; ++n)
+    {
+        if (p[n] - q[n] > threshold || q[n] - p[n] > threshold)
+            return 1;
+    }
+
+    return 0;
+}
+/*  End of sbh_adaptive_differs.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_adaptive_trace_tile                                               *
+ *  Purpose:                                                                  *
+ *      The first pass, one ray through the center of each pixel of a tile.   *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile.                                                         *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The frame, a struct sbh_adaptive_frame.                           *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_adaptive_trace_tile(const struct sbh_render_tile *tile,
+                        unsigned int thread,
+                        void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_adaptive_frame *frame =
+        (const struct sbh_adaptive_frame *)data;
+    struct sbh_progress *const progress = frame->render->progress;
+    const size_t width = frame->render->width;
+    size_t i, j;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t index = j * width + i;
+            const double x = (double)i + 0.5;
+            const double y = (double)j + 0.5;
+            float *rgb = frame->rgb + 3 * index;
+
+            if (sbh_progress_cancelled(progress))
+                return;
+
+            frame->status[index] = (unsigned char)
+                frame->sample(x, y, thread, rgb, frame->data);
+        }
+
+        sbh_progress_add_rays(progress, (unsigned long)tile->width);
+    }
+
+    frame->tile_rays[tile->index] = (unsigned long)(tile->width*tile->height);
+}
+/*  End of sbh_adaptive_trace_tile.                                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_adaptive_mark_tile                                                *
+ *  Purpose:                                                                  *
+ *      The second pass, marks the pixels of a tile that need refinement.     *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile.                                                         *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread, unused.                           *
+ *      data (void *):                                                        *
+ *          The frame, a struct sbh_adaptive_frame.                           *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      Pixels on the border of the tile are compared with the neighboring    *
+ *      tiles, which were finished by the first pass.                         *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_adaptive_mark_tile(const struct sbh_render_tile *tile,
+                       unsigned int thread,
+                       void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_adaptive_frame *frame =
+        (const struct sbh_adaptive_frame *)data;
+    const size_t width = frame->render->width;
+    const size_t height = frame->render->height;
+    size_t i, j;
+
+    (void)thread;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t index = j * width + i;
+            int mark = 0;
+
+            if (i > 0)
+                mark = mark || sbh_adaptive_differs(frame, index, index - 1);
+
+            if (i + 1 < width)
+                mark = mark || sbh_adaptive_differs(frame, index, index + 1);
+
+            if (j > 0)
+                mark = mark || sbh_adaptive_differs(frame, index, index-width);
+
+            if (j + 1 < height)
+                mark = mark || sbh_adaptive_differs(frame, index, index+width);
+
+            frame->marks[index] = (unsigned char)mark;
+        }
+    }
+}
+/*  End of sbh_adaptive_mark_tile.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_adaptive_refine_tile                                              *
+ *  Purpose:                                                                  *
+ *      The third pass, supersamples the marked pixels of a tile.             *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile.                                                         *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The frame, a struct sbh_adaptive_frame.                           *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Sample the centers of a grid x grid subdivision of the pixel. The     *
+ *      first pass sample is not reused, for even grids it is not on the      *
+ *      grid, and reusing it for odd grids would weight it differently.       *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_adaptive_refine_tile(const struct sbh_render_tile *tile,
+                         unsigned int thread,
+                         void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_adaptive_frame *frame =
+        (const struct sbh_adaptive_frame *)data;
+    struct sbh_progress *const progress = frame->render->progress;
+    const size_t width = frame->render->width;
+    const unsigned int grid = frame->params->grid;
+    const double spacing = 1.0 / (double)grid;
+    const float weight = 1.0F / (float)(grid * grid);
+    unsigned long rays = 0UL;
+    size_t i, j;
+    unsigned int a, b;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t index = j * width + i;
+            float *rgb = frame->rgb + 3 * index;
+            float sum[3], sample[3];
+
+            if (!frame->marks[index])
+                continue;
+
+            if (sbh_progress_cancelled(progress))
+                return;
+
+            sum[0] = sum[1] = sum[2] = 0.0F;
+
+            for (b = 0U; b < grid; ++b)
+            {
+                const double y = (double)j + ((double)b + 0.5) * spacing;
+
+                for (a = 0U; a < grid; ++a)
+                {
+                    const double x = (double)i + ((double)a + 0.5) * spacing;
+                    frame->sample(x, y, thread, sample, frame->data);
+                    sum[0] += sample[0];
+                    sum[1] += sample[1];
+                    sum[2] += sample[2];
+                }
+            }
+
+            rgb[0] = weight * sum[0];
+            rgb[1] = weight * sum[1];
+            rgb[2] = weight * sum[2];
+            rays += (unsigned long)(grid * grid);
+            sbh_progress_add_rays(progress, (unsigned long)(grid * grid));
+        }
+    }
+
+    frame->tile_rays[tile->index] = rays;
+}
+/*  End of sbh_adaptive_refine_tile.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_adaptive_render                                                   *
+ *  Purpose:                                                                  *
+ *      Renders a frame with adaptive antialiasing.                           *
+ *  Arguments:                                                                *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry and number of threads.                         *
+ *      params (const struct sbh_adaptive_params *):                          *
+ *          The antialiasing parameters. A grid of 0 or 1 skips refinement.   *
+ *      sample (sbh_adaptive_sample):                                         *
+ *          The function that traces and shades a ray. It is called from      *
+ *          several threads at once.                                          *
+ *      data (void *):                                                        *
+ *          Passed to sample.                                                 *
+ *      rgb (float *):                                                        *
+ *          The output image, render->width * render->height RGB triples in   *
+ *          row-major order.                                                  *
+ *      rays (unsigned long *):                                               *
+ *          If not NULL, set to the number of rays traced.                    *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the frame was rendered, 0 if memory could not be allocated   *
+ *          or sbh_render_frame failed.                                       *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_adaptive_render(const struct sbh_render_params *render,
+                    const struct sbh_adaptive_params *params,
+                    sbh_adaptive_sample sample,
+                    void *data,
+                    float *rgb,
+                    unsigned long *rays)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_adaptive_frame frame;
+    const size_t pixels = render->width * render->height;
+    const size_t tiles = sbh_render_tile_count(render);
+    unsigned long total = 0UL;
+    int success = 0;
+    size_t n;
+
+    frame.params = params;
+    frame.render = render;
+    frame.sample = sample;
+    frame.data = data;
+    frame.rgb = rgb;
+    frame.status = (unsigned char *)malloc(pixels + 1);
+    frame.marks = (unsigned char *)malloc(pixels + 1);
+    frame.tile_rays = (unsigned long *)
+        malloc(sizeof(*frame.tile_rays) * (tiles + 1));
+
+    if (frame.status && frame.marks && frame.tile_rays)
+        success = sbh_render_frame(render, sbh_adaptive_trace_tile, &frame);
+
+    if (success)
+    {
+        for (n = 0; n < tiles; ++n)
+            total += frame.tile_rays[n];
+    }
+
+    /*  Refinement needs both passes, the marks depend on the whole image.    */
+    if (success && params->grid > 1U)
+    {
+        success = sbh_render_frame(render, sbh_adaptive_mark_tile, &frame) &&
+                  sbh_render_frame(render, sbh_adaptive_refine_tile, &frame);
+
+        for (n = 0; success && n < tiles; ++n)
+            total += frame.tile_rays[n];
+    }
+
+    if (success && rays)
+        *rays = total;
+
+    free(frame.status);
+    free(frame.marks);
+    free(frame.tile_rays);
+    return success;
+}
+/*  End of sbh_adaptive_render.                                               */
+
+#endif
+/*  End of include guard.                                                     */
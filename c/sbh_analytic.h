@@ -0,0 +1,726 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a ray tracing engine that solves the orbit equation in       *
+ *      closed form with elliptic functions, so that the cost of a ray does   *
+ *      not depend on how long its path is.                                   *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      As in sbh_planar.h, a ray lies in a plane and u = 1 / r satisfies     *
+ *      u'' + u = 3 M u^2 with ' = d / dpsi. Its first integral is            *
+ *                                                                            *
+ *          (u')^2 = P(u) = 1 / b^2 - u^2 + 2 M u^3                           *
+ *                                                                            *
+ *      where b is the impact parameter. P is a cubic, and psi as a function  *
+ *      of u is an elliptic integral of the first kind. Inverting it gives u  *
+ *      as a Jacobi elliptic function of psi. There are three cases:          *
+ *                                                                            *
+ *          b > 3 sqrt(3) M, ray outside the photon sphere: P has roots       *
+ *              u1 < 0 < u2 < u3 and the ray lives in u1 < u <= u2. It turns  *
+ *              around at the periapsis r = 1 / u2 and escapes.               *
+ *          b > 3 sqrt(3) M, ray inside the photon sphere: the ray lives in   *
+ *              u >= u3. It turns around at r = 1 / u3 and is captured.       *
+ *          b < 3 sqrt(3) M: P has one real root u1 < 0 and two complex ones. *
+ *              There are no turning points, the ray escapes or is captured   *
+ *              depending on where it is heading.                             *
+ *                                                                            *
+ *      The fate, the angle psi at which the ray reaches the escape radius or *
+ *      the horizon, and the points where it crosses a disk in the equator    *
+ *      are then found directly. A ray costs two elliptic integrals and one   *
+ *      Jacobi function evaluation per output point, for every impact         *
+ *      parameter. The RK engines need more and more steps as b approaches    *
+ *      3 sqrt(3) M, since the ray winds around the photon sphere.            *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      The coordinate time and the affine parameter are not computed. The    *
+ *      result has the initial time in position.dat[3], time and lambda set   *
+ *      to -1, and disk hits have lambda set to zero.                         *
+ ******************************************************************************
+ *  References:                                                               *
+ *      1.) Byrd, P., Friedman, M. (1971).                                    *
+ *          Handbook of Elliptic Integrals for Engineers and Scientists,      *
+ *          formulas 236.00, 239.00, and 238.00.                              *
+ *      2.) Chandrasekhar, S. (1983).                                         *
+ *          The Mathematical Theory of Black Holes, chapter 3.                *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_ANALYTIC_H
+#define SBH_ANALYTIC_H
+
+#include "sbh_inline.h"
+#include "sbh_constants.h"
+#include "sbh_vec4.h"
+#include "sbh_geodesic.h"
+#include "sbh_ray.h"
+#include "sbh_planar.h"
+#include "sbh_disk.h"
+#include "sbh_elliptic.h"
+#include <math.h>
+
+/*  Parameters for the analytic engine.                                       */
+struct sbh_analytic_params {
+
+    /*  The mass of the black hole, in geometrized units.                     */
+    double mass;
+
+    /*  Rays heading outwards beyond this radius are considered escaped.      */
+    double escape_radius;
+
+    /*  Rays that turn by more than this angle before their fate is decided   *
+     *  are reported incomplete. This is the analogue of max_steps, and only  *
+     *  rays within rounding error of the critical impact parameter reach it. */
+    double max_angle;
+};
+
+/*  Which part of the orbit equation a ray lives on, see above.               */
+enum sbh_analytic_region {
+
+    /*  u1 < u <= u2, outside the photon sphere.                              */
+    SBH_ANALYTIC_OUTER,
+
+    /*  u >= u3, inside the photon sphere.                                    */
+    SBH_ANALYTIC_INNER,
+
+    /*  u > u1, the case with one real root.                                  */
+    SBH_ANALYTIC_PLUNGE
+};
+
+/*  The closed-form solution for the orbit of one ray.                        */
+struct sbh_analytic_orbit {
+    enum sbh_analytic_region region;
+
+    /*  The real roots of P. Only u1 is used for SBH_ANALYTIC_PLUNGE.         */
+    double u1, u2, u3;
+
+    /*  For SBH_ANALYTIC_PLUNGE, |u1 - z| where z is either complex root.     */
+    double a;
+
+    /*  The complementary parameter of the elliptic functions.                */
+    double mc;
+
+    /*  psi = scale F(phi, k) is the angle from the reference point, u1 or u3 *
+     *  for real roots. w0 is its value at the start of the ray.              */
+    double scale, w0;
+
+    /*  +1 if the ray starts off heading inwards, -1 if outwards. The angle   *
+     *  from the reference point is w0 + direction psi.                       */
+    double direction;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_default_params                                           *
+ *  Purpose:                                                                  *
+ *      Creates a reasonable set of parameters for the analytic engine.       *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_analytic_params):                                  *
+ *          Parameters with an escape radius of 1000M and a largest angle of  *
+ *          1000 radians, the same limits as sbh_planar_default_params.       *
+ ******************************************************************************/
+SBH_INLINE struct sbh_analytic_params
+sbh_analytic_default_params(double mass)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_analytic_params params;
+
+    /*  Set the defaults and return.                                          */
+    params.mass = mass;
+    params.escape_radius = 1000.0 * mass;
+    params.max_angle = 1000.0;
+    return params;
+}
+/*  End of sbh_analytic_default_params.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_orbit_angle                                              *
+ *  Purpose:                                                                  *
+ *      Computes the angle from the reference point of an orbit to the point  *
+ *      with inverse radius u, the elliptic integral of the first kind.       *
+ *  Arguments:                                                                *
+ *      orbit (const struct sbh_analytic_orbit *):                            *
+ *          The orbit.                                                        *
+ *      u (double):                                                           *
+ *          The inverse radius, in the region of the orbit.                   *
+ *  Outputs:                                                                  *
+ *      w (double):                                                           *
+ *          The angle, non-negative.                                          *
+ *  Method:                                                                   *
+ *      Write the integral in the standard form of Byrd and Friedman:         *
+ *                                                                            *
+ *          SBH_ANALYTIC_OUTER:  sin^2(phi) = (u - u1) / (u2 - u1)            *
+ *          SBH_ANALYTIC_INNER:  sin^2(phi) = (u - u3) / (u - u2)             *
+ *          SBH_ANALYTIC_PLUNGE: cos(phi) = (a - u + u1) / (a + u - u1)       *
+ *                                                                            *
+ *      Values just outside the region, from rounding, are clamped to it.     *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_analytic_orbit_angle(const struct sbh_analytic_orbit *orbit, double u)
+{
+    /*  Declare necessary variables.                                          */
+    double s2, c2, s, c;
+
+    if (orbit->region == SBH_ANALYTIC_PLUNGE)
+    {
+        const double d = (u > orbit->u1 ? u - orbit->u1 : 0.0);
+        s = 2.0 * sqrt(orbit->a * d) / (orbit->a + d);
+        c = (orbit->a - d) / (orbit->a + d);
+        return orbit->scale * sbh_elliptic_f(s, c, orbit->mc);
+    }
+
+    if (orbit->region == SBH_ANALYTIC_OUTER)
+    {
+        s2 = (u - orbit->u1) / (orbit->u2 - orbit->u1);
+        c2 = (orbit->u2 - u) / (orbit->u2 - orbit->u1);
+    }
+    else
+    {
+        s2 = (u - orbit->u3) / (u - orbit->u2);
+        c2 = (orbit->u3 - orbit->u2) / (u - orbit->u2);
+    }
+
+    s = (s2 > 0.0 ? sqrt(s2) : 0.0);
+    c = (c2 > 0.0 ? sqrt(c2) : 0.0);
+    return orbit->scale * sbh_elliptic_f(s, c, orbit->mc);
+}
+/*  End of sbh_analytic_orbit_angle.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_orbit_create                                             *
+ *  Purpose:                                                                  *
+ *      Solves the orbit equation for the given initial data.                 *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      u0 (double):                                                          *
+ *          The initial inverse radius.                                       *
+ *      du0 (double):                                                         *
+ *          The initial value of u'.                                          *
+ *  Outputs:                                                                  *
+ *      orbit (struct sbh_analytic_orbit):                                    *
+ *          The solution.                                                     *
+ *  Method:                                                                   *
+ *      1 / b^2 = (u0')^2 + u0^2 - 2 M u0^3. The roots of P follow from the   *
+ *      trigonometric or hyperbolic solution of the cubic with                *
+ *      c = 1 - 54 M^2 / b^2. For three real roots only the largest, u3, is   *
+ *      taken from the trigonometric form, which loses digits in the small    *
+ *      roots when b is large. u1 and u2 are found from u1 + u2 + u3 = 1 / 2M *
+ *      and u1 u2 u3 = -1 / (2 M b^2) instead.                                *
+ ******************************************************************************/
+SBH_INLINE struct sbh_analytic_orbit
+sbh_analytic_orbit_create(double mass, double u0, double du0)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_analytic_orbit orbit;
+    const double two_m = 2.0 * mass;
+    const double rcpr_b_sq = du0 * du0 + u0 * u0 * (1.0 - two_m * u0);
+    const double c = 1.0 - 54.0 * mass * mass * rcpr_b_sq;
+    const double sqrt_two_m = sqrt(two_m);
+
+    /*  Exactly tangent rays are heading inwards if they are at a periapsis,  *
+     *  outside the photon sphere, and outwards at an apoapsis inside it.     */
+    if (du0 != 0.0)
+        orbit.direction = (du0 > 0.0 ? 1.0 : -1.0);
+    else
+        orbit.direction = (3.0 * mass * u0 > 1.0 ? 1.0 : -1.0);
+
+    if (c > -1.0)
+    {
+        const double theta = acos(c);
+        double range;
+
+        orbit.u3 = (1.0 + 2.0 * cos(theta / 3.0)) / (6.0 * mass);
+
+        /*  u1 and u2 are the roots of x^2 - s x + p, with p < 0.             */
+        {
+            const double s = 1.0 / two_m - orbit.u3;
+            const double p = -rcpr_b_sq / (two_m * orbit.u3);
+            orbit.u2 = 0.5 * (s + sqrt(s * s - 4.0 * p));
+            orbit.u1 = p / orbit.u2;
+        }
+
+        range = orbit.u3 - orbit.u1;
+        orbit.mc = (orbit.u3 - orbit.u2) / range;
+        orbit.scale = 2.0 / (sqrt(range) * sqrt_two_m);
+        orbit.a = 0.0;
+
+        /*  Rounding can put u0 slightly between u2 and u3, where P < 0. Put  *
+         *  it on whichever turning point is closer.                          */
+        if (u0 - orbit.u2 < orbit.u3 - u0)
+        {
+            orbit.region = SBH_ANALYTIC_OUTER;
+            u0 = (u0 < orbit.u2 ? u0 : orbit.u2);
+        }
+        else
+        {
+            orbit.region = SBH_ANALYTIC_INNER;
+            u0 = (u0 > orbit.u3 ? u0 : orbit.u3);
+        }
+    }
+    else
+    {
+        /*  acosh(-c), written out since C89 does not have acosh.             */
+        const double eta = log(-c + sqrt(c * c - 1.0));
+        double m, z_sq, n_sq, dm;
+
+        orbit.region = SBH_ANALYTIC_PLUNGE;
+        orbit.u1 = (1.0 - 2.0 * cosh(eta / 3.0)) / (6.0 * mass);
+
+        /*  The complex roots are m +- i n, from the sum and the product.     */
+        m = 0.5 * (1.0 / two_m - orbit.u1);
+        z_sq = -rcpr_b_sq / (two_m * orbit.u1);
+        n_sq = z_sq - m * m;
+        dm = m - orbit.u1;
+        orbit.a = sqrt(dm * dm + (n_sq > 0.0 ? n_sq : 0.0));
+        orbit.mc = 0.5 * (orbit.a - m + orbit.u1) / orbit.a;
+        orbit.scale = 1.0 / (sqrt(orbit.a) * sqrt_two_m);
+        orbit.u2 = orbit.u3 = m;
+    }
+
+    orbit.w0 = sbh_analytic_orbit_angle(&orbit, u0);
+    return orbit;
+}
+/*  End of sbh_analytic_orbit_create.                                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_orbit_eval                                               *
+ *  Purpose:                                                                  *
+ *      Evaluates the orbit at a given angle.                                 *
+ *  Arguments:                                                                *
+ *      orbit (const struct sbh_analytic_orbit *):                            *
+ *          The orbit.                                                        *
+ *      psi (double):                                                         *
+ *          The angle from the start of the ray.                              *
+ *      u (double *):                                                         *
+ *          Set to the inverse radius.                                        *
+ *      du (double *):                                                        *
+ *          Set to du / dpsi.                                                 *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Invert the substitutions of sbh_analytic_orbit_angle with sn, cn, dn  *
+ *      at w / scale, w = w0 + direction psi. These are periodic, so the same *
+ *      formula holds on both sides of a turning point. du is the derivative  *
+ *      of the formula, which has the right sign without a square root of P.  *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_analytic_orbit_eval(const struct sbh_analytic_orbit *orbit, double psi,
+                        double *u, double *du)
+{
+    /*  Declare necessary variables.                                          */
+    const double w = orbit->w0 + orbit->direction * psi;
+    const double factor = orbit->direction / orbit->scale;
+    double sn, cn, dn;
+
+    sbh_elliptic_jacobi(w / orbit->scale, orbit->mc, &sn, &cn, &dn);
+
+    if (orbit->region == SBH_ANALYTIC_OUTER)
+    {
+        const double range = orbit->u2 - orbit->u1;
+        *u = orbit->u1 + range * sn * sn;
+        *du = 2.0 * factor * range * sn * cn * dn;
+    }
+    else if (orbit->region == SBH_ANALYTIC_INNER)
+    {
+        const double cn_sq = cn * cn;
+        *u = (orbit->u3 - orbit->u2 * sn * sn) / cn_sq;
+        *du = 2.0 * factor * (orbit->u3 - orbit->u2) * sn * dn / (cn_sq * cn);
+    }
+    else
+    {
+        const double denom = 1.0 + cn;
+        *u = orbit->u1 + orbit->a * (1.0 - cn) / denom;
+        *du = 2.0 * factor * orbit->a * sn * dn / (denom * denom);
+    }
+}
+/*  End of sbh_analytic_orbit_eval.                                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_orbit_end                                                *
+ *  Purpose:                                                                  *
+ *      Computes the fate of an orbit and the angle at which it is decided.   *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_analytic_params *):                          *
+ *          The engine parameters.                                            *
+ *      orbit (const struct sbh_analytic_orbit *):                            *
+ *          The orbit.                                                        *
+ *      u0 (double):                                                          *
+ *          The initial inverse radius.                                       *
+ *      psi (double *):                                                       *
+ *          Set to the angle at which the ray reaches the escape radius or    *
+ *          the horizon.                                                      *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          SBH_RAY_ESCAPED, SBH_RAY_CAPTURED, or SBH_RAY_INCOMPLETE if psi   *
+ *          would be larger than params->max_angle, in which case psi is set  *
+ *          to max_angle.                                                     *
+ *  Method:                                                                   *
+ *      With G the angle from sbh_analytic_orbit_angle, and using that G is   *
+ *      increasing along the ray while it is heading inwards:                 *
+ *                                                                            *
+ *          Outer, inwards: reaches the periapsis at G(u2) and climbs back    *
+ *              out, psi = 2 G(u2) - w0 - G(u_escape).                        *
+ *          Outer, outwards: psi = w0 - G(u_escape).                          *
+ *          Inner, inwards: psi = G(u_horizon) - w0.                          *
+ *          Inner, outwards: reaches the apoapsis at G(u3) = 0 and falls      *
+ *              back, psi = w0 + G(u_horizon).                                *
+ *          Plunge: psi = G(u_horizon) - w0 inwards, w0 - G(u_escape)         *
+ *              outwards.                                                     *
+ *                                                                            *
+ *      The escape radius counts only while heading outwards, as for          *
+ *      sbh_planar_integrate, and a periapsis beyond it counts as escaped.    *
+ ******************************************************************************/
+SBH_INLINE enum sbh_ray_status
+sbh_analytic_orbit_end(const struct sbh_analytic_params *params,
+                       const struct sbh_analytic_orbit *orbit,
+                       double u0, double *psi)
+{
+    /*  Declare necessary variables.                                          */
+    const double u_escape = 1.0 / params->escape_radius;
+    const double u_horizon = 0.5 / params->mass;
+    enum sbh_ray_status status;
+
+    if (orbit->region == SBH_ANALYTIC_OUTER)
+    {
+        const double u_stop = (u_escape < orbit->u2 ? u_escape : orbit->u2);
+        const double w_stop = sbh_analytic_orbit_angle(orbit, u_stop);
+        status = SBH_RAY_ESCAPED;
+
+        if (orbit->direction > 0.0)
+        {
+            const double w_turn = sbh_analytic_orbit_angle(orbit, orbit->u2);
+            *psi = 2.0 * w_turn - orbit->w0 - w_stop;
+        }
+        else
+            *psi = (u0 > u_stop ? orbit->w0 - w_stop : 0.0);
+    }
+    else
+    {
+        const double w_horizon = sbh_analytic_orbit_angle(orbit, u_horizon);
+
+        if (u0 >= u_horizon)
+        {
+            *psi = 0.0;
+            return SBH_RAY_CAPTURED;
+        }
+
+        if (orbit->direction > 0.0)
+        {
+            status = SBH_RAY_CAPTURED;
+            *psi = w_horizon - orbit->w0;
+        }
+        else if (orbit->region == SBH_ANALYTIC_INNER)
+        {
+            status = SBH_RAY_CAPTURED;
+            *psi = orbit->w0 + w_horizon;
+        }
+        else
+        {
+            status = SBH_RAY_ESCAPED;
+
+            if (u0 > u_escape)
+                *psi = orbit->w0 - sbh_analytic_orbit_angle(orbit, u_escape);
+            else
+                *psi = 0.0;
+        }
+    }
+
+    /*  Also catches NaN and infinity, at the critical impact parameter.      */
+    if (!(*psi <= params->max_angle))
+    {
+        *psi = params->max_angle;
+        return SBH_RAY_INCOMPLETE;
+    }
+
+    if (*psi < 0.0)
+        *psi = 0.0;
+
+    return status;
+}
+/*  End of sbh_analytic_orbit_end.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_setup                                                    *
+ *  Purpose:                                                                  *
+ *      Computes the plane, the orbit, and the fate of a ray.                 *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_analytic_params *):                          *
+ *          The engine parameters.                                            *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity, in Schwarzschild coordinates.  *
+ *      e1 (struct sbh_vec4 *):                                               *
+ *          Set to the first basis vector of the plane.                       *
+ *      e2 (struct sbh_vec4 *):                                               *
+ *          Set to the second basis vector of the plane.                      *
+ *      n (struct sbh_vec4 *):                                                *
+ *          Set to the normal of the plane.                                   *
+ *      orbit (struct sbh_analytic_orbit *):                                  *
+ *          Set to the orbit.                                                 *
+ *      psi (double *):                                                       *
+ *          Set to the angle at which the fate of the ray is decided.         *
+ *      status (enum sbh_ray_status *):                                       *
+ *          Set to the fate of the ray.                                       *
+ *  Outputs:                                                                  *
+ *      is_planar (int):                                                      *
+ *          0 if the ray is radial, as for sbh_planar_basis, and 1 otherwise. *
+ *          For radial rays only e1 and status are set.                       *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_analytic_setup(const struct sbh_analytic_params *params,
+                   const struct sbh_geodesic *ray,
+                   struct sbh_vec4 *e1, struct sbh_vec4 *e2, struct sbh_vec4 *n,
+                   struct sbh_analytic_orbit *orbit, double *psi,
+                   enum sbh_ray_status *status)
+{
+    /*  Declare necessary variables.                                          */
+    const double r0 = ray->p.dat[0];
+    double v_r, tangential_speed, u0;
+
+    /*  Radial rays do not define a plane, see sbh_planar_trace.              */
+    if (!sbh_planar_basis(ray, e1, e2, n, &v_r, &tangential_speed))
+    {
+        *status = (v_r < 0.0 ? SBH_RAY_CAPTURED : SBH_RAY_ESCAPED);
+        return 0;
+    }
+
+    u0 = 1.0 / r0;
+    *orbit = sbh_analytic_orbit_create(params->mass, u0,
+                                       -v_r / (r0 * tangential_speed));
+    *status = sbh_analytic_orbit_end(params, orbit, u0, psi);
+    return 1;
+}
+/*  End of sbh_analytic_setup.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_result                                                   *
+ *  Purpose:                                                                  *
+ *      Computes the position and direction of a ray at a given angle.        *
+ *  Arguments:                                                                *
+ *      orbit (const struct sbh_analytic_orbit *):                            *
+ *          The orbit.                                                        *
+ *      psi (double):                                                         *
+ *          The angle.                                                        *
+ *      t (double):                                                           *
+ *          The time component for the position.                              *
+ *      e1 (const struct sbh_vec4 *):                                         *
+ *          The first basis vector of the plane.                              *
+ *      e2 (const struct sbh_vec4 *):                                         *
+ *          The second basis vector of the plane.                             *
+ *      n (const struct sbh_vec4 *):                                          *
+ *          The normal of the plane.                                          *
+ *      result (struct sbh_ray_result *):                                     *
+ *          The position and direction are set.                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_analytic_result(const struct sbh_analytic_orbit *orbit,
+                    double psi, double t,
+                    const struct sbh_vec4 *e1,
+                    const struct sbh_vec4 *e2,
+                    const struct sbh_vec4 *n,
+                    struct sbh_ray_result *result)
+{
+    /*  Declare necessary variables.                                          */
+    double u, du;
+
+    sbh_analytic_orbit_eval(orbit, psi, &u, &du);
+
+    /*  Same as sbh_planar_trace, the direction is at angle atan2(u, -u').    */
+    result->position = sbh_planar_to_space(1.0 / u, psi, t, e1, e2, n);
+    result->direction = sbh_planar_to_space(1.0, psi + atan2(u, -du), 0.0,
+                                            e1, e2, n);
+}
+/*  End of sbh_analytic_result.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_trace                                                    *
+ *  Purpose:                                                                  *
+ *      Traces a single light ray with the closed-form solution.              *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_analytic_params *):                          *
+ *          The engine parameters.                                            *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity, in Schwarzschild coordinates,  *
+ *          the same input as sbh_planar_trace.                               *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          The fate, final position, and final direction of the ray. steps   *
+ *          is zero.                                                          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_result
+sbh_analytic_trace(const struct sbh_analytic_params *params,
+                   const struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_result result;
+    struct sbh_analytic_orbit orbit;
+    struct sbh_vec4 e1, e2, n;
+    double psi;
+    const int is_planar = sbh_analytic_setup(params, ray, &e1, &e2, &n,
+                                             &orbit, &psi, &result.status);
+
+    result.steps = 0UL;
+    result.rejected = 0UL;
+    result.time = -1.0;
+    result.lambda = -1.0;
+    result.position = sbh_vec4_schwarzschild_to_rect(&ray->p);
+
+    /*  Radial rays keep their initial direction, e1 or -e1.                  */
+    if (!is_planar)
+    {
+        const double sign = (result.status == SBH_RAY_CAPTURED ? -1.0 : 1.0);
+        result.direction = sbh_vec4_linear_combination(sign, &e1, 0.0, &e1,
+                                                       0.0, &e1);
+        return result;
+    }
+
+    sbh_analytic_result(&orbit, psi, ray->p.dat[3], &e1, &e2, &n, &result);
+    return result;
+}
+/*  End of sbh_analytic_trace.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_analytic_disk_trace                                               *
+ *  Purpose:                                                                  *
+ *      Traces a light ray against the disk with the closed-form solution.    *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_analytic_params *):                          *
+ *          The engine parameters.                                            *
+ *      disk (const struct sbh_disk *):                                       *
+ *          The disk.                                                         *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity of the ray.                     *
+ *      hit (struct sbh_disk_hit *):                                          *
+ *          Set if the disk was hit. The redshift is for an observer at rest  *
+ *          at the initial position of the ray, and lambda is zero.           *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          As for sbh_analytic_trace, with status SBH_RAY_DISK and the       *
+ *          position and direction at the hit if the disk was hit.            *
+ *  Method:                                                                   *
+ *      The point at angle psi is in the equator when                         *
+ *                                                                            *
+ *          cos(psi) e1_z + sin(psi) e2_z = 0                                 *
+ *                                                                            *
+ *      which holds every pi radians. Evaluate the orbit at each crossing     *
+ *      before the end of the ray, in order, until one lands on the disk.     *
+ *      The redshift uses the conserved E = f dt / dlambda and                *
+ *      L = r^2 sin^2(theta) dphi / dlambda of the initial ray, which are all *
+ *      that sbh_disk_redshift reads from the state at the hit.               *
+ *  Notes:                                                                    *
+ *      phi is in (-pi, pi], while sbh_disk_trace gives the coordinate phi    *
+ *      of the integrated ray, which can differ from it by a multiple of      *
+ *      2 pi. Rays whose plane is the equator never cross it and never hit    *
+ *      the disk, and a ray starting on the plane does not count as a hit.    *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_result
+sbh_analytic_disk_trace(const struct sbh_analytic_params *params,
+                        const struct sbh_disk *disk,
+                        const struct sbh_geodesic *ray,
+                        struct sbh_disk_hit *hit)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_result result;
+    struct sbh_analytic_orbit orbit;
+    struct sbh_vec4 e1, e2, n;
+    const double r0 = ray->p.dat[0];
+    const double sin_theta = sin(ray->p.dat[2]);
+    const double energy = (1.0 - 2.0 * params->mass / r0) * ray->v.dat[3];
+    const double momentum = r0 * r0 * sin_theta * sin_theta * ray->v.dat[1];
+    enum sbh_ray_status status;
+    double psi_end, psi;
+
+    /*  Radial rays are not in any plane and cannot cross the disk.           */
+    if (!sbh_analytic_setup(params, ray, &e1, &e2, &n,
+                            &orbit, &psi_end, &status))
+        return sbh_analytic_trace(params, ray);
+
+    /*  The first crossing with psi > 0. If the plane of the orbit is the     *
+     *  equator there are none, skip the loop.                                */
+    psi = fmod(atan2(e2.dat[2], e1.dat[2]) + SBH_HALF_PI, SBH_PI);
+
+    if (psi <= 0.0)
+        psi += SBH_PI;
+
+    if (e1.dat[2] == 0.0 && e2.dat[2] == 0.0)
+        psi = psi_end;
+
+    for (; psi < psi_end; psi += SBH_PI)
+    {
+        struct sbh_ray_result crossing;
+        struct sbh_geodesic state;
+        double u, du, r;
+
+        sbh_analytic_orbit_eval(&orbit, psi, &u, &du);
+        r = 1.0 / u;
+
+        if (r < disk->inner_radius || r > disk->outer_radius)
+            continue;
+
+        sbh_analytic_result(&orbit, psi, ray->p.dat[3],
+                            &e1, &e2, &n, &crossing);
+        crossing.status = SBH_RAY_DISK;
+        crossing.steps = 0UL;
+        crossing.rejected = 0UL;
+        crossing.time = -1.0;
+        crossing.lambda = -1.0;
+
+        /*  The state at the hit, with the conserved quantities of the ray.   */
+        state.p = sbh_vec4_rect(r, atan2(crossing.position.dat[1],
+                                         crossing.position.dat[0]),
+                                SBH_HALF_PI, ray->p.dat[3]);
+        state.v = sbh_vec4_rect(0.0, momentum / (r * r), 0.0,
+                                energy / (1.0 - 2.0 * params->mass / r));
+
+        hit->radius = r;
+        hit->phi = state.p.dat[1];
+        hit->lambda = 0.0;
+        hit->redshift = sbh_disk_redshift(params->mass, &state, r0);
+        return crossing;
+    }
+
+    /*  The disk was missed, finish the ray as sbh_analytic_trace does.       */
+    result.status = status;
+    result.steps = 0UL;
+    result.rejected = 0UL;
+    result.time = -1.0;
+    result.lambda = -1.0;
+    sbh_analytic_result(&orbit, psi_end, ray->p.dat[3], &e1, &e2, &n, &result);
+    return result;
+}
+/*  End of sbh_analytic_disk_trace.                                           */
+
+#endif
+/*  End of include guard.                                                     */
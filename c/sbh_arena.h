@@ -0,0 +1,447 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides an arena, or bump, allocator for scratch memory. Each render *
+ *      thread owns one arena, draws tile and trajectory buffers from it, and *
+ *      resets it when the tile is done.                                      *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      An arena is a list of large blocks. An allocation takes the next      *
+ *      aligned bytes of the current block, and moves to the next block, or   *
+ *      allocates one, if it does not fit. Resetting rewinds to the first     *
+ *      block but keeps every block, so once the arena has grown to the size  *
+ *      a tile needs no further calls to malloc are made.                     *
+ *                                                                            *
+ *      Every allocation is aligned to SBH_ARENA_ALIGNMENT bytes, a cache     *
+ *      line, which is also the widest SIMD load used by sbh_sincos.h. Two    *
+ *      threads never share a line, and the array kernels never split a load. *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      An arena must only be used by one thread at a time. Index an array of *
+ *      arenas, see sbh_arena_create_array, by the thread argument of the     *
+ *      tile callback of sbh_render_frame, and reset it at the end of the     *
+ *      callback.                                                             *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_ARENA_H
+#define SBH_ARENA_H
+
+#include "sbh_inline.h"
+#include "sbh_vec4_array.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*  The alignment of every allocation, a power of two.                        */
+#ifndef SBH_ARENA_ALIGNMENT
+#define SBH_ARENA_ALIGNMENT 64
+#endif
+
+/*  The default size of a block, 1 MiB.                                       */
+#define SBH_ARENA_DEFAULT_BLOCK_SIZE 1048576
+
+/*  A block of memory. The usable bytes follow the header, aligned.           */
+struct sbh_arena_block {
+    struct sbh_arena_block *next;
+    unsigned char *data;
+    size_t size, used;
+};
+
+/*  A list of blocks and the position of the next allocation.                 */
+struct sbh_arena {
+    struct sbh_arena_block *first, *current;
+
+    /*  The size of new blocks. Larger requests get a block of their own.     */
+    size_t block_size;
+
+    /*  The most recent allocation, which sbh_arena_extend can grow in place. */
+    void *last;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_round                                                       *
+ *  Purpose:                                                                  *
+ *      Rounds a size up to a multiple of SBH_ARENA_ALIGNMENT.                *
+ *  Arguments:                                                                *
+ *      size (size_t):                                                        *
+ *          The size.                                                         *
+ *  Outputs:                                                                  *
+ *      rounded (size_t):                                                     *
+ *          The rounded size.                                                 *
+ ******************************************************************************/
+SBH_INLINE size_t sbh_arena_round(size_t size)
+{
+    const size_t mask = (size_t)SBH_ARENA_ALIGNMENT - 1;
+    return (size + mask) & ~mask;
+}
+/*  End of sbh_arena_round.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_new_block                                                   *
+ *  Purpose:                                                                  *
+ *      Allocates a block with at least a given number of usable bytes.       *
+ *  Arguments:                                                                *
+ *      size (size_t):                                                        *
+ *          The number of usable bytes, a multiple of SBH_ARENA_ALIGNMENT.    *
+ *  Outputs:                                                                  *
+ *      block (struct sbh_arena_block *):                                     *
+ *          The block, or NULL if malloc failed.                              *
+ *  Method:                                                                   *
+ *      Allocate the header and data together, with SBH_ARENA_ALIGNMENT       *
+ *      spare bytes, and align the start of the data.                         *
+ ******************************************************************************/
+SBH_INLINE struct sbh_arena_block *sbh_arena_new_block(size_t size)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t header = sizeof(struct sbh_arena_block);
+    struct sbh_arena_block *block;
+    unsigned char *start;
+    size_t misalignment;
+
+    block = (struct sbh_arena_block *)
+        malloc(header + size + (size_t)SBH_ARENA_ALIGNMENT);
+
+    if (!block)
+        return NULL;
+
+    start = (unsigned char *)block + header;
+    misalignment = (size_t)start & ((size_t)SBH_ARENA_ALIGNMENT - 1);
+
+    if (misalignment)
+        start += (size_t)SBH_ARENA_ALIGNMENT - misalignment;
+
+    block->next = NULL;
+    block->data = start;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+/*  End of sbh_arena_new_block.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_init                                                        *
+ *  Purpose:                                                                  *
+ *      Creates an arena with one block.                                      *
+ *  Arguments:                                                                *
+ *      arena (struct sbh_arena *):                                           *
+ *          The arena to initialize.                                          *
+ *      block_size (size_t):                                                  *
+ *          The size of a block in bytes. Zero selects                        *
+ *          SBH_ARENA_DEFAULT_BLOCK_SIZE.                                     *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if memory could not be allocated. The arena may   *
+ *          be passed to sbh_arena_destroy either way.                        *
+ ******************************************************************************/
+SBH_INLINE int sbh_arena_init(struct sbh_arena *arena, size_t block_size)
+{
+    if (block_size == 0)
+        block_size = SBH_ARENA_DEFAULT_BLOCK_SIZE;
+
+    arena->block_size = sbh_arena_round(block_size);
+    arena->first = sbh_arena_new_block(arena->block_size);
+    arena->current = arena->first;
+    arena->last = NULL;
+    return arena->first != NULL;
+}
+/*  End of sbh_arena_init.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_destroy                                                     *
+ *  Purpose:                                                                  *
+ *      Frees every block of an arena.                                        *
+ *  Arguments:                                                                *
+ *      arena (struct sbh_arena *):                                           *
+ *          The arena.                                                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_arena_destroy(struct sbh_arena *arena)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_arena_block *block = arena->first;
+
+    while (block)
+    {
+        struct sbh_arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->last = NULL;
+}
+/*  End of sbh_arena_destroy.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_reset                                                       *
+ *  Purpose:                                                                  *
+ *      Frees every allocation of an arena at once, keeping its blocks.       *
+ *  Arguments:                                                                *
+ *      arena (struct sbh_arena *):                                           *
+ *          The arena.                                                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_arena_reset(struct sbh_arena *arena)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_arena_block *block;
+
+    for (block = arena->first; block; block = block->next)
+        block->used = 0;
+
+    arena->current = arena->first;
+    arena->last = NULL;
+}
+/*  End of sbh_arena_reset.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_alloc                                                       *
+ *  Purpose:                                                                  *
+ *      Allocates memory from an arena.                                       *
+ *  Arguments:                                                                *
+ *      arena (struct sbh_arena *):                                           *
+ *          The arena.                                                        *
+ *      size (size_t):                                                        *
+ *          The number of bytes.                                              *
+ *  Outputs:                                                                  *
+ *      ptr (void *):                                                         *
+ *          The memory, aligned to SBH_ARENA_ALIGNMENT, valid until the arena *
+ *          is reset or destroyed. NULL if memory could not be allocated.     *
+ *  Method:                                                                   *
+ *      Try the current block and then the following ones, which are free     *
+ *      after a reset. Append a new block if none has room.                   *
+ ******************************************************************************/
+SBH_INLINE void *sbh_arena_alloc(struct sbh_arena *arena, size_t size)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_arena_block *block = arena->current;
+    struct sbh_arena_block *tail = NULL;
+    void *ptr;
+
+    size = sbh_arena_round(size);
+
+    while (block && block->size - block->used < size)
+    {
+        tail = block;
+        block = block->next;
+    }
+
+    if (!block)
+    {
+        block = sbh_arena_new_block(
+            size > arena->block_size ? size : arena->block_size
+        );
+
+        if (!block)
+            return NULL;
+
+        if (tail)
+            tail->next = block;
+        else
+            arena->first = block;
+    }
+
+    ptr = block->data + block->used;
+    block->used += size;
+    arena->current = block;
+    arena->last = ptr;
+    return ptr;
+}
+/*  End of sbh_arena_alloc.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_extend                                                      *
+ *  Purpose:                                                                  *
+ *      Grows an allocation, the arena counterpart of realloc.                *
+ *  Arguments:                                                                *
+ *      arena (struct sbh_arena *):                                           *
+ *          The arena.                                                        *
+ *      ptr (void *):                                                         *
+ *          The allocation, from sbh_arena_alloc, or NULL.                    *
+ *      old_size (size_t):                                                    *
+ *          The size it was allocated with.                                   *
+ *      new_size (size_t):                                                    *
+ *          The new size, at least old_size.                                  *
+ *  Outputs:                                                                  *
+ *      new_ptr (void *):                                                     *
+ *          The grown allocation with the old contents, or NULL if memory     *
+ *          could not be allocated, in which case ptr is still valid.         *
+ *  Method:                                                                   *
+ *      The most recent allocation is grown in place if its block has room.   *
+ *      Otherwise a new allocation is made and the contents copied. The old   *
+ *      memory is only reclaimed by a reset, so buffers that grow one element *
+ *      at a time should grow geometrically.                                  *
+ ******************************************************************************/
+SBH_INLINE void *
+sbh_arena_extend(struct sbh_arena *arena, void *ptr,
+                 size_t old_size, size_t new_size)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_arena_block *block = arena->current;
+    void *new_ptr;
+
+    if (!ptr)
+        return sbh_arena_alloc(arena, new_size);
+
+    old_size = sbh_arena_round(old_size);
+    new_size = sbh_arena_round(new_size);
+
+    if (ptr == arena->last && block->size - block->used >= new_size - old_size)
+    {
+        block->used += new_size - old_size;
+        return ptr;
+    }
+
+    new_ptr = sbh_arena_alloc(arena, new_size);
+
+    if (new_ptr)
+        memcpy(new_ptr, ptr, old_size);
+
+    return new_ptr;
+}
+/*  End of sbh_arena_extend.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_vec4_array                                                  *
+ *  Purpose:                                                                  *
+ *      Allocates a structure-of-arrays buffer from an arena.                 *
+ *  Arguments:                                                                *
+ *      arena (struct sbh_arena *):                                           *
+ *          The arena.                                                        *
+ *      len (size_t):                                                         *
+ *          The number of vectors.                                            *
+ *      arr (struct sbh_vec4_array *):                                        *
+ *          Set to the buffer. Each component array is aligned.               *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if memory could not be allocated.                 *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_arena_vec4_array(struct sbh_arena *arena, size_t len,
+                     struct sbh_vec4_array *arr)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t stride = sbh_arena_round(sizeof(double) * len);
+    unsigned char *memory;
+    int n;
+
+    memory = (unsigned char *)sbh_arena_alloc(arena, 4 * stride);
+
+    if (!memory)
+        return 0;
+
+    for (n = 0; n < 4; ++n)
+        arr->dat[n] = (double *)(void *)(memory + (size_t)n * stride);
+
+    return 1;
+}
+/*  End of sbh_arena_vec4_array.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_create_array                                                *
+ *  Purpose:                                                                  *
+ *      Creates one arena per render thread.                                  *
+ *  Arguments:                                                                *
+ *      count (size_t):                                                       *
+ *          The number of arenas, see sbh_render_thread_count.                *
+ *      block_size (size_t):                                                  *
+ *          The block size, as for sbh_arena_init.                            *
+ *  Outputs:                                                                  *
+ *      arenas (struct sbh_arena *):                                          *
+ *          The arenas, or NULL if memory could not be allocated. Free with   *
+ *          sbh_arena_destroy_array.                                          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_arena *
+sbh_arena_create_array(size_t count, size_t block_size)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_arena *arenas;
+    size_t n;
+
+    arenas = (struct sbh_arena *)malloc(sizeof(*arenas) * count + 1);
+
+    if (!arenas)
+        return NULL;
+
+    for (n = 0; n < count; ++n)
+    {
+        if (!sbh_arena_init(arenas + n, block_size))
+        {
+            /*  Destroy the arenas made so far, including the failed one.     */
+            count = n + 1;
+
+            for (n = 0; n < count; ++n)
+                sbh_arena_destroy(arenas + n);
+
+            free(arenas);
+            return NULL;
+        }
+    }
+
+    return arenas;
+}
+/*  End of sbh_arena_create_array.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_arena_destroy_array                                               *
+ *  Purpose:                                                                  *
+ *      Frees arenas made by sbh_arena_create_array.                          *
+ *  Arguments:                                                                *
+ *      arenas (struct sbh_arena *):                                          *
+ *          The arenas.                                                       *
+ *      count (size_t):                                                       *
+ *          The number of arenas.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_arena_destroy_array(struct sbh_arena *arenas, size_t count)
+{
+    /*  Declare necessary variables.                                          */
+    size_t n;
+
+    if (!arenas)
+        return;
+
+    for (n = 0; n < count; ++n)
+        sbh_arena_destroy(arenas + n);
+
+    free(arenas);
+}
+/*  End of sbh_arena_destroy_array.                                           */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,760 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a branch-free atan2 kernel, in scalar and SIMD form, for the *
+ *      rectangular-to-spherical conversions.                                 *
+ ******************************************************************************
+ *  Error Bound:                                                              *
+ *      For DBL_MIN <= |x|, |y| <= 2^1020 the result is within 2.5 ULP of the *
+ *      exact value. The largest error observed, over 10^7 random arguments   *
+ *      of random signs and magnitudes compared against atan2l, is 2.28 ULP.  *
+ *      Zeros, subnormals, huge values, infinities, and NaN are passed to     *
+ *      libm, so the result is whatever atan2 from math.h returns.            *
+ ******************************************************************************
+ *  SIMD Support:                                                             *
+ *      The same kernels and runtime dispatch as sbh_sincos.h, which decides  *
+ *      what is available. Define SBH_NO_SIMD before including this file to   *
+ *      force the portable C kernel.                                          *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_ATAN2_H
+#define SBH_ATAN2_H
+
+#include "sbh_inline.h"
+#include "sbh_sincos.h"
+#include <stddef.h>
+#include <math.h>
+
+/*  Range of |x| and |y| the kernels handle. Above the max mn + mx could      *
+ *  overflow, below the min (DBL_MIN) the quotient loses precision. This also *
+ *  excludes zeros, whose signs need the special cases in libm.               */
+#define SBH_ATAN2_MAX_ARG (1.12355820928894744233E+307)
+#define SBH_ATAN2_MIN_ARG (2.22507385850720138309E-308)
+
+/*  Ratios above tan(pi / 8) are reduced with atan(a) = pi / 4 + atan(t),     *
+ *  t = (a - 1) / (a + 1), which leaves |t| <= tan(pi / 8) in both cases.     */
+#define SBH_ATAN2_TAN_PI_BY_8 (4.14213562373095034452E-01)
+
+/*  pi / 4, pi / 2, and pi, split into a double and the rounding error.       */
+#define SBH_ATAN2_PIO4_HI (7.85398163397448278999E-01)
+#define SBH_ATAN2_PIO4_LO (3.06161699786838301793E-17)
+#define SBH_ATAN2_PIO2_HI (1.57079632679489655800E+00)
+#define SBH_ATAN2_PIO2_LO (6.12323399573676603587E-17)
+#define SBH_ATAN2_PI_HI (3.14159265358979311600E+00)
+#define SBH_ATAN2_PI_LO (1.22464679914735320717E-16)
+
+/*  Coefficients for the arctangent polynomial on |t| < 7 / 16, from fdlibm.  */
+#define SBH_ATAN2_A0 (3.33333333333329318027E-01)
+#define SBH_ATAN2_A1 (-1.99999999998764832476E-01)
+#define SBH_ATAN2_A2 (1.42857142725034663711E-01)
+#define SBH_ATAN2_A3 (-1.11111104054623557880E-01)
+#define SBH_ATAN2_A4 (9.09088713343650656196E-02)
+#define SBH_ATAN2_A5 (-7.69187620504482999495E-02)
+#define SBH_ATAN2_A6 (6.66107313738753120669E-02)
+#define SBH_ATAN2_A7 (-5.83357013379057348645E-02)
+#define SBH_ATAN2_A8 (4.97687799461593236017E-02)
+#define SBH_ATAN2_A9 (-3.65315727442169155270E-02)
+#define SBH_ATAN2_A10 (1.62858201153657823623E-02)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2                                                             *
+ *  Purpose:                                                                  *
+ *      Computes the angle of the point (x, y) from the positive x axis.      *
+ *  Arguments:                                                                *
+ *      y (double):                                                           *
+ *          The vertical component.                                           *
+ *      x (double):                                                           *
+ *          The horizontal component.                                         *
+ *  Outputs:                                                                  *
+ *      angle (double):                                                       *
+ *          atan2(y, x), in [-pi, pi].                                        *
+ *  Method:                                                                   *
+ *      With mn and mx the smaller and larger of |x| and |y|, atan(mn / mx)   *
+ *      is in [0, pi / 4]. For mn <= tan(pi / 8) mx take t = mn / mx,         *
+ *      otherwise t = (mn - mx) / (mn + mx) and add pi / 4, so that only one  *
+ *      division is needed. atan(t) is the fdlibm minimax polynomial. Then    *
+ *      reflect about pi / 4 if |y| > |x|, about pi / 2 if x < 0, and copy    *
+ *      the sign of y. Each reflection adds the rounding error of the         *
+ *      constant separately to keep the result accurate near pi / 2 and pi.   *
+ *  Notes:                                                                    *
+ *      The SIMD kernels below perform the exact same operations, with        *
+ *      selects in place of the branches.                                     *
+ ******************************************************************************/
+SBH_INLINE double sbh_atan2(double y, double x)
+{
+    /*  Declare necessary variables.                                          */
+    const double ax = fabs(x);
+    const double ay = fabs(y);
+    const double mn = (ax < ay ? ax : ay);
+    const double mx = (ax < ay ? ay : ax);
+    double t, z, w, s1, s2, r;
+
+    /*  Zeros, huge values, infinities and NaN, see the error bound above.    */
+    if (!(mn >= SBH_ATAN2_MIN_ARG && mx <= SBH_ATAN2_MAX_ARG))
+        return atan2(y, x);
+
+    if (mn > SBH_ATAN2_TAN_PI_BY_8 * mx)
+        t = (mn - mx) / (mn + mx);
+    else
+        t = mn / mx;
+
+    /*  The polynomial, split into even and odd powers of w as in fdlibm.     */
+    z = t * t;
+    w = z * z;
+    s1 = z * (SBH_ATAN2_A0 + w * (SBH_ATAN2_A2 + w * (SBH_ATAN2_A4 +
+         w * (SBH_ATAN2_A6 + w * (SBH_ATAN2_A8 + w * SBH_ATAN2_A10)))));
+    s2 = w * (SBH_ATAN2_A1 + w * (SBH_ATAN2_A3 + w * (SBH_ATAN2_A5 +
+         w * (SBH_ATAN2_A7 + w * SBH_ATAN2_A9))));
+
+    if (mn > SBH_ATAN2_TAN_PI_BY_8 * mx)
+        r = SBH_ATAN2_PIO4_HI + (SBH_ATAN2_PIO4_LO - (t * (s1 + s2) - t));
+    else
+        r = t - t * (s1 + s2);
+
+    if (ay > ax)
+        r = (SBH_ATAN2_PIO2_HI - r) + SBH_ATAN2_PIO2_LO;
+
+    if (x < 0.0)
+        r = (SBH_ATAN2_PI_HI - r) + SBH_ATAN2_PI_LO;
+
+    return (y < 0.0 ? -r : r);
+}
+/*  End of sbh_atan2.                                                         */
+
+/*  The SSE2 kernel, two lanes at a time.                                     */
+#if defined(SBH_SINCOS_HAS_SSE2)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2_array_sse2                                                  *
+ *  Purpose:                                                                  *
+ *      Computes atan2 of two arrays using SSE2 instructions.                 *
+ *  Arguments:                                                                *
+ *      y (const double *):                                                   *
+ *          The vertical components.                                          *
+ *      x (const double *):                                                   *
+ *          The horizontal components.                                        *
+ *      out (double *):                                                       *
+ *          The output array, out[k] = atan2(y[k], x[k]).                     *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_atan2. SSE2 has no blend, so selects are built from and,  *
+ *      andnot, and or. Lanes that fail the range check are redone with       *
+ *      sbh_atan2, which sends them to libm.                                  *
+ *  Notes:                                                                    *
+ *      minpd and maxpd return their second operand if either is NaN. mn is   *
+ *      min(ax, ay) and mx is max(ay, ax), so a NaN in either input ends up   *
+ *      in mn or mx and fails the range check, exactly as in sbh_atan2.       *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_atan2_array_sse2(const double *y, const double *x, double *out, size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const __m128d sign_bit = _mm_set1_pd(-0.0);
+    const __m128d max_arg = _mm_set1_pd(SBH_ATAN2_MAX_ARG);
+    const __m128d min_arg = _mm_set1_pd(SBH_ATAN2_MIN_ARG);
+    const __m128d zero = _mm_setzero_pd();
+    size_t k = 0;
+
+    /*  Loop through the array two elements at a time.                        */
+    for (; k + 2 <= len; k += 2)
+    {
+        const __m128d yv = _mm_loadu_pd(y + k);
+        const __m128d xv = _mm_loadu_pd(x + k);
+        const __m128d ax = _mm_andnot_pd(sign_bit, xv);
+        const __m128d ay = _mm_andnot_pd(sign_bit, yv);
+        const __m128d mn = _mm_min_pd(ax, ay);
+        const __m128d mx = _mm_max_pd(ay, ax);
+        const int bad = _mm_movemask_pd(
+            _mm_and_pd(_mm_cmpge_pd(mn, min_arg), _mm_cmple_pd(mx, max_arg))
+        ) ^ 3;
+
+        const __m128d big = _mm_cmpgt_pd(
+            mn, _mm_mul_pd(_mm_set1_pd(SBH_ATAN2_TAN_PI_BY_8), mx)
+        );
+        const __m128d swap = _mm_cmpgt_pd(ay, ax);
+        const __m128d negative = _mm_cmplt_pd(xv, zero);
+        __m128d num, den, t, z, w, s1, s2, r, reflected;
+
+        /*  One division for both reductions.                                 */
+        num = _mm_or_pd(_mm_and_pd(big, _mm_sub_pd(mn, mx)),
+                        _mm_andnot_pd(big, mn));
+        den = _mm_or_pd(_mm_and_pd(big, _mm_add_pd(mn, mx)),
+                        _mm_andnot_pd(big, mx));
+        t = _mm_div_pd(num, den);
+        z = _mm_mul_pd(t, t);
+        w = _mm_mul_pd(z, z);
+
+        /*  The polynomial, the same as the scalar code.                      */
+        s1 = _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A8),
+                        _mm_mul_pd(w, _mm_set1_pd(SBH_ATAN2_A10)));
+        s1 = _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A6), _mm_mul_pd(w, s1));
+        s1 = _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A4), _mm_mul_pd(w, s1));
+        s1 = _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A2), _mm_mul_pd(w, s1));
+        s1 = _mm_mul_pd(z, _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A0),
+                                      _mm_mul_pd(w, s1)));
+
+        s2 = _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A7),
+                        _mm_mul_pd(w, _mm_set1_pd(SBH_ATAN2_A9)));
+        s2 = _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A5), _mm_mul_pd(w, s2));
+        s2 = _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A3), _mm_mul_pd(w, s2));
+        s2 = _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(SBH_ATAN2_A1),
+                                      _mm_mul_pd(w, s2)));
+
+        /*  atan(t), plus pi / 4 for the big lanes. Adding zero for the other *
+         *  lanes gives the same result as the scalar code.                   */
+        r = _mm_sub_pd(_mm_mul_pd(t, _mm_add_pd(s1, s2)), t);
+        r = _mm_sub_pd(_mm_and_pd(big, _mm_set1_pd(SBH_ATAN2_PIO4_LO)), r);
+        r = _mm_add_pd(_mm_and_pd(big, _mm_set1_pd(SBH_ATAN2_PIO4_HI)), r);
+
+        /*  Reflect about pi / 4 and pi / 2.                                  */
+        reflected = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(SBH_ATAN2_PIO2_HI), r),
+                               _mm_set1_pd(SBH_ATAN2_PIO2_LO));
+        r = _mm_or_pd(_mm_and_pd(swap, reflected), _mm_andnot_pd(swap, r));
+
+        reflected = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(SBH_ATAN2_PI_HI), r),
+                               _mm_set1_pd(SBH_ATAN2_PI_LO));
+        r = _mm_or_pd(_mm_and_pd(negative, reflected),
+                      _mm_andnot_pd(negative, r));
+
+        /*  r is non-negative, so or-ing in the sign of y negates it.         */
+        _mm_storeu_pd(out + k, _mm_or_pd(r, _mm_and_pd(sign_bit, yv)));
+
+        /*  Lanes outside of the range of the kernel are rare. Fix them. The  *
+         *  inputs are taken from the registers since out may alias y or x.   */
+        if (bad)
+        {
+            double y_lane[2], x_lane[2];
+
+            _mm_storeu_pd(y_lane, yv);
+            _mm_storeu_pd(x_lane, xv);
+
+            if (bad & 1)
+                out[k] = sbh_atan2(y_lane[0], x_lane[0]);
+
+            if (bad & 2)
+                out[k + 1] = sbh_atan2(y_lane[1], x_lane[1]);
+        }
+    }
+
+    /*  The leftover element, if any, is handled by the scalar kernel.        */
+    for (; k < len; ++k)
+        out[k] = sbh_atan2(y[k], x[k]);
+}
+/*  End of sbh_atan2_array_sse2.                                              */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_SSE2).                                  */
+
+/*  The AVX2 kernel, four lanes at a time with fused multiply-adds.           */
+#if defined(SBH_SINCOS_HAS_AVX2)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2_array_avx2                                                  *
+ *  Purpose:                                                                  *
+ *      Computes atan2 of two arrays using AVX2 and FMA instructions.         *
+ *  Arguments:                                                                *
+ *      y (const double *):                                                   *
+ *          The vertical components.                                          *
+ *      x (const double *):                                                   *
+ *          The horizontal components.                                        *
+ *      out (double *):                                                       *
+ *          The output array, out[k] = atan2(y[k], x[k]).                     *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_atan2_array_sse2, with FMA for the polynomial and blendv  *
+ *      for the selects.                                                      *
+ ******************************************************************************/
+SBH_SINCOS_TARGET_AVX2 SBH_INLINE void
+sbh_atan2_array_avx2(const double *y, const double *x, double *out, size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const __m256d sign_bit = _mm256_set1_pd(-0.0);
+    const __m256d max_arg = _mm256_set1_pd(SBH_ATAN2_MAX_ARG);
+    const __m256d min_arg = _mm256_set1_pd(SBH_ATAN2_MIN_ARG);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t k = 0;
+
+    /*  Loop through the array four elements at a time.                       */
+    for (; k + 4 <= len; k += 4)
+    {
+        const __m256d yv = _mm256_loadu_pd(y + k);
+        const __m256d xv = _mm256_loadu_pd(x + k);
+        const __m256d ax = _mm256_andnot_pd(sign_bit, xv);
+        const __m256d ay = _mm256_andnot_pd(sign_bit, yv);
+        const __m256d mn = _mm256_min_pd(ax, ay);
+        const __m256d mx = _mm256_max_pd(ay, ax);
+        const int bad = _mm256_movemask_pd(
+            _mm256_and_pd(_mm256_cmp_pd(mn, min_arg, _CMP_GE_OQ),
+                          _mm256_cmp_pd(mx, max_arg, _CMP_LE_OQ))
+        ) ^ 15;
+
+        const __m256d big = _mm256_cmp_pd(
+            mn, _mm256_mul_pd(_mm256_set1_pd(SBH_ATAN2_TAN_PI_BY_8), mx),
+            _CMP_GT_OQ
+        );
+        const __m256d swap = _mm256_cmp_pd(ay, ax, _CMP_GT_OQ);
+        const __m256d negative = _mm256_cmp_pd(xv, zero, _CMP_LT_OQ);
+        __m256d t, z, w, s1, s2, r, reflected;
+
+        /*  One division for both reductions.                                 */
+        t = _mm256_div_pd(
+            _mm256_blendv_pd(mn, _mm256_sub_pd(mn, mx), big),
+            _mm256_blendv_pd(mx, _mm256_add_pd(mn, mx), big)
+        );
+        z = _mm256_mul_pd(t, t);
+        w = _mm256_mul_pd(z, z);
+
+        /*  The polynomial.                                                   */
+        s1 = _mm256_fmadd_pd(w, _mm256_set1_pd(SBH_ATAN2_A10),
+                             _mm256_set1_pd(SBH_ATAN2_A8));
+        s1 = _mm256_fmadd_pd(w, s1, _mm256_set1_pd(SBH_ATAN2_A6));
+        s1 = _mm256_fmadd_pd(w, s1, _mm256_set1_pd(SBH_ATAN2_A4));
+        s1 = _mm256_fmadd_pd(w, s1, _mm256_set1_pd(SBH_ATAN2_A2));
+        s1 = _mm256_mul_pd(z, _mm256_fmadd_pd(w, s1,
+                                              _mm256_set1_pd(SBH_ATAN2_A0)));
+
+        s2 = _mm256_fmadd_pd(w, _mm256_set1_pd(SBH_ATAN2_A9),
+                             _mm256_set1_pd(SBH_ATAN2_A7));
+        s2 = _mm256_fmadd_pd(w, s2, _mm256_set1_pd(SBH_ATAN2_A5));
+        s2 = _mm256_fmadd_pd(w, s2, _mm256_set1_pd(SBH_ATAN2_A3));
+        s2 = _mm256_mul_pd(w, _mm256_fmadd_pd(w, s2,
+                                              _mm256_set1_pd(SBH_ATAN2_A1)));
+
+        /*  atan(t), plus pi / 4 for the big lanes. fmsub gives t (s1 + s2)   *
+         *  - t with one rounding.                                            */
+        r = _mm256_fmsub_pd(t, _mm256_add_pd(s1, s2), t);
+        r = _mm256_sub_pd(
+            _mm256_and_pd(big, _mm256_set1_pd(SBH_ATAN2_PIO4_LO)), r
+        );
+        r = _mm256_add_pd(
+            _mm256_and_pd(big, _mm256_set1_pd(SBH_ATAN2_PIO4_HI)), r
+        );
+
+        /*  Reflect about pi / 4 and pi / 2.                                  */
+        reflected = _mm256_add_pd(
+            _mm256_sub_pd(_mm256_set1_pd(SBH_ATAN2_PIO2_HI), r),
+            _mm256_set1_pd(SBH_ATAN2_PIO2_LO)
+        );
+        r = _mm256_blendv_pd(r, reflected, swap);
+
+        reflected = _mm256_add_pd(
+            _mm256_sub_pd(_mm256_set1_pd(SBH_ATAN2_PI_HI), r),
+            _mm256_set1_pd(SBH_ATAN2_PI_LO)
+        );
+        r = _mm256_blendv_pd(r, reflected, negative);
+        _mm256_storeu_pd(out + k,
+                         _mm256_or_pd(r, _mm256_and_pd(sign_bit, yv)));
+
+        /*  Redo any lanes that are out of range, as in the SSE2 kernel.      */
+        if (bad)
+        {
+            double y_lane[4], x_lane[4];
+            int lane;
+
+            _mm256_storeu_pd(y_lane, yv);
+            _mm256_storeu_pd(x_lane, xv);
+
+            for (lane = 0; lane < 4; ++lane)
+                if (bad & (1 << lane))
+                    out[k + lane] = sbh_atan2(y_lane[lane], x_lane[lane]);
+        }
+    }
+
+    /*  The leftover elements are handled by the scalar kernel.               */
+    for (; k < len; ++k)
+        out[k] = sbh_atan2(y[k], x[k]);
+}
+/*  End of sbh_atan2_array_avx2.                                              */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_AVX2).                                  */
+
+/*  The AVX-512 kernel, eight lanes at a time.                                */
+#if defined(SBH_SINCOS_HAS_AVX512)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2_array_avx512                                                *
+ *  Purpose:                                                                  *
+ *      Computes atan2 of two arrays using AVX-512F instructions.             *
+ *  Arguments:                                                                *
+ *      y (const double *):                                                   *
+ *          The vertical components.                                          *
+ *      x (const double *):                                                   *
+ *          The horizontal components.                                        *
+ *      out (double *):                                                       *
+ *          The output array, out[k] = atan2(y[k], x[k]).                     *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_atan2_array_avx2, with mask registers for the selects.    *
+ ******************************************************************************/
+SBH_SINCOS_TARGET_AVX512 SBH_INLINE void
+sbh_atan2_array_avx512(const double *y, const double *x, double *out,
+                       size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const __m512d max_arg = _mm512_set1_pd(SBH_ATAN2_MAX_ARG);
+    const __m512d min_arg = _mm512_set1_pd(SBH_ATAN2_MIN_ARG);
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512i sign_bit = _mm512_castpd_si512(_mm512_set1_pd(-0.0));
+    size_t k = 0;
+
+    /*  Loop through the array eight elements at a time.                      */
+    for (; k + 8 <= len; k += 8)
+    {
+        const __m512d yv = _mm512_loadu_pd(y + k);
+        const __m512d xv = _mm512_loadu_pd(x + k);
+        const __m512d ax = _mm512_abs_pd(xv);
+        const __m512d ay = _mm512_abs_pd(yv);
+        const __m512d mn = _mm512_min_pd(ax, ay);
+        const __m512d mx = _mm512_max_pd(ay, ax);
+        const unsigned int bad = (unsigned int)(
+            _mm512_cmp_pd_mask(mn, min_arg, _CMP_GE_OQ) &
+            _mm512_cmp_pd_mask(mx, max_arg, _CMP_LE_OQ)
+        ) ^ 0xFFU;
+
+        const __mmask8 big = _mm512_cmp_pd_mask(
+            mn, _mm512_mul_pd(_mm512_set1_pd(SBH_ATAN2_TAN_PI_BY_8), mx),
+            _CMP_GT_OQ
+        );
+        const __mmask8 swap = _mm512_cmp_pd_mask(ay, ax, _CMP_GT_OQ);
+        const __mmask8 negative = _mm512_cmp_pd_mask(xv, zero, _CMP_LT_OQ);
+        __m512d t, z, w, s1, s2, r;
+
+        /*  One division for both reductions.                                 */
+        t = _mm512_div_pd(
+            _mm512_mask_blend_pd(big, mn, _mm512_sub_pd(mn, mx)),
+            _mm512_mask_blend_pd(big, mx, _mm512_add_pd(mn, mx))
+        );
+        z = _mm512_mul_pd(t, t);
+        w = _mm512_mul_pd(z, z);
+
+        /*  The polynomial.                                                   */
+        s1 = _mm512_fmadd_pd(w, _mm512_set1_pd(SBH_ATAN2_A10),
+                             _mm512_set1_pd(SBH_ATAN2_A8));
+        s1 = _mm512_fmadd_pd(w, s1, _mm512_set1_pd(SBH_ATAN2_A6));
+        s1 = _mm512_fmadd_pd(w, s1, _mm512_set1_pd(SBH_ATAN2_A4));
+        s1 = _mm512_fmadd_pd(w, s1, _mm512_set1_pd(SBH_ATAN2_A2));
+        s1 = _mm512_mul_pd(z, _mm512_fmadd_pd(w, s1,
+                                              _mm512_set1_pd(SBH_ATAN2_A0)));
+
+        s2 = _mm512_fmadd_pd(w, _mm512_set1_pd(SBH_ATAN2_A9),
+                             _mm512_set1_pd(SBH_ATAN2_A7));
+        s2 = _mm512_fmadd_pd(w, s2, _mm512_set1_pd(SBH_ATAN2_A5));
+        s2 = _mm512_fmadd_pd(w, s2, _mm512_set1_pd(SBH_ATAN2_A3));
+        s2 = _mm512_mul_pd(w, _mm512_fmadd_pd(w, s2,
+                                              _mm512_set1_pd(SBH_ATAN2_A1)));
+
+        /*  atan(t), plus pi / 4 for the big lanes.                           */
+        r = _mm512_fmsub_pd(t, _mm512_add_pd(s1, s2), t);
+        r = _mm512_sub_pd(
+            _mm512_maskz_mov_pd(big, _mm512_set1_pd(SBH_ATAN2_PIO4_LO)), r
+        );
+        r = _mm512_add_pd(
+            _mm512_maskz_mov_pd(big, _mm512_set1_pd(SBH_ATAN2_PIO4_HI)), r
+        );
+
+        /*  Reflect about pi / 4 and pi / 2, only in the masked lanes.        */
+        r = _mm512_mask_add_pd(
+            r, swap, _mm512_sub_pd(_mm512_set1_pd(SBH_ATAN2_PIO2_HI), r),
+            _mm512_set1_pd(SBH_ATAN2_PIO2_LO)
+        );
+        r = _mm512_mask_add_pd(
+            r, negative, _mm512_sub_pd(_mm512_set1_pd(SBH_ATAN2_PI_HI), r),
+            _mm512_set1_pd(SBH_ATAN2_PI_LO)
+        );
+
+        /*  Copy the sign of y. AVX-512F only has integer bitwise operations. */
+        r = _mm512_castsi512_pd(_mm512_or_si512(
+            _mm512_castpd_si512(r),
+            _mm512_and_si512(sign_bit, _mm512_castpd_si512(yv))
+        ));
+        _mm512_storeu_pd(out + k, r);
+
+        /*  Redo any lanes that are out of range, as in the SSE2 kernel.      */
+        if (bad)
+        {
+            double y_lane[8], x_lane[8];
+            int lane;
+
+            _mm512_storeu_pd(y_lane, yv);
+            _mm512_storeu_pd(x_lane, xv);
+
+            for (lane = 0; lane < 8; ++lane)
+                if (bad & (1U << lane))
+                    out[k + lane] = sbh_atan2(y_lane[lane], x_lane[lane]);
+        }
+    }
+
+    /*  The leftover elements are handled by the scalar kernel.               */
+    for (; k < len; ++k)
+        out[k] = sbh_atan2(y[k], x[k]);
+}
+/*  End of sbh_atan2_array_avx512.                                            */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_AVX512).                                */
+
+/*  The NEON kernel, two lanes at a time.                                     */
+#if defined(SBH_SINCOS_HAS_NEON)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2_array_neon                                                  *
+ *  Purpose:                                                                  *
+ *      Computes atan2 of two arrays using AArch64 NEON instructions.         *
+ *  Arguments:                                                                *
+ *      y (const double *):                                                   *
+ *          The vertical components.                                          *
+ *      x (const double *):                                                   *
+ *          The horizontal components.                                        *
+ *      out (double *):                                                       *
+ *          The output array, out[k] = atan2(y[k], x[k]).                     *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_atan2_array_avx2, with bsl for the selects.               *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_atan2_array_neon(const double *y, const double *x, double *out, size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const float64x2_t max_arg = vdupq_n_f64(SBH_ATAN2_MAX_ARG);
+    const float64x2_t min_arg = vdupq_n_f64(SBH_ATAN2_MIN_ARG);
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    const uint64x2_t sign_bit = vdupq_n_u64((uint64_t)1 << 63);
+    size_t k = 0;
+
+    /*  Loop through the array two elements at a time.                        */
+    for (; k + 2 <= len; k += 2)
+    {
+        const float64x2_t yv = vld1q_f64(y + k);
+        const float64x2_t xv = vld1q_f64(x + k);
+        const float64x2_t ax = vabsq_f64(xv);
+        const float64x2_t ay = vabsq_f64(yv);
+        const float64x2_t mn = vminq_f64(ax, ay);
+        const float64x2_t mx = vmaxq_f64(ax, ay);
+        const uint64x2_t good = vandq_u64(vcgeq_f64(mn, min_arg),
+                                          vcleq_f64(mx, max_arg));
+
+        const uint64x2_t big = vcgtq_f64(
+            mn, vmulq_f64(vdupq_n_f64(SBH_ATAN2_TAN_PI_BY_8), mx)
+        );
+        const uint64x2_t swap = vcgtq_f64(ay, ax);
+        const uint64x2_t negative = vcltq_f64(xv, zero);
+        float64x2_t t, z, w, s1, s2, r, reflected;
+
+        /*  One division for both reductions.                                 */
+        t = vdivq_f64(vbslq_f64(big, vsubq_f64(mn, mx), mn),
+                      vbslq_f64(big, vaddq_f64(mn, mx), mx));
+        z = vmulq_f64(t, t);
+        w = vmulq_f64(z, z);
+
+        /*  The polynomial. vfmaq computes a + b c.                           */
+        s1 = vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A8), w,
+                       vdupq_n_f64(SBH_ATAN2_A10));
+        s1 = vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A6), w, s1);
+        s1 = vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A4), w, s1);
+        s1 = vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A2), w, s1);
+        s1 = vmulq_f64(z, vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A0), w, s1));
+
+        s2 = vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A7), w,
+                       vdupq_n_f64(SBH_ATAN2_A9));
+        s2 = vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A5), w, s2);
+        s2 = vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A3), w, s2);
+        s2 = vmulq_f64(w, vfmaq_f64(vdupq_n_f64(SBH_ATAN2_A1), w, s2));
+
+        /*  atan(t), plus pi / 4 for the big lanes. vfmsq computes a - b c.   */
+        r = vfmsq_f64(t, t, vaddq_f64(s1, s2));
+        r = vaddq_f64(vbslq_f64(big, vdupq_n_f64(SBH_ATAN2_PIO4_HI), zero),
+                      vaddq_f64(vbslq_f64(big, vdupq_n_f64(SBH_ATAN2_PIO4_LO),
+                                          zero), r));
+
+        /*  Reflect about pi / 4 and pi / 2.                                  */
+        reflected = vaddq_f64(vsubq_f64(vdupq_n_f64(SBH_ATAN2_PIO2_HI), r),
+                              vdupq_n_f64(SBH_ATAN2_PIO2_LO));
+        r = vbslq_f64(swap, reflected, r);
+
+        reflected = vaddq_f64(vsubq_f64(vdupq_n_f64(SBH_ATAN2_PI_HI), r),
+                              vdupq_n_f64(SBH_ATAN2_PI_LO));
+        r = vbslq_f64(negative, reflected, r);
+
+        /*  Copy the sign of y.                                               */
+        vst1q_f64(out + k, vreinterpretq_f64_u64(vorrq_u64(
+            vreinterpretq_u64_f64(r),
+            vandq_u64(sign_bit, vreinterpretq_u64_f64(yv))
+        )));
+
+        /*  Redo any lanes that are out of range, as in the SSE2 kernel.      */
+        if (!vgetq_lane_u64(good, 0))
+            out[k] = sbh_atan2(vgetq_lane_f64(yv, 0), vgetq_lane_f64(xv, 0));
+
+        if (!vgetq_lane_u64(good, 1))
+            out[k + 1] = sbh_atan2(vgetq_lane_f64(yv, 1),
+                                   vgetq_lane_f64(xv, 1));
+    }
+
+    /*  The leftover element, if any, is handled by the scalar kernel.        */
+    for (; k < len; ++k)
+        out[k] = sbh_atan2(y[k], x[k]);
+}
+/*  End of sbh_atan2_array_neon.                                              */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_NEON).                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2_array_scalar                                                *
+ *  Purpose:                                                                  *
+ *      Computes atan2 of two arrays with the portable C kernel.              *
+ *  Arguments:                                                                *
+ *      y (const double *):                                                   *
+ *          The vertical components.                                          *
+ *      x (const double *):                                                   *
+ *          The horizontal components.                                        *
+ *      out (double *):                                                       *
+ *          The output array, out[k] = atan2(y[k], x[k]).                     *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_atan2_array_scalar(const double *y, const double *x, double *out,
+                       size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t k;
+
+    /*  Loop through and compute one element at a time.                       */
+    for (k = 0; k < len; ++k)
+        out[k] = sbh_atan2(y[k], x[k]);
+}
+/*  End of sbh_atan2_array_scalar.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2_array_with_kernel                                           *
+ *  Purpose:                                                                  *
+ *      Computes atan2 of two arrays with a specific kernel.                  *
+ *  Arguments:                                                                *
+ *      kernel (enum sbh_sincos_kernel):                                      *
+ *          The kernel to use, as for sbh_sincos_array_with_kernel.           *
+ *      y (const double *):                                                   *
+ *          The vertical components.                                          *
+ *      x (const double *):                                                   *
+ *          The horizontal components.                                        *
+ *      out (double *):                                                       *
+ *          The output array, out[k] = atan2(y[k], x[k]).                     *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_atan2_array_with_kernel(enum sbh_sincos_kernel kernel,
+                            const double *y,
+                            const double *x,
+                            double *out,
+                            size_t len)
+{
+    switch (kernel)
+    {
+#if defined(SBH_SINCOS_HAS_AVX512)
+        case SBH_SINCOS_KERNEL_AVX512:
+            sbh_atan2_array_avx512(y, x, out, len);
+            return;
+#endif
+
+#if defined(SBH_SINCOS_HAS_AVX2)
+        case SBH_SINCOS_KERNEL_AVX2:
+            sbh_atan2_array_avx2(y, x, out, len);
+            return;
+#endif
+
+#if defined(SBH_SINCOS_HAS_SSE2)
+        case SBH_SINCOS_KERNEL_SSE2:
+            sbh_atan2_array_sse2(y, x, out, len);
+            return;
+#endif
+
+#if defined(SBH_SINCOS_HAS_NEON)
+        case SBH_SINCOS_KERNEL_NEON:
+            sbh_atan2_array_neon(y, x, out, len);
+            return;
+#endif
+
+        default:
+            sbh_atan2_array_scalar(y, x, out, len);
+            return;
+    }
+}
+/*  End of sbh_atan2_array_with_kernel.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_atan2_array                                                       *
+ *  Purpose:                                                                  *
+ *      Computes atan2 of two arrays with the fastest available kernel.       *
+ *  Arguments:                                                                *
+ *      y (const double *):                                                   *
+ *          The vertical components.                                          *
+ *      x (const double *):                                                   *
+ *          The horizontal components.                                        *
+ *      out (double *):                                                       *
+ *          The output array, out[k] = atan2(y[k], x[k]).                     *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      The output may be one of the inputs, each lane is read before it is   *
+ *      written.                                                              *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_atan2_array(const double *y, const double *x, double *out, size_t len)
+{
+    /*  Same kernel as sbh_sincos_array, the same instructions are needed.    */
+    const enum sbh_sincos_kernel kernel = sbh_sincos_best_kernel();
+    sbh_atan2_array_with_kernel(kernel, y, x, out, len);
+}
+/*  End of sbh_atan2_array.                                                   */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,472 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a pinhole camera for a static observer, generating the       *
+ *      initial rays of a tile directly in Schwarzschild coordinates.         *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      An observer at rest at (r, phi, theta) measures lengths and times in  *
+ *      the orthonormal frame                                                 *
+ *                                                                            *
+ *          e_t = d_t / sqrt(f),        e_r = sqrt(f) d_r,                    *
+ *          e_phi = d_phi / (r sin(theta)),  e_theta = d_theta / r,           *
+ *                                                                            *
+ *      with f = 1 - 2M / r. A photon seen travelling in the unit direction   *
+ *      n of this frame has velocity e_t + n_r e_r + n_phi e_phi +            *
+ *      n_theta e_theta, which is null. The frame is identified with the      *
+ *      Cartesian axes through the usual spherical unit vectors, so the       *
+ *      camera can be aimed with Cartesian points and directions.             *
+ *                                                                            *
+ *      Everything that does not depend on the pixel, the camera axes in the  *
+ *      local frame and the scale factors above, is computed once when the    *
+ *      camera is created. A ray then costs an axpy, a normalization, and     *
+ *      four multiplies, with no trig.                                        *
+ ******************************************************************************
+ *  Conventions:                                                              *
+ *      Pixels are numbered as in sbh_render.h, (0, 0) is the top left and y  *
+ *      increases downwards. Pixel (i, j) covers [i, i + 1] x [j, j + 1] and  *
+ *      its center is (i + 0.5, j + 0.5). Rays point away from the camera,    *
+ *      into the scene.                                                       *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_CAMERA_H
+#define SBH_CAMERA_H
+
+#include "sbh_inline.h"
+#include "sbh_restrict.h"
+#include "sbh_constants.h"
+#include "sbh_vec4.h"
+#include "sbh_vec4_array.h"
+#include "sbh_geodesic.h"
+#include "sbh_render.h"
+#include <stddef.h>
+#include <math.h>
+
+/*  A pinhole camera at rest outside the horizon.                             */
+struct sbh_camera {
+
+    /*  The position of the camera in Schwarzschild coordinates.              */
+    struct sbh_vec4 position;
+
+    /*  The size of the image, in pixels.                                     */
+    size_t width, height;
+
+    /*  The camera axes in the local frame, stored in the (r, phi, theta)     *
+     *  order of struct sbh_vec4. right and up are scaled by the size of one  *
+     *  pixel on the image plane at unit distance.                            */
+    double forward[3], right[3], up[3];
+
+    /*  Maps a unit direction in the local frame to a coordinate velocity,    *
+     *  (sqrt(f), 1 / (r sin(theta)), 1 / r) for (r, phi, theta), and the     *
+     *  time component 1 / sqrt(f).                                           */
+    double scale[3], dt;
+
+    /*  The spherical unit vectors at the camera, in the same order, in       *
+     *  Cartesian coordinates.                                                */
+    struct sbh_vec4 basis[3];
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_camera_init                                                       *
+ *  Purpose:                                                                  *
+ *      Creates a camera looking at a point.                                  *
+ *  Arguments:                                                                *
+ *      camera (struct sbh_camera *):                                         *
+ *          The camera to initialize.                                         *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      position (const struct sbh_vec4 *):                                   *
+ *          The position of the camera, in Schwarzschild coordinates.         *
+ *      target (const struct sbh_vec4 *):                                     *
+ *          The point at the center of the image, in Cartesian coordinates.   *
+ *          Use (0, 0, 0, 0) to look at the black hole.                       *
+ *      up (const struct sbh_vec4 *):                                         *
+ *          A Cartesian direction that appears vertical in the image. It only *
+ *          needs to not be parallel to the line of sight.                    *
+ *      fov (double):                                                         *
+ *          The horizontal field of view, in radians, 0 < fov < pi.           *
+ *      width (size_t):                                                       *
+ *          The width of the image in pixels.                                 *
+ *      height (size_t):                                                      *
+ *          The height of the image in pixels. Pixels are square.             *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success. 0 if the camera is not outside the horizon, away    *
+ *          from the polar axis, the target is the camera position, up is     *
+ *          parallel to the line of sight, or fov or the size are invalid.    *
+ *  Method:                                                                   *
+ *      The directions are built in Cartesian coordinates, as in flat space,  *
+ *      and then projected onto the spherical unit vectors at the camera.     *
+ *      Since the camera is at rest, directions near the camera are measured  *
+ *      with respect to a frame aligned with these unit vectors.              *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_camera_init(struct sbh_camera *camera,
+                double mass,
+                const struct sbh_vec4 *position,
+                const struct sbh_vec4 *target,
+                const struct sbh_vec4 *up,
+                double fov,
+                size_t width,
+                size_t height)
+{
+    /*  Declare necessary variables.                                          */
+    const double r = position->dat[0];
+    const double sin_phi = sin(position->dat[1]);
+    const double cos_phi = cos(position->dat[1]);
+    const double sin_theta = sin(position->dat[2]);
+    const double cos_theta = cos(position->dat[2]);
+    const struct sbh_vec4 origin = sbh_vec4_schwarzschild_to_rect(position);
+    struct sbh_vec4 e[3], forward, right, vertical, line;
+    double pixel;
+    int k;
+
+    if (!(r > 2.0 * mass) || sin_theta == 0.0 || width == 0 || height == 0)
+        return 0;
+
+    if (!(fov > 0.0 && fov < SBH_PI))
+        return 0;
+
+    /*  The spherical unit vectors at the camera, ordered (r, phi, theta).    */
+    e[0] = sbh_vec4_rect(sin_theta*cos_phi, sin_theta*sin_phi, cos_theta, 0.0);
+    e[1] = sbh_vec4_rect(-sin_phi, cos_phi, 0.0, 0.0);
+    e[2] = sbh_vec4_rect(cos_theta*cos_phi, cos_theta*sin_phi, -sin_theta, 0.0);
+
+    /*  The camera axes in Cartesian coordinates.                             */
+    line = sbh_vec4_linear_combination(1.0, target, -1.0, &origin, 0.0, target);
+
+    if (sbh_vec4_spatial_dot(&line, &line) == 0.0)
+        return 0;
+
+    forward = sbh_vec4_spatial_normalize(&line);
+    right = sbh_vec4_spatial_cross(&forward, up);
+
+    if (sbh_vec4_spatial_dot(&right, &right) == 0.0)
+        return 0;
+
+    right = sbh_vec4_spatial_normalize(&right);
+    vertical = sbh_vec4_spatial_cross(&right, &forward);
+
+    /*  The width of one pixel on the image plane at unit distance.           */
+    pixel = 2.0 * tan(0.5 * fov) / (double)width;
+
+    /*  Project onto the local frame.                                         */
+    for (k = 0; k < 3; ++k)
+    {
+        camera->forward[k] = sbh_vec4_spatial_dot(&forward, e + k);
+        camera->right[k] = pixel * sbh_vec4_spatial_dot(&right, e + k);
+        camera->up[k] = pixel * sbh_vec4_spatial_dot(&vertical, e + k);
+        camera->basis[k] = e[k];
+    }
+
+    camera->position = *position;
+    camera->width = width;
+    camera->height = height;
+    camera->dt = 1.0 / sqrt(1.0 - 2.0 * mass / r);
+    camera->scale[0] = 1.0 / camera->dt;
+    camera->scale[1] = 1.0 / (r * sin_theta);
+    camera->scale[2] = 1.0 / r;
+    return 1;
+}
+/*  End of sbh_camera_init.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_camera_velocity                                                   *
+ *  Purpose:                                                                  *
+ *      Computes the initial velocity of the ray through a point of the       *
+ *      image.                                                                *
+ *  Arguments:                                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      x (double):                                                           *
+ *          The horizontal pixel coordinate, 0 <= x <= width.                 *
+ *      y (double):                                                           *
+ *          The vertical pixel coordinate, 0 <= y <= height.                  *
+ *  Outputs:                                                                  *
+ *      v (struct sbh_vec4):                                                  *
+ *          The velocity, in Schwarzschild coordinates. The photon has unit   *
+ *          energy as measured by the camera.                                 *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_camera_velocity(const struct sbh_camera *camera, double x, double y)
+{
+    /*  Declare necessary variables.                                          */
+    const double a = x - 0.5 * (double)camera->width;
+    const double b = 0.5 * (double)camera->height - y;
+    double n[3], rcpr_norm;
+    int k;
+
+    /*  The direction through the point, in the local frame.                  */
+    for (k = 0; k < 3; ++k)
+        n[k] = camera->forward[k] + a * camera->right[k] + b * camera->up[k];
+
+    rcpr_norm = 1.0 / sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+    /*  Convert from the local frame to the coordinate basis.                 */
+    return sbh_vec4_rect(
+        rcpr_norm * n[0] * camera->scale[0],
+        rcpr_norm * n[1] * camera->scale[1],
+        rcpr_norm * n[2] * camera->scale[2],
+        camera->dt
+    );
+}
+/*  End of sbh_camera_velocity.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_camera_direction                                                  *
+ *  Purpose:                                                                  *
+ *      Computes the initial direction of the ray through a point of the      *
+ *      image, in Cartesian coordinates.                                      *
+ *  Arguments:                                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      x (double):                                                           *
+ *          The horizontal pixel coordinate.                                  *
+ *      y (double):                                                           *
+ *          The vertical pixel coordinate.                                    *
+ *  Outputs:                                                                  *
+ *      d (struct sbh_vec4):                                                  *
+ *          The unit direction, with zero time component.                     *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_camera_direction(const struct sbh_camera *camera, double x, double y)
+{
+    /*  Declare necessary variables.                                          */
+    const double a = x - 0.5 * (double)camera->width;
+    const double b = 0.5 * (double)camera->height - y;
+    double n[3];
+    struct sbh_vec4 d;
+    int k;
+
+    for (k = 0; k < 3; ++k)
+        n[k] = camera->forward[k] + a * camera->right[k] + b * camera->up[k];
+
+    d = sbh_vec4_linear_combination(
+        n[0], camera->basis, n[1], camera->basis + 1, n[2], camera->basis + 2
+    );
+
+    return sbh_vec4_spatial_normalize(&d);
+}
+/*  End of sbh_camera_direction.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_camera_project                                                    *
+ *  Purpose:                                                                  *
+ *      Finds the point of the image whose ray starts in a given direction,   *
+ *      the inverse of sbh_camera_direction.                                  *
+ *  Arguments:                                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      d (const struct sbh_vec4 *):                                          *
+ *          The direction, in Cartesian coordinates. It need not be a unit    *
+ *          vector.                                                           *
+ *      x (double *):                                                         *
+ *          The horizontal pixel coordinate.                                  *
+ *      y (double *):                                                         *
+ *          The vertical pixel coordinate.                                    *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the direction is in front of the camera, 0 otherwise. The    *
+ *          point may lie outside of the image.                               *
+ *  Method:                                                                   *
+ *      The forward, right and up axes are orthogonal in the local frame, so  *
+ *      the image plane coordinates are ratios of dot products.               *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_camera_project(const struct sbh_camera *camera,
+                   const struct sbh_vec4 *d, double *x, double *y)
+{
+    /*  Declare necessary variables.                                          */
+    double n[3], depth, along, across, pixel_squared;
+    int k;
+
+    for (k = 0; k < 3; ++k)
+        n[k] = sbh_vec4_spatial_dot(d, camera->basis + k);
+
+    depth = n[0]*camera->forward[0] +
+            n[1]*camera->forward[1] +
+            n[2]*camera->forward[2];
+
+    if (!(depth > 0.0))
+        return 0;
+
+    along = n[0]*camera->right[0] + n[1]*camera->right[1] +
+            n[2]*camera->right[2];
+
+    across = n[0]*camera->up[0] + n[1]*camera->up[1] + n[2]*camera->up[2];
+
+    /*  right and up both have the length of a pixel.                         */
+    pixel_squared = camera->right[0]*camera->right[0] +
+                    camera->right[1]*camera->right[1] +
+                    camera->right[2]*camera->right[2];
+
+    *x = 0.5 * (double)camera->width + along / (pixel_squared * depth);
+    *y = 0.5 * (double)camera->height - across / (pixel_squared * depth);
+    return 1;
+}
+/*  End of sbh_camera_project.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_camera_ray                                                        *
+ *  Purpose:                                                                  *
+ *      Creates the ray through a point of the image.                         *
+ *  Arguments:                                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      x (double):                                                           *
+ *          The horizontal pixel coordinate.                                  *
+ *      y (double):                                                           *
+ *          The vertical pixel coordinate.                                    *
+ *  Outputs:                                                                  *
+ *      ray (struct sbh_geodesic):                                            *
+ *          The ray, starting at the camera.                                  *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic
+sbh_camera_ray(const struct sbh_camera *camera, double x, double y)
+{
+    const struct sbh_vec4 v = sbh_camera_velocity(camera, x, y);
+    return sbh_geodesic_create(&camera->position, &v);
+}
+/*  End of sbh_camera_ray.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_camera_tile_rays                                                  *
+ *  Purpose:                                                                  *
+ *      Creates the rays through the centers of the pixels of a tile, in      *
+ *      structure-of-arrays form.                                             *
+ *  Arguments:                                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile. It must lie inside the image.                           *
+ *      positions (struct sbh_vec4_array *):                                  *
+ *          The positions of the rays, tile->width * tile->height of them in  *
+ *          row-major order. All are the camera position.                     *
+ *      velocities (struct sbh_vec4_array *):                                 *
+ *          The velocities of the rays, in the same order.                    *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      The same as sbh_camera_velocity, written over whole rows so the       *
+ *      compiler can vectorize it. Along a row only the horizontal offset     *
+ *      changes, so the vertical part is added once per row.                  *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_camera_tile_rays(const struct sbh_camera *camera,
+                     const struct sbh_render_tile *tile,
+                     struct sbh_vec4_array *positions,
+                     struct sbh_vec4_array *velocities)
+{
+    /*  Declare necessary variables.                                          */
+    double * SBH_RESTRICT v_r = velocities->dat[0];
+    double * SBH_RESTRICT v_phi = velocities->dat[1];
+    double * SBH_RESTRICT v_theta = velocities->dat[2];
+    double * SBH_RESTRICT v_t = velocities->dat[3];
+    const double a_start = (double)tile->x + 0.5 - 0.5*(double)camera->width;
+    const size_t count = tile->width * tile->height;
+    size_t i, j, k;
+
+    for (j = 0; j < tile->height; ++j)
+    {
+        /*  The part of the direction that is the same along the row.         */
+        const double b = 0.5 * (double)camera->height -
+                         ((double)(tile->y + j) + 0.5);
+        const double row_r = camera->forward[0] + b * camera->up[0];
+        const double row_phi = camera->forward[1] + b * camera->up[1];
+        const double row_theta = camera->forward[2] + b * camera->up[2];
+        const size_t offset = j * tile->width;
+
+        for (i = 0; i < tile->width; ++i)
+        {
+            const double a = a_start + (double)i;
+            const double n_r = row_r + a * camera->right[0];
+            const double n_phi = row_phi + a * camera->right[1];
+            const double n_theta = row_theta + a * camera->right[2];
+            const double rcpr_norm =
+                1.0 / sqrt(n_r*n_r + n_phi*n_phi + n_theta*n_theta);
+
+            v_r[offset + i] = rcpr_norm * n_r * camera->scale[0];
+            v_phi[offset + i] = rcpr_norm * n_phi * camera->scale[1];
+            v_theta[offset + i] = rcpr_norm * n_theta * camera->scale[2];
+            v_t[offset + i] = camera->dt;
+        }
+    }
+
+    /*  Every ray starts at the camera.                                       */
+    for (k = 0; k < 4; ++k)
+    {
+        double * SBH_RESTRICT p = positions->dat[k];
+        const double value = camera->position.dat[k];
+
+        for (i = 0; i < count; ++i)
+            p[i] = value;
+    }
+}
+/*  End of sbh_camera_tile_rays.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_camera_tile_geodesics                                             *
+ *  Purpose:                                                                  *
+ *      Creates the rays through the centers of the pixels of a tile, as an   *
+ *      array of struct sbh_geodesic for the ray tracing engines.             *
+ *  Arguments:                                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile. It must lie inside the image.                           *
+ *      rays (struct sbh_geodesic *):                                         *
+ *          The output, tile->width * tile->height rays in row-major order.   *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_camera_tile_geodesics(const struct sbh_camera *camera,
+                          const struct sbh_render_tile *tile,
+                          struct sbh_geodesic *rays)
+{
+    /*  Declare necessary variables.                                          */
+    size_t i, j;
+
+    for (j = 0; j < tile->height; ++j)
+    {
+        const double y = (double)(tile->y + j) + 0.5;
+
+        for (i = 0; i < tile->width; ++i)
+        {
+            const double x = (double)(tile->x + i) + 0.5;
+            rays[j * tile->width + i] = sbh_camera_ray(camera, x, y);
+        }
+    }
+}
+/*  End of sbh_camera_tile_geodesics.                                         */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,41 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides mathematical constants. M_PI and friends are not part of     *
+ *      the C standard, so they cannot be relied upon.                        *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_CONSTANTS_H
+#define SBH_CONSTANTS_H
+
+/*  pi and a few of its multiples, to more digits than a double can hold.     */
+#define SBH_PI (3.14159265358979323846264338327950288419716939937510)
+#define SBH_HALF_PI (1.57079632679489661923132169163975144209858469968755)
+#define SBH_TWO_PI (6.28318530717958647692528676655900576839433879875021)
+
+/*  sqrt(27), the critical impact parameter in units of the mass.             */
+#define SBH_SQRT_27 (5.19615242270663188058233902451761710082841576143114)
+
+#endif
+/*  End of include guard.                                                     */
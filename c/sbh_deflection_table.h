@@ -0,0 +1,530 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a precomputed table of deflection angles for a static        *
+ *      observer, so rays can be traced with a lookup instead of integrating. *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      For an observer at rest at radius r_obs, a ray leaving at the angle   *
+ *      alpha from the outward radial direction, as measured by the observer, *
+ *      has impact parameter                                                  *
+ *                                                                            *
+ *          b = r_obs sin(alpha) / sqrt(1 - 2M / r_obs)                       *
+ *                                                                            *
+ *      and its path, within its plane, depends only on alpha. Given b, the   *
+ *      two possible values of alpha are the outward and inward rays. Rays    *
+ *      with alpha beyond the critical angle alpha_c, where b = 3 sqrt(3) M   *
+ *      on the inward branch, are captured. The table stores, for a grid of   *
+ *      alpha in [0, alpha_c), the final orbital angle psi and the direction  *
+ *      of the escaped ray in the plane of the orbit.                         *
+ *                                                                            *
+ *      The deflection diverges like -log(alpha_c - alpha) at the critical    *
+ *      angle, so the grid is uniform in x = -log(1 - alpha / alpha_c). In    *
+ *      this variable the angles are smooth and cubic interpolation works     *
+ *      well. Rays closer to alpha_c than the last sample are traced exactly. *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Only the angles are stored. The results have time and lambda set to   *
+ *      -1, and the initial time in position.dat[3].                          *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_DEFLECTION_TABLE_H
+#define SBH_DEFLECTION_TABLE_H
+
+#include "sbh_inline.h"
+#include "sbh_constants.h"
+#include "sbh_vec4.h"
+#include "sbh_geodesic.h"
+#include "sbh_planar.h"
+#include "sbh_ray.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*  The samples are stored in double precision, or in single precision if     *
+ *  SBH_DEFLECTION_TABLE_FLOAT is defined. Float halves the size of the       *
+ *  table, so a larger table stays in cache. The rounding error is about      *
+ *  1E-7 times the deflection, below the interpolation error of the default   *
+ *  table. Lookups are computed in double precision either way.               */
+#ifdef SBH_DEFLECTION_TABLE_FLOAT
+typedef float sbh_deflection_sample;
+#else
+typedef double sbh_deflection_sample;
+#endif
+
+/*  Parameters for building a deflection table.                               */
+struct sbh_deflection_table_params {
+
+    /*  The radius of the observer. This must be larger than 3M.              */
+    double observer_radius;
+
+    /*  The number of samples in the table. Must be at least 4.               */
+    size_t size;
+
+    /*  The table covers alpha up to alpha_c (1 - critical_gap).              */
+    double critical_gap;
+
+    /*  The planar engine parameters used to fill the table, and to trace     *
+     *  rays closer to the critical angle than the table reaches.             */
+    struct sbh_planar_params planar;
+};
+
+/*  A table of deflection angles for a static observer.                       */
+struct sbh_deflection_table {
+
+    /*  The mass of the black hole and the radius of the observer.            */
+    double mass, observer_radius;
+
+    /*  sqrt(1 - 2M / r_obs), the redshift factor of the observer.            */
+    double sqrt_f;
+
+    /*  Rays with local angle from the outward radial direction larger than   *
+     *  this are captured.                                                    */
+    double critical_angle;
+
+    /*  The grid is x_n = n dx for n = 0, 1, ..., size - 1.                   */
+    double dx;
+    size_t size;
+
+    /*  The final orbital angle of the ray, and the angle in the orbital      *
+     *  plane of its final direction, both measured from the observer.        */
+    sbh_deflection_sample *psi;
+    sbh_deflection_sample *direction;
+
+    /*  The engine parameters used to build the table.                        */
+    struct sbh_planar_params planar;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_default_params                                   *
+ *  Purpose:                                                                  *
+ *      Creates reasonable parameters for a deflection table.                 *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      observer_radius (double):                                             *
+ *          The radius of the observer.                                       *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_deflection_table_params):                          *
+ *          Parameters for a 4096 sample table. The escape radius is raised   *
+ *          to be well beyond the observer if needed, and the step is finer   *
+ *          than the default since the table is only computed once.           *
+ ******************************************************************************/
+SBH_INLINE struct sbh_deflection_table_params
+sbh_deflection_table_default_params(double mass, double observer_radius)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_deflection_table_params params;
+
+    /*  Set the defaults and return.                                          */
+    params.observer_radius = observer_radius;
+    params.size = 4096;
+    params.critical_gap = 1.0E-12;
+    params.planar = sbh_planar_default_params(mass);
+    params.planar.step = 0.001;
+
+    if (params.planar.escape_radius < 10.0 * observer_radius)
+        params.planar.escape_radius = 10.0 * observer_radius;
+
+    return params;
+}
+/*  End of sbh_deflection_table_default_params.                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_trace_angle                                      *
+ *  Purpose:                                                                  *
+ *      Traces the ray leaving a static observer at a given local angle.      *
+ *  Arguments:                                                                *
+ *      planar (const struct sbh_planar_params *):                            *
+ *          The planar engine parameters.                                     *
+ *      observer_radius (double):                                             *
+ *          The radius of the observer.                                       *
+ *      alpha (double):                                                       *
+ *          The angle from the outward radial direction, 0 <= alpha <= pi.    *
+ *      psi (double *):                                                       *
+ *          The orbital angle where the ray crosses the escape radius.        *
+ *      direction (double *):                                                 *
+ *          The angle of the final direction of travel.                       *
+ *      steps (unsigned long int *):                                          *
+ *          The number of steps taken is added to this.                       *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          The fate of the ray.                                              *
+ *  Method:                                                                   *
+ *      The static observer measures dr / dlambda = sqrt(f) cos(alpha) and    *
+ *      r dpsi / dlambda = sin(alpha), up to a common factor. Hence           *
+ *      u' = -sqrt(f) cot(alpha) / r. Integrate with sbh_planar_integrate.    *
+ ******************************************************************************/
+SBH_INLINE enum sbh_ray_status
+sbh_deflection_table_trace_angle(const struct sbh_planar_params *planar,
+                                 double observer_radius,
+                                 double alpha,
+                                 double *psi,
+                                 double *direction,
+                                 unsigned long int *steps)
+{
+    /*  Declare necessary variables.                                          */
+    const double sqrt_f = sqrt(1.0 - 2.0 * planar->mass / observer_radius);
+    const double sin_alpha = sin(alpha);
+    double u = 1.0 / observer_radius;
+    double du;
+    enum sbh_ray_status status;
+
+    /*  Radial rays go straight out, or straight in.                          */
+    *psi = 0.0;
+    *direction = 0.0;
+
+    if (sin_alpha == 0.0)
+        return (alpha < SBH_HALF_PI ? SBH_RAY_ESCAPED : SBH_RAY_CAPTURED);
+
+    du = -sqrt_f * cos(alpha) / (sin_alpha * observer_radius);
+
+    /*  Integrate the orbit equation and return the final angles.             */
+    status = sbh_planar_integrate(planar, &u, &du, psi, steps, NULL);
+    *direction = *psi + atan2(u, -du);
+
+    /*  The last step overshoots the escape radius by a varying amount. Far   *
+     *  out u is linear in psi, so move psi back to exactly the escape radius *
+     *  to make it a smooth function of alpha that can be interpolated.       */
+    if (status == SBH_RAY_ESCAPED)
+        *psi += (1.0 / planar->escape_radius - u) / du;
+
+    return status;
+}
+/*  End of sbh_deflection_table_trace_angle.                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_init                                             *
+ *  Purpose:                                                                  *
+ *      Allocates and computes a deflection table.                            *
+ *  Arguments:                                                                *
+ *      table (struct sbh_deflection_table *):                                *
+ *          The table to fill.                                                *
+ *      params (const struct sbh_deflection_table_params *):                  *
+ *          The parameters for the table.                                     *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the table was computed, and 0 if the parameters are invalid  *
+ *          or memory could not be allocated. On failure the table holds NULL *
+ *          pointers and may be passed to sbh_deflection_table_destroy.       *
+ *  Notes:                                                                    *
+ *      This traces params->size rays, so it is expensive. It is meant to be  *
+ *      done once, and then reused for every frame with the same observer.    *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_deflection_table_init(struct sbh_deflection_table *table,
+                          const struct sbh_deflection_table_params *params)
+{
+    /*  Declare necessary variables.                                          */
+    const double mass = params->planar.mass;
+    const double r_obs = params->observer_radius;
+    double sin_critical;
+    size_t n;
+
+    table->psi = NULL;
+    table->direction = NULL;
+
+    /*  The observer must be outside the photon sphere, and the cubic         *
+     *  interpolation needs at least four samples.                            */
+    if (!(r_obs > 3.0 * mass) || params->size < 4 ||
+        !(params->critical_gap > 0.0 && params->critical_gap < 1.0))
+        return 0;
+
+    table->mass = mass;
+    table->observer_radius = r_obs;
+    table->sqrt_f = sqrt(1.0 - 2.0 * mass / r_obs);
+    table->size = params->size;
+    table->planar = params->planar;
+
+    /*  The critical angle is on the inward branch, where b = 3 sqrt(3) M.    */
+    sin_critical = SBH_SQRT_27 * mass * table->sqrt_f / r_obs;
+    table->critical_angle = SBH_PI - asin(sin_critical);
+    table->dx = -log(params->critical_gap) / (double)(params->size - 1);
+
+    table->psi = (sbh_deflection_sample *)
+        malloc(sizeof(*table->psi) * params->size);
+    table->direction = (sbh_deflection_sample *)
+        malloc(sizeof(*table->direction) * params->size);
+
+    if (!table->psi || !table->direction)
+    {
+        free(table->psi);
+        free(table->direction);
+        table->psi = NULL;
+        table->direction = NULL;
+        return 0;
+    }
+
+    /*  Trace the ray for each sample on the grid.                            */
+    for (n = 0; n < params->size; ++n)
+    {
+        const double x = table->dx * (double)n;
+        const double alpha = table->critical_angle * (1.0 - exp(-x));
+        unsigned long int steps = 0UL;
+        double psi, direction;
+
+        sbh_deflection_table_trace_angle(&table->planar, r_obs, alpha,
+                                         &psi, &direction, &steps);
+
+        table->psi[n] = (sbh_deflection_sample)psi;
+        table->direction[n] = (sbh_deflection_sample)direction;
+    }
+
+    return 1;
+}
+/*  End of sbh_deflection_table_init.                                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_destroy                                          *
+ *  Purpose:                                                                  *
+ *      Frees the memory used by a deflection table.                          *
+ *  Arguments:                                                                *
+ *      table (struct sbh_deflection_table *):                                *
+ *          The table. Its pointers are set to NULL.                          *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_deflection_table_destroy(struct sbh_deflection_table *table)
+{
+    free(table->psi);
+    free(table->direction);
+    table->psi = NULL;
+    table->direction = NULL;
+}
+/*  End of sbh_deflection_table_destroy.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_interpolate                                      *
+ *  Purpose:                                                                  *
+ *      Cubic (Catmull-Rom) interpolation on the uniform grid of the table.   *
+ *  Arguments:                                                                *
+ *      y (const sbh_deflection_sample *):                                    *
+ *          The samples, either table->psi or table->direction.               *
+ *      size (size_t):                                                        *
+ *          The number of samples.                                            *
+ *      index (size_t):                                                       *
+ *          The left end of the interval, 0 <= index < size - 1.              *
+ *      t (double):                                                           *
+ *          The position inside the interval, 0 <= t <= 1.                    *
+ *  Outputs:                                                                  *
+ *      value (double):                                                       *
+ *          The interpolated value.                                           *
+ *  Method:                                                                   *
+ *      Use the four samples around the interval. At the ends of the table    *
+ *      the missing sample is extrapolated linearly.                          *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_deflection_table_interpolate(const sbh_deflection_sample *y, size_t size,
+                                 size_t index, double t)
+{
+    /*  Declare necessary variables.                                          */
+    const double y1 = (double)y[index];
+    const double y2 = (double)y[index + 1];
+    const double y0 = (index > 0 ? (double)y[index - 1] : 2.0*y1 - y2);
+    const double y3 = (index + 2 < size ? (double)y[index + 2] : 2.0*y2 - y1);
+
+    /*  The Catmull-Rom spline, evaluated with Horner's method.               */
+    const double c1 = 0.5 * (y2 - y0);
+    const double c2 = y0 - 2.5*y1 + 2.0*y2 - 0.5*y3;
+    const double c3 = 0.5 * (y3 - y0) + 1.5 * (y1 - y2);
+    return y1 + t * (c1 + t * (c2 + t * c3));
+}
+/*  End of sbh_deflection_table_interpolate.                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_lookup_angle                                     *
+ *  Purpose:                                                                  *
+ *      Finds the fate of the ray leaving the observer at a given local       *
+ *      angle from the outward radial direction.                              *
+ *  Arguments:                                                                *
+ *      table (const struct sbh_deflection_table *):                          *
+ *          The table.                                                        *
+ *      alpha (double):                                                       *
+ *          The angle from the outward radial direction, 0 <= alpha <= pi.    *
+ *      psi (double *):                                                       *
+ *          The final orbital angle. Only set for escaped rays.               *
+ *      direction (double *):                                                 *
+ *          The angle of the final direction. Only set for escaped rays.      *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          SBH_RAY_ESCAPED or SBH_RAY_CAPTURED. Rays past the end of the     *
+ *          table are traced, and may return SBH_RAY_INCOMPLETE.              *
+ ******************************************************************************/
+SBH_INLINE enum sbh_ray_status
+sbh_deflection_table_lookup_angle(const struct sbh_deflection_table *table,
+                                  double alpha, double *psi, double *direction)
+{
+    /*  Declare necessary variables.                                          */
+    double x, position, t;
+    size_t index;
+    unsigned long int steps = 0UL;
+
+    /*  Anything past the critical angle falls in.                            */
+    if (alpha >= table->critical_angle)
+        return SBH_RAY_CAPTURED;
+
+    /*  Convert to the grid variable.                                         */
+    x = -log(1.0 - alpha / table->critical_angle);
+    position = x / table->dx;
+
+    /*  Very close to the critical angle the table does not have samples.     *
+     *  These rays are rare, a thin ring in the image, so trace them.         */
+    if (position >= (double)(table->size - 1))
+        return sbh_deflection_table_trace_angle(
+            &table->planar, table->observer_radius, alpha,
+            psi, direction, &steps
+        );
+
+    /*  Interpolate between the neighboring samples.                          */
+    index = (size_t)position;
+    t = position - (double)index;
+    *psi = sbh_deflection_table_interpolate(table->psi, table->size, index, t);
+    *direction = sbh_deflection_table_interpolate(
+        table->direction, table->size, index, t
+    );
+
+    return SBH_RAY_ESCAPED;
+}
+/*  End of sbh_deflection_table_lookup_angle.                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_lookup                                           *
+ *  Purpose:                                                                  *
+ *      Finds the total deflection of a ray from its impact parameter.        *
+ *  Arguments:                                                                *
+ *      table (const struct sbh_deflection_table *):                          *
+ *          The table.                                                        *
+ *      b (double):                                                           *
+ *          The impact parameter of the ray, 0 <= b <= r_obs / sqrt(f).       *
+ *      inward (int):                                                         *
+ *          Non-zero if the ray leaves the observer heading inwards.          *
+ *      deflection (double *):                                                *
+ *          The angle between the initial and final directions of the ray,    *
+ *          measured in its plane. Only set for escaped rays.                 *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          The fate of the ray.                                              *
+ ******************************************************************************/
+SBH_INLINE enum sbh_ray_status
+sbh_deflection_table_lookup(const struct sbh_deflection_table *table,
+                            double b, int inward, double *deflection)
+{
+    /*  Declare necessary variables.                                          */
+    double sin_alpha = b * table->sqrt_f / table->observer_radius;
+    double alpha, psi, direction;
+    enum sbh_ray_status status;
+
+    /*  Impact parameters past the tangential ray are clamped to it.          */
+    if (sin_alpha > 1.0)
+        sin_alpha = 1.0;
+
+    alpha = asin(sin_alpha);
+
+    if (inward)
+        alpha = SBH_PI - alpha;
+
+    status = sbh_deflection_table_lookup_angle(table, alpha, &psi, &direction);
+
+    /*  The initial direction makes the angle alpha with e1 in the plane.     */
+    if (status == SBH_RAY_ESCAPED)
+        *deflection = direction - alpha;
+
+    return status;
+}
+/*  End of sbh_deflection_table_lookup.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_deflection_table_trace                                            *
+ *  Purpose:                                                                  *
+ *      Traces a ray starting at the observer using the table.                *
+ *  Arguments:                                                                *
+ *      table (const struct sbh_deflection_table *):                          *
+ *          The table.                                                        *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity. The position should be at the  *
+ *          radius of the observer, only its direction is used.               *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          The result, in the same form as sbh_planar_trace. Escaped rays    *
+ *          are placed on the escape radius used to build the table. The      *
+ *          position of captured rays is the initial position.                *
+ *  Method:                                                                   *
+ *      Compute the plane of the ray with sbh_planar_basis and the local      *
+ *      angle alpha from the static observer's radial and tangential speeds,  *
+ *      v_r / sqrt(f) and v_t. Look up the angles and rotate back into space. *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_result
+sbh_deflection_table_trace(const struct sbh_deflection_table *table,
+                           const struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_result result;
+    struct sbh_vec4 e1, e2, n;
+    double v_r, v_t, alpha, psi, direction;
+    int is_planar = sbh_planar_basis(ray, &e1, &e2, &n, &v_r, &v_t);
+
+    result.steps = 0UL;
+    result.rejected = 0UL;
+    result.time = -1.0;
+    result.lambda = -1.0;
+    result.position = sbh_vec4_schwarzschild_to_rect(&ray->p);
+
+    /*  Radial rays, the same as sbh_planar_trace.                            */
+    if (!is_planar)
+    {
+        const double sign = (v_r < 0.0 ? -1.0 : 1.0);
+        result.direction = sbh_vec4_linear_combination(sign, &e1, 0.0, &e1,
+                                                       0.0, &e1);
+        result.status = (v_r < 0.0 ? SBH_RAY_CAPTURED : SBH_RAY_ESCAPED);
+        return result;
+    }
+
+    alpha = atan2(v_t, v_r / table->sqrt_f);
+    result.status = sbh_deflection_table_lookup_angle(table, alpha,
+                                                      &psi, &direction);
+
+    /*  Captured rays have no meaningful final direction, keep the initial.   */
+    if (result.status != SBH_RAY_ESCAPED)
+    {
+        result.direction = sbh_planar_to_space(1.0, alpha, 0.0, &e1, &e2, &n);
+        return result;
+    }
+
+    result.position = sbh_planar_to_space(table->planar.escape_radius, psi,
+                                          ray->p.dat[3], &e1, &e2, &n);
+    result.direction = sbh_planar_to_space(1.0, direction, 0.0, &e1, &e2, &n);
+    return result;
+}
+/*  End of sbh_deflection_table_trace.                                        */
+
+#endif
+/*  End of include guard.                                                     */
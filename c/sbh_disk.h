@@ -0,0 +1,367 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a thin accretion disk in the equatorial plane, and an        *
+ *      integrator that stops rays where they hit it.                         *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The disk lies in the plane theta = pi / 2 between an inner and an     *
+ *      outer radius. After each accepted step the sign of cos(theta) is      *
+ *      compared with its sign before the step. This costs one cos per step,  *
+ *      next to the six derivative evaluations of a DP45 step. Only when the  *
+ *      sign changes is the crossing point located accurately, by stepping    *
+ *      from the start of the step with RK4 to the affine parameter where     *
+ *      cos(theta) = 0, estimated first by linear interpolation and then by   *
+ *      Newton's method.                                                      *
+ *                                                                            *
+ *      The disk gas moves on circular Keplerian orbits, with angular         *
+ *      velocity Omega = sqrt(M / r^3) and u^t = 1 / sqrt(1 - 3M / r). For    *
+ *      a photon with energy E = -p_t and angular momentum L = p_phi, the     *
+ *      ratio of observed to emitted frequency is                             *
+ *                                                                            *
+ *          g = 1 / (sqrt(f_obs) u^t (1 - Omega L / E))                       *
+ *                                                                            *
+ *      where the observer is at rest at radius r_obs and f_obs is            *
+ *      1 - 2M / r_obs. This includes both the Doppler and the gravitational  *
+ *      shift. Traced rays run backwards in time, from the camera to the      *
+ *      disk, so the photon's L is minus that of the traced ray, while E is   *
+ *      the same.                                                             *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_DISK_H
+#define SBH_DISK_H
+
+#include "sbh_inline.h"
+#include "sbh_vec4.h"
+#include "sbh_geodesic.h"
+#include "sbh_ray.h"
+#include <math.h>
+
+/*  A thin disk in the equatorial plane.                                      */
+struct sbh_disk {
+
+    /*  The disk covers inner_radius <= r <= outer_radius. Circular orbits    *
+     *  only exist for r > 3M, so inner_radius must be larger than that.      */
+    double inner_radius, outer_radius;
+};
+
+/*  Where and how a ray hit the disk.                                         */
+struct sbh_disk_hit {
+
+    /*  The position of the hit, in the plane theta = pi / 2.                 */
+    double radius, phi;
+
+    /*  The ratio of observed to emitted frequency, see above.                */
+    double redshift;
+
+    /*  The affine parameter at the hit.                                      */
+    double lambda;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_disk_create                                                       *
+ *  Purpose:                                                                  *
+ *      Creates a disk from its inner and outer radii.                        *
+ *  Arguments:                                                                *
+ *      inner_radius (double):                                                *
+ *          The inner edge of the disk, larger than 3M.                       *
+ *      outer_radius (double):                                                *
+ *          The outer edge of the disk.                                       *
+ *  Outputs:                                                                  *
+ *      disk (struct sbh_disk):                                               *
+ *          The disk.                                                         *
+ ******************************************************************************/
+SBH_INLINE struct sbh_disk
+sbh_disk_create(double inner_radius, double outer_radius)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_disk disk;
+
+    disk.inner_radius = inner_radius;
+    disk.outer_radius = outer_radius;
+    return disk;
+}
+/*  End of sbh_disk_create.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_disk_default                                                      *
+ *  Purpose:                                                                  *
+ *      Creates a disk from the innermost stable circular orbit out to 20M.   *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *  Outputs:                                                                  *
+ *      disk (struct sbh_disk):                                               *
+ *          The disk, 6M <= r <= 20M.                                         *
+ ******************************************************************************/
+SBH_INLINE struct sbh_disk sbh_disk_default(double mass)
+{
+    return sbh_disk_create(6.0 * mass, 20.0 * mass);
+}
+/*  End of sbh_disk_default.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_disk_redshift                                                     *
+ *  Purpose:                                                                  *
+ *      Computes the redshift factor of light emitted by the disk.            *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The traced ray at the point where it meets the disk.              *
+ *      observer_radius (double):                                             *
+ *          The radius of the observer, who is at rest.                       *
+ *  Outputs:                                                                  *
+ *      g (double):                                                           *
+ *          The ratio of observed to emitted frequency. Larger than 1 is a    *
+ *          blueshift. Zero if there are no circular orbits at the radius.    *
+ *  Method:                                                                   *
+ *      E = f dt / dlambda and L = r^2 sin^2(theta) dphi / dlambda for the    *
+ *      traced ray. Use the formula above with L replaced by -L.              *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_disk_redshift(double mass, const struct sbh_geodesic *ray,
+                  double observer_radius)
+{
+    /*  Declare necessary variables.                                          */
+    const double r = ray->p.dat[0];
+    const double sin_theta = sin(ray->p.dat[2]);
+    const double energy = (1.0 - 2.0 * mass / r) * ray->v.dat[3];
+    const double momentum = r * r * sin_theta * sin_theta * ray->v.dat[1];
+    const double sqrt_f_obs = sqrt(1.0 - 2.0 * mass / observer_radius);
+    double omega, rcpr_u_t;
+
+    /*  Inside the photon sphere the gas cannot orbit at all.                 */
+    if (!(r > 3.0 * mass))
+        return 0.0;
+
+    omega = sqrt(mass / (r * r * r));
+    rcpr_u_t = sqrt(1.0 - 3.0 * mass / r);
+    return rcpr_u_t / (sqrt_f_obs * (1.0 + omega * momentum / energy));
+}
+/*  End of sbh_disk_redshift.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_disk_locate_crossing                                              *
+ *  Purpose:                                                                  *
+ *      Finds where a step crossed the equatorial plane.                      *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The state at the start of the step. On output, the state at the   *
+ *          crossing.                                                         *
+ *      cos_start (double):                                                   *
+ *          cos(theta) at the start of the step.                              *
+ *      cos_end (double):                                                     *
+ *          cos(theta) at the end, of opposite sign.                          *
+ *      step (double):                                                        *
+ *          The size of the step.                                             *
+ *  Outputs:                                                                  *
+ *      lambda (double):                                                      *
+ *          The affine parameter of the crossing, from the start of the step. *
+ *  Method:                                                                   *
+ *      Step with RK4 to the linear estimate of the crossing, then take two   *
+ *      Newton corrections using d cos(theta) / dlambda = -sin(theta) theta'. *
+ *      Steps are small near the disk, so this is accurate to roughly the     *
+ *      tolerance of the integrator.                                          *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_disk_locate_crossing(double mass, struct sbh_geodesic *ray,
+                         double cos_start, double cos_end, double step)
+{
+    /*  Declare necessary variables.                                          */
+    double lambda = step * cos_start / (cos_start - cos_end);
+    int n;
+
+    sbh_geodesic_rk4_step(mass, ray, lambda);
+
+    for (n = 0; n < 2; ++n)
+    {
+        const double theta = ray->p.dat[2];
+        const double slope = -sin(theta) * ray->v.dat[2];
+        double correction;
+
+        if (slope == 0.0)
+            break;
+
+        correction = -cos(theta) / slope;
+        sbh_geodesic_rk4_step(mass, ray, correction);
+        lambda += correction;
+    }
+
+    return lambda;
+}
+/*  End of sbh_disk_locate_crossing.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_disk_integrate                                                    *
+ *  Purpose:                                                                  *
+ *      Integrates a ray until it hits the disk, is captured, or escapes.     *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      disk (const struct sbh_disk *):                                       *
+ *          The disk.                                                         *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray. On output it holds the final state, which is on the disk *
+ *          if it was hit.                                                    *
+ *      hit (struct sbh_disk_hit *):                                          *
+ *          Set if the disk was hit. The redshift is for an observer at rest  *
+ *          at the initial position of the ray.                               *
+ *      steps (unsigned long int *):                                          *
+ *          The number of steps taken.                                        *
+ *      rejected (unsigned long int *):                                       *
+ *          The number of those steps that were rejected, see sbh_stats.h.    *
+ *      lambda (double *):                                                    *
+ *          The affine parameter of the final state.                          *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          SBH_RAY_DISK if the disk was hit, otherwise as for                *
+ *          sbh_geodesic_status on the final state.                           *
+ *  Notes:                                                                    *
+ *      The disk is opaque, only the first hit counts. A step that crosses    *
+ *      the plane twice is not detected, but this needs the ray to turn by    *
+ *      about pi within one step, which the step control prevents.            *
+ ******************************************************************************/
+SBH_INLINE enum sbh_ray_status
+sbh_disk_integrate(const struct sbh_geodesic_params *params,
+                   const struct sbh_disk *disk,
+                   struct sbh_geodesic *ray,
+                   struct sbh_disk_hit *hit,
+                   unsigned long int *steps,
+                   unsigned long int *rejected,
+                   double *lambda)
+{
+    /*  Declare necessary variables.                                          */
+    const double observer_radius = ray->p.dat[0];
+    struct sbh_geodesic_stepper stepper;
+    enum sbh_ray_status status = sbh_geodesic_status(params, ray);
+    double cos_theta = cos(ray->p.dat[2]);
+
+    *steps = 0UL;
+    *rejected = 0UL;
+    *lambda = 0.0;
+
+    if (status != SBH_RAY_INCOMPLETE)
+        return status;
+
+    stepper = sbh_geodesic_stepper_create(params, ray);
+
+    while (status == SBH_RAY_INCOMPLETE)
+    {
+        const struct sbh_geodesic start = *ray;
+        const double lambda_start = stepper.lambda;
+        const double cos_start = cos_theta;
+
+        if (!sbh_geodesic_advance(params, &stepper, ray))
+            break;
+
+        /*  The stepper already has cos(theta) for the new state.             */
+        status = sbh_geodesic_status(params, ray);
+        cos_theta = stepper.trig.cos_theta;
+
+        /*  No sign change, the step stayed on one side of the plane.         */
+        if ((cos_start < 0.0) == (cos_theta < 0.0))
+            continue;
+
+        /*  Locate the crossing from the start of the step, using a copy so   *
+         *  that the integration continues unchanged if the disk is missed.   */
+        {
+            struct sbh_geodesic crossing = start;
+            const double offset =
+                sbh_disk_locate_crossing(params->mass, &crossing, cos_start,
+                                         cos_theta, stepper.lambda -
+                                         lambda_start);
+            const double r = crossing.p.dat[0];
+
+            if (r < disk->inner_radius || r > disk->outer_radius)
+                continue;
+
+            hit->radius = r;
+            hit->phi = crossing.p.dat[1];
+            hit->lambda = lambda_start + offset;
+            hit->redshift = sbh_disk_redshift(params->mass, &crossing,
+                                              observer_radius);
+            *ray = crossing;
+            status = SBH_RAY_DISK;
+        }
+    }
+
+    *steps = stepper.steps;
+    *rejected = stepper.rejected;
+    *lambda = (status == SBH_RAY_DISK ? hit->lambda : stepper.lambda);
+    return status;
+}
+/*  End of sbh_disk_integrate.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_disk_trace                                                        *
+ *  Purpose:                                                                  *
+ *      Traces a light ray against the disk with the full geodesic equations. *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      disk (const struct sbh_disk *):                                       *
+ *          The disk.                                                         *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity of the ray.                     *
+ *      hit (struct sbh_disk_hit *):                                          *
+ *          Set if the disk was hit.                                          *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          As for sbh_geodesic_trace, with status SBH_RAY_DISK and the       *
+ *          position of the hit if the disk was hit.                          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_result
+sbh_disk_trace(const struct sbh_geodesic_params *params,
+               const struct sbh_disk *disk,
+               const struct sbh_geodesic *ray,
+               struct sbh_disk_hit *hit)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_result result;
+    struct sbh_geodesic state = *ray;
+    struct sbh_vec4 velocity;
+
+    /*  Integrate, then convert the final state to Cartesian coordinates.     */
+    result.status = sbh_disk_integrate(params, disk, &state, hit,
+                                       &result.steps, &result.rejected,
+                                       &result.lambda);
+    result.time = state.p.dat[3] - ray->p.dat[3];
+    result.position = sbh_vec4_schwarzschild_to_rect(&state.p);
+    velocity = sbh_vec4_rect_velocity_from_schwarzschild(&state.p, &state.v);
+    result.direction = sbh_vec4_spatial_normalize(&velocity);
+    return result;
+}
+/*  End of sbh_disk_trace.                                                    */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,765 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides distributed frame rendering over MPI. A coordinator hands    *
+ *      chunks of the frame to worker processes, which render them with the   *
+ *      tile pool of sbh_render.h and send the pixels back.                   *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The frame is split into chunks, larger than the tiles of the thread   *
+ *      pool. Rank 0 is the coordinator and every other rank is a worker.     *
+ *      Each worker is given one chunk. When it returns the pixels it is      *
+ *      given the next chunk not yet started, until none are left. Chunks     *
+ *      near the photon ring take many times longer than open sky, and with   *
+ *      this self-scheduling a slow chunk only delays the worker holding it,  *
+ *      never a queue of chunks behind it.                                    *
+ *                                                                            *
+ *      The chunks are handed out in order of decreasing cost if a cost is    *
+ *      given, and in row-major order otherwise. The time each chunk took is  *
+ *      returned, so a sequence can order each frame by the times of the      *
+ *      last, starting the expensive chunks first so that none is left for    *
+ *      the very end.                                                         *
+ *                                                                            *
+ *      Within a worker a chunk is a frame of its own for sbh_render_frame,   *
+ *      so the tiles of the chunk are shared by the threads of the node,      *
+ *      which are balanced by work stealing.                                  *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Define SBH_MPI and build with an MPI compiler wrapper, such as mpicc, *
+ *      to enable MPI. The caller initializes and finalizes MPI. Without      *
+ *      SBH_MPI, or with a single rank, every chunk is rendered by the        *
+ *      calling process. The coordinator only schedules and copies pixels,    *
+ *      so it may share a node with a worker.                                 *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_DISTRIBUTED_H
+#define SBH_DISTRIBUTED_H
+
+#include "sbh_inline.h"
+#include "sbh_render.h"
+#include "sbh_stats.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*  1 if MPI is used, 0 otherwise. Use with #if.                              */
+#if defined(SBH_MPI)
+#define SBH_DISTRIBUTED_HAS_MPI 1
+#include <mpi.h>
+#else
+#define SBH_DISTRIBUTED_HAS_MPI 0
+#endif
+
+/*  The message tags. A chunk index sent to a worker, and the index and time  *
+ *  of a finished chunk followed by its pixels, sent back.                    */
+#define SBH_DISTRIBUTED_TAG_WORK (1)
+#define SBH_DISTRIBUTED_TAG_DONE (2)
+#define SBH_DISTRIBUTED_TAG_PIXELS (3)
+
+/*  Parameters for a distributed frame.                                       */
+struct sbh_distributed_params {
+
+    /*  The size of the frame, and the tiles and threads used on each node    *
+     *  to render a chunk. The stats member is not used.                      */
+    struct sbh_render_params render;
+
+    /*  The size of a chunk, the unit of work handed to a node. The chunks    *
+     *  on the right and bottom edges are cropped.                            */
+    size_t chunk_width, chunk_height;
+
+    /*  The size in bytes of a pixel of the frame.                            */
+    size_t pixel_size;
+
+#if SBH_DISTRIBUTED_HAS_MPI
+    /*  The ranks taking part. Rank 0 of it is the coordinator.               */
+    MPI_Comm comm;
+#endif
+};
+
+/*  The pixels of a chunk, as seen by the callback.                           */
+struct sbh_distributed_chunk {
+
+    /*  The pixels covered, in frame coordinates, and the chunk index.        */
+    struct sbh_render_tile area;
+
+    /*  The pixel (area.x, area.y), the bytes between the starts of two rows, *
+     *  and the size of a pixel. On a worker node these are in a buffer for   *
+     *  the chunk, otherwise they are in the frame itself.                    */
+    unsigned char *pixels;
+    size_t stride, pixel_size;
+};
+
+/*  Renders the pixels of a tile into a chunk. The tile is one row of a tile  *
+ *  of the pool, in frame coordinates and inside chunk->area. thread and data *
+ *  are as for sbh_render_tile_callback. Use sbh_distributed_pixel to find    *
+ *  the pixels.                                                               */
+typedef void
+(*sbh_distributed_callback)(const struct sbh_render_tile *tile,
+                            unsigned int thread,
+                            const struct sbh_distributed_chunk *chunk,
+                            void *data);
+
+/*  The argument of the tile callback that renders a chunk, see               *
+ *  sbh_distributed_render_chunk.                                             */
+struct sbh_distributed_pass {
+    const struct sbh_distributed_chunk *chunk;
+    sbh_distributed_callback callback;
+    void *data;
+
+    /*  The progress counters of the render, or NULL.                         */
+    struct sbh_progress *progress;
+};
+
+/*  The order chunks are handed out in.                                       */
+struct sbh_distributed_order {
+    double cost;
+    size_t index;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_default_params                                        *
+ *  Purpose:                                                                  *
+ *      Creates reasonable parameters for a distributed frame.                *
+ *  Arguments:                                                                *
+ *      width (size_t):                                                       *
+ *          The width of the frame.                                           *
+ *      height (size_t):                                                      *
+ *          The height of the frame.                                          *
+ *      pixel_size (size_t):                                                  *
+ *          The size in bytes of a pixel.                                     *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_distributed_params):                               *
+ *          128x64 chunks of 16x16 tiles, one thread per processor on each    *
+ *          node, and MPI_COMM_WORLD if MPI is used.                          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_distributed_params
+sbh_distributed_default_params(size_t width, size_t height, size_t pixel_size)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_distributed_params params;
+
+    /*  Set the defaults and return.                                          */
+    params.render = sbh_render_default_params(width, height);
+    params.chunk_width = 128;
+    params.chunk_height = 64;
+    params.pixel_size = pixel_size;
+
+#if SBH_DISTRIBUTED_HAS_MPI
+    params.comm = MPI_COMM_WORLD;
+#endif
+
+    return params;
+}
+/*  End of sbh_distributed_default_params.                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_chunk_params                                          *
+ *  Purpose:                                                                  *
+ *      Returns render parameters whose tiles are the chunks of a frame.      *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_distributed_params *):                       *
+ *          The parameters of the frame.                                      *
+ *  Outputs:                                                                  *
+ *      chunks (struct sbh_render_params):                                    *
+ *          Parameters for sbh_render_tile_count and sbh_render_get_tile,     *
+ *          which number the chunks and find their pixels.                    *
+ ******************************************************************************/
+SBH_INLINE struct sbh_render_params
+sbh_distributed_chunk_params(const struct sbh_distributed_params *params)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_render_params chunks = params->render;
+
+    chunks.tile_width = params->chunk_width;
+    chunks.tile_height = params->chunk_height;
+    chunks.stats = NULL;
+    return chunks;
+}
+/*  End of sbh_distributed_chunk_params.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_chunk_count                                           *
+ *  Purpose:                                                                  *
+ *      Computes the number of chunks in a frame.                             *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_distributed_params *):                       *
+ *          The parameters of the frame. The chunk sizes must be positive.    *
+ *  Outputs:                                                                  *
+ *      count (size_t):                                                       *
+ *          The number of chunks, the length of the cost and seconds arrays   *
+ *          of sbh_distributed_frame.                                         *
+ ******************************************************************************/
+SBH_INLINE size_t
+sbh_distributed_chunk_count(const struct sbh_distributed_params *params)
+{
+    const struct sbh_render_params chunks =
+        sbh_distributed_chunk_params(params);
+
+    return sbh_render_tile_count(&chunks);
+}
+/*  End of sbh_distributed_chunk_count.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_pixel                                                 *
+ *  Purpose:                                                                  *
+ *      Finds a pixel of a chunk.                                             *
+ *  Arguments:                                                                *
+ *      chunk (const struct sbh_distributed_chunk *):                         *
+ *          The chunk.                                                        *
+ *      x (size_t):                                                           *
+ *          The column of the pixel in the frame, inside the chunk.           *
+ *      y (size_t):                                                           *
+ *          The row of the pixel in the frame, inside the chunk.              *
+ *  Outputs:                                                                  *
+ *      pixel (void *):                                                       *
+ *          The first of the pixel_size bytes of the pixel.                   *
+ ******************************************************************************/
+SBH_INLINE void *
+sbh_distributed_pixel(const struct sbh_distributed_chunk *chunk,
+                      size_t x, size_t y)
+{
+    return chunk->pixels + (y - chunk->area.y) * chunk->stride +
+           (x - chunk->area.x) * chunk->pixel_size;
+}
+/*  End of sbh_distributed_pixel.                                             */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_chunk_tile                                            *
+ *  Purpose:                                                                  *
+ *      The tile callback that renders the tiles of a chunk.                  *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile, relative to the top left of the chunk.                  *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The pass, a struct sbh_distributed_pass.                          *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      The callback is given the tile one row at a time. The cancel flag is  *
+ *      checked before each row, and the pixels of a row are counted as rays  *
+ *      once it is drawn, since the library cannot see into the callback.     *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_distributed_chunk_tile(const struct sbh_render_tile *tile,
+                           unsigned int thread,
+                           void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_distributed_pass *pass =
+        (const struct sbh_distributed_pass *)data;
+    struct sbh_render_tile row = *tile;
+    size_t j;
+
+    /*  Move the tile to frame coordinates.                                   */
+    row.x += pass->chunk->area.x;
+    row.height = 1;
+
+    for (j = 0; j < tile->height; ++j)
+    {
+        if (sbh_progress_cancelled(pass->progress))
+            return;
+
+        row.y = pass->chunk->area.y + tile->y + j;
+        pass->callback(&row, thread, pass->chunk, pass->data);
+        sbh_progress_add_rays(pass->progress, (unsigned long)tile->width);
+    }
+}
+/*  End of sbh_distributed_chunk_tile.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_render_chunk                                          *
+ *  Purpose:                                                                  *
+ *      Renders one chunk with the threads of this process.                   *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_distributed_params *):                       *
+ *          The parameters of the frame.                                      *
+ *      chunk (const struct sbh_distributed_chunk *):                         *
+ *          The chunk, with its area and pixels set.                          *
+ *      callback (sbh_distributed_callback):                                  *
+ *          Renders a tile of the chunk.                                      *
+ *      data (void *):                                                        *
+ *          Passed to the callback.                                           *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          The return value of sbh_render_frame.                             *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_distributed_render_chunk(const struct sbh_distributed_params *params,
+                             const struct sbh_distributed_chunk *chunk,
+                             sbh_distributed_callback callback,
+                             void *data)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_render_params local = params->render;
+    struct sbh_distributed_pass pass;
+
+    local.width = chunk->area.width;
+    local.height = chunk->area.height;
+    local.stats = NULL;
+    pass.chunk = chunk;
+    pass.callback = callback;
+    pass.data = data;
+    pass.progress = local.progress;
+    return sbh_render_frame(&local, sbh_distributed_chunk_tile, &pass);
+}
+/*  End of sbh_distributed_render_chunk.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_order_compare                                         *
+ *  Purpose:                                                                  *
+ *      Compares chunks for qsort, by decreasing cost, then by index.         *
+ *  Arguments:                                                                *
+ *      a (const void *):                                                     *
+ *          A struct sbh_distributed_order.                                   *
+ *      b (const void *):                                                     *
+ *          Another struct sbh_distributed_order.                             *
+ *  Outputs:                                                                  *
+ *      sign (int):                                                           *
+ *          Negative if a is handed out first, positive if b is.              *
+ ******************************************************************************/
+SBH_INLINE int sbh_distributed_order_compare(const void *a, const void *b)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_distributed_order *p =
+        (const struct sbh_distributed_order *)a;
+    const struct sbh_distributed_order *q =
+        (const struct sbh_distributed_order *)b;
+
+    if (p->cost != q->cost)
+        return (p->cost > q->cost ? -1 : 1);
+
+    return (p->index < q->index ? -1 : (p->index > q->index ? 1 : 0));
+}
+/*  End of sbh_distributed_order_compare.                                     */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_order_create                                          *
+ *  Purpose:                                                                  *
+ *      Computes the order the chunks are handed out in.                      *
+ *  Arguments:                                                                *
+ *      cost (const double *):                                                *
+ *          The estimated cost of each chunk, or NULL.                        *
+ *      count (size_t):                                                       *
+ *          The number of chunks.                                             *
+ *  Outputs:                                                                  *
+ *      order (struct sbh_distributed_order *):                               *
+ *          The chunks, most expensive first, or in row-major order if cost   *
+ *          is NULL. NULL if memory could not be allocated. Free with free.   *
+ ******************************************************************************/
+SBH_INLINE struct sbh_distributed_order *
+sbh_distributed_order_create(const double *cost, size_t count)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_distributed_order *order = (struct sbh_distributed_order *)
+        malloc(sizeof(*order) * (count + 1));
+    size_t n;
+
+    if (!order)
+        return NULL;
+
+    for (n = 0; n < count; ++n)
+    {
+        order[n].cost = (cost ? cost[n] : 0.0);
+        order[n].index = n;
+    }
+
+    if (cost)
+        qsort(order, count, sizeof(*order), sbh_distributed_order_compare);
+
+    return order;
+}
+/*  End of sbh_distributed_order_create.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_frame_local                                           *
+ *  Purpose:                                                                  *
+ *      Renders every chunk of a frame on this process.                       *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_distributed_params *):                       *
+ *          The parameters of the frame.                                      *
+ *      order (const struct sbh_distributed_order *):                         *
+ *          The order to render the chunks in.                                *
+ *      callback (sbh_distributed_callback):                                  *
+ *          Renders a tile.                                                   *
+ *      data (void *):                                                        *
+ *          Passed to the callback.                                           *
+ *      frame (void *):                                                       *
+ *          The frame, written in place.                                      *
+ *      seconds (double *):                                                   *
+ *          Set to the time taken by each chunk, or NULL.                     *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if every chunk was rendered, 0 otherwise.                       *
+ *  Notes:                                                                    *
+ *      The callback writes to the frame directly, nothing is copied.         *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_distributed_frame_local(const struct sbh_distributed_params *params,
+                            const struct sbh_distributed_order *order,
+                            sbh_distributed_callback callback,
+                            void *data,
+                            void *frame,
+                            double *seconds)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_render_params chunks =
+        sbh_distributed_chunk_params(params);
+    const size_t count = sbh_render_tile_count(&chunks);
+    struct sbh_distributed_chunk chunk;
+    size_t n;
+    int success = 1;
+
+    chunk.stride = params->render.width * params->pixel_size;
+    chunk.pixel_size = params->pixel_size;
+
+    for (n = 0; n < count; ++n)
+    {
+        const double start = sbh_stats_seconds();
+
+        chunk.area = sbh_render_get_tile(&chunks, order[n].index);
+        chunk.pixels = (unsigned char *)frame + chunk.area.y * chunk.stride +
+                       chunk.area.x * chunk.pixel_size;
+
+        success = sbh_distributed_render_chunk(params, &chunk,
+                                               callback, data) && success;
+
+        if (seconds)
+            seconds[chunk.area.index] = sbh_stats_seconds() - start;
+    }
+
+    return success;
+}
+/*  End of sbh_distributed_frame_local.                                       */
+
+#if SBH_DISTRIBUTED_HAS_MPI
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_coordinate                                            *
+ *  Purpose:                                                                  *
+ *      The main loop of the coordinator, rank 0.                             *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_distributed_params *):                       *
+ *          The parameters of the frame.                                      *
+ *      order (const struct sbh_distributed_order *):                         *
+ *          The order to hand the chunks out in.                              *
+ *      ranks (int):                                                          *
+ *          The number of ranks, at least 2.                                  *
+ *      buffer (unsigned char *):                                             *
+ *          Space for the pixels of one chunk.                                *
+ *      frame (void *):                                                       *
+ *          The frame, written in place.                                      *
+ *      seconds (double *):                                                   *
+ *          Set to the time taken by each chunk, or NULL.                     *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if every chunk was rendered, 0 if a worker reported a failure.  *
+ *  Method:                                                                   *
+ *      Send each worker its first chunk, or the stop value, the chunk count, *
+ *      if there are more workers than chunks. Then wait for any worker to    *
+ *      finish, copy its pixels into the frame, and send it the next chunk,   *
+ *      or the stop value once every chunk is started.                        *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_distributed_coordinate(const struct sbh_distributed_params *params,
+                           const struct sbh_distributed_order *order,
+                           int ranks,
+                           unsigned char *buffer,
+                           void *frame,
+                           double *seconds)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_render_params chunks =
+        sbh_distributed_chunk_params(params);
+    const unsigned long int count =
+        (unsigned long int)sbh_render_tile_count(&chunks);
+    const size_t stride = params->render.width * params->pixel_size;
+    unsigned long int next = 0UL;
+    unsigned long int message;
+    int rank, active = 0;
+    int success = 1;
+
+    for (rank = 1; rank < ranks; ++rank)
+    {
+        message = (next < count ? (unsigned long int)order[next].index : count);
+
+        if (next < count)
+        {
+            ++next;
+            ++active;
+        }
+
+        MPI_Send(&message, 1, MPI_UNSIGNED_LONG, rank,
+                 SBH_DISTRIBUTED_TAG_WORK, params->comm);
+    }
+
+    while (active > 0)
+    {
+        /*  The index and time of a finished chunk, -1 if it failed.          */
+        double done[2];
+        struct sbh_render_tile area;
+        MPI_Status status;
+        size_t row;
+
+        MPI_Recv(done, 2, MPI_DOUBLE, MPI_ANY_SOURCE,
+                 SBH_DISTRIBUTED_TAG_DONE, params->comm, &status);
+
+        rank = status.MPI_SOURCE;
+        area = sbh_render_get_tile(&chunks, (size_t)done[0]);
+
+        MPI_Recv(buffer, (int)(area.width * area.height * params->pixel_size),
+                 MPI_BYTE, rank, SBH_DISTRIBUTED_TAG_PIXELS, params->comm,
+                 &status);
+
+        /*  Copy the rows of the chunk into their place in the frame.         */
+        for (row = 0; row < area.height; ++row)
+            memcpy((unsigned char *)frame + (area.y + row) * stride +
+                   area.x * params->pixel_size,
+                   buffer + row * area.width * params->pixel_size,
+                   area.width * params->pixel_size);
+
+        if (done[1] < 0.0)
+            success = 0;
+
+        if (seconds)
+            seconds[area.index] = done[1];
+
+        /*  Hand out the next chunk, or tell the worker to stop.              */
+        if (next < count)
+        {
+            message = (unsigned long int)order[next].index;
+            ++next;
+        }
+        else
+        {
+            message = count;
+            --active;
+        }
+
+        MPI_Send(&message, 1, MPI_UNSIGNED_LONG, rank,
+                 SBH_DISTRIBUTED_TAG_WORK, params->comm);
+    }
+
+    return success;
+}
+/*  End of sbh_distributed_coordinate.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_work                                                  *
+ *  Purpose:                                                                  *
+ *      The main loop of a worker, any rank but 0.                            *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_distributed_params *):                       *
+ *          The parameters of the frame.                                      *
+ *      callback (sbh_distributed_callback):                                  *
+ *          Renders a tile.                                                   *
+ *      data (void *):                                                        *
+ *          Passed to the callback.                                           *
+ *      buffer (unsigned char *):                                             *
+ *          Space for the pixels of one chunk.                                *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if every chunk given to this worker was rendered.               *
+ *  Method:                                                                   *
+ *      Receive a chunk index, render the chunk into the buffer with the      *
+ *      threads of this process, and send back its index, its time, and its   *
+ *      pixels. Stop on receiving the chunk count.                            *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_distributed_work(const struct sbh_distributed_params *params,
+                     sbh_distributed_callback callback,
+                     void *data,
+                     unsigned char *buffer)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_render_params chunks =
+        sbh_distributed_chunk_params(params);
+    const unsigned long int count =
+        (unsigned long int)sbh_render_tile_count(&chunks);
+    struct sbh_distributed_chunk chunk;
+    int success = 1;
+
+    chunk.pixels = buffer;
+    chunk.pixel_size = params->pixel_size;
+
+    for (;;)
+    {
+        unsigned long int message;
+        double done[2], start;
+        MPI_Status status;
+
+        MPI_Recv(&message, 1, MPI_UNSIGNED_LONG, 0,
+                 SBH_DISTRIBUTED_TAG_WORK, params->comm, &status);
+
+        if (message >= count)
+            break;
+
+        /*  The chunk buffer packs the rows of the chunk with no gaps.        */
+        chunk.area = sbh_render_get_tile(&chunks, (size_t)message);
+        chunk.stride = chunk.area.width * chunk.pixel_size;
+        start = sbh_stats_seconds();
+
+        if (sbh_distributed_render_chunk(params, &chunk, callback, data))
+            done[1] = sbh_stats_seconds() - start;
+        else
+        {
+            done[1] = -1.0;
+            success = 0;
+        }
+
+        done[0] = (double)message;
+        MPI_Send(done, 2, MPI_DOUBLE, 0, SBH_DISTRIBUTED_TAG_DONE,
+                 params->comm);
+        MPI_Send(buffer, (int)(chunk.area.height * chunk.stride), MPI_BYTE, 0,
+                 SBH_DISTRIBUTED_TAG_PIXELS, params->comm);
+    }
+
+    return success;
+}
+/*  End of sbh_distributed_work.                                              */
+
+#endif
+/*  End of #if SBH_DISTRIBUTED_HAS_MPI.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_distributed_frame                                                 *
+ *  Purpose:                                                                  *
+ *      Renders a frame over every rank of the communicator.                  *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_distributed_params *):                       *
+ *          The parameters of the frame, the same on every rank.              *
+ *      callback (sbh_distributed_callback):                                  *
+ *          Renders a tile into a chunk. On each node it is called from       *
+ *          several threads at once, and must only write the pixels of the    *
+ *          tile it is given.                                                 *
+ *      data (void *):                                                        *
+ *          Passed to the callback.                                           *
+ *      frame (void *):                                                       *
+ *          The frame, width * height pixels of pixel_size bytes in           *
+ *          row-major order. Only used on the coordinator, and may be NULL on *
+ *          the workers.                                                      *
+ *      cost (const double *):                                                *
+ *          The estimated cost of each chunk, or NULL. Only used on the       *
+ *          coordinator.                                                      *
+ *      seconds (double *):                                                   *
+ *          Set to the time taken by each chunk, or NULL. Only used on the    *
+ *          coordinator. It may be the same array as cost.                    *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          On the coordinator, 1 if the frame was rendered, and 0 if the     *
+ *          sizes are zero, memory could not be allocated on some rank, or a  *
+ *          chunk could not be rendered. On a worker, 1 if its chunks were    *
+ *          rendered.                                                         *
+ *  Notes:                                                                    *
+ *      Every rank must call this for every frame, like an MPI collective.    *
+ *      The pixels of a chunk are sent in one message, so a chunk must be     *
+ *      smaller than 2 GiB.                                                   *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_distributed_frame(const struct sbh_distributed_params *params,
+                      sbh_distributed_callback callback,
+                      void *data,
+                      void *frame,
+                      const double *cost,
+                      double *seconds)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_distributed_order *order = NULL;
+    size_t count;
+    int success;
+
+#if SBH_DISTRIBUTED_HAS_MPI
+    unsigned char *buffer = NULL;
+    int rank = 0, ranks = 1, ready;
+#endif
+
+    if (params->chunk_width == 0 || params->chunk_height == 0 ||
+        params->pixel_size == 0)
+        return 0;
+
+    count = sbh_distributed_chunk_count(params);
+
+#if SBH_DISTRIBUTED_HAS_MPI
+    MPI_Comm_rank(params->comm, &rank);
+    MPI_Comm_size(params->comm, &ranks);
+
+    if (ranks > 1)
+    {
+        /*  Every rank needs a chunk buffer, and the coordinator the order.   *
+         *  Agree on whether they all have them before any work is sent.      */
+        buffer = (unsigned char *)malloc(params->chunk_width *
+                                         params->chunk_height *
+                                         params->pixel_size);
+        ready = (buffer != NULL);
+
+        if (rank == 0)
+        {
+            order = sbh_distributed_order_create(cost, count);
+            ready = ready && order;
+        }
+
+        MPI_Allreduce(MPI_IN_PLACE, &ready, 1, MPI_INT, MPI_LAND,
+                      params->comm);
+
+        if (!ready)
+            success = 0;
+        else if (rank == 0)
+            success = sbh_distributed_coordinate(params, order, ranks, buffer,
+                                                 frame, seconds);
+        else
+            success = sbh_distributed_work(params, callback, data, buffer);
+
+        free(buffer);
+        free(order);
+        return success;
+    }
+#endif
+
+    order = sbh_distributed_order_create(cost, count);
+
+    if (!order)
+        return 0;
+
+    success = sbh_distributed_frame_local(params, order, callback, data,
+                                          frame, seconds);
+    free(order);
+    return success;
+}
+/*  End of sbh_distributed_frame.                                             */
+
+#endif
+/*  End of include guard.                                                     */
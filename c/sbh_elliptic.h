@@ -0,0 +1,259 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides the elliptic integral of the first kind and the Jacobi       *
+ *      elliptic functions, for the closed-form orbits of sbh_analytic.h.     *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The integral is computed with Carlson's symmetric form R_F and its    *
+ *      duplication theorem, which converges the same way for every argument, *
+ *      including parameters m = k^2 close to 1. The Jacobi functions use the *
+ *      descending Landen transformation, the arithmetic-geometric mean of 1  *
+ *      and sqrt(1 - m).                                                      *
+ *                                                                            *
+ *      Both take the complementary parameter mc = 1 - m instead of m. Near   *
+ *      the photon sphere m is within rounding error of 1, and forming 1 - m  *
+ *      from m would lose every digit of mc.                                  *
+ ******************************************************************************
+ *  References:                                                               *
+ *      1.) Carlson, B. (1995).                                               *
+ *          Numerical computation of real or complex elliptic integrals.      *
+ *          Numerical Algorithms, 10, 13-26.                                  *
+ *      2.) Abramowitz, M., Stegun, I. (1964).                                *
+ *          Handbook of Mathematical Functions, section 16.4.                 *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_ELLIPTIC_H
+#define SBH_ELLIPTIC_H
+
+#include "sbh_inline.h"
+#include <math.h>
+
+/*  The most AGM steps in sbh_elliptic_jacobi. Each step squares the error,   *
+ *  so even mc = 1E-300 converges in about ten.                               */
+#define SBH_ELLIPTIC_MAX_AGM_STEPS 16
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_elliptic_rf                                                       *
+ *  Purpose:                                                                  *
+ *      Computes Carlson's symmetric elliptic integral of the first kind,     *
+ *                                                                            *
+ *                    infty                                                   *
+ *                     -                                                      *
+ *                1   | |             dt                                      *
+ *          R_F = -   |   ---------------------------                         *
+ *                2 | |   sqrt((t + x) (t + y) (t + z))                       *
+ *                   -                                                        *
+ *                   0                                                        *
+ *  Arguments:                                                                *
+ *      x (double):                                                           *
+ *          The first argument, non-negative.                                 *
+ *      y (double):                                                           *
+ *          The second argument, non-negative.                                *
+ *      z (double):                                                           *
+ *          The third argument, non-negative. At most one may be zero.        *
+ *  Outputs:                                                                  *
+ *      rf (double):                                                          *
+ *          The integral.                                                     *
+ *  Method:                                                                   *
+ *      The duplication theorem R_F(x, y, z) = R_F((x + l) / 4, (y + l) / 4,  *
+ *      (z + l) / 4), l = sqrt(x y) + sqrt(x z) + sqrt(y z), moves the three  *
+ *      arguments together. Once they agree to within 0.0025 the fifth order  *
+ *      Taylor series about their mean is accurate to double precision.       *
+ ******************************************************************************/
+SBH_INLINE double sbh_elliptic_rf(double x, double y, double z)
+{
+    /*  Declare necessary variables.                                          */
+    double mean, dx, dy, dz, e2, e3;
+
+    while (1)
+    {
+        const double sx = sqrt(x);
+        const double sy = sqrt(y);
+        const double sz = sqrt(z);
+        const double lambda = sx * (sy + sz) + sy * sz;
+
+        x = 0.25 * (x + lambda);
+        y = 0.25 * (y + lambda);
+        z = 0.25 * (z + lambda);
+        mean = (x + y + z) / 3.0;
+        dx = (mean - x) / mean;
+        dy = (mean - y) / mean;
+        dz = (mean - z) / mean;
+
+        /*  Written so that a NaN argument ends the loop instead of hanging.  */
+        if (!(fabs(dx) >= 0.0025 || fabs(dy) >= 0.0025 || fabs(dz) >= 0.0025))
+            break;
+    }
+
+    e2 = dx * dy - dz * dz;
+    e3 = dx * dy * dz;
+
+    return (1.0 + (e2 / 24.0 - 0.1 - 3.0 * e3 / 44.0) * e2 + e3 / 14.0) /
+           sqrt(mean);
+}
+/*  End of sbh_elliptic_rf.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_elliptic_k                                                        *
+ *  Purpose:                                                                  *
+ *      Computes the complete elliptic integral of the first kind K.          *
+ *  Arguments:                                                                *
+ *      mc (double):                                                          *
+ *          The complementary parameter 1 - k^2, positive.                    *
+ *  Outputs:                                                                  *
+ *      K (double):                                                           *
+ *          The integral, R_F(0, mc, 1).                                      *
+ ******************************************************************************/
+SBH_INLINE double sbh_elliptic_k(double mc)
+{
+    return sbh_elliptic_rf(0.0, mc, 1.0);
+}
+/*  End of sbh_elliptic_k.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_elliptic_f                                                        *
+ *  Purpose:                                                                  *
+ *      Computes the incomplete elliptic integral of the first kind F(phi, k) *
+ *      for 0 <= phi <= pi.                                                   *
+ *  Arguments:                                                                *
+ *      s (double):                                                           *
+ *          sin(phi), non-negative.                                           *
+ *      c (double):                                                           *
+ *          cos(phi).                                                         *
+ *      mc (double):                                                          *
+ *          The complementary parameter 1 - k^2, positive.                    *
+ *  Outputs:                                                                  *
+ *      F (double):                                                           *
+ *          The integral.                                                     *
+ *  Method:                                                                   *
+ *      F = s R_F(c^2, 1 - k^2 s^2, 1), with 1 - k^2 s^2 = c^2 + mc s^2 to    *
+ *      avoid cancellation. For phi > pi / 2, use F(phi) = 2K - F(pi - phi).  *
+ *      The angle is given by its sine and cosine because the orbits of       *
+ *      sbh_analytic.h produce those directly.                                *
+ ******************************************************************************/
+SBH_INLINE double sbh_elliptic_f(double s, double c, double mc)
+{
+    /*  Declare necessary variables.                                          */
+    const double c2 = c * c;
+    const double f = s * sbh_elliptic_rf(c2, c2 + mc * s * s, 1.0);
+
+    if (c < 0.0)
+        return 2.0 * sbh_elliptic_k(mc) - f;
+
+    return f;
+}
+/*  End of sbh_elliptic_f.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_elliptic_jacobi                                                   *
+ *  Purpose:                                                                  *
+ *      Computes the Jacobi elliptic functions sn, cn, and dn.                *
+ *  Arguments:                                                                *
+ *      u (double):                                                           *
+ *          The argument.                                                     *
+ *      mc (double):                                                          *
+ *          The complementary parameter 1 - k^2, 0 <= mc <= 1.                *
+ *      sn (double *):                                                        *
+ *          Set to sn(u, k).                                                  *
+ *      cn (double *):                                                        *
+ *          Set to cn(u, k).                                                  *
+ *      dn (double *):                                                        *
+ *          Set to dn(u, k).                                                  *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Run the AGM of a_0 = 1 and b_0 = sqrt(mc) until a_n and b_n agree,    *
+ *      evaluate sin and cos at u scaled by the mean, and descend back        *
+ *      through the stored a_n and b_n, carrying a_n cot(phi_n) to avoid      *
+ *      inverse trig functions, see A&S 16.4. For mc = 0 the functions reduce *
+ *      to tanh(u) and sech(u).                                               *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_elliptic_jacobi(double u, double mc, double *sn, double *cn, double *dn)
+{
+    /*  Declare necessary variables.                                          */
+    double a[SBH_ELLIPTIC_MAX_AGM_STEPS], b[SBH_ELLIPTIC_MAX_AGM_STEPS];
+    double an = 1.0, bn, mean, ratio, scale;
+    int n, count = 0;
+
+    if (mc == 0.0)
+    {
+        *sn = tanh(u);
+        *cn = 1.0 / cosh(u);
+        *dn = *cn;
+        return;
+    }
+
+    /*  The AGM, keeping each a_n and b_n for the descent.                    */
+    bn = mc;
+    mean = 1.0;
+
+    for (n = 0; n < SBH_ELLIPTIC_MAX_AGM_STEPS; ++n)
+    {
+        count = n + 1;
+        a[n] = an;
+        bn = sqrt(bn);
+        b[n] = bn;
+        mean = 0.5 * (an + bn);
+
+        if (fabs(an - bn) <= 1.0E-10 * an)
+            break;
+
+        bn *= an;
+        an = mean;
+    }
+
+    u *= mean;
+    *sn = sin(u);
+    *cn = cos(u);
+    *dn = 1.0;
+
+    if (*sn == 0.0)
+        return;
+
+    /*  Descend, with scale = a_n cot(phi_n).                                 */
+    ratio = *cn / *sn;
+    scale = mean * ratio;
+
+    for (n = count - 1; n >= 0; --n)
+    {
+        ratio *= scale;
+        scale *= *dn;
+        *dn = (b[n] + ratio) / (a[n] + ratio);
+        ratio = scale / a[n];
+    }
+
+    ratio = 1.0 / sqrt(scale * scale + 1.0);
+    *sn = (*sn >= 0.0 ? ratio : -ratio);
+    *cn = scale * *sn;
+}
+/*  End of sbh_elliptic_jacobi.                                               */
+
+#endif
+/*  End of include guard.                                                     */
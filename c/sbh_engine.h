@@ -0,0 +1,154 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a single entry point for tracing a ray with any of the       *
+ *      engines, chosen at runtime.                                           *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      This is the CPU counterpart of enum sbh_cuda_engine. Tracing code can *
+ *      take a struct sbh_engine and leave the choice between the RK          *
+ *      integrators, the planar reduction, the deflection table, and the      *
+ *      closed-form solution to the caller.                                   *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_ENGINE_H
+#define SBH_ENGINE_H
+
+#include "sbh_inline.h"
+#include "sbh_geodesic.h"
+#include "sbh_ray.h"
+#include "sbh_planar.h"
+#include "sbh_deflection_table.h"
+#include "sbh_disk.h"
+#include "sbh_analytic.h"
+#include <stddef.h>
+
+/*  The available engines.                                                    */
+enum sbh_engine_type {
+
+    /*  sbh_geodesic_trace, or sbh_disk_trace if there is a disk.             */
+    SBH_ENGINE_GEODESIC,
+
+    /*  sbh_planar_trace.                                                     */
+    SBH_ENGINE_PLANAR,
+
+    /*  sbh_deflection_table_trace.                                           */
+    SBH_ENGINE_TABLE,
+
+    /*  sbh_analytic_trace, or sbh_analytic_disk_trace if there is a disk.    */
+    SBH_ENGINE_ANALYTIC
+};
+
+/*  An engine and the parameters for it.                                      */
+struct sbh_engine {
+    enum sbh_engine_type type;
+    struct sbh_geodesic_params geodesic;
+    struct sbh_planar_params planar;
+    struct sbh_analytic_params analytic;
+
+    /*  The table for SBH_ENGINE_TABLE. Not owned by the engine.              */
+    const struct sbh_deflection_table *table;
+
+    /*  The disk, or NULL for none. The planar and table engines ignore it.   */
+    const struct sbh_disk *disk;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_engine_create                                                     *
+ *  Purpose:                                                                  *
+ *      Creates an engine with the default parameters of each engine.         *
+ *  Arguments:                                                                *
+ *      type (enum sbh_engine_type):                                          *
+ *          The engine.                                                       *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *  Outputs:                                                                  *
+ *      engine (struct sbh_engine):                                           *
+ *          The engine, with no table and no disk.                            *
+ ******************************************************************************/
+SBH_INLINE struct sbh_engine
+sbh_engine_create(enum sbh_engine_type type, double mass)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_engine engine;
+
+    engine.type = type;
+    engine.geodesic = sbh_geodesic_default_params(mass);
+    engine.planar = sbh_planar_default_params(mass);
+    engine.analytic = sbh_analytic_default_params(mass);
+    engine.table = NULL;
+    engine.disk = NULL;
+    return engine;
+}
+/*  End of sbh_engine_create.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_engine_trace                                                      *
+ *  Purpose:                                                                  *
+ *      Traces a single light ray with the selected engine.                   *
+ *  Arguments:                                                                *
+ *      engine (const struct sbh_engine *):                                   *
+ *          The engine. SBH_ENGINE_TABLE needs a table.                       *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity, in Schwarzschild coordinates.  *
+ *      hit (struct sbh_disk_hit *):                                          *
+ *          Set if the disk was hit. May be NULL if there is no disk.         *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          The result of the engine.                                         *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_result
+sbh_engine_trace(const struct sbh_engine *engine,
+                 const struct sbh_geodesic *ray,
+                 struct sbh_disk_hit *hit)
+{
+    switch (engine->type)
+    {
+        case SBH_ENGINE_PLANAR:
+            return sbh_planar_trace(&engine->planar, ray);
+
+        case SBH_ENGINE_TABLE:
+            return sbh_deflection_table_trace(engine->table, ray);
+
+        case SBH_ENGINE_ANALYTIC:
+            if (engine->disk)
+                return sbh_analytic_disk_trace(&engine->analytic,
+                                               engine->disk, ray, hit);
+
+            return sbh_analytic_trace(&engine->analytic, ray);
+
+        default:
+            if (engine->disk)
+                return sbh_disk_trace(&engine->geodesic,
+                                      engine->disk, ray, hit);
+
+            return sbh_geodesic_trace(&engine->geodesic, ray);
+    }
+}
+/*  End of sbh_engine_trace.                                                  */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,248 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a single-precision 4D vector struct, the float counterpart   *
+ *      of struct sbh_vec4, and conversions between the two.                  *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Single precision is meant for output, frame buffers and tables, where *
+ *      halving the memory traffic matters more than the last digits. Ray     *
+ *      integration should stay in double precision; the "mixed" routines     *
+ *      take double input and produce float output.                           *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_FVEC4_H
+#define SBH_FVEC4_H
+
+#include "sbh_inline.h"
+#include "sbh_vec4.h"
+#include <math.h>
+
+/*  C89 only has the double versions of the math functions. On C89 compilers  *
+ *  compute in double and round, which gives the same or better accuracy.     */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+
+#define SBH_FSIN(x) sinf(x)
+#define SBH_FCOS(x) cosf(x)
+
+#else
+/*  Else for #if __STDC_VERSION__ >= 199901L.                                 */
+
+#define SBH_FSIN(x) ((float)sin((double)(x)))
+#define SBH_FCOS(x) ((float)cos((double)(x)))
+
+#endif
+/*  End of #if __STDC_VERSION__ >= 199901L.                                   */
+
+/*  Struct for working with four-dimensional points in single precision.      */
+struct sbh_fvec4 {
+
+    /*  The same layout as struct sbh_vec4, with float in place of double.    */
+    float dat[4];
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_rect                                                        *
+ *  Purpose:                                                                  *
+ *      Creates a 4D vector from "rectangular", or Cartesian, coordinates.    *
+ *  Arguments:                                                                *
+ *      x (float):                                                            *
+ *          The x-component of the vector.                                    *
+ *      y (float):                                                            *
+ *          The y-component of the vector.                                    *
+ *      z (float):                                                            *
+ *          The z-component of the vector.                                    *
+ *      t (float):                                                            *
+ *          The time component of the vector.                                 *
+ *  Outputs:                                                                  *
+ *      v (struct sbh_fvec4):                                                 *
+ *          The vector (x, y, z, t).                                          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_fvec4
+sbh_fvec4_rect(float x, float y, float z, float t)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_fvec4 p;
+
+    /*  Set the components for the vector and return.                         */
+    p.dat[0] = x;
+    p.dat[1] = y;
+    p.dat[2] = z;
+    p.dat[3] = t;
+    return p;
+}
+/*  End of sbh_fvec4_rect.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_rect_from_schwarzschild                                     *
+ *  Purpose:                                                                  *
+ *      Given the Schwarzschild coordinates of a point p, returns the vector  *
+ *      in R^4 with the corresponding Cartesian coordinates.                  *
+ *  Arguments:                                                                *
+ *      r (float):                                                            *
+ *          The radial component of the point.                                *
+ *      phi (float):                                                          *
+ *          The azimuthal part of the vector.                                 *
+ *      theta (float):                                                        *
+ *          The angle the vector makes with the north pole.                   *
+ *      t (float):                                                            *
+ *          The time component of the vector.                                 *
+ *  Outputs:                                                                  *
+ *      v (struct sbh_fvec4):                                                 *
+ *          The vector (x, y, z, t).                                          *
+ *  Method:                                                                   *
+ *      Use the spherical coordinate formulas and append the time component.  *
+ ******************************************************************************/
+SBH_INLINE struct sbh_fvec4
+sbh_fvec4_rect_from_schwarzschild(float r, float phi, float theta, float t)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_fvec4 p;
+
+    /*  Standard spherical-to-rectangular conversion factors.                 */
+    const float sin_phi = SBH_FSIN(phi);
+    const float cos_phi = SBH_FCOS(phi);
+    const float sin_theta = SBH_FSIN(theta);
+    const float cos_theta = SBH_FCOS(theta);
+
+    /*  Compute Cartesian coordinates from the spatial part (r, theta, phi).  */
+    p.dat[0] = r * sin_theta * cos_phi;
+    p.dat[1] = r * sin_theta * sin_phi;
+    p.dat[2] = r * cos_theta;
+
+    /*  The time factor is the same in both coordinate systems.               */
+    p.dat[3] = t;
+    return p;
+}
+/*  End of sbh_fvec4_rect_from_schwarzschild.                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_schwarzschild_to_rect                                       *
+ *  Purpose:                                                                  *
+ *      Converts a point from Schwarzschild to Cartesian coordinates.         *
+ *  Arguments:                                                                *
+ *      q (const struct sbh_fvec4 *):                                         *
+ *          The point, given as (r, phi, theta, t).                           *
+ *  Outputs:                                                                  *
+ *      p (struct sbh_fvec4):                                                 *
+ *          The point as (x, y, z, t).                                        *
+ ******************************************************************************/
+SBH_INLINE struct sbh_fvec4
+sbh_fvec4_schwarzschild_to_rect(const struct sbh_fvec4 *q)
+{
+    return sbh_fvec4_rect_from_schwarzschild(
+        q->dat[0], q->dat[1], q->dat[2], q->dat[3]
+    );
+}
+/*  End of sbh_fvec4_schwarzschild_to_rect.                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_convert_schwarzschild_to_rect                               *
+ *  Purpose:                                                                  *
+ *      Converts a point from Schwarzschild to Cartesian coordinates in       *
+ *      place.                                                                *
+ *  Arguments:                                                                *
+ *      p (struct sbh_fvec4 *):                                               *
+ *          The point, given as (r, phi, theta, t). On output (x, y, z, t).   *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_fvec4_convert_schwarzschild_to_rect(struct sbh_fvec4 *p)
+{
+    *p = sbh_fvec4_schwarzschild_to_rect(p);
+}
+/*  End of sbh_fvec4_convert_schwarzschild_to_rect.                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_from_vec4                                                   *
+ *  Purpose:                                                                  *
+ *      Rounds a double-precision vector to single precision.                 *
+ *  Arguments:                                                                *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The vector.                                                       *
+ *  Outputs:                                                                  *
+ *      q (struct sbh_fvec4):                                                 *
+ *          The rounded vector.                                               *
+ ******************************************************************************/
+SBH_INLINE struct sbh_fvec4 sbh_fvec4_from_vec4(const struct sbh_vec4 *p)
+{
+    return sbh_fvec4_rect(
+        (float)p->dat[0], (float)p->dat[1], (float)p->dat[2], (float)p->dat[3]
+    );
+}
+/*  End of sbh_fvec4_from_vec4.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_to_vec4                                                     *
+ *  Purpose:                                                                  *
+ *      Converts a single-precision vector to double precision, exactly.      *
+ *  Arguments:                                                                *
+ *      p (const struct sbh_fvec4 *):                                         *
+ *          The vector.                                                       *
+ *  Outputs:                                                                  *
+ *      q (struct sbh_vec4):                                                  *
+ *          The same vector in double precision.                              *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4 sbh_fvec4_to_vec4(const struct sbh_fvec4 *p)
+{
+    return sbh_vec4_rect(
+        (double)p->dat[0], (double)p->dat[1],
+        (double)p->dat[2], (double)p->dat[3]
+    );
+}
+/*  End of sbh_fvec4_to_vec4.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_rect_from_schwarzschild_mixed                               *
+ *  Purpose:                                                                  *
+ *      Converts a double-precision point in Schwarzschild coordinates to     *
+ *      a single-precision point in Cartesian coordinates.                    *
+ *  Arguments:                                                                *
+ *      q (const struct sbh_vec4 *):                                          *
+ *          The point, given as (r, phi, theta, t).                           *
+ *  Outputs:                                                                  *
+ *      p (struct sbh_fvec4):                                                 *
+ *          The point as (x, y, z, t).                                        *
+ *  Method:                                                                   *
+ *      Convert in double precision and round the result. Rounding the        *
+ *      angles first would lose accuracy for large or nearly polar angles.    *
+ ******************************************************************************/
+SBH_INLINE struct sbh_fvec4
+sbh_fvec4_rect_from_schwarzschild_mixed(const struct sbh_vec4 *q)
+{
+    const struct sbh_vec4 p = sbh_vec4_schwarzschild_to_rect(q);
+    return sbh_fvec4_from_vec4(&p);
+}
+/*  End of sbh_fvec4_rect_from_schwarzschild_mixed.                           */
+
+#endif
+/*  End of include guard.                                                     */
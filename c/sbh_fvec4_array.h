@@ -0,0 +1,372 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides structure-of-arrays routines for single-precision 4D         *
+ *      vectors, the float counterpart of sbh_vec4_array.h.                   *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      Twice as many floats as doubles fit in a vector register and in a     *
+ *      cache line, so loops over float arrays move half the data and take    *
+ *      half the instructions. Sines and cosines are still computed with      *
+ *      sbh_sincos_array in double precision one block at a time, and only    *
+ *      the results are rounded. This keeps the float output fully accurate   *
+ *      at a small cost, since the trig is not the memory bound part.         *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_FVEC4_ARRAY_H
+#define SBH_FVEC4_ARRAY_H
+
+#include "sbh_inline.h"
+#include "sbh_restrict.h"
+#include "sbh_fvec4.h"
+#include "sbh_vec4_array.h"
+#include "sbh_sincos.h"
+#include <stddef.h>
+
+/*  Struct for working with many single-precision points at once.             */
+struct sbh_fvec4_array {
+
+    /*  dat[k][n] is the kth component of the nth point, as for               *
+     *  struct sbh_vec4_array.                                                */
+    float *dat[4];
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_array_create                                                *
+ *  Purpose:                                                                  *
+ *      Creates a structure-of-arrays from four user-provided buffers.        *
+ *  Arguments:                                                                *
+ *      a0 (float *):                                                         *
+ *          The buffer for the zeroth component of the points.                *
+ *      a1 (float *):                                                         *
+ *          The buffer for the first component of the points.                 *
+ *      a2 (float *):                                                         *
+ *          The buffer for the second component of the points.                *
+ *      a3 (float *):                                                         *
+ *          The buffer for the time component of the points.                  *
+ *  Outputs:                                                                  *
+ *      arr (struct sbh_fvec4_array):                                         *
+ *          The array with dat = {a0, a1, a2, a3}.                            *
+ *  Notes:                                                                    *
+ *      The buffers are not copied, the caller owns the memory.               *
+ ******************************************************************************/
+SBH_INLINE struct sbh_fvec4_array
+sbh_fvec4_array_create(float *a0, float *a1, float *a2, float *a3)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_fvec4_array arr;
+
+    /*  Set the pointers and return.                                          */
+    arr.dat[0] = a0;
+    arr.dat[1] = a1;
+    arr.dat[2] = a2;
+    arr.dat[3] = a3;
+    return arr;
+}
+/*  End of sbh_fvec4_array_create.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_array_rect_from_schwarzschild                               *
+ *  Purpose:                                                                  *
+ *      Given an array of points in Schwarzschild coordinates, computes the   *
+ *      corresponding Cartesian coordinates, storing them in a second array.  *
+ *  Arguments:                                                                *
+ *      out (struct sbh_fvec4_array *):                                       *
+ *          The output array, points are stored as (x, y, z, t).              *
+ *      in (const struct sbh_fvec4_array *):                                  *
+ *          The input array, points are given as (r, phi, theta, t).          *
+ *      len (size_t):                                                         *
+ *          The number of points in the arrays.                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      The same as sbh_vec4_array_rect_from_schwarzschild. The angles of     *
+ *      each block are widened to double for sbh_sincos_array.                *
+ *  Notes:                                                                    *
+ *      The buffers for out must not overlap the buffers for in.              *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_fvec4_array_rect_from_schwarzschild(struct sbh_fvec4_array *out,
+                                        const struct sbh_fvec4_array *in,
+                                        size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const float * SBH_RESTRICT r = in->dat[0];
+    const float * SBH_RESTRICT phi = in->dat[1];
+    const float * SBH_RESTRICT theta = in->dat[2];
+    const float * SBH_RESTRICT t_in = in->dat[3];
+    float * SBH_RESTRICT x = out->dat[0];
+    float * SBH_RESTRICT y = out->dat[1];
+    float * SBH_RESTRICT z = out->dat[2];
+    float * SBH_RESTRICT t_out = out->dat[3];
+    double angle_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double angle_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double sin_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double sin_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    size_t start, n;
+
+    /*  Loop through the points one block at a time.                          */
+    for (start = 0; start < len; start += SBH_VEC4_ARRAY_BLOCK_SIZE)
+    {
+        /*  The last block may be smaller than the others.                    */
+        const size_t remaining = len - start;
+        const size_t size = (remaining < SBH_VEC4_ARRAY_BLOCK_SIZE ?
+                             remaining : SBH_VEC4_ARRAY_BLOCK_SIZE);
+
+        /*  Widen the angles and compute the conversion factors.              */
+        for (n = 0; n < size; ++n)
+        {
+            angle_phi[n] = (double)phi[start + n];
+            angle_theta[n] = (double)theta[start + n];
+        }
+
+        sbh_sincos_array(angle_phi, sin_phi, cos_phi, size);
+        sbh_sincos_array(angle_theta, sin_theta, cos_theta, size);
+
+        /*  Perform the conversion and round the results.                     */
+        for (n = 0; n < size; ++n)
+        {
+            const double r_sin_theta = (double)r[start + n] * sin_theta[n];
+            x[start + n] = (float)(r_sin_theta * cos_phi[n]);
+            y[start + n] = (float)(r_sin_theta * sin_phi[n]);
+            z[start + n] = (float)((double)r[start + n] * cos_theta[n]);
+        }
+    }
+
+    /*  The time factor is the same in both coordinate systems. Copy it.      */
+    for (n = 0; n < len; ++n)
+        t_out[n] = t_in[n];
+}
+/*  End of sbh_fvec4_array_rect_from_schwarzschild.                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_array_rect_from_schwarzschild_mixed                         *
+ *  Purpose:                                                                  *
+ *      Converts double-precision points in Schwarzschild coordinates to      *
+ *      single-precision points in Cartesian coordinates.                     *
+ *  Arguments:                                                                *
+ *      out (struct sbh_fvec4_array *):                                       *
+ *          The output array, points are stored as (x, y, z, t).              *
+ *      in (const struct sbh_vec4_array *):                                   *
+ *          The input array, points are given as (r, phi, theta, t).          *
+ *      len (size_t):                                                         *
+ *          The number of points in the arrays.                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      This is the usual last step of a frame: integrator state in double,   *
+ *      written once to a float buffer.                                       *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_fvec4_array_rect_from_schwarzschild_mixed(struct sbh_fvec4_array *out,
+                                              const struct sbh_vec4_array *in,
+                                              size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const double * SBH_RESTRICT r = in->dat[0];
+    const double * SBH_RESTRICT phi = in->dat[1];
+    const double * SBH_RESTRICT theta = in->dat[2];
+    const double * SBH_RESTRICT t_in = in->dat[3];
+    float * SBH_RESTRICT x = out->dat[0];
+    float * SBH_RESTRICT y = out->dat[1];
+    float * SBH_RESTRICT z = out->dat[2];
+    float * SBH_RESTRICT t_out = out->dat[3];
+    double sin_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double sin_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    size_t start, n;
+
+    /*  Loop through the points one block at a time.                          */
+    for (start = 0; start < len; start += SBH_VEC4_ARRAY_BLOCK_SIZE)
+    {
+        /*  The last block may be smaller than the others.                    */
+        const size_t remaining = len - start;
+        const size_t size = (remaining < SBH_VEC4_ARRAY_BLOCK_SIZE ?
+                             remaining : SBH_VEC4_ARRAY_BLOCK_SIZE);
+
+        sbh_sincos_array(phi + start, sin_phi, cos_phi, size);
+        sbh_sincos_array(theta + start, sin_theta, cos_theta, size);
+
+        /*  Perform the conversion and round the results.                     */
+        for (n = 0; n < size; ++n)
+        {
+            const double r_sin_theta = r[start + n] * sin_theta[n];
+            x[start + n] = (float)(r_sin_theta * cos_phi[n]);
+            y[start + n] = (float)(r_sin_theta * sin_phi[n]);
+            z[start + n] = (float)(r[start + n] * cos_theta[n]);
+        }
+    }
+
+    /*  The time factor is the same in both coordinate systems. Round it.     */
+    for (n = 0; n < len; ++n)
+        t_out[n] = (float)t_in[n];
+}
+/*  End of sbh_fvec4_array_rect_from_schwarzschild_mixed.                     */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_array_from_vec4_array                                       *
+ *  Purpose:                                                                  *
+ *      Rounds a double-precision structure-of-arrays to single precision.    *
+ *  Arguments:                                                                *
+ *      out (struct sbh_fvec4_array *):                                       *
+ *          The output array.                                                 *
+ *      in (const struct sbh_vec4_array *):                                   *
+ *          The input array.                                                  *
+ *      len (size_t):                                                         *
+ *          The number of points.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_fvec4_array_from_vec4_array(struct sbh_fvec4_array *out,
+                                const struct sbh_vec4_array *in,
+                                size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t k, n;
+
+    /*  Each component is a separate contiguous loop, which vectorizes.       */
+    for (k = 0; k < 4; ++k)
+    {
+        const double * SBH_RESTRICT src = in->dat[k];
+        float * SBH_RESTRICT dst = out->dat[k];
+
+        for (n = 0; n < len; ++n)
+            dst[n] = (float)src[n];
+    }
+}
+/*  End of sbh_fvec4_array_from_vec4_array.                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_array_to_vec4_array                                         *
+ *  Purpose:                                                                  *
+ *      Widens a single-precision structure-of-arrays to double precision.    *
+ *  Arguments:                                                                *
+ *      out (struct sbh_vec4_array *):                                        *
+ *          The output array.                                                 *
+ *      in (const struct sbh_fvec4_array *):                                  *
+ *          The input array.                                                  *
+ *      len (size_t):                                                         *
+ *          The number of points.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_fvec4_array_to_vec4_array(struct sbh_vec4_array *out,
+                              const struct sbh_fvec4_array *in,
+                              size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t k, n;
+
+    /*  Each component is a separate contiguous loop, which vectorizes.       */
+    for (k = 0; k < 4; ++k)
+    {
+        const float * SBH_RESTRICT src = in->dat[k];
+        double * SBH_RESTRICT dst = out->dat[k];
+
+        for (n = 0; n < len; ++n)
+            dst[n] = (double)src[n];
+    }
+}
+/*  End of sbh_fvec4_array_to_vec4_array.                                     */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_array_load                                                  *
+ *  Purpose:                                                                  *
+ *      Copies an array of struct sbh_fvec4 into structure-of-arrays form.    *
+ *  Arguments:                                                                *
+ *      out (struct sbh_fvec4_array *):                                       *
+ *          The output array.                                                 *
+ *      in (const struct sbh_fvec4 *):                                        *
+ *          The input points.                                                 *
+ *      len (size_t):                                                         *
+ *          The number of points.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_fvec4_array_load(struct sbh_fvec4_array *out,
+                     const struct sbh_fvec4 *in,
+                     size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t n;
+
+    /*  Transpose the array-of-structs into the structure-of-arrays.          */
+    for (n = 0; n < len; ++n)
+    {
+        out->dat[0][n] = in[n].dat[0];
+        out->dat[1][n] = in[n].dat[1];
+        out->dat[2][n] = in[n].dat[2];
+        out->dat[3][n] = in[n].dat[3];
+    }
+}
+/*  End of sbh_fvec4_array_load.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_fvec4_array_store                                                 *
+ *  Purpose:                                                                  *
+ *      Copies a structure-of-arrays into an array of struct sbh_fvec4.       *
+ *  Arguments:                                                                *
+ *      out (struct sbh_fvec4 *):                                             *
+ *          The output points.                                                *
+ *      in (const struct sbh_fvec4_array *):                                  *
+ *          The input array.                                                  *
+ *      len (size_t):                                                         *
+ *          The number of points.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_fvec4_array_store(struct sbh_fvec4 *out,
+                      const struct sbh_fvec4_array *in,
+                      size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t n;
+
+    /*  Transpose the structure-of-arrays back into array-of-structs form.    */
+    for (n = 0; n < len; ++n)
+    {
+        out[n].dat[0] = in->dat[0][n];
+        out[n].dat[1] = in->dat[1][n];
+        out[n].dat[2] = in->dat[2][n];
+        out[n].dat[3] = in->dat[3][n];
+    }
+}
+/*  End of sbh_fvec4_array_store.                                             */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,404 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a geometry buffer that stores what every ray of a frame hit, *
+ *      so the frame can be shaded again without tracing any rays.            *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      For a fixed camera the outcome of a ray depends only on the geometry, *
+ *      the escape direction on the sky, or where on the disk it landed and   *
+ *      with what redshift. Textures and colormaps only enter when this is    *
+ *      turned into a color. sbh_gbuffer_build traces the frame once and      *
+ *      keeps these per sample, and sbh_gbuffer_shade turns them into colors. *
+ *      Changing the sky or the disk colormap only needs sbh_gbuffer_shade.   *
+ *                                                                            *
+ *      Each pixel has grid x grid samples on a stratified grid, and its      *
+ *      color is their mean, so antialiasing survives the re-shade.           *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Samples are stored in single precision, see sbh_fvec4.h. A unit       *
+ *      direction in float is accurate to about 1e-7 rad, far below a pixel.  *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_GBUFFER_H
+#define SBH_GBUFFER_H
+
+#include "sbh_inline.h"
+#include "sbh_fvec4.h"
+#include "sbh_ray.h"
+#include "sbh_disk.h"
+#include "sbh_render.h"
+#include <stddef.h>
+#include <stdlib.h>
+
+/*  What one ray hit.                                                         */
+struct sbh_gbuffer_sample {
+
+    /*  The fate of the ray, an enum sbh_ray_status.                          */
+    unsigned char status;
+
+    /*  For SBH_RAY_ESCAPED the direction of travel, as in struct             *
+     *  sbh_ray_result. For SBH_RAY_DISK the radius, azimuth and redshift of  *
+     *  the hit, as in struct sbh_disk_hit. Zero otherwise.                   */
+    struct sbh_fvec4 dat;
+};
+
+/*  The samples of a frame.                                                   */
+struct sbh_gbuffer {
+
+    /*  The size of the frame in pixels, and the samples per pixel along      *
+     *  each axis.                                                            */
+    size_t width, height;
+    unsigned int grid;
+
+    /*  grid * grid samples per pixel, pixels in row-major order and the      *
+     *  samples of a pixel in row-major order on its grid.                    */
+    struct sbh_gbuffer_sample *samples;
+};
+
+/*  Traces the ray through the point (x, y) of the image, in pixel            *
+ *  coordinates as in sbh_camera.h, and stores what it hit.                   */
+typedef void
+(*sbh_gbuffer_trace_callback)(double x, double y, unsigned int thread,
+                              struct sbh_gbuffer_sample *sample, void *data);
+
+/*  Computes the color of a sample.                                           */
+typedef void
+(*sbh_gbuffer_shade_callback)(const struct sbh_gbuffer_sample *sample,
+                              float *rgb, void *data);
+
+/*  The state shared by the tiles of a pass.                                  */
+struct sbh_gbuffer_pass {
+    struct sbh_gbuffer *gbuffer;
+    sbh_gbuffer_trace_callback trace;
+    sbh_gbuffer_shade_callback shade;
+    void *data;
+    float *rgb;
+
+    /*  The progress counters of the render, or NULL.                         */
+    struct sbh_progress *progress;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_gbuffer_init                                                      *
+ *  Purpose:                                                                  *
+ *      Allocates a geometry buffer.                                          *
+ *  Arguments:                                                                *
+ *      gbuffer (struct sbh_gbuffer *):                                       *
+ *          The buffer to initialize.                                         *
+ *      width (size_t):                                                       *
+ *          The width of the frame in pixels.                                 *
+ *      height (size_t):                                                      *
+ *          The height of the frame in pixels.                                *
+ *      grid (unsigned int):                                                  *
+ *          The samples per pixel along each axis, at least 1.                *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if grid is zero or memory could not be allocated. *
+ *          On failure samples is NULL and the buffer may still be passed to  *
+ *          sbh_gbuffer_destroy.                                              *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_gbuffer_init(struct sbh_gbuffer *gbuffer,
+                 size_t width, size_t height, unsigned int grid)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t count = width * height * (size_t)grid * (size_t)grid;
+
+    gbuffer->width = width;
+    gbuffer->height = height;
+    gbuffer->grid = grid;
+    gbuffer->samples = NULL;
+
+    if (grid == 0U)
+        return 0;
+
+    gbuffer->samples = (struct sbh_gbuffer_sample *)
+        malloc(sizeof(*gbuffer->samples) * count + 1);
+
+    return gbuffer->samples != NULL;
+}
+/*  End of sbh_gbuffer_init.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_gbuffer_destroy                                                   *
+ *  Purpose:                                                                  *
+ *      Frees the memory of a geometry buffer.                                *
+ *  Arguments:                                                                *
+ *      gbuffer (struct sbh_gbuffer *):                                       *
+ *          The buffer.                                                       *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_gbuffer_destroy(struct sbh_gbuffer *gbuffer)
+{
+    free(gbuffer->samples);
+    gbuffer->samples = NULL;
+}
+/*  End of sbh_gbuffer_destroy.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_gbuffer_sample_from_result                                        *
+ *  Purpose:                                                                  *
+ *      Creates a sample from the result of one of the engines.               *
+ *  Arguments:                                                                *
+ *      result (const struct sbh_ray_result *):                               *
+ *          The result.                                                       *
+ *      hit (const struct sbh_disk_hit *):                                    *
+ *          The disk hit, used if the status is SBH_RAY_DISK.                 *
+ *  Outputs:                                                                  *
+ *      sample (struct sbh_gbuffer_sample):                                   *
+ *          The sample.                                                       *
+ ******************************************************************************/
+SBH_INLINE struct sbh_gbuffer_sample
+sbh_gbuffer_sample_from_result(const struct sbh_ray_result *result,
+                               const struct sbh_disk_hit *hit)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_gbuffer_sample sample;
+
+    sample.status = (unsigned char)result->status;
+
+    if (result->status == SBH_RAY_ESCAPED)
+        sample.dat = sbh_fvec4_from_vec4(&result->direction);
+
+    else if (result->status == SBH_RAY_DISK)
+        sample.dat = sbh_fvec4_rect(
+            (float)hit->radius, (float)hit->phi, (float)hit->redshift, 0.0F
+        );
+
+    else
+        sample.dat = sbh_fvec4_rect(0.0F, 0.0F, 0.0F, 0.0F);
+
+    return sample;
+}
+/*  End of sbh_gbuffer_sample_from_result.                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_gbuffer_build_tile                                                *
+ *  Purpose:                                                                  *
+ *      Traces the samples of the pixels of a tile.                           *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile.                                                         *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The pass, a struct sbh_gbuffer_pass.                              *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_gbuffer_build_tile(const struct sbh_render_tile *tile,
+                       unsigned int thread,
+                       void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_gbuffer_pass *pass = (const struct sbh_gbuffer_pass *)data;
+    const struct sbh_gbuffer *gbuffer = pass->gbuffer;
+    const unsigned int grid = gbuffer->grid;
+    const size_t per_pixel = (size_t)grid * (size_t)grid;
+    const double spacing = 1.0 / (double)grid;
+    size_t i, j;
+    unsigned int a, b;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            struct sbh_gbuffer_sample *sample =
+                gbuffer->samples + (j * gbuffer->width + i) * per_pixel;
+
+            if (sbh_progress_cancelled(pass->progress))
+                return;
+
+            for (b = 0U; b < grid; ++b)
+            {
+                const double y = (double)j + ((double)b + 0.5) * spacing;
+
+                for (a = 0U; a < grid; ++a)
+                {
+                    const double x = (double)i + ((double)a + 0.5) * spacing;
+                    pass->trace(x, y, thread, sample, pass->data);
+                    ++sample;
+                }
+            }
+        }
+
+        sbh_progress_add_rays(pass->progress,
+                              (unsigned long)(tile->width * per_pixel));
+    }
+}
+/*  End of sbh_gbuffer_build_tile.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_gbuffer_shade_tile                                                *
+ *  Purpose:                                                                  *
+ *      Shades the pixels of a tile from their samples.                       *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile.                                                         *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread, unused.                           *
+ *      data (void *):                                                        *
+ *          The pass, a struct sbh_gbuffer_pass.                              *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_gbuffer_shade_tile(const struct sbh_render_tile *tile,
+                       unsigned int thread,
+                       void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_gbuffer_pass *pass = (const struct sbh_gbuffer_pass *)data;
+    const struct sbh_gbuffer *gbuffer = pass->gbuffer;
+    const size_t per_pixel = (size_t)gbuffer->grid * (size_t)gbuffer->grid;
+    const float weight = 1.0F / (float)per_pixel;
+    size_t i, j, k;
+
+    (void)thread;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t index = j * gbuffer->width + i;
+            const struct sbh_gbuffer_sample *sample =
+                gbuffer->samples + index * per_pixel;
+            float *rgb = pass->rgb + 3 * index;
+            float sum[3], color[3];
+
+            sum[0] = sum[1] = sum[2] = 0.0F;
+
+            for (k = 0; k < per_pixel; ++k)
+            {
+                pass->shade(sample + k, color, pass->data);
+                sum[0] += color[0];
+                sum[1] += color[1];
+                sum[2] += color[2];
+            }
+
+            rgb[0] = weight * sum[0];
+            rgb[1] = weight * sum[1];
+            rgb[2] = weight * sum[2];
+        }
+    }
+}
+/*  End of sbh_gbuffer_shade_tile.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_gbuffer_build                                                     *
+ *  Purpose:                                                                  *
+ *      Traces every sample of a frame into a geometry buffer.                *
+ *  Arguments:                                                                *
+ *      gbuffer (struct sbh_gbuffer *):                                       *
+ *          The buffer. Its size must match render.                           *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry and number of threads.                         *
+ *      trace (sbh_gbuffer_trace_callback):                                   *
+ *          Traces a ray. It is called from several threads at once.          *
+ *      data (void *):                                                        *
+ *          Passed to trace.                                                  *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          0 if the sizes of the buffer and the frame differ, and otherwise  *
+ *          the return value of sbh_render_frame.                             *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_gbuffer_build(struct sbh_gbuffer *gbuffer,
+                  const struct sbh_render_params *render,
+                  sbh_gbuffer_trace_callback trace,
+                  void *data)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_gbuffer_pass pass;
+
+    if (gbuffer->width != render->width || gbuffer->height != render->height)
+        return 0;
+
+    pass.gbuffer = gbuffer;
+    pass.trace = trace;
+    pass.shade = NULL;
+    pass.data = data;
+    pass.rgb = NULL;
+    pass.progress = render->progress;
+    return sbh_render_frame(render, sbh_gbuffer_build_tile, &pass);
+}
+/*  End of sbh_gbuffer_build.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_gbuffer_shade                                                     *
+ *  Purpose:                                                                  *
+ *      Shades a frame from its geometry buffer.                              *
+ *  Arguments:                                                                *
+ *      gbuffer (const struct sbh_gbuffer *):                                 *
+ *          The buffer, filled by sbh_gbuffer_build.                          *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry and number of threads.                         *
+ *      shade (sbh_gbuffer_shade_callback):                                   *
+ *          Computes the color of a sample. It is called from several threads *
+ *          at once.                                                          *
+ *      data (void *):                                                        *
+ *          Passed to shade.                                                  *
+ *      rgb (float *):                                                        *
+ *          The output image, width * height RGB triples in row-major order.  *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          0 if the sizes of the buffer and the frame differ, and otherwise  *
+ *          the return value of sbh_render_frame.                             *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_gbuffer_shade(const struct sbh_gbuffer *gbuffer,
+                  const struct sbh_render_params *render,
+                  sbh_gbuffer_shade_callback shade,
+                  void *data,
+                  float *rgb)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_gbuffer_pass pass;
+
+    if (gbuffer->width != render->width || gbuffer->height != render->height)
+        return 0;
+
+    /*  The shade pass only reads the buffer.                                 */
+    pass.gbuffer = (struct sbh_gbuffer *)gbuffer;
+    pass.trace = NULL;
+    pass.shade = shade;
+    pass.data = data;
+    pass.rgb = rgb;
+    pass.progress = render->progress;
+    return sbh_render_frame(render, sbh_gbuffer_shade_tile, &pass);
+}
+/*  End of sbh_gbuffer_shade.                                                 */
+
+#endif
+/*  End of include guard.                                                     */
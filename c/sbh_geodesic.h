@@ -0,0 +1,1245 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides routines for integrating null geodesics, light rays, in the  *
+ *      Schwarzschild geometry.                                               *
+ ******************************************************************************
+ *  Conventions:                                                              *
+ *      Geometrized units are used, G = c = 1. Points are stored in           *
+ *      Schwarzschild coordinates in the order (r, phi, theta, t), matching   *
+ *      sbh_vec4_rect_from_schwarzschild, and velocities are derivatives      *
+ *      with respect to the affine parameter, stored in the same order.       *
+ *      The metric is                                                         *
+ *                                                                            *
+ *          ds^2 = -f dt^2 + dr^2 / f + r^2 (dtheta^2 + sin^2(theta) dphi^2)  *
+ *                                                                            *
+ *      with f = 1 - 2M / r. The equations are singular at r = 2M and on the  *
+ *      polar axis, theta = 0 or pi. Rays passing very close to the poles     *
+ *      will need very small steps.                                           *
+ ******************************************************************************
+ *  Trig Cache:                                                               *
+ *      Every stage of every step needs sin(theta) and cos(theta). Between    *
+ *      stages theta only moves by a small amount, so the stepper keeps the   *
+ *      values at the last accepted state and rotates them by the angle       *
+ *      addition formulas, with short Taylor series for the sine and cosine   *
+ *      of the difference. The cache is recomputed from scratch every         *
+ *      SBH_GEODESIC_TRIG_REFRESH updates, and whenever theta moves by more   *
+ *      than SBH_GEODESIC_TRIG_MAX_DELTA, to bound the drift.                 *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_GEODESIC_H
+#define SBH_GEODESIC_H
+
+#include "sbh_inline.h"
+#include "sbh_vec4.h"
+#include "sbh_sincos.h"
+#include "sbh_ray.h"
+#include "sbh_arena.h"
+#include "sbh_stats.h"
+#include <stddef.h>
+#include <math.h>
+
+/*  Largest change in theta applied with the angle addition formulas. Up to   *
+ *  this the Taylor series below are accurate to well below one ULP.          */
+#define SBH_GEODESIC_TRIG_MAX_DELTA (0.0625)
+
+/*  Number of incremental updates of the trig cache between full refreshes.   *
+ *  Each update may add about one ULP of error to the cached values.          */
+#define SBH_GEODESIC_TRIG_REFRESH (32U)
+
+/*  Struct for the state of a ray, its position and its velocity.             */
+struct sbh_geodesic {
+
+    /*  The position (r, phi, theta, t) of the ray.                           */
+    struct sbh_vec4 p;
+
+    /*  The velocity (dr, dphi, dtheta, dt) / dlambda of the ray.             */
+    struct sbh_vec4 v;
+};
+
+/*  The available numerical methods.                                          */
+enum sbh_geodesic_method {
+
+    /*  Classic fourth order Runge-Kutta with a fixed step size.              */
+    SBH_GEODESIC_RK4,
+
+    /*  Dormand-Prince 5(4) with adaptive step size control.                  */
+    SBH_GEODESIC_DP45
+};
+
+/*  Parameters for the integrator.                                            */
+struct sbh_geodesic_params {
+
+    /*  The mass of the black hole, in geometrized units.                     */
+    double mass;
+
+    /*  The numerical method used for stepping.                               */
+    enum sbh_geodesic_method method;
+
+    /*  The step size for RK4, and the initial step size for DP45.            */
+    double step;
+
+    /*  DP45 only. The allowed local error per step, relative to 1 + |y|.     */
+    double tolerance;
+
+    /*  DP45 only. Bounds for the step size.                                  */
+    double min_step, max_step;
+
+    /*  Integration stops once the affine parameter reaches this value.       */
+    double max_lambda;
+
+    /*  Integration stops once r < 2M + horizon_epsilon. The equations are    *
+     *  singular at the horizon, so this should be positive.                  */
+    double horizon_epsilon;
+
+    /*  Integration stops once r > escape_radius with dr / dlambda > 0, the   *
+     *  ray has reached the celestial sphere. Zero disables this check.       */
+    double escape_radius;
+
+    /*  Integration stops once this many steps, accepted or not, are taken.   */
+    unsigned long int max_steps;
+};
+
+/*  Cached sin(theta) and cos(theta), see the notes at the top of the file.   */
+struct sbh_geodesic_trig {
+
+    /*  The angle the sine and cosine were computed for.                      */
+    double theta;
+
+    /*  sin(theta) and cos(theta).                                            */
+    double sin_theta, cos_theta;
+
+    /*  The number of incremental updates since the last full refresh.        */
+    unsigned int updates;
+};
+
+/*  The state carried between the steps of an integration.                    */
+struct sbh_geodesic_stepper {
+
+    /*  The affine parameter travelled so far.                                */
+    double lambda;
+
+    /*  The next step size to try.                                            */
+    double h;
+
+    /*  DP45 only. The derivative at the current state.                       */
+    struct sbh_geodesic k1;
+
+    /*  The number of steps taken so far, accepted or not.                    */
+    unsigned long int steps;
+
+    /*  The number of those steps that were rejected. Only counted if         *
+     *  SBH_STATS is defined, see sbh_stats.h.                                */
+    unsigned long int rejected;
+
+    /*  The sine and cosine of theta at the current state of the ray.         */
+    struct sbh_geodesic_trig trig;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_default_params                                           *
+ *  Purpose:                                                                  *
+ *      Creates a reasonable set of integrator parameters for a black hole.   *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_geodesic_params):                                  *
+ *          Parameters for adaptive DP45 integration. The step sizes scale    *
+ *          with the mass, and the affine parameter limit is large enough for *
+ *          rays with |v| ~ 1 to travel a few thousand M. Rays stop 0.001 M   *
+ *          outside the horizon, or heading outwards past 1000 M.             *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic_params
+sbh_geodesic_default_params(double mass)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic_params params;
+
+    /*  Set the defaults and return.                                          */
+    params.mass = mass;
+    params.method = SBH_GEODESIC_DP45;
+    params.step = 0.01 * mass;
+    params.tolerance = 1.0E-8;
+    params.min_step = 1.0E-10 * mass;
+    params.max_step = 100.0 * mass;
+    params.max_lambda = 1.0E+04 * mass;
+    params.horizon_epsilon = 1.0E-03 * mass;
+    params.escape_radius = 1.0E+03 * mass;
+    params.max_steps = 100000UL;
+    return params;
+}
+/*  End of sbh_geodesic_default_params.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_create                                                   *
+ *  Purpose:                                                                  *
+ *      Creates a ray from a position and a velocity.                         *
+ *  Arguments:                                                                *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The position, in Schwarzschild coordinates.                       *
+ *      v (const struct sbh_vec4 *):                                          *
+ *          The velocity, in Schwarzschild coordinates.                       *
+ *  Outputs:                                                                  *
+ *      ray (struct sbh_geodesic):                                            *
+ *          The ray with the given position and velocity.                     *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic
+sbh_geodesic_create(const struct sbh_vec4 *p, const struct sbh_vec4 *v)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic ray;
+
+    /*  Copy the vectors and return.                                          */
+    ray.p = *p;
+    ray.v = *v;
+    return ray;
+}
+/*  End of sbh_geodesic_create.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_null_time_component                                      *
+ *  Purpose:                                                                  *
+ *      Given a position and the spatial part of a velocity, computes the     *
+ *      time component that makes the velocity null and future pointing.      *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The position, in Schwarzschild coordinates, with r > 2M.          *
+ *      v (const struct sbh_vec4 *):                                          *
+ *          The velocity. Only the spatial part, dat[0] to dat[2], is used.   *
+ *  Outputs:                                                                  *
+ *      vt (double):                                                          *
+ *          The value for v->dat[3] such that g(v, v) = 0 and vt > 0.         *
+ *  Method:                                                                   *
+ *      Solve f vt^2 = vr^2 / f + r^2 (vtheta^2 + sin^2(theta) vphi^2).       *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_geodesic_null_time_component(double mass,
+                                 const struct sbh_vec4 *p,
+                                 const struct sbh_vec4 *v)
+{
+    /*  Declare necessary variables.                                          */
+    const double r = p->dat[0];
+    const double sin_theta = sin(p->dat[2]);
+    const double f = 1.0 - 2.0 * mass / r;
+    const double vr = v->dat[0];
+    const double vphi = v->dat[1] * sin_theta;
+    const double vtheta = v->dat[2];
+
+    /*  The spatial part of g(v, v), which the time part must cancel.         */
+    const double spatial = vr * vr / f + r * r * (vtheta*vtheta + vphi*vphi);
+    return sqrt(spatial / f);
+}
+/*  End of sbh_geodesic_null_time_component.                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_norm_squared                                             *
+ *  Purpose:                                                                  *
+ *      Computes g(v, v) for the velocity of a ray. For a light ray this is   *
+ *      zero, so it is a useful check on the accuracy of the integration.     *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The ray.                                                          *
+ *  Outputs:                                                                  *
+ *      norm_sq (double):                                                     *
+ *          The Schwarzschild inner product of the velocity with itself.      *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_geodesic_norm_squared(double mass, const struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    const double r = ray->p.dat[0];
+    const double sin_theta = sin(ray->p.dat[2]);
+    const double f = 1.0 - 2.0 * mass / r;
+    const double vr = ray->v.dat[0];
+    const double vphi = ray->v.dat[1] * sin_theta;
+    const double vtheta = ray->v.dat[2];
+    const double vt = ray->v.dat[3];
+
+    /*  Apply the metric to the velocity vector.                              */
+    return -f*vt*vt + vr*vr / f + r*r*(vtheta*vtheta + vphi*vphi);
+}
+/*  End of sbh_geodesic_norm_squared.                                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_trig_create                                              *
+ *  Purpose:                                                                  *
+ *      Creates a trig cache for a given angle.                               *
+ *  Arguments:                                                                *
+ *      theta (double):                                                       *
+ *          The polar angle.                                                  *
+ *  Outputs:                                                                  *
+ *      trig (struct sbh_geodesic_trig):                                      *
+ *          The cache, with sin(theta) and cos(theta) from sbh_sincos.        *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic_trig sbh_geodesic_trig_create(double theta)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic_trig trig;
+
+    /*  A full evaluation, which also resets the drift.                       */
+    trig.theta = theta;
+    trig.updates = 0U;
+    sbh_sincos(theta, &trig.sin_theta, &trig.cos_theta);
+    return trig;
+}
+/*  End of sbh_geodesic_trig_create.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_trig_eval                                                *
+ *  Purpose:                                                                  *
+ *      Computes sin(theta) and cos(theta) for an angle near a cached one.    *
+ *  Arguments:                                                                *
+ *      trig (const struct sbh_geodesic_trig *):                              *
+ *          The cache.                                                        *
+ *      theta (double):                                                       *
+ *          The polar angle.                                                  *
+ *      sin_theta (double *):                                                 *
+ *          Set to sin(theta).                                                *
+ *      cos_theta (double *):                                                 *
+ *          Set to cos(theta).                                                *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      With d = theta - trig->theta, use                                     *
+ *                                                                            *
+ *          sin(theta) = s + (s (cos(d) - 1) + c sin(d))                      *
+ *          cos(theta) = c + (c (cos(d) - 1) - s sin(d))                      *
+ *                                                                            *
+ *      where s and c are the cached values. sin(d) is summed to d^7 and      *
+ *      cos(d) - 1 to d^8, the first omitted terms are below 10^-16 for       *
+ *      |d| <= 1 / 16. Larger changes, and NaN, fall back to sbh_sincos.      *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_geodesic_trig_eval(const struct sbh_geodesic_trig *trig, double theta,
+                       double *sin_theta, double *cos_theta)
+{
+    /*  Declare necessary variables.                                          */
+    const double d = theta - trig->theta;
+    const double d_sq = d * d;
+    double sin_d, cos_d_minus_one;
+
+    /*  Written so that NaN takes the slow path, which returns NaN.           */
+    if (!(fabs(d) <= SBH_GEODESIC_TRIG_MAX_DELTA))
+    {
+        sbh_sincos(theta, sin_theta, cos_theta);
+        return;
+    }
+
+    /*  The Taylor series, in Horner form.                                    */
+    sin_d = d + d * d_sq * (-1.0 / 6.0 + d_sq * (1.0 / 120.0 +
+            d_sq * (-1.0 / 5040.0)));
+    cos_d_minus_one = d_sq * (-0.5 + d_sq * (1.0 / 24.0 +
+                      d_sq * (-1.0 / 720.0 + d_sq * (1.0 / 40320.0))));
+
+    /*  The angle addition formulas, with the small correction added last.    */
+    *sin_theta = trig->sin_theta + (trig->sin_theta * cos_d_minus_one +
+                                    trig->cos_theta * sin_d);
+    *cos_theta = trig->cos_theta + (trig->cos_theta * cos_d_minus_one -
+                                    trig->sin_theta * sin_d);
+}
+/*  End of sbh_geodesic_trig_eval.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_trig_update                                              *
+ *  Purpose:                                                                  *
+ *      Moves a trig cache to a new angle.                                    *
+ *  Arguments:                                                                *
+ *      trig (struct sbh_geodesic_trig *):                                    *
+ *          The cache.                                                        *
+ *      theta (double):                                                       *
+ *          The new angle.                                                    *
+ *      sin_theta (double):                                                   *
+ *          sin(theta), usually from sbh_geodesic_trig_eval.                  *
+ *      cos_theta (double):                                                   *
+ *          cos(theta).                                                       *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      Every SBH_GEODESIC_TRIG_REFRESH updates the given values are ignored  *
+ *      and the cache is recomputed with sbh_sincos.                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_geodesic_trig_update(struct sbh_geodesic_trig *trig, double theta,
+                         double sin_theta, double cos_theta)
+{
+    /*  Incremental values accumulate rounding error, refresh periodically.   */
+    if (++trig->updates >= SBH_GEODESIC_TRIG_REFRESH)
+    {
+        *trig = sbh_geodesic_trig_create(theta);
+        return;
+    }
+
+    trig->theta = theta;
+    trig->sin_theta = sin_theta;
+    trig->cos_theta = cos_theta;
+}
+/*  End of sbh_geodesic_trig_update.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_derivative_trig                                          *
+ *  Purpose:                                                                  *
+ *      Computes the right-hand side of the geodesic equation, given the sine *
+ *      and cosine of the polar angle of the ray.                             *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The current state of the ray.                                     *
+ *      sin_theta (double):                                                   *
+ *          sin(theta) for the polar angle of the ray.                        *
+ *      cos_theta (double):                                                   *
+ *          cos(theta) for the polar angle of the ray.                        *
+ *  Outputs:                                                                  *
+ *      d (struct sbh_geodesic):                                              *
+ *          The derivative of the state with respect to the affine parameter. *
+ *  Method:                                                                   *
+ *      See sbh_geodesic_derivative.                                          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic
+sbh_geodesic_derivative_trig(double mass, const struct sbh_geodesic *ray,
+                             double sin_theta, double cos_theta)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic d;
+    const double r = ray->p.dat[0];
+    const double rcpr_r = 1.0 / r;
+    const double f = 1.0 - 2.0 * mass * rcpr_r;
+    const double m_by_r_sq = mass * rcpr_r * rcpr_r;
+    const double vr = ray->v.dat[0];
+    const double vphi = ray->v.dat[1];
+    const double vtheta = ray->v.dat[2];
+    const double vt = ray->v.dat[3];
+
+    /*  The derivative of the position is the velocity.                       */
+    d.p = ray->v;
+
+    /*  The radial acceleration has terms from t, r, theta, and phi.          */
+    d.v.dat[0] = -m_by_r_sq * f * vt * vt + m_by_r_sq / f * vr * vr +
+                 r * f * (vtheta*vtheta + sin_theta*sin_theta*vphi*vphi);
+
+    /*  The azimuthal acceleration. The cot(theta) term is the pole problem.  */
+    d.v.dat[1] = -2.0 * vphi * (vr * rcpr_r + cos_theta / sin_theta * vtheta);
+
+    /*  The polar acceleration.                                               */
+    d.v.dat[2] = -2.0 * vr * vtheta * rcpr_r + sin_theta*cos_theta*vphi*vphi;
+
+    /*  The time acceleration.                                                */
+    d.v.dat[3] = -2.0 * m_by_r_sq / f * vt * vr;
+    return d;
+}
+/*  End of sbh_geodesic_derivative_trig.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_derivative                                               *
+ *  Purpose:                                                                  *
+ *      Computes the right-hand side of the geodesic equation. The derivative *
+ *      of the position is the velocity, and the derivative of the velocity   *
+ *      is -Gamma^mu_ab v^a v^b.                                              *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The current state of the ray.                                     *
+ *  Outputs:                                                                  *
+ *      d (struct sbh_geodesic):                                              *
+ *          The derivative of the state with respect to the affine parameter. *
+ *  Method:                                                                   *
+ *      The non-zero Christoffel symbols for the Schwarzschild metric are:    *
+ *                                                                            *
+ *          Gamma^t_tr = M / (r^2 f)                                          *
+ *          Gamma^r_tt = M f / r^2                                            *
+ *          Gamma^r_rr = -M / (r^2 f)                                         *
+ *          Gamma^r_theta_theta = -r f                                        *
+ *          Gamma^r_phi_phi = -r f sin^2(theta)                               *
+ *          Gamma^theta_r_theta = Gamma^phi_r_phi = 1 / r                     *
+ *          Gamma^theta_phi_phi = -sin(theta) cos(theta)                      *
+ *          Gamma^phi_theta_phi = cot(theta)                                  *
+ *                                                                            *
+ *      Symbols with mixed lower indices appear twice in the sum.             *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic
+sbh_geodesic_derivative(double mass, const struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    double sin_theta, cos_theta;
+
+    /*  One fused sincos call gives every angular factor we need.             */
+    sbh_sincos(ray->p.dat[2], &sin_theta, &cos_theta);
+    return sbh_geodesic_derivative_trig(mass, ray, sin_theta, cos_theta);
+}
+/*  End of sbh_geodesic_derivative.                                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_derivative_cached                                        *
+ *  Purpose:                                                                  *
+ *      Computes the right-hand side of the geodesic equation, taking the     *
+ *      angular factors from a trig cache.                                    *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The current state of the ray.                                     *
+ *      trig (const struct sbh_geodesic_trig *):                              *
+ *          A cache for an angle near the polar angle of the ray.             *
+ *  Outputs:                                                                  *
+ *      d (struct sbh_geodesic):                                              *
+ *          The derivative of the state with respect to the affine parameter. *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic
+sbh_geodesic_derivative_cached(double mass, const struct sbh_geodesic *ray,
+                               const struct sbh_geodesic_trig *trig)
+{
+    /*  Declare necessary variables.                                          */
+    double sin_theta, cos_theta;
+
+    /*  Rotate the cached values to the angle of this state.                  */
+    sbh_geodesic_trig_eval(trig, ray->p.dat[2], &sin_theta, &cos_theta);
+    return sbh_geodesic_derivative_trig(mass, ray, sin_theta, cos_theta);
+}
+/*  End of sbh_geodesic_derivative_cached.                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_combine                                                  *
+ *  Purpose:                                                                  *
+ *      Computes y + h sum_n c_n k_n, the operation every Runge-Kutta stage   *
+ *      is built from.                                                        *
+ *  Arguments:                                                                *
+ *      y (const struct sbh_geodesic *):                                      *
+ *          The base state.                                                   *
+ *      h (double):                                                           *
+ *          The step size.                                                    *
+ *      c (const double *):                                                   *
+ *          The coefficients, one for each stage.                             *
+ *      k (const struct sbh_geodesic *):                                      *
+ *          The stage derivatives.                                            *
+ *      n_stages (unsigned int):                                              *
+ *          The number of elements in c and k.                                *
+ *  Outputs:                                                                  *
+ *      out (struct sbh_geodesic):                                            *
+ *          The combined state.                                               *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic
+sbh_geodesic_combine(const struct sbh_geodesic *y,
+                     double h,
+                     const double *c,
+                     const struct sbh_geodesic *k,
+                     unsigned int n_stages)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic out = *y;
+    unsigned int stage, n;
+
+    /*  Add the contribution of each stage to each of the eight components.   */
+    for (stage = 0U; stage < n_stages; ++stage)
+    {
+        const double hc = h * c[stage];
+
+        /*  Zero coefficients are common in Butcher tableaus. Skip them.      */
+        if (hc == 0.0)
+            continue;
+
+        for (n = 0U; n < 4U; ++n)
+        {
+            out.p.dat[n] += hc * k[stage].p.dat[n];
+            out.v.dat[n] += hc * k[stage].v.dat[n];
+        }
+    }
+
+    return out;
+}
+/*  End of sbh_geodesic_combine.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_rk4_step_cached                                          *
+ *  Purpose:                                                                  *
+ *      Performs one step of the classic fourth order Runge-Kutta method,     *
+ *      using and updating a trig cache.                                      *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray, advanced by h in place.                                  *
+ *      h (double):                                                           *
+ *          The step size.                                                    *
+ *      trig (struct sbh_geodesic_trig *):                                    *
+ *          A cache for the polar angle of the ray. On output it is for the   *
+ *          angle after the step.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_geodesic_rk4_step_cached(double mass, struct sbh_geodesic *ray, double h,
+                             struct sbh_geodesic_trig *trig)
+{
+    /*  The weights for the final combination, and for the midpoints.         */
+    const double weights[4] = {1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0};
+    const double half = 0.5;
+    const double one = 1.0;
+
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic k[4], tmp;
+    double sin_theta, cos_theta;
+
+    /*  Evaluate the four stages.                                             */
+    k[0] = sbh_geodesic_derivative_cached(mass, ray, trig);
+    tmp = sbh_geodesic_combine(ray, h, &half, k, 1U);
+    k[1] = sbh_geodesic_derivative_cached(mass, &tmp, trig);
+    tmp = sbh_geodesic_combine(ray, h, &half, k + 1, 1U);
+    k[2] = sbh_geodesic_derivative_cached(mass, &tmp, trig);
+    tmp = sbh_geodesic_combine(ray, h, &one, k + 2, 1U);
+    k[3] = sbh_geodesic_derivative_cached(mass, &tmp, trig);
+
+    /*  Combine the stages to advance the ray, and move the cache with it.    */
+    *ray = sbh_geodesic_combine(ray, h, weights, k, 4U);
+    sbh_geodesic_trig_eval(trig, ray->p.dat[2], &sin_theta, &cos_theta);
+    sbh_geodesic_trig_update(trig, ray->p.dat[2], sin_theta, cos_theta);
+}
+/*  End of sbh_geodesic_rk4_step_cached.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_rk4_step                                                 *
+ *  Purpose:                                                                  *
+ *      Performs one step of the classic fourth order Runge-Kutta method.     *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray, advanced by h in place.                                  *
+ *      h (double):                                                           *
+ *          The step size.                                                    *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      The stages share one sincos call through a temporary trig cache.      *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_geodesic_rk4_step(double mass, struct sbh_geodesic *ray, double h)
+{
+    struct sbh_geodesic_trig trig = sbh_geodesic_trig_create(ray->p.dat[2]);
+    sbh_geodesic_rk4_step_cached(mass, ray, h, &trig);
+}
+/*  End of sbh_geodesic_rk4_step.                                             */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_dp45_step_cached                                         *
+ *  Purpose:                                                                  *
+ *      Attempts one step of the Dormand-Prince 5(4) method and computes the  *
+ *      step size to use next, using and updating a trig cache.               *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters. The mass, tolerance, and step bounds   *
+ *          are used.                                                         *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray. It is advanced in place if the step is accepted.         *
+ *      k1 (struct sbh_geodesic *):                                           *
+ *          The derivative at the current state. On acceptance this is set to *
+ *          the derivative at the new state (first same as last).             *
+ *      h (double *):                                                         *
+ *          On input the step to try, on output the step to try next.         *
+ *      trig (struct sbh_geodesic_trig *):                                    *
+ *          A cache for the polar angle of the ray. It is moved to the new    *
+ *          state if the step is accepted.                                    *
+ *  Outputs:                                                                  *
+ *      accepted (int):                                                       *
+ *          1 if the step was accepted, 0 if it was rejected.                 *
+ *  Method:                                                                   *
+ *      Compute the seven stages, use the difference of the fifth and fourth  *
+ *      order solutions as the error estimate, and rescale h by               *
+ *      0.9 err^(-1/5) clamped to [0.2, 5]. err is the largest component      *
+ *      error divided by tolerance * (1 + |y|). Steps at min_step are always  *
+ *      accepted so the integration cannot stall.                             *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_geodesic_dp45_step_cached(const struct sbh_geodesic_params *params,
+                              struct sbh_geodesic *ray,
+                              struct sbh_geodesic *k1,
+                              double *h,
+                              struct sbh_geodesic_trig *trig)
+{
+    /*  The Dormand-Prince tableau. Only the lower triangle is stored.        */
+    static const double a2[1] = {1.0/5.0};
+    static const double a3[2] = {3.0/40.0, 9.0/40.0};
+    static const double a4[3] = {44.0/45.0, -56.0/15.0, 32.0/9.0};
+    static const double a5[4] = {
+        19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0
+    };
+    static const double a6[5] = {
+        9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0,
+        -5103.0/18656.0
+    };
+
+    /*  The fifth order weights. These are also the seventh stage.            */
+    static const double b[6] = {
+        35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
+    };
+
+    /*  The difference between the fifth and fourth order weights.            */
+    static const double e[7] = {
+        71.0/57600.0, 0.0, -71.0/16695.0, 71.0/1920.0, -17253.0/339200.0,
+        22.0/525.0, -1.0/40.0
+    };
+
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic k[7], tmp, next, err;
+    double err_max = 0.0;
+    double factor, sin_theta, cos_theta;
+    unsigned int n;
+
+    /*  The first stage is the derivative we were given.                      */
+    k[0] = *k1;
+
+    /*  Evaluate the remaining stages from the tableau.                       */
+    tmp = sbh_geodesic_combine(ray, *h, a2, k, 1U);
+    k[1] = sbh_geodesic_derivative_cached(params->mass, &tmp, trig);
+    tmp = sbh_geodesic_combine(ray, *h, a3, k, 2U);
+    k[2] = sbh_geodesic_derivative_cached(params->mass, &tmp, trig);
+    tmp = sbh_geodesic_combine(ray, *h, a4, k, 3U);
+    k[3] = sbh_geodesic_derivative_cached(params->mass, &tmp, trig);
+    tmp = sbh_geodesic_combine(ray, *h, a5, k, 4U);
+    k[4] = sbh_geodesic_derivative_cached(params->mass, &tmp, trig);
+    tmp = sbh_geodesic_combine(ray, *h, a6, k, 5U);
+    k[5] = sbh_geodesic_derivative_cached(params->mass, &tmp, trig);
+    next = sbh_geodesic_combine(ray, *h, b, k, 6U);
+
+    /*  The last stage is at the new state. Keep its angular factors, they    *
+     *  become the cache if the step is accepted.                             */
+    sbh_geodesic_trig_eval(trig, next.p.dat[2], &sin_theta, &cos_theta);
+    k[6] = sbh_geodesic_derivative_trig(params->mass, &next,
+                                        sin_theta, cos_theta);
+
+    /*  The error estimate is h times the e-weighted sum of the stages.       */
+    for (n = 0U; n < 4U; ++n)
+    {
+        err.p.dat[n] = 0.0;
+        err.v.dat[n] = 0.0;
+    }
+
+    err = sbh_geodesic_combine(&err, *h, e, k, 7U);
+
+    /*  Scale each component by the size of the state and find the worst.     */
+    for (n = 0U; n < 4U; ++n)
+    {
+        const double sp = 1.0 + fabs(next.p.dat[n]);
+        const double sv = 1.0 + fabs(next.v.dat[n]);
+        const double ep = fabs(err.p.dat[n]) / sp;
+        const double ev = fabs(err.v.dat[n]) / sv;
+
+        if (ep > err_max)
+            err_max = ep;
+
+        if (ev > err_max)
+            err_max = ev;
+    }
+
+    err_max /= params->tolerance;
+
+    /*  Compute the new step size. NaN errors, from stepping into the         *
+     *  horizon for example, are treated as a huge error.                     */
+    if (err_max == 0.0)
+        factor = 5.0;
+    else if (!(err_max == err_max))
+        factor = 0.2;
+    else
+    {
+        factor = 0.9 * pow(err_max, -0.2);
+
+        if (factor < 0.2)
+            factor = 0.2;
+        else if (factor > 5.0)
+            factor = 5.0;
+    }
+
+    /*  Steps at the minimum size must be accepted, or we may loop forever.   */
+    if (err_max <= 1.0 || fabs(*h) <= params->min_step)
+    {
+        *ray = next;
+        *k1 = k[6];
+        *h *= factor;
+        sbh_geodesic_trig_update(trig, next.p.dat[2], sin_theta, cos_theta);
+
+        if (fabs(*h) > params->max_step)
+            *h = (*h < 0.0 ? -params->max_step : params->max_step);
+
+        return 1;
+    }
+
+    /*  Otherwise the step is rejected. Shrink it, but not below min_step.    */
+    *h *= factor;
+
+    if (fabs(*h) < params->min_step)
+        *h = (*h < 0.0 ? -params->min_step : params->min_step);
+
+    return 0;
+}
+/*  End of sbh_geodesic_dp45_step_cached.                                     */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_dp45_step                                                *
+ *  Purpose:                                                                  *
+ *      Attempts one step of the Dormand-Prince 5(4) method and computes the  *
+ *      step size to use next.                                                *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters. The mass, tolerance, and step bounds   *
+ *          are used.                                                         *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray. It is advanced in place if the step is accepted.         *
+ *      k1 (struct sbh_geodesic *):                                           *
+ *          The derivative at the current state. On acceptance this is set to *
+ *          the derivative at the new state (first same as last).             *
+ *      h (double *):                                                         *
+ *          On input the step to try, on output the step to try next.         *
+ *  Outputs:                                                                  *
+ *      accepted (int):                                                       *
+ *          1 if the step was accepted, 0 if it was rejected.                 *
+ *  Notes:                                                                    *
+ *      See sbh_geodesic_dp45_step_cached. The stages share one sincos call   *
+ *      through a temporary trig cache.                                       *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_geodesic_dp45_step(const struct sbh_geodesic_params *params,
+                       struct sbh_geodesic *ray,
+                       struct sbh_geodesic *k1,
+                       double *h)
+{
+    struct sbh_geodesic_trig trig = sbh_geodesic_trig_create(ray->p.dat[2]);
+    return sbh_geodesic_dp45_step_cached(params, ray, k1, h, &trig);
+}
+/*  End of sbh_geodesic_dp45_step.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_status                                                   *
+ *  Purpose:                                                                  *
+ *      Determines if the fate of a ray has been decided.                     *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The current state of the ray.                                     *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          SBH_RAY_CAPTURED if r < 2M + horizon_epsilon, SBH_RAY_ESCAPED if  *
+ *          r > escape_radius heading outwards, and SBH_RAY_INCOMPLETE        *
+ *          otherwise.                                                        *
+ ******************************************************************************/
+SBH_INLINE enum sbh_ray_status
+sbh_geodesic_status(const struct sbh_geodesic_params *params,
+                    const struct sbh_geodesic *ray)
+{
+    const double r = ray->p.dat[0];
+
+    /*  Written so that NaN, which a step through r = 2M may produce, counts  *
+     *  as captured rather than running on to the step limit.                 */
+    if (!(r >= 2.0 * params->mass + params->horizon_epsilon))
+        return SBH_RAY_CAPTURED;
+
+    if (params->escape_radius > 0.0 && r > params->escape_radius)
+        if (ray->v.dat[0] > 0.0)
+            return SBH_RAY_ESCAPED;
+
+    return SBH_RAY_INCOMPLETE;
+}
+/*  End of sbh_geodesic_status.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_stepper_create                                           *
+ *  Purpose:                                                                  *
+ *      Prepares to integrate a ray one step at a time.                       *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial state of the ray.                                     *
+ *  Outputs:                                                                  *
+ *      stepper (struct sbh_geodesic_stepper):                                *
+ *          The state for sbh_geodesic_advance, at lambda = 0.                *
+ ******************************************************************************/
+SBH_INLINE struct sbh_geodesic_stepper
+sbh_geodesic_stepper_create(const struct sbh_geodesic_params *params,
+                            const struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic_stepper stepper;
+
+    stepper.lambda = 0.0;
+    stepper.h = params->step;
+    stepper.steps = 0UL;
+    stepper.rejected = 0UL;
+    stepper.trig = sbh_geodesic_trig_create(ray->p.dat[2]);
+
+    /*  The first DP45 stage is the last stage of the previous step, so the   *
+     *  derivative is only computed once here. RK4 does not use it.           */
+    if (params->method == SBH_GEODESIC_DP45)
+        stepper.k1 = sbh_geodesic_derivative_trig(params->mass, ray,
+                                                  stepper.trig.sin_theta,
+                                                  stepper.trig.cos_theta);
+    else
+        stepper.k1 = *ray;
+
+    return stepper;
+}
+/*  End of sbh_geodesic_stepper_create.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_advance                                                  *
+ *  Purpose:                                                                  *
+ *      Takes one accepted step along a ray.                                  *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      stepper (struct sbh_geodesic_stepper *):                              *
+ *          The stepper, from sbh_geodesic_stepper_create.                    *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray. On output it holds the state after the step.             *
+ *  Outputs:                                                                  *
+ *      advanced (int):                                                       *
+ *          1 if a step was accepted, and 0 if max_lambda or max_steps was    *
+ *          reached first, in which case the ray is unchanged.                *
+ *  Method:                                                                   *
+ *      With DP45, retry rejected steps with the smaller step size until one  *
+ *      is accepted. The step is shortened so that max_lambda is not          *
+ *      overshot, and if the shortened step is accepted the step size of the  *
+ *      controller is kept as it was. Every attempt counts toward max_steps.  *
+ *      The stepper's trig cache follows the ray, so after each call          *
+ *      stepper->trig holds the sine and cosine of the current polar angle.   *
+ *  Notes:                                                                    *
+ *      This is the building block for integrators that need to look at each  *
+ *      step, for example to find where a ray crosses a surface.              *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_geodesic_advance(const struct sbh_geodesic_params *params,
+                     struct sbh_geodesic_stepper *stepper,
+                     struct sbh_geodesic *ray)
+{
+    while (stepper->steps < params->max_steps &&
+           stepper->lambda < params->max_lambda)
+    {
+        double step = stepper->h;
+        double next;
+        int clipped = 0;
+
+        /*  Shorten the step so we land exactly on max_lambda.                */
+        if (stepper->lambda + step > params->max_lambda)
+        {
+            step = params->max_lambda - stepper->lambda;
+            clipped = 1;
+        }
+
+        ++stepper->steps;
+
+        /*  Fixed step size, just take a step of size h.                      */
+        if (params->method == SBH_GEODESIC_RK4)
+        {
+            sbh_geodesic_rk4_step_cached(params->mass, ray, step,
+                                         &stepper->trig);
+            stepper->lambda += step;
+            return 1;
+        }
+
+        /*  Adaptive step size. On return next holds the next step to try.    */
+        next = step;
+
+        if (sbh_geodesic_dp45_step_cached(params, ray, &stepper->k1,
+                                          &next, &stepper->trig))
+        {
+            /*  A shortened step says nothing about the step size the error   *
+             *  allows, so keep h for a ray continued past max_lambda.        */
+            if (!clipped)
+                stepper->h = next;
+
+            stepper->lambda += step;
+            return 1;
+        }
+
+        stepper->h = next;
+
+        SBH_STATS_ADD(stepper->rejected, 1UL);
+    }
+
+    return 0;
+}
+/*  End of sbh_geodesic_advance.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_integrate                                                *
+ *  Purpose:                                                                  *
+ *      Integrates a single ray.                                              *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray. On output it holds the final state.                      *
+ *  Outputs:                                                                  *
+ *      steps (unsigned long int):                                            *
+ *          The number of steps taken, including rejected DP45 steps.         *
+ *  Method:                                                                   *
+ *      Step with sbh_geodesic_advance until the ray is captured or escapes,  *
+ *      as decided by sbh_geodesic_status, until the affine parameter         *
+ *      reaches max_lambda, or until max_steps steps have been taken. Call    *
+ *      sbh_geodesic_status on the final state to find the reason             *
+ *      integration stopped.                                                  *
+ ******************************************************************************/
+SBH_INLINE unsigned long int
+sbh_geodesic_integrate(const struct sbh_geodesic_params *params,
+                       struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic_stepper stepper;
+
+    /*  Rays that start captured or escaped need no work.                     */
+    if (sbh_geodesic_status(params, ray) != SBH_RAY_INCOMPLETE)
+        return 0UL;
+
+    stepper = sbh_geodesic_stepper_create(params, ray);
+
+    while (sbh_geodesic_advance(params, &stepper, ray))
+        if (sbh_geodesic_status(params, ray) != SBH_RAY_INCOMPLETE)
+            break;
+
+    return stepper.steps;
+}
+/*  End of sbh_geodesic_integrate.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_record                                                   *
+ *  Purpose:                                                                  *
+ *      Integrates a single ray and records its trajectory.                   *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      ray (struct sbh_geodesic *):                                          *
+ *          The ray. On output it holds the final state.                      *
+ *      arena (struct sbh_arena *):                                           *
+ *          The arena the trajectory is allocated from.                       *
+ *      points (struct sbh_vec4 **):                                          *
+ *          Set to the positions of the ray, the initial position followed by *
+ *          the position after every accepted step, in Schwarzschild          *
+ *          coordinates. Valid until the arena is reset.                      *
+ *      count (size_t *):                                                     *
+ *          Set to the number of points.                                      *
+ *  Outputs:                                                                  *
+ *      steps (unsigned long int):                                            *
+ *          As for sbh_geodesic_integrate. If the arena runs out of memory    *
+ *          integration stops early, *points is NULL and *count is zero.      *
+ *  Method:                                                                   *
+ *      The same loop as sbh_geodesic_integrate. The buffer is the most       *
+ *      recent allocation of the arena, so it usually grows in place, and it  *
+ *      doubles when it does not, for amortized constant cost per step.       *
+ ******************************************************************************/
+SBH_INLINE unsigned long int
+sbh_geodesic_record(const struct sbh_geodesic_params *params,
+                    struct sbh_geodesic *ray,
+                    struct sbh_arena *arena,
+                    struct sbh_vec4 **points,
+                    size_t *count)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_geodesic_stepper stepper;
+    size_t capacity = 64;
+    size_t len = 1;
+    struct sbh_vec4 *buffer;
+
+    buffer = (struct sbh_vec4 *)sbh_arena_alloc(arena,
+                                                sizeof(*buffer) * capacity);
+    *points = NULL;
+    *count = 0;
+
+    if (!buffer)
+        return 0UL;
+
+    buffer[0] = ray->p;
+    stepper = sbh_geodesic_stepper_create(params, ray);
+
+    if (sbh_geodesic_status(params, ray) == SBH_RAY_INCOMPLETE)
+    {
+        while (sbh_geodesic_advance(params, &stepper, ray))
+        {
+            if (len == capacity)
+            {
+                buffer = (struct sbh_vec4 *)sbh_arena_extend(
+                    arena, buffer, sizeof(*buffer) * capacity,
+                    2 * sizeof(*buffer) * capacity
+                );
+
+                if (!buffer)
+                    return stepper.steps;
+
+                capacity *= 2;
+            }
+
+            buffer[len] = ray->p;
+            ++len;
+
+            if (sbh_geodesic_status(params, ray) != SBH_RAY_INCOMPLETE)
+                break;
+        }
+    }
+
+    *points = buffer;
+    *count = len;
+    return stepper.steps;
+}
+/*  End of sbh_geodesic_record.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_integrate_array                                          *
+ *  Purpose:                                                                  *
+ *      Integrates an array of rays with the same parameters.                 *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      rays (struct sbh_geodesic *):                                         *
+ *          The rays. On output they hold the final states.                   *
+ *      len (size_t):                                                         *
+ *          The number of rays.                                               *
+ *  Outputs:                                                                  *
+ *      steps (unsigned long int):                                            *
+ *          The total number of steps taken over all rays.                    *
+ ******************************************************************************/
+SBH_INLINE unsigned long int
+sbh_geodesic_integrate_array(const struct sbh_geodesic_params *params,
+                             struct sbh_geodesic *rays,
+                             size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    unsigned long int steps = 0UL;
+    size_t n;
+
+    /*  Rays are independent, integrate them one after the other.             */
+    for (n = 0; n < len; ++n)
+        steps += sbh_geodesic_integrate(params, rays + n);
+
+    return steps;
+}
+/*  End of sbh_geodesic_integrate_array.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_trace                                                    *
+ *  Purpose:                                                                  *
+ *      Traces a light ray with the full geodesic equations.                  *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity of the ray.                     *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          The fate of the ray and its final position and direction, in the  *
+ *          same form as the other engines.                                   *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_result
+sbh_geodesic_trace(const struct sbh_geodesic_params *params,
+                   const struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_result result;
+    struct sbh_geodesic state = *ray;
+    struct sbh_geodesic_stepper stepper;
+    struct sbh_vec4 velocity;
+
+    /*  The loop of sbh_geodesic_integrate, keeping the stepper so that the   *
+     *  rejected steps can be reported.                                       */
+    stepper = sbh_geodesic_stepper_create(params, &state);
+
+    if (sbh_geodesic_status(params, &state) == SBH_RAY_INCOMPLETE)
+        while (sbh_geodesic_advance(params, &stepper, &state))
+            if (sbh_geodesic_status(params, &state) != SBH_RAY_INCOMPLETE)
+                break;
+
+    /*  Convert the final state to Cartesian coordinates.                     */
+    result.steps = stepper.steps;
+    result.rejected = stepper.rejected;
+    result.status = sbh_geodesic_status(params, &state);
+    result.position = sbh_vec4_schwarzschild_to_rect(&state.p);
+    velocity = sbh_vec4_rect_velocity_from_schwarzschild(&state.p, &state.v);
+    result.direction = sbh_vec4_spatial_normalize(&velocity);
+
+    /*  t is the last component of the state, integrated with the rest.       */
+    result.time = state.p.dat[3] - ray->p.dat[3];
+    result.lambda = stepper.lambda;
+    return result;
+}
+/*  End of sbh_geodesic_trace.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_geodesic_trace_array                                              *
+ *  Purpose:                                                                  *
+ *      Traces an array of light rays with the full geodesic equations.       *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_geodesic_params *):                          *
+ *          The integrator parameters.                                        *
+ *      rays (const struct sbh_geodesic *):                                   *
+ *          The initial positions and velocities of the rays.                 *
+ *      results (struct sbh_ray_result *):                                    *
+ *          The output array, one result per ray.                             *
+ *      len (size_t):                                                         *
+ *          The number of rays.                                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_geodesic_trace_array(const struct sbh_geodesic_params *params,
+                         const struct sbh_geodesic *rays,
+                         struct sbh_ray_result *results,
+                         size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t k;
+
+    /*  Rays are independent, trace them one after the other.                 */
+    for (k = 0; k < len; ++k)
+        results[k] = sbh_geodesic_trace(params, rays + k);
+}
+/*  End of sbh_geodesic_trace_array.                                          */
+
+#endif
+/*  End of include guard.                                                     */
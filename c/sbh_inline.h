@@ -29,20 +29,25 @@
 #ifndef SBH_INLINE_H
 #define SBH_INLINE_H
 
+/*  CUDA compiles every function for both the host and the GPU, so the same   *
+ *  code runs in both places. See cuda/sbh_cuda.cuh.                          */
+#if defined(__CUDACC__)
+#define SBH_INLINE static __host__ __device__ inline
+
 /*  Check the __STDC_VERSION__ macro for inline support.                      */
-#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
 
 /*  C99 and higher have inline as a keyword. Nothing to add here.             */
 #define SBH_INLINE static inline
 
 #else
-/*  Else for #if __STDC_VERSION__ >= 199901L.                                 */
+/*  Else for #if defined(__CUDACC__).                                         */
 
 /*  Otherwise we can somewhat mimic inlining with "static".                   */
 #define SBH_INLINE static
 
 #endif
-/*  End of #if __STDC_VERSION__ >= 199901L.                                   */
+/*  End of #if defined(__CUDACC__).                                           */
 
 #endif
 /*  End of include guard.                                                     */
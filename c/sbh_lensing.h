@@ -0,0 +1,968 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides batched lensing queries. For a static observer and a point   *
+ *      source, finds the images of the source and their observables: the     *
+ *      direction, the bending angle, the travel time, and the magnification. *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The rays joining the observer and a source lie in the plane through   *
+ *      both and the center. With gamma the angle between the observer and    *
+ *      the source, as seen from the center, an image is a ray that sweeps    *
+ *      the angle T = gamma, 2 pi - gamma, gamma + 2 pi, and so on, between   *
+ *      them. These are the primary and secondary images, then pairs of       *
+ *      higher order images close to the photon ring.                         *
+ *                                                                            *
+ *      With r_min and r_max the smaller and larger of the two radii, there   *
+ *      are two families of rays joining the radii:                           *
+ *                                                                            *
+ *          Direct: r is monotonic along the ray. The impact parameter b      *
+ *              runs from 0, the radial ray, to the tangent ray at r_min,     *
+ *              b_max = r_min / sqrt(f(r_min)). The angle swept is            *
+ *              |G(u_obs) - G(u_src)|.                                        *
+ *          Periapsis: the ray passes through a periapsis r_p < r_min. r_p    *
+ *              runs from r_min down to the photon sphere, and the angle      *
+ *              swept is 2 G(u_p) - G(u_obs) - G(u_src).                      *
+ *                                                                            *
+ *      Here G is the elliptic integral of sbh_analytic_orbit_angle. The two  *
+ *      families meet at r_p = r_min, and T increases along both, from 0 to   *
+ *      infinity at the photon sphere, so every T has exactly one ray. It is  *
+ *      found by bracketed root finding on the family that contains T.        *
+ *                                                                            *
+ *      The coordinate travel time is the integral of                         *
+ *                                                                            *
+ *          dt / dr = r^(3/2) / (f sqrt(r^3 - b^2 r + 2 M b^2))               *
+ *                                                                            *
+ *      over each leg of the ray. The substitution r = r_lo + s^2, with the   *
+ *      cubic expanded about r_lo, removes the square root singularity at a   *
+ *      periapsis without cancellation. The integral in s uses Gauss-Legendre *
+ *      quadrature on panels that halve in size toward s = 0.                 *
+ *                                                                            *
+ *      The magnification is the ratio of the solid angle of the image to     *
+ *      that of the source as it would be seen without the black hole,        *
+ *                                                                            *
+ *          mu = sin(vartheta) dvartheta / (sin(beta) dbeta)                  *
+ *                                                                            *
+ *      with vartheta the angle of the image from the center, and beta that   *
+ *      of the source in flat space. dvartheta / dT is computed by central    *
+ *      differences of the image angle, which is smooth in T.                 *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      The observer and the sources must be outside the photon sphere,       *
+ *      r > 3M. Time components of the inputs are ignored. No buffers are     *
+ *      allocated, the results are written directly to the output array.      *
+ ******************************************************************************
+ *  References:                                                               *
+ *      1.) Virbhadra, K., Ellis, G. (2000).                                  *
+ *          Schwarzschild black hole lensing.                                 *
+ *          Physical Review D, 62, 084003.                                    *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_LENSING_H
+#define SBH_LENSING_H
+
+#include "sbh_inline.h"
+#include "sbh_constants.h"
+#include "sbh_vec4.h"
+#include "sbh_analytic.h"
+#include "sbh_render.h"
+#include <stddef.h>
+#include <math.h>
+
+/*  The largest number of images a query can return.                          */
+#define SBH_LENSING_MAX_IMAGES (6U)
+
+/*  Step in T for the differences used by the magnification.                  */
+#define SBH_LENSING_DERIVATIVE_STEP (1.0E-05)
+
+/*  Periapses closer to the photon sphere than this, relative to 3M, can not  *
+ *  be resolved in double precision. This limits T to about 35 radians.       */
+#define SBH_LENSING_MIN_PHOTON_GAP (1.0E-14)
+
+/*  Parameters for lensing queries.                                           */
+struct sbh_lensing_params {
+
+    /*  The mass of the black hole, in geometrized units.                     */
+    double mass;
+
+    /*  The number of images to find for each source, at most                 *
+     *  SBH_LENSING_MAX_IMAGES. 1 is the primary image only, 2 adds the       *
+     *  secondary image, and so on.                                           */
+    unsigned int images;
+
+    /*  The root finding stops once the swept angle is within this of T.      */
+    double tolerance;
+
+    /*  The root finding gives up after this many iterations.                 */
+    unsigned int max_iterations;
+
+    /*  sbh_lensing_query_array only. The number of threads, zero for one per *
+     *  processor, and the number of sources handed to a thread at once.      */
+    unsigned int threads;
+    size_t batch_size;
+
+    /*  sbh_lensing_query_array only. Progress counters, or NULL. Each source *
+     *  is counted as one ray.                                                */
+    struct sbh_progress *progress;
+};
+
+/*  The observables of one image.                                             */
+struct sbh_lensing_image {
+
+    /*  1 if the image was found, and 0 if the root finding failed or T is    *
+     *  too close to the photon ring. The other fields are only set if 1.     */
+    int found;
+
+    /*  The angle swept around the black hole between observer and source.    */
+    double psi;
+
+    /*  The angle of the image from the direction of the black hole, as seen  *
+     *  by the static observer.                                               */
+    double angle;
+
+    /*  The direction the observer sees the image in, a Cartesian unit        *
+     *  vector with zero time component.                                      */
+    struct sbh_vec4 direction;
+
+    /*  The impact parameter of the ray.                                      *
+     *  Its direction at the source minus its direction at the observer,      *
+     *  measured in the plane of the ray, is the bending angle.               */
+    double impact_parameter;
+    double deflection;
+
+    /*  The coordinate time light takes from the source to the observer, and  *
+     *  that time minus the Euclidean distance between them in Schwarzschild  *
+     *  coordinates. The difference of two images is their relative delay.    */
+    double time;
+    double delay;
+
+    /*  The signed magnification. It is negative for images of odd parity,    *
+     *  such as the secondary image. It is infinite, or undefined, for a      *
+     *  source on the axis through the observer and the center, where the     *
+     *  images are rings.                                                     */
+    double magnification;
+};
+
+/*  The result of the query for one source.                                   */
+struct sbh_lensing_result {
+
+    /*  The angle between observer and source as seen from the center, and    *
+     *  the angle of the source from the black hole in flat space.            */
+    double separation;
+    double source_angle;
+
+    /*  The images, in order of increasing psi.                               */
+    struct sbh_lensing_image image[SBH_LENSING_MAX_IMAGES];
+};
+
+/*  The radii of one query, shared by the steps of the root finding.          */
+struct sbh_lensing_geometry {
+    double mass;
+
+    /*  Radii of the observer and source, their inverses, and the smaller and *
+     *  larger of the two radii.                                              */
+    double r_obs, r_src, u_obs, u_src, r_min, r_max;
+
+    /*  The impact parameter of the direct ray tangent at r_min, and the      *
+     *  angle it sweeps, where the two families of rays meet.                 */
+    double b_max, psi_join;
+
+    /*  The lowest value of log((r_p - 3M) / (r_min - 3M)) that is used.      */
+    double y_min;
+};
+
+/*  The argument passed to the tile callback of sbh_lensing_query_array.      */
+struct sbh_lensing_batch {
+    const struct sbh_lensing_params *params;
+    const struct sbh_vec4 *observer;
+    const struct sbh_vec4 *sources;
+    struct sbh_lensing_result *results;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_default_params                                            *
+ *  Purpose:                                                                  *
+ *      Creates a reasonable set of parameters for lensing queries.           *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_lensing_params):                                   *
+ *          Parameters for the primary and secondary images, found to 1E-13   *
+ *          radians, on one thread per processor in batches of 256 sources,   *
+ *          without progress counters.                                        *
+ ******************************************************************************/
+SBH_INLINE struct sbh_lensing_params sbh_lensing_default_params(double mass)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_lensing_params params;
+
+    /*  Set the defaults and return.                                          */
+    params.mass = mass;
+    params.images = 2U;
+    params.tolerance = 1.0E-13;
+    params.max_iterations = 100U;
+    params.threads = 0U;
+    params.batch_size = 256;
+    params.progress = NULL;
+    return params;
+}
+/*  End of sbh_lensing_default_params.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_geometry_create                                           *
+ *  Purpose:                                                                  *
+ *      Computes the quantities of a query that do not depend on the image.   *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      r_obs (double):                                                       *
+ *          The radius of the observer, larger than 3M.                       *
+ *      r_src (double):                                                       *
+ *          The radius of the source, larger than 3M.                         *
+ *  Outputs:                                                                  *
+ *      geometry (struct sbh_lensing_geometry):                               *
+ *          The radii and the point where the families of rays meet.          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_lensing_geometry
+sbh_lensing_geometry_create(double mass, double r_obs, double r_src)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_lensing_geometry geo;
+    struct sbh_analytic_orbit orbit;
+    double u_far;
+
+    geo.mass = mass;
+    geo.r_obs = r_obs;
+    geo.r_src = r_src;
+    geo.u_obs = 1.0 / r_obs;
+    geo.u_src = 1.0 / r_src;
+    geo.r_min = (r_obs < r_src ? r_obs : r_src);
+    geo.r_max = (r_obs < r_src ? r_src : r_obs);
+    geo.b_max = geo.r_min / sqrt(1.0 - 2.0 * mass / geo.r_min);
+    geo.y_min = log(SBH_LENSING_MIN_PHOTON_GAP * 3.0 * mass /
+                    (geo.r_min - 3.0 * mass));
+
+    /*  The ray tangent at r_min sweeps G(u_p) - G(u_far).                    */
+    u_far = 1.0 / geo.r_max;
+    orbit = sbh_analytic_orbit_create(mass, 1.0 / geo.r_min, 0.0);
+    geo.psi_join = sbh_analytic_orbit_angle(&orbit, orbit.u2) -
+                   sbh_analytic_orbit_angle(&orbit, u_far);
+
+    if (geo.psi_join < 0.0)
+        geo.psi_join = 0.0;
+
+    return geo;
+}
+/*  End of sbh_lensing_geometry_create.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_direct_angle                                              *
+ *  Purpose:                                                                  *
+ *      Computes the angle swept by the direct ray with a given impact        *
+ *      parameter.                                                            *
+ *  Arguments:                                                                *
+ *      geo (const struct sbh_lensing_geometry *):                            *
+ *          The geometry of the query.                                        *
+ *      b (double):                                                           *
+ *          The impact parameter, 0 <= b <= geo->b_max.                       *
+ *  Outputs:                                                                  *
+ *      psi (double):                                                         *
+ *          |G(u_obs) - G(u_src)|.                                            *
+ *  Notes:                                                                    *
+ *      The orbit is created at r_max, where u' is largest, so that 1 / b^2   *
+ *      is recovered accurately from u and u'.                                *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_lensing_direct_angle(const struct sbh_lensing_geometry *geo, double b)
+{
+    /*  Declare necessary variables.                                          */
+    const double u_far = 1.0 / geo->r_max;
+    const double p = 1.0 - b * b * u_far * u_far * (1.0 - 2.0*geo->mass*u_far);
+    struct sbh_analytic_orbit orbit;
+
+    /*  The radial ray does not turn at all.                                  */
+    if (b <= 0.0)
+        return 0.0;
+
+    orbit = sbh_analytic_orbit_create(geo->mass, u_far,
+                                      (p > 0.0 ? sqrt(p) : 0.0) / b);
+
+    return fabs(sbh_analytic_orbit_angle(&orbit, geo->u_obs) -
+                sbh_analytic_orbit_angle(&orbit, geo->u_src));
+}
+/*  End of sbh_lensing_direct_angle.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_periapsis_radius                                          *
+ *  Purpose:                                                                  *
+ *      Maps the variable used for the periapsis family to the periapsis.     *
+ *  Arguments:                                                                *
+ *      geo (const struct sbh_lensing_geometry *):                            *
+ *          The geometry of the query.                                        *
+ *      y (double):                                                           *
+ *          The variable, y <= 0.                                             *
+ *  Outputs:                                                                  *
+ *      r_p (double):                                                         *
+ *          3M + (r_min - 3M) exp(y). T diverges like -y at the photon        *
+ *          sphere, so T is close to linear in y there.                       *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_lensing_periapsis_radius(const struct sbh_lensing_geometry *geo, double y)
+{
+    return 3.0 * geo->mass + (geo->r_min - 3.0 * geo->mass) * exp(y);
+}
+/*  End of sbh_lensing_periapsis_radius.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_periapsis_angle                                           *
+ *  Purpose:                                                                  *
+ *      Computes the angle swept by the ray through a given periapsis.        *
+ *  Arguments:                                                                *
+ *      geo (const struct sbh_lensing_geometry *):                            *
+ *          The geometry of the query.                                        *
+ *      y (double):                                                           *
+ *          The variable of sbh_lensing_periapsis_radius.                     *
+ *  Outputs:                                                                  *
+ *      psi (double):                                                         *
+ *          2 G(u_p) - G(u_obs) - G(u_src).                                   *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_lensing_periapsis_angle(const struct sbh_lensing_geometry *geo, double y)
+{
+    /*  Declare necessary variables.                                          */
+    const double r_p = sbh_lensing_periapsis_radius(geo, y);
+    const struct sbh_analytic_orbit orbit =
+        sbh_analytic_orbit_create(geo->mass, 1.0 / r_p, 0.0);
+    const double w_p = sbh_analytic_orbit_angle(&orbit, orbit.u2);
+
+    return 2.0 * w_p - sbh_analytic_orbit_angle(&orbit, geo->u_obs) -
+           sbh_analytic_orbit_angle(&orbit, geo->u_src);
+}
+/*  End of sbh_lensing_periapsis_angle.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_family_angle                                              *
+ *  Purpose:                                                                  *
+ *      Evaluates the angle swept along either family of rays.                *
+ *  Arguments:                                                                *
+ *      geo (const struct sbh_lensing_geometry *):                            *
+ *          The geometry of the query.                                        *
+ *      periapsis (int):                                                      *
+ *          Non-zero for the periapsis family, zero for the direct one.       *
+ *      x (double):                                                           *
+ *          b for the direct family, y for the periapsis family.              *
+ *  Outputs:                                                                  *
+ *      psi (double):                                                         *
+ *          The angle swept.                                                  *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_lensing_family_angle(const struct sbh_lensing_geometry *geo,
+                         int periapsis, double x)
+{
+    if (periapsis)
+        return sbh_lensing_periapsis_angle(geo, x);
+
+    return sbh_lensing_direct_angle(geo, x);
+}
+/*  End of sbh_lensing_family_angle.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_solve                                                     *
+ *  Purpose:                                                                  *
+ *      Finds the ray that sweeps a given angle.                              *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_lensing_params *):                           *
+ *          The tolerance and iteration limit are used.                       *
+ *      geo (const struct sbh_lensing_geometry *):                            *
+ *          The geometry of the query.                                        *
+ *      target (double):                                                      *
+ *          The angle the ray must sweep, T >= 0.                             *
+ *      periapsis (int *):                                                    *
+ *          Set to 1 if the ray passes through a periapsis, and 0 otherwise.  *
+ *      b (double *):                                                         *
+ *          Set to the impact parameter of the ray.                           *
+ *      r_p (double *):                                                       *
+ *          Set to the periapsis, for the periapsis family only.              *
+ *  Outputs:                                                                  *
+ *      found (int):                                                          *
+ *          1 if the ray was found, and 0 if T is beyond what the periapsis   *
+ *          family can resolve or the iteration did not converge.             *
+ *  Method:                                                                   *
+ *      Choose the family from T <= psi_join, bracket the root, and refine    *
+ *      with the Illinois variant of regula falsi. The direct family is       *
+ *      bracketed by [0, b_max]. For the periapsis family y = 0 is the lower  *
+ *      end, and the other end is moved out by doubling until it passes T.    *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_lensing_solve(const struct sbh_lensing_params *params,
+                  const struct sbh_lensing_geometry *geo,
+                  double target, int *periapsis, double *b, double *r_p)
+{
+    /*  Declare necessary variables.                                          */
+    double lo, hi, f_lo, f_hi, x = 0.0;
+    unsigned int iteration;
+    int side = 0;
+    int found = 0;
+
+    *periapsis = !(target <= geo->psi_join && geo->psi_join > 0.0);
+
+    /*  Bracket the root. f is increasing along the direct family in b, and   *
+     *  decreasing along the periapsis family in y.                           */
+    if (!*periapsis)
+    {
+        lo = 0.0;
+        hi = geo->b_max;
+        f_lo = -target;
+        f_hi = geo->psi_join - target;
+    }
+    else
+    {
+        hi = 0.0;
+        f_hi = geo->psi_join - target;
+        lo = -1.0;
+        f_lo = sbh_lensing_periapsis_angle(geo, lo) - target;
+
+        while (f_lo < 0.0 && lo > geo->y_min)
+        {
+            hi = lo;
+            f_hi = f_lo;
+            lo = (2.0 * lo > geo->y_min ? 2.0 * lo : geo->y_min);
+            f_lo = sbh_lensing_periapsis_angle(geo, lo) - target;
+        }
+
+        /*  Also catches NaN.                                                 */
+        if (!(f_lo >= 0.0))
+            return 0;
+    }
+
+    /*  Either end of the bracket may already be the root.                    */
+    if (fabs(f_lo) <= params->tolerance)
+    {
+        x = lo;
+        found = 1;
+    }
+    else if (fabs(f_hi) <= params->tolerance)
+    {
+        x = hi;
+        found = 1;
+    }
+
+    for (iteration = 0U; !found && iteration < params->max_iterations;
+         ++iteration)
+    {
+        double f_x;
+
+        /*  The secant through the bracket, falling back to the midpoint if   *
+         *  the secant leaves it due to rounding.                             */
+        x = hi - f_hi * (hi - lo) / (f_hi - f_lo);
+
+        if (!(x > (lo < hi ? lo : hi) && x < (lo < hi ? hi : lo)))
+            x = 0.5 * (lo + hi);
+
+        f_x = sbh_lensing_family_angle(geo, *periapsis, x) - target;
+
+        if (fabs(f_x) <= params->tolerance ||
+            fabs(hi - lo) <= 4.0E-16 * (fabs(lo) + fabs(hi)))
+        {
+            found = 1;
+            break;
+        }
+
+        /*  Replace the end with the same sign. If the same end is kept twice *
+         *  in a row, halve its value, which is the Illinois modification.    */
+        if ((f_x < 0.0) == (f_lo < 0.0))
+        {
+            lo = x;
+            f_lo = f_x;
+
+            if (side == -1)
+                f_hi *= 0.5;
+
+            side = -1;
+        }
+        else
+        {
+            hi = x;
+            f_hi = f_x;
+
+            if (side == 1)
+                f_lo *= 0.5;
+
+            side = 1;
+        }
+    }
+
+    if (!found)
+        return 0;
+
+    if (*periapsis)
+    {
+        *r_p = sbh_lensing_periapsis_radius(geo, x);
+        *b = *r_p / sqrt(1.0 - 2.0 * geo->mass / *r_p);
+    }
+    else
+        *b = x;
+
+    return 1;
+}
+/*  End of sbh_lensing_solve.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_image_angle                                               *
+ *  Purpose:                                                                  *
+ *      Computes the angle, from the outward radial direction, at which the   *
+ *      observer must look to see a ray.                                      *
+ *  Arguments:                                                                *
+ *      geo (const struct sbh_lensing_geometry *):                            *
+ *          The geometry of the query.                                        *
+ *      periapsis (int):                                                      *
+ *          The family of the ray, from sbh_lensing_solve.                    *
+ *      b (double):                                                           *
+ *          The impact parameter of the ray.                                  *
+ *  Outputs:                                                                  *
+ *      alpha (double):                                                       *
+ *          The angle, with sin(alpha) = b sqrt(f(r_obs)) / r_obs. The ray    *
+ *          leaves the observer heading outwards, alpha <= pi / 2, only if it *
+ *          is direct and the source is farther out than the observer.        *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_lensing_image_angle(const struct sbh_lensing_geometry *geo,
+                        int periapsis, double b)
+{
+    /*  Declare necessary variables.                                          */
+    double sin_alpha = b * sqrt(1.0 - 2.0 * geo->mass * geo->u_obs) *
+                       geo->u_obs;
+
+    /*  Rounding at the tangent ray may give values slightly larger than 1.   */
+    if (sin_alpha > 1.0)
+        sin_alpha = 1.0;
+
+    if (!periapsis && geo->r_src > geo->r_obs)
+        return asin(sin_alpha);
+
+    return SBH_PI - asin(sin_alpha);
+}
+/*  End of sbh_lensing_image_angle.                                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_leg_time                                                  *
+ *  Purpose:                                                                  *
+ *      Computes the coordinate time light takes between two radii along a    *
+ *      leg of a ray on which r is monotonic.                                 *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      b (double):                                                           *
+ *          The impact parameter of the ray.                                  *
+ *      r_lo (double):                                                        *
+ *          The smaller radius.                                               *
+ *      r_hi (double):                                                        *
+ *          The larger radius.                                                *
+ *      turning (int):                                                        *
+ *          Non-zero if r_lo is the periapsis of the ray.                     *
+ *  Outputs:                                                                  *
+ *      time (double):                                                        *
+ *          The integral of dt / dr from r_lo to r_hi.                        *
+ *  Method:                                                                   *
+ *      With g(r) = r^3 - b^2 r + 2 M b^2 and r = r_lo + s^2,                 *
+ *                                                                            *
+ *          g = g0 + s^2 (h0 + s^2 (3 r_lo + s^2)),  h0 = 3 r_lo^2 - b^2,     *
+ *                                                                            *
+ *      with g0 = g(r_lo) set to exactly zero at a periapsis. The integrand   *
+ *      2 s r^(3/2) / (f sqrt(g)) has layers of width sqrt(g0 / h0) and       *
+ *      sqrt(h0 / 3 r_lo), from a near tangent ray and from a periapsis near  *
+ *      the photon sphere. The panels halve toward s = 0 until they are       *
+ *      smaller than both, and each uses 8-point Gauss-Legendre quadrature.   *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_lensing_leg_time(double mass, double b, double r_lo, double r_hi,
+                     int turning)
+{
+    /*  The 8-point Gauss-Legendre rule on [-1, 1], symmetric about 0.        */
+    static const double node[4] = {
+        1.83434642495649804939E-01, 5.25532409916328985818E-01,
+        7.96666477413626739592E-01, 9.60289856497536231684E-01
+    };
+    static const double weight[4] = {
+        3.62683783378361982965E-01, 3.13706645877887287338E-01,
+        2.22381034453374470544E-01, 1.01228536290376259153E-01
+    };
+
+    /*  Declare necessary variables.                                          */
+    const double b_sq = b * b;
+    const double g0 = (turning ? 0.0 : r_lo * (r_lo * r_lo - b_sq) +
+                                       2.0 * mass * b_sq);
+    const double h0 = 3.0 * r_lo * r_lo - b_sq;
+    double scale, a, upper, time = 0.0;
+    unsigned int panel;
+
+    if (!(r_hi > r_lo))
+        return 0.0;
+
+    /*  The smallest feature of the integrand near s = 0.                     */
+    upper = sqrt(r_hi - r_lo);
+    scale = sqrt(r_lo - 2.0 * mass);
+
+    if (g0 > 0.0 && h0 > 0.0 && sqrt(g0 / h0) < scale)
+        scale = sqrt(g0 / h0);
+
+    if (h0 > 0.0 && sqrt(h0 / (3.0 * r_lo)) < scale)
+        scale = sqrt(h0 / (3.0 * r_lo));
+
+    /*  Integrate over [a, upper], then halve a and continue. The last panel  *
+     *  is [0, a]. 64 panels reach features 2^-64 times the range.            */
+    a = upper;
+
+    for (panel = 0U; panel < 64U; ++panel)
+    {
+        const double top = a;
+        unsigned int n;
+        double sum = 0.0;
+
+        a = (a > 0.25 * scale && panel < 63U ? 0.5 * a : 0.0);
+
+        for (n = 0U; n < 8U; ++n)
+        {
+            const double x = (n < 4U ? -node[n] : node[n - 4U]);
+            const double s = 0.5 * (top + a) + 0.5 * (top - a) * x;
+            const double s_sq = s * s;
+            const double r = r_lo + s_sq;
+            const double f = 1.0 - 2.0 * mass / r;
+            const double g = g0 + s_sq * (h0 + s_sq * (3.0 * r_lo + s_sq));
+
+            sum += weight[n & 3U] * 2.0 * s * r * sqrt(r) / (f * sqrt(g));
+        }
+
+        time += 0.5 * (top - a) * sum;
+
+        if (a == 0.0)
+            break;
+    }
+
+    return time;
+}
+/*  End of sbh_lensing_leg_time.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_look_angle                                                *
+ *  Purpose:                                                                  *
+ *      Finds the angle from the outward radial direction at which the        *
+ *      observer sees the ray sweeping a given angle.                         *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_lensing_params *):                           *
+ *          The query parameters.                                             *
+ *      geo (const struct sbh_lensing_geometry *):                            *
+ *          The geometry of the query.                                        *
+ *      target (double):                                                      *
+ *          The angle swept.                                                  *
+ *      alpha (double *):                                                     *
+ *          Set to the angle.                                                 *
+ *  Outputs:                                                                  *
+ *      found (int):                                                          *
+ *          As for sbh_lensing_solve.                                         *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_lensing_look_angle(const struct sbh_lensing_params *params,
+                       const struct sbh_lensing_geometry *geo,
+                       double target, double *alpha)
+{
+    /*  Declare necessary variables.                                          */
+    int periapsis;
+    double b, r_p;
+
+    if (!sbh_lensing_solve(params, geo, target, &periapsis, &b, &r_p))
+        return 0;
+
+    *alpha = sbh_lensing_image_angle(geo, periapsis, b);
+    return 1;
+}
+/*  End of sbh_lensing_look_angle.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_query                                                     *
+ *  Purpose:                                                                  *
+ *      Finds the images of a point source seen by a static observer.         *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_lensing_params *):                           *
+ *          The query parameters.                                             *
+ *      observer (const struct sbh_vec4 *):                                   *
+ *          The position of the observer, in Schwarzschild coordinates.       *
+ *      source (const struct sbh_vec4 *):                                     *
+ *          The position of the source, in Schwarzschild coordinates.         *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_lensing_result):                                   *
+ *          The separation, the unlensed angle of the source, and the first   *
+ *          params->images images. Images past that, or with either radius    *
+ *          inside the photon sphere, have found set to zero.                 *
+ *  Method:                                                                   *
+ *      See the notes at the top of the file. The n-th pair of images sweeps  *
+ *      T = gamma + 2 pi n on the side of the source, and                     *
+ *      T = 2 pi (n + 1) - gamma on the far side. For each image, the ray is  *
+ *      found, then the travel time is integrated over its legs, and the      *
+ *      magnification is computed from the look angles at T +- h.             *
+ ******************************************************************************/
+SBH_INLINE struct sbh_lensing_result
+sbh_lensing_query(const struct sbh_lensing_params *params,
+                  const struct sbh_vec4 *observer,
+                  const struct sbh_vec4 *source)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_lensing_result result;
+    struct sbh_lensing_geometry geo;
+    struct sbh_vec4 x_obs, x_src, n_obs, tangent, rel;
+    const double mass = params->mass;
+    const double h = SBH_LENSING_DERIVATIVE_STEP;
+    double cos_gamma, sin_gamma, distance, dbeta, sin_beta, t_norm;
+    unsigned int k;
+
+    for (k = 0U; k < SBH_LENSING_MAX_IMAGES; ++k)
+        result.image[k].found = 0;
+
+    result.separation = 0.0;
+    result.source_angle = 0.0;
+
+    if (!(observer->dat[0] > 3.0 * mass && source->dat[0] > 3.0 * mass))
+        return result;
+
+    /*  The angle gamma from the cross and dot products of the directions.    */
+    x_obs = sbh_vec4_schwarzschild_to_rect(observer);
+    x_src = sbh_vec4_schwarzschild_to_rect(source);
+    n_obs = sbh_vec4_spatial_normalize(&x_obs);
+    rel = sbh_vec4_spatial_normalize(&x_src);
+    cos_gamma = sbh_vec4_spatial_dot(&n_obs, &rel);
+    rel = sbh_vec4_spatial_cross(&n_obs, &rel);
+    sin_gamma = sqrt(sbh_vec4_spatial_dot(&rel, &rel));
+    result.separation = atan2(sin_gamma, cos_gamma);
+
+    /*  The tangent toward the source, from two cross products so that it is  *
+     *  orthogonal to the observer even for small gamma. On the axis any will *
+     *  do, take the coordinate axis least aligned with the observer.         */
+    tangent = sbh_vec4_spatial_cross(&rel, &n_obs);
+
+    if (sin_gamma > 1.0E-14)
+        t_norm = 1.0 / sin_gamma;
+    else
+    {
+        struct sbh_vec4 axis = sbh_vec4_rect(0.0, 0.0, 1.0, 0.0);
+
+        if (fabs(n_obs.dat[2]) > 0.5)
+            axis = sbh_vec4_rect(1.0, 0.0, 0.0, 0.0);
+
+        tangent = sbh_vec4_spatial_cross(&n_obs, &axis);
+        t_norm = 1.0 / sqrt(sbh_vec4_spatial_dot(&tangent, &tangent));
+    }
+
+    tangent = sbh_vec4_linear_combination(t_norm, &tangent, 0.0, &tangent,
+                                          0.0, &tangent);
+
+    /*  The source as seen in flat space, and dbeta / dgamma.                 */
+    geo = sbh_lensing_geometry_create(mass, observer->dat[0], source->dat[0]);
+    distance = sqrt(geo.r_obs * geo.r_obs + geo.r_src * geo.r_src -
+                    2.0 * geo.r_obs * geo.r_src * cos_gamma);
+    result.source_angle = atan2(geo.r_src * sin_gamma,
+                                geo.r_obs - geo.r_src * cos_gamma);
+    sin_beta = sin(result.source_angle);
+    dbeta = geo.r_src * (geo.r_obs * cos_gamma - geo.r_src) /
+            (distance * distance);
+
+    for (k = 0U; k < params->images && k < SBH_LENSING_MAX_IMAGES; ++k)
+    {
+        struct sbh_lensing_image *image = result.image + k;
+        const double order = (double)(k / 2U);
+        const double side = (k % 2U == 0U ? 1.0 : -1.0);
+        const double target = (side > 0.0 ?
+                               result.separation + SBH_TWO_PI * order :
+                               SBH_TWO_PI * (order + 1.0) - result.separation);
+        int periapsis;
+        double b, r_p = 0.0, alpha, a_plus, a_minus, dalpha, u, du_b;
+
+        if (!sbh_lensing_solve(params, &geo, target, &periapsis, &b, &r_p))
+            continue;
+
+        alpha = sbh_lensing_image_angle(&geo, periapsis, b);
+
+        /*  d alpha / dT, one-sided if T - h would be negative.               */
+        if (target >= h)
+        {
+            if (!sbh_lensing_look_angle(params, &geo, target + h, &a_plus) ||
+                !sbh_lensing_look_angle(params, &geo, target - h, &a_minus))
+                continue;
+
+            dalpha = (a_plus - a_minus) / (2.0 * h);
+        }
+        else
+        {
+            if (!sbh_lensing_look_angle(params, &geo, target + h, &a_plus) ||
+                !sbh_lensing_look_angle(params, &geo, target + 2.0*h, &a_minus))
+                continue;
+
+            dalpha = (4.0 * a_plus - a_minus - 3.0 * alpha) / (2.0 * h);
+        }
+
+        image->found = 1;
+        image->psi = target;
+        image->impact_parameter = b;
+        image->angle = SBH_PI - alpha;
+        image->direction = sbh_vec4_linear_combination(
+            cos(alpha), &n_obs, side * sin(alpha), &tangent, 0.0, &tangent
+        );
+
+        /*  The direction at the source, as in sbh_planar_trace, from b u'.   *
+         *  The ray is heading outwards there unless it is direct and the     *
+         *  source is closer in than the observer.                            */
+        u = geo.u_src;
+        du_b = 1.0 - b * b * u * u * (1.0 - 2.0 * mass * u);
+        du_b = (du_b > 0.0 ? sqrt(du_b) : 0.0);
+
+        if (periapsis || geo.r_src > geo.r_obs)
+            du_b = -du_b;
+
+        image->deflection = target + atan2(u * b, -du_b) - alpha;
+
+        /*  The travel time, over one leg or two.                             */
+        if (periapsis)
+            image->time = sbh_lensing_leg_time(mass, b, r_p, geo.r_obs, 1) +
+                          sbh_lensing_leg_time(mass, b, r_p, geo.r_src, 1);
+        else
+            image->time = sbh_lensing_leg_time(mass, b, geo.r_min,
+                                               geo.r_max, 0);
+
+        image->delay = image->time - distance;
+
+        /*  mu = side sin(vartheta) / sin(beta) (-dalpha / dT) / dbeta.       */
+        image->magnification = -side * sin(alpha) * dalpha /
+                               (sin_beta * dbeta);
+    }
+
+    return result;
+}
+/*  End of sbh_lensing_query.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_query_tile                                                *
+ *  Purpose:                                                                  *
+ *      Runs the queries for one batch of sources, as a tile of a frame.      *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile. Its columns are the indices of the sources.             *
+ *      thread (unsigned int):                                                *
+ *          The index of the worker, unused.                                  *
+ *      data (void *):                                                        *
+ *          A pointer to a struct sbh_lensing_batch.                          *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_lensing_query_tile(const struct sbh_render_tile *tile,
+                       unsigned int thread,
+                       void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_lensing_batch *batch =
+        (const struct sbh_lensing_batch *)data;
+    size_t n;
+
+    (void)thread;
+
+    for (n = tile->x; n < tile->x + tile->width; ++n)
+    {
+        if (sbh_progress_cancelled(batch->params->progress))
+            return;
+
+        batch->results[n] = sbh_lensing_query(batch->params, batch->observer,
+                                              batch->sources + n);
+    }
+
+    sbh_progress_add_rays(batch->params->progress, (unsigned long)tile->width);
+}
+/*  End of sbh_lensing_query_tile.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensing_query_array                                               *
+ *  Purpose:                                                                  *
+ *      Finds the images of many sources seen by one observer, in parallel.   *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_lensing_params *):                           *
+ *          The query parameters.                                             *
+ *      observer (const struct sbh_vec4 *):                                   *
+ *          The position of the observer, in Schwarzschild coordinates.       *
+ *      sources (const struct sbh_vec4 *):                                    *
+ *          The positions of the sources, in Schwarzschild coordinates.       *
+ *      results (struct sbh_lensing_result *):                                *
+ *          The output array, results[n] is for sources[n].                   *
+ *      len (size_t):                                                         *
+ *          The number of sources.                                            *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, and 0 if batch_size is zero, the worker threads     *
+ *          could not be started, or the query was cancelled through          *
+ *          params->progress.                                                 *
+ *  Method:                                                                   *
+ *      The sources are run as a frame of one row with sbh_render_frame,      *
+ *      with one batch per tile, so expensive sources are balanced between    *
+ *      the threads by work stealing.                                         *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_lensing_query_array(const struct sbh_lensing_params *params,
+                        const struct sbh_vec4 *observer,
+                        const struct sbh_vec4 *sources,
+                        struct sbh_lensing_result *results,
+                        size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_render_params line = sbh_render_default_params(len, 1);
+    struct sbh_lensing_batch batch;
+
+    if (len == 0)
+        return 1;
+
+    batch.params = params;
+    batch.observer = observer;
+    batch.sources = sources;
+    batch.results = results;
+
+    line.tile_width = params->batch_size;
+    line.tile_height = 1;
+    line.threads = params->threads;
+    line.progress = params->progress;
+    return sbh_render_frame(&line, sbh_lensing_query_tile, &batch);
+}
+/*  End of sbh_lensing_query_array.                                           */
+
+#endif
+/*  End of include guard.                                                     */
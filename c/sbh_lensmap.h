@@ -0,0 +1,427 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Saves a geometry buffer to a file, a lensing map, that later jobs can *
+ *      map into memory and shade without tracing any rays.                   *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The file is a fixed header followed by the samples of the buffer,     *
+ *      exactly as they are laid out in memory:                               *
+ *                                                                            *
+ *          offset 0:       struct sbh_lensmap_header.                        *
+ *          offset 4096:    the width * height * grid^2 samples, in the       *
+ *                          order of struct sbh_gbuffer.                      *
+ *                                                                            *
+ *      The header holds the mass, the camera, and the size of the buffer.    *
+ *      Opening a map checks the header and points the samples of a struct    *
+ *      sbh_gbuffer at the mapped file, so there is nothing to parse or copy  *
+ *      and pages are only read from disk when they are first touched. Jobs   *
+ *      on the same machine share the pages through the page cache.           *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      The samples are stored in the native byte order and struct layout,    *
+ *      which the header records. A map opened on a machine that differs in   *
+ *      either is rejected rather than misread.                               *
+ *                                                                            *
+ *      mmap is used on POSIX systems, unless SBH_NO_MMAP is defined. Other   *
+ *      systems read the whole file into memory instead.                      *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_LENSMAP_H
+#define SBH_LENSMAP_H
+
+#include "sbh_inline.h"
+#include "sbh_vec4.h"
+#include "sbh_camera.h"
+#include "sbh_gbuffer.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*  Use mmap where it is available.                                           */
+#if !defined(SBH_NO_MMAP) && \
+    (defined(__unix__) || defined(__unix) || defined(__APPLE__))
+
+#define SBH_LENSMAP_HAS_MMAP 1
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#else
+/*  Else for #if !defined(SBH_NO_MMAP) && defined(__unix__).                  */
+
+#define SBH_LENSMAP_HAS_MMAP 0
+
+#endif
+/*  End of #if !defined(SBH_NO_MMAP) && defined(__unix__).                    */
+
+/*  The first eight bytes of every lensing map.                               */
+#define SBH_LENSMAP_MAGIC "SBHLENS"
+
+/*  Incremented whenever the layout of the file changes.                      */
+#define SBH_LENSMAP_VERSION 1
+
+/*  The offset of the samples in the file, a multiple of the page size.       */
+#define SBH_LENSMAP_DATA_OFFSET 4096
+
+/*  The number of samples copied into a zeroed buffer for each write.         */
+#define SBH_LENSMAP_BATCH 256
+
+/*  The header of a lensing map. Apart from the magic every field is a        *
+ *  double, so the header has no padding and does not depend on the sizes of  *
+ *  the integer types. The integers are exact as doubles below 2^53.          */
+struct sbh_lensmap_header {
+
+    /*  SBH_LENSMAP_MAGIC, including its terminating zero.                    */
+    char magic[8];
+
+    /*  1.0, which reads as something else on a machine of the other byte     *
+     *  order.                                                                */
+    double byte_order;
+
+    /*  SBH_LENSMAP_VERSION and sizeof(struct sbh_gbuffer_sample).            */
+    double version, sample_size;
+
+    /*  The size of the buffer, as in struct sbh_gbuffer.                     */
+    double width, height, grid;
+
+    /*  The mass of the black hole.                                           */
+    double mass;
+
+    /*  The fields of struct sbh_camera, with basis the three vectors in      *
+     *  order. The width and height of the camera are those of the buffer.    */
+    double position[4];
+    double forward[3], right[3], up[3];
+    double scale[3], dt;
+    double basis[12];
+};
+
+/*  A lensing map opened for shading.                                         */
+struct sbh_lensmap {
+
+    /*  The mass and camera the map was traced with.                          */
+    double mass;
+    struct sbh_camera camera;
+
+    /*  The samples, pointing into the map. Pass this to sbh_gbuffer_shade,   *
+     *  but not to sbh_gbuffer_destroy. Writes to the samples are private to  *
+     *  the process and never reach the file.                                 */
+    struct sbh_gbuffer gbuffer;
+
+    /*  The start and size of the mapped file.                                */
+    void *base;
+    size_t size;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensmap_write                                                     *
+ *  Purpose:                                                                  *
+ *      Saves a geometry buffer as a lensing map.                             *
+ *  Arguments:                                                                *
+ *      path (const char *):                                                  *
+ *          The file to create or overwrite.                                  *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera. Its size must match the buffer.                       *
+ *      gbuffer (const struct sbh_gbuffer *):                                 *
+ *          The buffer, filled by sbh_gbuffer_build or sbh_symmetric_build.   *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if the sizes differ or writing failed.            *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_lensmap_write(const char *path,
+                  double mass,
+                  const struct sbh_camera *camera,
+                  const struct sbh_gbuffer *gbuffer)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_lensmap_header header;
+    const size_t count = gbuffer->width * gbuffer->height *
+                         (size_t)gbuffer->grid * (size_t)gbuffer->grid;
+    char padding[SBH_LENSMAP_DATA_OFFSET - sizeof(header)];
+    struct sbh_gbuffer_sample batch[SBH_LENSMAP_BATCH];
+    size_t n = 0;
+    FILE *file;
+    int k, success;
+
+    if (camera->width != gbuffer->width || camera->height != gbuffer->height)
+        return 0;
+
+    /*  Zero the whole header first so that unused bytes are reproducible.    */
+    memset(&header, 0, sizeof(header));
+    memset(padding, 0, sizeof(padding));
+    memcpy(header.magic, SBH_LENSMAP_MAGIC, sizeof(SBH_LENSMAP_MAGIC));
+
+    header.byte_order = 1.0;
+    header.version = (double)SBH_LENSMAP_VERSION;
+    header.sample_size = (double)sizeof(struct sbh_gbuffer_sample);
+    header.width = (double)gbuffer->width;
+    header.height = (double)gbuffer->height;
+    header.grid = (double)gbuffer->grid;
+    header.mass = mass;
+    header.dt = camera->dt;
+
+    for (k = 0; k < 4; ++k)
+        header.position[k] = camera->position.dat[k];
+
+    for (k = 0; k < 3; ++k)
+    {
+        header.forward[k] = camera->forward[k];
+        header.right[k] = camera->right[k];
+        header.up[k] = camera->up[k];
+        header.scale[k] = camera->scale[k];
+    }
+
+    for (k = 0; k < 12; ++k)
+        header.basis[k] = camera->basis[k / 4].dat[k % 4];
+
+    file = fopen(path, "wb");
+
+    if (!file)
+        return 0;
+
+    success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(padding, sizeof(padding), 1, file) == 1;
+
+    /*  The padding of the samples in memory is not initialized. Copy the     *
+     *  fields into zeroed samples so the file is reproducible.               */
+    while (success && n < count)
+    {
+        const size_t size = (count - n < SBH_LENSMAP_BATCH ?
+                             count - n : SBH_LENSMAP_BATCH);
+        size_t m;
+
+        memset(batch, 0, sizeof(batch));
+
+        for (m = 0; m < size; ++m)
+        {
+            batch[m].status = gbuffer->samples[n + m].status;
+            batch[m].dat = gbuffer->samples[n + m].dat;
+        }
+
+        success = fwrite(batch, sizeof(*batch), size, file) == size;
+        n += size;
+    }
+
+    return fclose(file) == 0 && success;
+}
+/*  End of sbh_lensmap_write.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensmap_close                                                     *
+ *  Purpose:                                                                  *
+ *      Unmaps a lensing map.                                                 *
+ *  Arguments:                                                                *
+ *      map (struct sbh_lensmap *):                                           *
+ *          The map. Safe to call after a failed sbh_lensmap_open.            *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_lensmap_close(struct sbh_lensmap *map)
+{
+#if SBH_LENSMAP_HAS_MMAP
+    if (map->base)
+        munmap(map->base, map->size);
+#else
+    free(map->base);
+#endif
+
+    map->base = NULL;
+    map->size = 0;
+    map->gbuffer.samples = NULL;
+}
+/*  End of sbh_lensmap_close.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensmap_load                                                      *
+ *  Purpose:                                                                  *
+ *      Checks the header of a lensing map in memory and sets up the map.     *
+ *  Arguments:                                                                *
+ *      map (struct sbh_lensmap *):                                           *
+ *          The map, with base and size set.                                  *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the header is valid for this machine and the file holds      *
+ *          every sample, 0 otherwise.                                        *
+ ******************************************************************************/
+SBH_INLINE int sbh_lensmap_load(struct sbh_lensmap *map)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_lensmap_header header;
+    struct sbh_camera *camera = &map->camera;
+    double count;
+    int k;
+
+    if (map->size < SBH_LENSMAP_DATA_OFFSET)
+        return 0;
+
+    memcpy(&header, map->base, sizeof(header));
+
+    if (memcmp(header.magic, SBH_LENSMAP_MAGIC, sizeof(header.magic)) != 0)
+        return 0;
+
+    if (header.byte_order != 1.0 ||
+        header.version != (double)SBH_LENSMAP_VERSION ||
+        header.sample_size != (double)sizeof(struct sbh_gbuffer_sample))
+        return 0;
+
+    /*  The sizes are compared as doubles so that a corrupt header cannot     *
+     *  overflow size_t.                                                      */
+    count = header.width * header.height * header.grid * header.grid;
+
+    if (!(header.width >= 0.0 && header.height >= 0.0 && header.grid >= 1.0))
+        return 0;
+
+    if (!(count * header.sample_size <=
+          (double)(map->size - SBH_LENSMAP_DATA_OFFSET)))
+        return 0;
+
+    map->mass = header.mass;
+    map->gbuffer.width = (size_t)header.width;
+    map->gbuffer.height = (size_t)header.height;
+    map->gbuffer.grid = (unsigned int)header.grid;
+    map->gbuffer.samples = (struct sbh_gbuffer_sample *)
+        ((char *)map->base + SBH_LENSMAP_DATA_OFFSET);
+
+    camera->position = sbh_vec4_rect(header.position[0], header.position[1],
+                                     header.position[2], header.position[3]);
+    camera->width = map->gbuffer.width;
+    camera->height = map->gbuffer.height;
+    camera->dt = header.dt;
+
+    for (k = 0; k < 3; ++k)
+    {
+        camera->forward[k] = header.forward[k];
+        camera->right[k] = header.right[k];
+        camera->up[k] = header.up[k];
+        camera->scale[k] = header.scale[k];
+        camera->basis[k] = sbh_vec4_rect(
+            header.basis[4*k], header.basis[4*k + 1],
+            header.basis[4*k + 2], header.basis[4*k + 3]
+        );
+    }
+
+    return 1;
+}
+/*  End of sbh_lensmap_load.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_lensmap_open                                                      *
+ *  Purpose:                                                                  *
+ *      Opens a lensing map written by sbh_lensmap_write.                     *
+ *  Arguments:                                                                *
+ *      map (struct sbh_lensmap *):                                           *
+ *          The map to open.                                                  *
+ *      path (const char *):                                                  *
+ *          The file.                                                         *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success. 0 if the file could not be opened or mapped, or is  *
+ *          not a valid lensing map for this machine, see sbh_lensmap_load.   *
+ *          On failure the map may still be passed to sbh_lensmap_close.      *
+ *  Notes:                                                                    *
+ *      The mapping stays valid after the file is closed, and after it is     *
+ *      deleted, until sbh_lensmap_close. Replacing the file while it is      *
+ *      mapped should be done by renaming a new file over it, since writing   *
+ *      into it may change what the map reads.                                *
+ ******************************************************************************/
+SBH_INLINE int sbh_lensmap_open(struct sbh_lensmap *map, const char *path)
+{
+#if SBH_LENSMAP_HAS_MMAP
+    /*  Declare necessary variables.                                          */
+    struct stat status;
+    void *base;
+    int fd = open(path, O_RDONLY);
+
+    map->base = NULL;
+    map->size = 0;
+    map->gbuffer.samples = NULL;
+
+    if (fd < 0)
+        return 0;
+
+    if (fstat(fd, &status) != 0 || status.st_size <= 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    /*  Private and writable, so stray writes to the samples stay in memory.  */
+    base = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+        return 0;
+
+    map->base = base;
+    map->size = (size_t)status.st_size;
+#else
+    /*  Declare necessary variables.                                          */
+    FILE *file = fopen(path, "rb");
+    long int size;
+
+    map->base = NULL;
+    map->size = 0;
+    map->gbuffer.samples = NULL;
+
+    if (!file)
+        return 0;
+
+    if (fseek(file, 0L, SEEK_END) != 0 || (size = ftell(file)) <= 0 ||
+        fseek(file, 0L, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    map->base = malloc((size_t)size);
+
+    if (map->base)
+        map->size = fread(map->base, 1, (size_t)size, file);
+
+    fclose(file);
+#endif
+
+    if (!sbh_lensmap_load(map))
+    {
+        sbh_lensmap_close(map);
+        return 0;
+    }
+
+    return 1;
+}
+/*  End of sbh_lensmap_open.                                                  */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,539 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a fast ray tracing engine that uses the planar symmetry of   *
+ *      light rays in the Schwarzschild geometry.                             *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      By spherical symmetry every light ray lies in the plane through the   *
+ *      origin spanned by its initial position and velocity. Using polar      *
+ *      coordinates (r, psi) in that plane, u = 1 / r satisfies the orbit     *
+ *      equation                                                              *
+ *                                                                            *
+ *          u'' + u = 3 M u^2                                                 *
+ *                                                                            *
+ *      where ' is d / dpsi, with u(0) = 1 / r0 and u'(0) = -v_r / L. Here    *
+ *      L = r0 dpsi / dlambda is the angular part of the initial velocity.    *
+ *      This is a 2D system, (u, u'), instead of the 8D system used by        *
+ *      sbh_geodesic.h, and no trigonometric functions appear in the          *
+ *      derivative. The final point in the plane is mapped back to space      *
+ *      with sbh_vec4_rect_from_schwarzschild and the in-plane basis.         *
+ *                                                                            *
+ *      With E = f dt / dlambda and b = L / E, the coordinate time satisfies  *
+ *      dt / dpsi = 1 / (b u^2 f), which grows like r^2 far from the hole.    *
+ *      Along a straight line t + b u' / u is constant, and using the orbit   *
+ *      equation and (u')^2 = 1 / b^2 - u^2 f,                                *
+ *                                                                            *
+ *          d/dpsi (t + b u' / u) = 2M / (b u f) + b M u                      *
+ *          d/dpsi (E lambda + b u' / u) = b M u                              *
+ *                                                                            *
+ *      which only grow like r. These are integrated with the same RK4        *
+ *      stages as (u, u'), and t and lambda are recovered at the end.         *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_PLANAR_H
+#define SBH_PLANAR_H
+
+#include "sbh_inline.h"
+#include "sbh_constants.h"
+#include "sbh_vec4.h"
+#include "sbh_geodesic.h"
+#include "sbh_ray.h"
+#include <stddef.h>
+#include <math.h>
+
+/*  Parameters for the planar engine.                                         */
+struct sbh_planar_params {
+
+    /*  The mass of the black hole, in geometrized units.                     */
+    double mass;
+
+    /*  The largest step in the orbital angle psi, in radians.                */
+    double step;
+
+    /*  Rays heading outwards beyond this radius are considered escaped.      */
+    double escape_radius;
+
+    /*  Tracing stops once this many steps are taken.                         */
+    unsigned long int max_steps;
+};
+
+/*  The coordinate time and affine parameter of a ray in the planar engine,   *
+ *  without the b u' / u terms, see the notes at the top of the file.         */
+struct sbh_planar_clock {
+
+    /*  The impact parameter b = L / E of the ray.                            */
+    double impact_parameter;
+
+    /*  The integrals of 2M / (b u f) + b M u and of b M u over psi.          */
+    double time, length;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_default_params                                             *
+ *  Purpose:                                                                  *
+ *      Creates a reasonable set of parameters for the planar engine.         *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_planar_params):                                    *
+ *          Parameters with a 0.01 radian step and an escape radius of 1000M. *
+ ******************************************************************************/
+SBH_INLINE struct sbh_planar_params
+sbh_planar_default_params(double mass)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_planar_params params;
+
+    /*  Set the defaults and return.                                          */
+    params.mass = mass;
+    params.step = 0.01;
+    params.escape_radius = 1000.0 * mass;
+    params.max_steps = 100000UL;
+    return params;
+}
+/*  End of sbh_planar_default_params.                                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_rk4_step                                                   *
+ *  Purpose:                                                                  *
+ *      Performs one RK4 step of the orbit equation u'' = 3 M u^2 - u.        *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      u (double *):                                                         *
+ *          The inverse radius, advanced in place.                            *
+ *      du (double *):                                                        *
+ *          The derivative of u with respect to psi, advanced in place.       *
+ *      h (double):                                                           *
+ *          The step in psi.                                                  *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_planar_rk4_step(double mass, double *u, double *du, double h)
+{
+    /*  Declare necessary variables.                                          */
+    const double three_m = 3.0 * mass;
+    const double half_h = 0.5 * h;
+    const double u0 = *u;
+    const double w0 = *du;
+    double u1, w1, u2, w2, u3, w3, a0, a1, a2, a3;
+
+    /*  The four stages. The derivative of (u, w) is (w, 3 M u^2 - u).        */
+    a0 = u0 * (three_m * u0 - 1.0);
+    u1 = u0 + half_h * w0;
+    w1 = w0 + half_h * a0;
+    a1 = u1 * (three_m * u1 - 1.0);
+    u2 = u0 + half_h * w1;
+    w2 = w0 + half_h * a1;
+    a2 = u2 * (three_m * u2 - 1.0);
+    u3 = u0 + h * w2;
+    w3 = w0 + h * a2;
+    a3 = u3 * (three_m * u3 - 1.0);
+
+    /*  Combine the stages.                                                   */
+    *u = u0 + h * (w0 + 2.0*(w1 + w2) + w3) / 6.0;
+    *du = w0 + h * (a0 + 2.0*(a1 + a2) + a3) / 6.0;
+}
+/*  End of sbh_planar_rk4_step.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_rk4_step_clock                                             *
+ *  Purpose:                                                                  *
+ *      Performs one RK4 step of the orbit equation, and advances the clock   *
+ *      of the ray with the same stages.                                      *
+ *  Arguments:                                                                *
+ *      mass (double):                                                        *
+ *          The mass of the black hole.                                       *
+ *      u (double *):                                                         *
+ *          The inverse radius, advanced in place.                            *
+ *      du (double *):                                                        *
+ *          The derivative of u with respect to psi, advanced in place.       *
+ *      h (double):                                                           *
+ *          The step in psi.                                                  *
+ *      clock (struct sbh_planar_clock *):                                    *
+ *          The clock, advanced in place.                                     *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      The derivatives of the clock only depend on u, so they are evaluated  *
+ *      at the u of each stage of sbh_planar_rk4_step and combined with the   *
+ *      same weights. This is RK4 for the system (u, u', time, length).       *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_planar_rk4_step_clock(double mass, double *u, double *du, double h,
+                          struct sbh_planar_clock *clock)
+{
+    /*  Declare necessary variables.                                          */
+    const double three_m = 3.0 * mass;
+    const double two_m = 2.0 * mass;
+    const double half_h = 0.5 * h;
+    const double b = clock->impact_parameter;
+    const double shapiro = two_m / b;
+    const double bend = b * mass;
+    const double u0 = *u;
+    const double w0 = *du;
+    double u1, w1, u2, w2, u3, w3, a0, a1, a2, a3, c0, c1, c2, c3;
+
+    /*  The four stages, as in sbh_planar_rk4_step.                           */
+    a0 = u0 * (three_m * u0 - 1.0);
+    u1 = u0 + half_h * w0;
+    w1 = w0 + half_h * a0;
+    a1 = u1 * (three_m * u1 - 1.0);
+    u2 = u0 + half_h * w1;
+    w2 = w0 + half_h * a1;
+    a2 = u2 * (three_m * u2 - 1.0);
+    u3 = u0 + h * w2;
+    w3 = w0 + h * a2;
+    a3 = u3 * (three_m * u3 - 1.0);
+
+    /*  The 2M / (b u f) part of the time derivative at each stage.           */
+    c0 = shapiro / (u0 * (1.0 - two_m * u0));
+    c1 = shapiro / (u1 * (1.0 - two_m * u1));
+    c2 = shapiro / (u2 * (1.0 - two_m * u2));
+    c3 = shapiro / (u3 * (1.0 - two_m * u3));
+
+    /*  Combine the stages. The b M u part is common to both integrals.       */
+    *u = u0 + h * (w0 + 2.0*(w1 + w2) + w3) / 6.0;
+    *du = w0 + h * (a0 + 2.0*(a1 + a2) + a3) / 6.0;
+    clock->length += h * bend * (u0 + 2.0*(u1 + u2) + u3) / 6.0;
+    clock->time += h * bend * (u0 + 2.0*(u1 + u2) + u3) / 6.0 +
+                   h * (c0 + 2.0*(c1 + c2) + c3) / 6.0;
+}
+/*  End of sbh_planar_rk4_step_clock.                                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_integrate                                                  *
+ *  Purpose:                                                                  *
+ *      Integrates the orbit equation until the fate of the ray is decided.   *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_planar_params *):                            *
+ *          The engine parameters.                                            *
+ *      u (double *):                                                         *
+ *          The inverse radius, advanced in place.                            *
+ *      du (double *):                                                        *
+ *          The derivative of u with respect to psi, advanced in place.       *
+ *      psi (double *):                                                       *
+ *          The orbital angle, advanced in place.                             *
+ *      steps (unsigned long int *):                                          *
+ *          The number of steps taken, incremented in place.                  *
+ *      clock (struct sbh_planar_clock *):                                    *
+ *          The clock of the ray, advanced in place, or NULL to skip it.      *
+ *  Outputs:                                                                  *
+ *      status (enum sbh_ray_status):                                         *
+ *          The fate of the ray.                                              *
+ *  Method:                                                                   *
+ *      Integrate with RK4 until one of the following holds:                  *
+ *                                                                            *
+ *          u <= 1 / escape_radius and u' < 0: The ray escapes.               *
+ *          u > 1 / 3M and u' > 0: The ray is inside the photon sphere and    *
+ *              heading inwards. Photons have no turning points there, so it  *
+ *              is captured.                                                  *
+ *                                                                            *
+ *      Near the escape radius the step is limited so that u cannot jump      *
+ *      past zero, which would be a negative radius. With a clock, the step   *
+ *      is also limited so that u changes by at most a quarter, since the     *
+ *      time derivative grows like 1 / u and is poorly integrated by steps    *
+ *      that double the radius far from the black hole.                       *
+ ******************************************************************************/
+SBH_INLINE enum sbh_ray_status
+sbh_planar_integrate(const struct sbh_planar_params *params,
+                     double *u, double *du, double *psi,
+                     unsigned long int *steps,
+                     struct sbh_planar_clock *clock)
+{
+    /*  Declare necessary variables.                                          */
+    const double u_escape = 1.0 / params->escape_radius;
+    const double u_photon = 1.0 / (3.0 * params->mass);
+
+    while (*steps < params->max_steps)
+    {
+        double h = params->step;
+
+        /*  Check if the fate of the ray has been decided.                    */
+        if (*du < 0.0 && *u <= u_escape)
+            return SBH_RAY_ESCAPED;
+
+        if (*du > 0.0 && *u > u_photon)
+            return SBH_RAY_CAPTURED;
+
+        /*  Heading outwards u is nearly linear in psi. Aim for u_escape / 2  *
+         *  so the step lands past the escape radius but with u > 0.          */
+        if (*du < 0.0)
+        {
+            const double h_max = (*u - 0.5 * u_escape) / (-*du);
+
+            if (h_max < h)
+                h = h_max;
+        }
+
+        if (clock && *du != 0.0)
+        {
+            const double h_max = 0.25 * *u / fabs(*du);
+
+            if (h_max < h)
+                h = h_max;
+        }
+
+        if (clock)
+            sbh_planar_rk4_step_clock(params->mass, u, du, h, clock);
+        else
+            sbh_planar_rk4_step(params->mass, u, du, h);
+
+        *psi += h;
+        ++*steps;
+    }
+
+    return SBH_RAY_INCOMPLETE;
+}
+/*  End of sbh_planar_integrate.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_basis                                                      *
+ *  Purpose:                                                                  *
+ *      Computes an orthonormal basis adapted to the plane of a ray, and the  *
+ *      radial and tangential parts of its velocity.                          *
+ *  Arguments:                                                                *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The position and velocity, in Schwarzschild coordinates.          *
+ *      e1 (struct sbh_vec4 *):                                               *
+ *          The unit vector pointing from the origin to the ray.              *
+ *      e2 (struct sbh_vec4 *):                                               *
+ *          The unit vector along the tangential part of the velocity.        *
+ *      n (struct sbh_vec4 *):                                                *
+ *          The normal to the plane, e1 x e2.                                 *
+ *      v_r (double *):                                                       *
+ *          The radial part of the velocity, dr / dlambda.                    *
+ *      v_t (double *):                                                       *
+ *          The tangential part of the velocity, r dpsi / dlambda.            *
+ *  Outputs:                                                                  *
+ *      is_planar (int):                                                      *
+ *          0 if the ray is radial, in which case e2 and n are not set, and 1 *
+ *          otherwise.                                                        *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_planar_basis(const struct sbh_geodesic *ray,
+                 struct sbh_vec4 *e1, struct sbh_vec4 *e2, struct sbh_vec4 *n,
+                 double *v_r, double *v_t)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_vec4 x, d, tangent;
+
+    /*  Convert the initial data to Cartesian coordinates.                    */
+    x = sbh_vec4_schwarzschild_to_rect(&ray->p);
+    d = sbh_vec4_rect_velocity_from_schwarzschild(&ray->p, &ray->v);
+    *e1 = sbh_vec4_spatial_normalize(&x);
+
+    /*  Split the velocity into its radial and tangential parts.              */
+    *v_r = sbh_vec4_spatial_dot(&d, e1);
+    tangent = sbh_vec4_linear_combination(1.0, &d, -*v_r, e1, 0.0, e1);
+    *v_t = sqrt(sbh_vec4_spatial_dot(&tangent, &tangent));
+
+    /*  Radial rays do not define a plane.                                    */
+    if (*v_t <= 1.0E-14 * fabs(*v_r))
+        return 0;
+
+    /*  Complete the orthonormal basis for the plane of the orbit.            */
+    *e2 = sbh_vec4_linear_combination(1.0 / *v_t, &tangent, 0.0, e1, 0.0, e1);
+    *n = sbh_vec4_spatial_cross(e1, e2);
+    return 1;
+}
+/*  End of sbh_planar_basis.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_to_space                                                   *
+ *  Purpose:                                                                  *
+ *      Maps a point given in polar coordinates (r, psi) in the plane of a    *
+ *      ray into space.                                                       *
+ *  Arguments:                                                                *
+ *      r (double):                                                           *
+ *          The radius in the plane.                                          *
+ *      psi (double):                                                         *
+ *          The angle in the plane, measured from e1 towards e2.              *
+ *      t (double):                                                           *
+ *          The time component.                                               *
+ *      e1 (const struct sbh_vec4 *):                                         *
+ *          The first basis vector, from sbh_planar_basis.                    *
+ *      e2 (const struct sbh_vec4 *):                                         *
+ *          The second basis vector, from sbh_planar_basis.                   *
+ *      n (const struct sbh_vec4 *):                                          *
+ *          The normal vector, from sbh_planar_basis.                         *
+ *  Outputs:                                                                  *
+ *      p (struct sbh_vec4):                                                  *
+ *          The point in Cartesian coordinates.                               *
+ *  Method:                                                                   *
+ *      The plane is the equator of its own spherical coordinates, so apply   *
+ *      sbh_vec4_rect_from_schwarzschild with theta = pi / 2 and rotate the   *
+ *      result from the (e1, e2, n) basis to the standard one.                *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_planar_to_space(double r, double psi, double t,
+                    const struct sbh_vec4 *e1,
+                    const struct sbh_vec4 *e2,
+                    const struct sbh_vec4 *n)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_vec4 q = sbh_vec4_rect_from_schwarzschild(r, psi,
+                                                               SBH_HALF_PI, t);
+    struct sbh_vec4 p;
+
+    /*  Change basis. The time component does not rotate.                     */
+    p = sbh_vec4_linear_combination(q.dat[0], e1, q.dat[1], e2, q.dat[2], n);
+    p.dat[3] = q.dat[3];
+    return p;
+}
+/*  End of sbh_planar_to_space.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_trace                                                      *
+ *  Purpose:                                                                  *
+ *      Traces a single light ray using the planar reduction.                 *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_planar_params *):                            *
+ *          The engine parameters.                                            *
+ *      ray (const struct sbh_geodesic *):                                    *
+ *          The initial position and velocity, in Schwarzschild coordinates,  *
+ *          the same input as sbh_geodesic_integrate.                         *
+ *  Outputs:                                                                  *
+ *      result (struct sbh_ray_result):                                       *
+ *          The fate, final position, and final direction of the ray, and the *
+ *          coordinate time and affine parameter elapsed. Radial rays are not *
+ *          integrated, and both are -1 as in struct sbh_ray_result.          *
+ *  Method:                                                                   *
+ *      Build the orthonormal basis e1 = x / |x|, e2 along the tangential     *
+ *      part of the velocity, and n = e1 x e2. Integrate the orbit equation   *
+ *      with sbh_planar_integrate and rotate the result back into space.      *
+ *      E is f dt / dlambda for the null ray with the given spatial velocity, *
+ *      the time component of the input velocity is not used.                 *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_result
+sbh_planar_trace(const struct sbh_planar_params *params,
+                 const struct sbh_geodesic *ray)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_result result;
+    struct sbh_vec4 e1, e2, n;
+    struct sbh_planar_clock clock;
+    const double r0 = ray->p.dat[0];
+    double v_r, tangential_speed, u, du, psi, alpha, energy, shift;
+    const int is_planar = sbh_planar_basis(ray, &e1, &e2, &n,
+                                           &v_r, &tangential_speed);
+
+    result.steps = 0UL;
+    result.rejected = 0UL;
+    result.time = -1.0;
+    result.lambda = -1.0;
+    result.position = sbh_vec4_schwarzschild_to_rect(&ray->p);
+
+    /*  Radial rays do not define a plane, but their fate is trivial. Inward  *
+     *  rays fall in, outward rays escape in the direction they started in.   */
+    if (!is_planar)
+    {
+        const double sign = (v_r < 0.0 ? -1.0 : 1.0);
+        result.direction = sbh_vec4_linear_combination(sign, &e1, 0.0, &e1,
+                                                       0.0, &e1);
+        result.status = (v_r < 0.0 ? SBH_RAY_CAPTURED : SBH_RAY_ESCAPED);
+        return result;
+    }
+
+    /*  Initial conditions for the orbit equation. dpsi / dlambda is the      *
+     *  tangential speed divided by r, so u' = -v_r / (r0 tangential_speed).  */
+    u = 1.0 / r0;
+    du = -v_r / (r0 * tangential_speed);
+    psi = 0.0;
+
+    /*  E from the null condition, and b = L / E with L = r0 v_t.             */
+    energy = (1.0 - 2.0 * params->mass / r0) *
+             sbh_geodesic_null_time_component(params->mass, &ray->p, &ray->v);
+    clock.impact_parameter = r0 * tangential_speed / energy;
+    clock.time = 0.0;
+    clock.length = 0.0;
+    shift = -clock.impact_parameter * du / u;
+
+    result.status = sbh_planar_integrate(params, &u, &du, &psi,
+                                         &result.steps, &clock);
+
+    /*  Add the b u' / u terms of the clock back in.                          */
+    shift += clock.impact_parameter * du / u;
+    result.time = clock.time - shift;
+    result.lambda = (clock.length - shift) / energy;
+
+    /*  The velocity in the plane is proportional to -u' e_r + u e_psi, so    *
+     *  it makes the angle alpha with the radial direction.                   */
+    alpha = atan2(u, -du);
+
+    /*  Map the final point and direction from the plane into space.          */
+    result.position = sbh_planar_to_space(1.0 / u, psi,
+                                          ray->p.dat[3] + result.time,
+                                          &e1, &e2, &n);
+    result.direction = sbh_planar_to_space(1.0, psi + alpha, 0.0,
+                                           &e1, &e2, &n);
+
+    return result;
+}
+/*  End of sbh_planar_trace.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_planar_trace_array                                                *
+ *  Purpose:                                                                  *
+ *      Traces an array of light rays using the planar reduction.             *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_planar_params *):                            *
+ *          The engine parameters.                                            *
+ *      rays (const struct sbh_geodesic *):                                   *
+ *          The initial positions and velocities of the rays.                 *
+ *      results (struct sbh_ray_result *):                                    *
+ *          The output array, one result per ray.                             *
+ *      len (size_t):                                                         *
+ *          The number of rays.                                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_planar_trace_array(const struct sbh_planar_params *params,
+                       const struct sbh_geodesic *rays,
+                       struct sbh_ray_result *results,
+                       size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t k;
+
+    /*  Rays are independent, trace them one after the other.                 */
+    for (k = 0; k < len; ++k)
+        results[k] = sbh_planar_trace(params, rays + k);
+}
+/*  End of sbh_planar_trace_array.                                            */
+
+#endif
+/*  End of include guard.                                                     */
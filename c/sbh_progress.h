@@ -0,0 +1,343 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides progress reporting and cancellation for renders. Counters    *
+ *      are updated by the render threads without locks, and may be read, or  *
+ *      the render cancelled, from any other thread while it runs.            *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      A struct sbh_progress is passed to sbh_render_frame through the       *
+ *      progress field of struct sbh_render_params. The frame adds its tiles  *
+ *      to the total when it starts, and each tile is counted when it is      *
+ *      finished. The tile callbacks of the library add the rays of each row  *
+ *      as it is traced, and check the cancel flag before each pixel. The     *
+ *      tiles of sbh_distributed.h, whose pixels are drawn by a callback of   *
+ *      the user, are checked and counted row by row, one ray per pixel. Tile *
+ *      callbacks given to sbh_render_frame directly should do the same with  *
+ *      sbh_progress_cancelled and sbh_progress_add_rays.                     *
+ *                                                                            *
+ *      Once the flag is set no new tile is started, and the tile callbacks   *
+ *      return at the next pixel, so a render stops within about one pixel    *
+ *      per thread. sbh_render_frame then returns 0, unless every tile had    *
+ *      already been drawn in full, and the frame is left partly drawn and    *
+ *      should be discarded. A cancel that comes after the last pixel, such   *
+ *      as one from the callback of the last tile, does not void the frame.   *
+ *                                                                            *
+ *      The status may be polled with sbh_progress_status, or a callback may  *
+ *      be set, which is given the status after every finished tile.          *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      With GCC and clang the counters use the __atomic builtins with        *
+ *      relaxed ordering, which compile to plain loads and one locked add per *
+ *      update on x86. The flag is read with acquire and written with release *
+ *      ordering. Elsewhere volatile accesses are used, which are enough for  *
+ *      the flag and for counters that are only shown to a user, but are not  *
+ *      atomic in ISO C.                                                      *
+ *                                                                            *
+ *      The counters add up over every frame since the last reset. A render   *
+ *      made of several passes, such as sbh_adaptive_render, shows the        *
+ *      fraction of the passes started so far, and the fraction falls when a  *
+ *      new pass starts.                                                      *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_PROGRESS_H
+#define SBH_PROGRESS_H
+
+#include "sbh_inline.h"
+#include <stddef.h>
+
+/*  1 if the counters are updated with atomic builtins, 0 otherwise.          */
+#if defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || \
+                           (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define SBH_PROGRESS_HAS_ATOMICS 1
+#define SBH_PROGRESS_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define SBH_PROGRESS_ADD(x, n) \
+    ((void)__atomic_fetch_add(&(x), (n), __ATOMIC_RELAXED))
+#define SBH_PROGRESS_LOAD_FLAG(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define SBH_PROGRESS_STORE_FLAG(x, n) \
+    __atomic_store_n(&(x), (n), __ATOMIC_RELEASE)
+#else
+#define SBH_PROGRESS_HAS_ATOMICS 0
+#define SBH_PROGRESS_LOAD(x) (*(volatile unsigned long int *)&(x))
+#define SBH_PROGRESS_ADD(x, n) \
+    ((void)(*(volatile unsigned long int *)&(x) += (n)))
+#define SBH_PROGRESS_LOAD_FLAG(x) (*(volatile int *)&(x))
+#define SBH_PROGRESS_STORE_FLAG(x, n) ((void)(*(volatile int *)&(x) = (n)))
+#endif
+
+/*  A snapshot of the progress of a render.                                   */
+struct sbh_progress_status {
+
+    /*  The tiles of the frames started so far, and how many are finished.    */
+    unsigned long int tiles_total, tiles_done;
+
+    /*  The rays traced so far, as counted by the tile callbacks.             */
+    unsigned long int rays;
+
+    /*  tiles_done / tiles_total, or 0 if no frame has started.               */
+    double fraction;
+
+    /*  1 if the render was cancelled, 0 otherwise.                           */
+    int cancelled;
+};
+
+/*  Receives the status after a tile is finished, from the thread that        *
+ *  rendered it, so it is called from several threads at once. It should be   *
+ *  quick, it holds up the thread. Returns 0 to cancel the render, and 1 to   *
+ *  continue.                                                                 */
+typedef int
+(*sbh_progress_callback)(const struct sbh_progress_status *status, void *data);
+
+/*  The shared state of a render. Only access the counters and the flag with  *
+ *  the functions below while a render is running.                            */
+struct sbh_progress {
+
+    /*  The counters of struct sbh_progress_status.                           */
+    unsigned long int tiles_total, tiles_done, rays;
+
+    /*  Non-zero once the render is cancelled.                                */
+    int cancel;
+
+    /*  Called after each finished tile, or NULL.                             */
+    sbh_progress_callback callback;
+    void *callback_data;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_create                                                   *
+ *  Purpose:                                                                  *
+ *      Creates progress counters, all zero, with no callback.                *
+ *  Arguments:                                                                *
+ *      None (void).                                                          *
+ *  Outputs:                                                                  *
+ *      progress (struct sbh_progress):                                       *
+ *          The counters.                                                     *
+ ******************************************************************************/
+SBH_INLINE struct sbh_progress sbh_progress_create(void)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_progress progress;
+
+    progress.tiles_total = 0UL;
+    progress.tiles_done = 0UL;
+    progress.rays = 0UL;
+    progress.cancel = 0;
+    progress.callback = NULL;
+    progress.callback_data = NULL;
+    return progress;
+}
+/*  End of sbh_progress_create.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_reset                                                    *
+ *  Purpose:                                                                  *
+ *      Sets the counters to zero and clears the cancel flag, for a new job.  *
+ *  Arguments:                                                                *
+ *      progress (struct sbh_progress *):                                     *
+ *          The counters. No render may be using them.                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_progress_reset(struct sbh_progress *progress)
+{
+    progress->tiles_total = 0UL;
+    progress->tiles_done = 0UL;
+    progress->rays = 0UL;
+    progress->cancel = 0;
+}
+/*  End of sbh_progress_reset.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_cancel                                                   *
+ *  Purpose:                                                                  *
+ *      Asks the render to stop.                                              *
+ *  Arguments:                                                                *
+ *      progress (struct sbh_progress *):                                     *
+ *          The counters of the render.                                       *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      Safe to call from any thread, and from a signal handler where the     *
+ *      atomic builtins are used. The render returns after the rays being     *
+ *      traced are finished.                                                  *
+ ******************************************************************************/
+SBH_INLINE void sbh_progress_cancel(struct sbh_progress *progress)
+{
+    SBH_PROGRESS_STORE_FLAG(progress->cancel, 1);
+}
+/*  End of sbh_progress_cancel.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_cancelled                                                *
+ *  Purpose:                                                                  *
+ *      Checks if the render was cancelled. Tile callbacks call this before   *
+ *      each ray and return at once if it is set.                             *
+ *  Arguments:                                                                *
+ *      progress (const struct sbh_progress *):                               *
+ *          The counters, or NULL.                                            *
+ *  Outputs:                                                                  *
+ *      cancelled (int):                                                      *
+ *          1 if the render was cancelled, 0 if not or progress is NULL.      *
+ *  Notes:                                                                    *
+ *      The flag is only written once, so its cache line stays shared by the  *
+ *      readers and the check costs about as much as an ordinary load.        *
+ ******************************************************************************/
+SBH_INLINE int sbh_progress_cancelled(const struct sbh_progress *progress)
+{
+    if (!progress)
+        return 0;
+
+    return SBH_PROGRESS_LOAD_FLAG(progress->cancel) != 0;
+}
+/*  End of sbh_progress_cancelled.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_add_rays                                                 *
+ *  Purpose:                                                                  *
+ *      Counts traced rays.                                                   *
+ *  Arguments:                                                                *
+ *      progress (struct sbh_progress *):                                     *
+ *          The counters, or NULL.                                            *
+ *      rays (unsigned long int):                                             *
+ *          The number of rays.                                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      Every thread adds to the same counter, so call this once per row or   *
+ *      per tile, not once per ray.                                           *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_progress_add_rays(struct sbh_progress *progress, unsigned long int rays)
+{
+    if (progress)
+        SBH_PROGRESS_ADD(progress->rays, rays);
+}
+/*  End of sbh_progress_add_rays.                                             */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_status                                                   *
+ *  Purpose:                                                                  *
+ *      Reads the progress of a render.                                       *
+ *  Arguments:                                                                *
+ *      progress (const struct sbh_progress *):                               *
+ *          The counters.                                                     *
+ *  Outputs:                                                                  *
+ *      status (struct sbh_progress_status):                                  *
+ *          A snapshot of the counters.                                       *
+ *  Notes:                                                                    *
+ *      Safe to call from any thread while the render runs. The counters are  *
+ *      read one at a time, so they may be from slightly different moments,   *
+ *      but the fraction is never above 1.                                    *
+ ******************************************************************************/
+SBH_INLINE struct sbh_progress_status
+sbh_progress_status(const struct sbh_progress *progress)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_progress_status status;
+
+    /*  A tile is counted in the total before it can be done, so reading the  *
+     *  finished tiles first keeps done <= total.                             */
+    status.tiles_done = SBH_PROGRESS_LOAD(progress->tiles_done);
+    status.tiles_total = SBH_PROGRESS_LOAD(progress->tiles_total);
+    status.rays = SBH_PROGRESS_LOAD(progress->rays);
+    status.cancelled = sbh_progress_cancelled(progress);
+
+    if (status.tiles_done > status.tiles_total)
+        status.tiles_done = status.tiles_total;
+
+    if (status.tiles_total == 0UL)
+        status.fraction = 0.0;
+    else
+        status.fraction = (double)status.tiles_done /
+                          (double)status.tiles_total;
+
+    return status;
+}
+/*  End of sbh_progress_status.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_start_frame                                              *
+ *  Purpose:                                                                  *
+ *      Adds the tiles of a frame to the total. Called by sbh_render_frame.   *
+ *  Arguments:                                                                *
+ *      progress (struct sbh_progress *):                                     *
+ *          The counters, or NULL.                                            *
+ *      tiles (size_t):                                                       *
+ *          The number of tiles in the frame.                                 *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_progress_start_frame(struct sbh_progress *progress, size_t tiles)
+{
+    if (progress)
+        SBH_PROGRESS_ADD(progress->tiles_total, (unsigned long int)tiles);
+}
+/*  End of sbh_progress_start_frame.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progress_finish_tile                                              *
+ *  Purpose:                                                                  *
+ *      Counts a finished tile and calls the callback. Called by the threads  *
+ *      of sbh_render_frame.                                                  *
+ *  Arguments:                                                                *
+ *      progress (struct sbh_progress *):                                     *
+ *          The counters, or NULL.                                            *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      A tile cut short by a cancel is still counted, the fraction is then   *
+ *      only how much of the render was looked at.                            *
+ ******************************************************************************/
+SBH_INLINE void sbh_progress_finish_tile(struct sbh_progress *progress)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_progress_status status;
+
+    if (!progress)
+        return;
+
+    SBH_PROGRESS_ADD(progress->tiles_done, 1UL);
+
+    if (!progress->callback)
+        return;
+
+    status = sbh_progress_status(progress);
+
+    if (!progress->callback(&status, progress->callback_data))
+        sbh_progress_cancel(progress);
+}
+/*  End of sbh_progress_finish_tile.                                          */
+
+#endif
+/*  End of include guard.                                                     */
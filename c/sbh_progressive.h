@@ -0,0 +1,556 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides progressive rendering for interactive previews. A coarse     *
+ *      grid of rays is traced and shown first, and the image is refined by   *
+ *      subdividing only the cells of a quadtree where the rays disagree.     *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The image is covered by square cells of size s, a power of two. Each  *
+ *      cell is traced once, at the pixel of its top left corner, and every   *
+ *      pixel of the cell is given that color. This is the first image.       *
+ *                                                                            *
+ *      The four corners of a cell are the samples of the cell itself and of  *
+ *      the cells to its right, below, and diagonal. If two of them had       *
+ *      different fates (escaped, captured, disk), or colors that differ by   *
+ *      more than a threshold, the cell is split into four cells of size      *
+ *      s / 2. The top left child keeps the sample of its parent, so only 3   *
+ *      rays are traced per split. Only the children of split cells are       *
+ *      tested at the next level, and after log2(s) levels every pixel near   *
+ *      an edge has a ray of its own.                                         *
+ *                                                                            *
+ *      Each level is two passes of sbh_render_frame over the grid of cells,  *
+ *      the first marks the cells to split and the second traces and fills    *
+ *      them. The marks of a level are kept in their own array while the      *
+ *      next level reads them, so no pass reads what it writes. After each    *
+ *      level the image is handed to a callback, which may stop the render.   *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Features narrower than the coarse cells, such as the higher order     *
+ *      photon rings or single-pixel stars, can fall between the samples and  *
+ *      are only found if a neighboring edge splits the cells around them.    *
+ *      The final image is then not exactly one ray per pixel, and should be  *
+ *      replaced by a full render once the view stops moving if this matters. *
+ *      Cells on the right and bottom edges have no neighbor to compare with, *
+ *      so they are always split.                                             *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_PROGRESSIVE_H
+#define SBH_PROGRESSIVE_H
+
+#include "sbh_inline.h"
+#include "sbh_adaptive.h"
+#include "sbh_ray.h"
+#include "sbh_render.h"
+#include <stddef.h>
+#include <stdlib.h>
+
+/*  Receives the image after each level, width * height RGB triples. level is *
+ *  0 for the coarse grid, and rays is the number traced so far. It is called *
+ *  from the thread that started the render while no tile is running, so the  *
+ *  image may be read or copied. Returns 0 to stop, and 1 to continue.        */
+typedef int
+(*sbh_progressive_callback)(const float *rgb,
+                            unsigned int level,
+                            unsigned long rays,
+                            void *data);
+
+/*  Parameters for progressive rendering.                                     */
+struct sbh_progressive_params {
+
+    /*  The size of the coarse cells. Rounded down to a power of two.         */
+    unsigned int coarse;
+
+    /*  Cells are split if some channel differs between corners by more.      */
+    float threshold;
+};
+
+/*  The state shared by the tiles of a pass.                                  */
+struct sbh_progressive_frame {
+    const struct sbh_progressive_params *params;
+    const struct sbh_render_params *render;
+    sbh_adaptive_sample sample;
+    void *data;
+
+    /*  The output image, width * height RGB triples, row-major.              */
+    float *rgb;
+
+    /*  The fate of the sample that colored each pixel.                       */
+    unsigned char *status;
+
+    /*  The marks of the last level, NULL on the first, and of this level,    *
+     *  indexed by the pixel at the top left corner of a cell.                */
+    const unsigned char *split;
+    unsigned char *marks;
+
+    /*  The size of the cells of this level.                                  */
+    size_t size;
+
+    /*  The number of rays traced for each tile in the last pass.             */
+    unsigned long *tile_rays;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progressive_default_params                                        *
+ *  Purpose:                                                                  *
+ *      Returns the default parameters, 16 x 16 coarse cells and the          *
+ *      threshold of sbh_adaptive_default_params.                             *
+ *  Arguments:                                                                *
+ *      None (void).                                                          *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_progressive_params):                               *
+ *          The default parameters.                                           *
+ *  Notes:                                                                    *
+ *      A 1920 x 1080 image has 8160 coarse cells, a few milliseconds of      *
+ *      rays on a desktop processor.                                          *
+ ******************************************************************************/
+SBH_INLINE struct sbh_progressive_params sbh_progressive_default_params(void)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_progressive_params params;
+
+    params.coarse = 16U;
+    params.threshold = 0.05F;
+    return params;
+}
+/*  End of sbh_progressive_default_params.                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progressive_differs                                               *
+ *  Purpose:                                                                  *
+ *      Checks if two pixels disagree.                                        *
+ *  Arguments:                                                                *
+ *      frame (const struct sbh_progressive_frame *):                         *
+ *          The frame.                                                        *
+ *      a (size_t):                                                           *
+ *          The index of the first pixel.                                     *
+ *      b (size_t):                                                           *
+ *          The index of the second pixel.                                    *
+ *  Outputs:                                                                  *
+ *      differs (int):                                                        *
+ *          1 if the samples had different fates or some channel differs by   *
+ *          more than the threshold, and 0 otherwise.                         *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_progressive_differs(const struct sbh_progressive_frame *frame,
+                        size_t a, size_t b)
+{
+    /*  Declare necessary variables.                                          */
+    const float *p = frame->rgb + 3 * a;
+    const float *q = frame->rgb + 3 * b;
+    const float threshold = frame->params->threshold;
+    int n;
+
+    if (frame->status[a] != frame->status[b])
+        return 1;
+
+    for (n = 0; n < 3; ++n)
+    {
+        if (p[n] - q[n] > threshold || q[n] - p[n] > threshold)
+            return 1;
+    }
+
+    return 0;
+}
+/*  End of sbh_progressive_differs.                                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progressive_cell                                                  *
+ *  Purpose:                                                                  *
+ *      Traces the sample of a cell and gives its color to every pixel.       *
+ *  Arguments:                                                                *
+ *      frame (const struct sbh_progressive_frame *):                         *
+ *          The frame.                                                        *
+ *      x (size_t):                                                           *
+ *          The column of the top left pixel of the cell.                     *
+ *      y (size_t):                                                           *
+ *          The row of the top left pixel of the cell.                        *
+ *      size (size_t):                                                        *
+ *          The size of the cell, cropped to the image.                       *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_progressive_cell(const struct sbh_progressive_frame *frame,
+                     size_t x, size_t y, size_t size, unsigned int thread)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t width = frame->render->width;
+    const size_t height = frame->render->height;
+    const size_t index = y * width + x;
+    const size_t right = (x + size < width ? x + size : width);
+    const size_t bottom = (y + size < height ? y + size : height);
+    const float *rgb = frame->rgb + 3 * index;
+    unsigned char status;
+    size_t i, j;
+
+    status = (unsigned char)frame->sample((double)x + 0.5, (double)y + 0.5,
+                                          thread, frame->rgb + 3 * index,
+                                          frame->data);
+
+    for (j = y; j < bottom; ++j)
+    {
+        for (i = x; i < right; ++i)
+        {
+            float *pixel = frame->rgb + 3 * (j * width + i);
+
+            pixel[0] = rgb[0];
+            pixel[1] = rgb[1];
+            pixel[2] = rgb[2];
+            frame->status[j * width + i] = status;
+        }
+    }
+}
+/*  End of sbh_progressive_cell.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progressive_trace_tile                                            *
+ *  Purpose:                                                                  *
+ *      The first pass, traces and fills the coarse cells of a tile.          *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile, in cells.                                               *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The frame, a struct sbh_progressive_frame.                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_progressive_trace_tile(const struct sbh_render_tile *tile,
+                           unsigned int thread,
+                           void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_progressive_frame *frame =
+        (const struct sbh_progressive_frame *)data;
+    struct sbh_progress *const progress = frame->render->progress;
+    const size_t size = frame->size;
+    size_t i, j;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            if (sbh_progress_cancelled(progress))
+                return;
+
+            sbh_progressive_cell(frame, i * size, j * size, size, thread);
+        }
+
+        sbh_progress_add_rays(progress, (unsigned long)tile->width);
+    }
+
+    frame->tile_rays[tile->index] = (unsigned long)(tile->width*tile->height);
+}
+/*  End of sbh_progressive_trace_tile.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progressive_mark_tile                                             *
+ *  Purpose:                                                                  *
+ *      Marks the cells of a tile that are split at this level.               *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile, in cells.                                               *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread, unused.                           *
+ *      data (void *):                                                        *
+ *          The frame, a struct sbh_progressive_frame.                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      Every cell of the level is written, split or not, so the marks of     *
+ *      older levels left in the array are never read by the next level.      *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_progressive_mark_tile(const struct sbh_render_tile *tile,
+                          unsigned int thread,
+                          void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_progressive_frame *frame =
+        (const struct sbh_progressive_frame *)data;
+    const size_t width = frame->render->width;
+    const size_t height = frame->render->height;
+    const size_t size = frame->size;
+    size_t i, j;
+
+    (void)thread;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t x = i * size;
+            const size_t y = j * size;
+            const size_t index = y * width + x;
+            int mark = 0;
+
+            /*  Only the children of a split cell are tested. The parent has  *
+             *  its corner at a multiple of twice the size.                   */
+            if (frame->split)
+            {
+                const size_t parent = (y - y % (2 * size)) * width +
+                                      (x - x % (2 * size));
+
+                mark = frame->split[parent];
+            }
+            else
+                mark = 1;
+
+            if (mark && size > 1)
+            {
+                if (x + size >= width || y + size >= height)
+                    mark = 1;
+                else
+                {
+                    const size_t below = index + size * width;
+
+                    mark = sbh_progressive_differs(frame, index, index+size) ||
+                           sbh_progressive_differs(frame, index, below) ||
+                           sbh_progressive_differs(frame, index, below+size);
+                }
+            }
+            else
+                mark = 0;
+
+            frame->marks[index] = (unsigned char)mark;
+        }
+    }
+}
+/*  End of sbh_progressive_mark_tile.                                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progressive_refine_tile                                           *
+ *  Purpose:                                                                  *
+ *      Splits the marked cells of a tile, tracing the three new children.    *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile, in cells.                                               *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The frame, a struct sbh_progressive_frame.                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_progressive_refine_tile(const struct sbh_render_tile *tile,
+                            unsigned int thread,
+                            void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_progressive_frame *frame =
+        (const struct sbh_progressive_frame *)data;
+    struct sbh_progress *const progress = frame->render->progress;
+    const size_t width = frame->render->width;
+    const size_t height = frame->render->height;
+    const size_t size = frame->size;
+    const size_t half = size / 2;
+    unsigned long rays = 0UL;
+    size_t i, j;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t x = i * size;
+            const size_t y = j * size;
+
+            if (!frame->marks[y * width + x])
+                continue;
+
+            if (sbh_progress_cancelled(progress))
+                return;
+
+            if (x + half < width)
+            {
+                sbh_progressive_cell(frame, x + half, y, half, thread);
+                ++rays;
+            }
+
+            if (y + half < height)
+            {
+                sbh_progressive_cell(frame, x, y + half, half, thread);
+                ++rays;
+            }
+
+            if (x + half < width && y + half < height)
+            {
+                sbh_progressive_cell(frame, x + half, y + half, half, thread);
+                ++rays;
+            }
+        }
+    }
+
+    frame->tile_rays[tile->index] = rays;
+    sbh_progress_add_rays(progress, rays);
+}
+/*  End of sbh_progressive_refine_tile.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_progressive_render                                                *
+ *  Purpose:                                                                  *
+ *      Renders a frame progressively, from coarse cells down to pixels.      *
+ *  Arguments:                                                                *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry and number of threads. The tiles are measured  *
+ *          in cells of the current level, not in pixels.                     *
+ *      params (const struct sbh_progressive_params *):                       *
+ *          The refinement parameters. A coarse size of 0 or 1 traces every   *
+ *          pixel in a single level.                                          *
+ *      sample (sbh_adaptive_sample):                                         *
+ *          The function that traces and shades a ray. It is called from      *
+ *          several threads at once.                                          *
+ *      data (void *):                                                        *
+ *          Passed to sample.                                                 *
+ *      rgb (float *):                                                        *
+ *          The output image, render->width * render->height RGB triples in   *
+ *          row-major order.                                                  *
+ *      callback (sbh_progressive_callback):                                  *
+ *          Receives the image after each level, or NULL.                     *
+ *      callback_data (void *):                                               *
+ *          Passed to callback.                                               *
+ *      rays (unsigned long *):                                               *
+ *          If not NULL, set to the number of rays traced.                    *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the frame was rendered, or stopped by the callback, 0 if     *
+ *          memory could not be allocated or sbh_render_frame failed.         *
+ *  Notes:                                                                    *
+ *      The render ends early, without another call to the callback, once a   *
+ *      level splits no cells, since the image can no longer change.          *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_progressive_render(const struct sbh_render_params *render,
+                       const struct sbh_progressive_params *params,
+                       sbh_adaptive_sample sample,
+                       void *data,
+                       float *rgb,
+                       sbh_progressive_callback callback,
+                       void *callback_data,
+                       unsigned long *rays)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_progressive_frame frame;
+    struct sbh_render_params cells = *render;
+    const size_t pixels = render->width * render->height;
+    const size_t tiles = sbh_render_tile_count(render);
+    unsigned char *marks[2];
+    unsigned long total = 0UL, added;
+    unsigned int level = 0U;
+    int success = 0, running = 1;
+    size_t n, count, size = 1;
+
+    while (2 * size <= (size_t)params->coarse)
+        size *= 2;
+
+    /*  The grid of cells has no more tiles than the grid of pixels.          */
+    cells.stats = NULL;
+    frame.params = params;
+    frame.render = render;
+    frame.sample = sample;
+    frame.data = data;
+    frame.rgb = rgb;
+    frame.status = (unsigned char *)malloc(pixels + 1);
+    frame.split = NULL;
+    frame.marks = NULL;
+    frame.size = size;
+    frame.tile_rays = (unsigned long *)
+        malloc(sizeof(*frame.tile_rays) * (tiles + 1));
+    marks[0] = (unsigned char *)malloc(pixels + 1);
+    marks[1] = (unsigned char *)malloc(pixels + 1);
+
+    if (frame.status && frame.tile_rays && marks[0] && marks[1])
+    {
+        cells.width = (render->width + size - 1) / size;
+        cells.height = (render->height + size - 1) / size;
+        success = sbh_render_frame(&cells, sbh_progressive_trace_tile, &frame);
+    }
+
+    if (success)
+    {
+        count = sbh_render_tile_count(&cells);
+
+        for (n = 0; n < count; ++n)
+            total += frame.tile_rays[n];
+
+        if (callback)
+            running = callback(rgb, level, total, callback_data);
+    }
+
+    while (success && running && frame.size > 1)
+    {
+        cells.width = (render->width + frame.size - 1) / frame.size;
+        cells.height = (render->height + frame.size - 1) / frame.size;
+        frame.marks = marks[level & 1U];
+
+        success =
+            sbh_render_frame(&cells, sbh_progressive_mark_tile, &frame) &&
+            sbh_render_frame(&cells, sbh_progressive_refine_tile, &frame);
+
+        if (!success)
+            break;
+
+        added = 0UL;
+        count = sbh_render_tile_count(&cells);
+
+        for (n = 0; n < count; ++n)
+            added += frame.tile_rays[n];
+
+        if (added == 0UL)
+            break;
+
+        total += added;
+        ++level;
+        frame.split = frame.marks;
+        frame.size /= 2;
+
+        if (callback)
+            running = callback(rgb, level, total, callback_data);
+    }
+
+    if (success && rays)
+        *rays = total;
+
+    free(frame.status);
+    free(frame.tile_rays);
+    free(marks[0]);
+    free(marks[1]);
+    return success;
+}
+/*  End of sbh_progressive_render.                                            */
+
+#endif
+/*  End of include guard.                                                     */
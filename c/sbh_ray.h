@@ -0,0 +1,125 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides the common result type for the ray tracing engines.          *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_RAY_H
+#define SBH_RAY_H
+
+#include "sbh_inline.h"
+#include "sbh_vec4.h"
+#include "sbh_fvec4.h"
+
+/*  The fate of a traced ray.                                                 */
+enum sbh_ray_status {
+
+    /*  The step limit was reached before the fate of the ray was decided.    */
+    SBH_RAY_INCOMPLETE,
+
+    /*  The ray reached the celestial sphere heading outwards.                */
+    SBH_RAY_ESCAPED,
+
+    /*  The ray fell into the black hole.                                     */
+    SBH_RAY_CAPTURED,
+
+    /*  The ray hit an accretion disk, see sbh_disk.h.                        */
+    SBH_RAY_DISK
+};
+
+/*  The outcome of tracing a ray, shared by every engine.                     */
+struct sbh_ray_result {
+
+    /*  How the trace ended.                                                  */
+    enum sbh_ray_status status;
+
+    /*  The final position of the ray in Cartesian coordinates (x, y, z, t).  */
+    struct sbh_vec4 position;
+
+    /*  The direction of travel at the final position, a unit vector in       *
+     *  Cartesian coordinates. The time component is zero. For escaped rays   *
+     *  this is the direction on the sky the ray came from, reversed.         */
+    struct sbh_vec4 direction;
+
+    /*  The coordinate time and the affine parameter elapsed between the      *
+     *  initial state and the final position, accumulated along with the      *
+     *  position. The affine parameter has the scale of the initial velocity. *
+     *  Both are -1 where they are not computed, by the closed-form solution, *
+     *  the deflection table, and the planar engine for radial rays, and      *
+     *  position.dat[3] is then the initial time.                             */
+    double time;
+    double lambda;
+
+    /*  The number of steps taken by the engine.                              */
+    unsigned long int steps;
+
+    /*  The number of those steps that were rejected by the adaptive step     *
+     *  control. Only counted if SBH_STATS is defined, see sbh_stats.h, and   *
+     *  zero otherwise and for engines other than DP45.                       */
+    unsigned long int rejected;
+};
+
+/*  The same as struct sbh_ray_result in single precision, for per-pixel      *
+ *  output buffers. Rays are traced in double and rounded once at the end.    */
+struct sbh_ray_fresult {
+    enum sbh_ray_status status;
+    struct sbh_fvec4 position;
+    struct sbh_fvec4 direction;
+    float time;
+    float lambda;
+    unsigned long int steps;
+    unsigned long int rejected;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_ray_result_to_float                                               *
+ *  Purpose:                                                                  *
+ *      Rounds a ray result to single precision.                              *
+ *  Arguments:                                                                *
+ *      result (const struct sbh_ray_result *):                               *
+ *          The result from one of the engines.                               *
+ *  Outputs:                                                                  *
+ *      fresult (struct sbh_ray_fresult):                                     *
+ *          The same result with float vectors.                               *
+ ******************************************************************************/
+SBH_INLINE struct sbh_ray_fresult
+sbh_ray_result_to_float(const struct sbh_ray_result *result)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_ray_fresult fresult;
+
+    fresult.status = result->status;
+    fresult.position = sbh_fvec4_from_vec4(&result->position);
+    fresult.direction = sbh_fvec4_from_vec4(&result->direction);
+    fresult.time = (float)result->time;
+    fresult.lambda = (float)result->lambda;
+    fresult.steps = result->steps;
+    fresult.rejected = result->rejected;
+    return fresult;
+}
+/*  End of sbh_ray_result_to_float.                                           */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,673 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a tile based frame driver. The image is split into tiles     *
+ *      and the tiles are rendered by a work-stealing pool of threads.        *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The tiles are numbered in row-major order and each thread starts with *
+ *      a contiguous range of them. A thread takes tiles from the front of    *
+ *      its own range. When its range is empty it steals the back half of     *
+ *      the range of another thread. Tiles near the photon sphere cost many   *
+ *      times more than tiles of open sky, so a static split of the rows      *
+ *      would leave most threads idle while a few finish the hard band.       *
+ *                                                                            *
+ *      Each range is guarded by its own mutex. There is one lock per tile    *
+ *      taken, which is negligible next to the cost of tracing a tile.        *
+ *                                                                            *
+ *      If progress counters are given, see sbh_progress.h, each thread       *
+ *      checks the cancel flag before taking a tile, and stops once it is     *
+ *      set.                                                                  *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Threads use POSIX threads, so link with -pthread. Define              *
+ *      SBH_NO_THREADS, or build on a system without POSIX threads, and       *
+ *      frames are rendered on the calling thread only.                       *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_RENDER_H
+#define SBH_RENDER_H
+
+#include "sbh_inline.h"
+#include "sbh_progress.h"
+#include "sbh_stats.h"
+#include <stddef.h>
+#include <stdlib.h>
+
+/*  Use POSIX threads where they are available.                               */
+#if !defined(SBH_NO_THREADS) && \
+    (defined(__unix__) || defined(__unix) || defined(__APPLE__))
+
+#define SBH_RENDER_HAS_THREADS 1
+#include <pthread.h>
+#include <unistd.h>
+
+#else
+/*  Else for #if !defined(SBH_NO_THREADS) && defined(__unix__).               */
+
+#define SBH_RENDER_HAS_THREADS 0
+
+#endif
+/*  End of #if !defined(SBH_NO_THREADS) && defined(__unix__).                 */
+
+/*  A rectangular block of pixels. The pixels are (x + i, y + j) for          *
+ *  0 <= i < width and 0 <= j < height, with (0, 0) the top left.             */
+struct sbh_render_tile {
+    size_t x, y, width, height;
+
+    /*  The position of the tile in the row-major ordering of all tiles.      */
+    size_t index;
+};
+
+/*  The function called to render a tile. thread is the index of the worker,  *
+ *  0 <= thread < the number of threads, so per-thread scratch memory can be  *
+ *  indexed by it. data is the pointer passed to sbh_render_frame.            */
+typedef void
+(*sbh_render_tile_callback)(const struct sbh_render_tile *tile,
+                            unsigned int thread,
+                            void *data);
+
+/*  Parameters for rendering a frame.                                         */
+struct sbh_render_params {
+
+    /*  The size of the image, in pixels.                                     */
+    size_t width, height;
+
+    /*  The size of a tile. Tiles on the right and bottom edges are cropped.  */
+    size_t tile_width, tile_height;
+
+    /*  The number of threads to use. Zero means one per online processor.    */
+    unsigned int threads;
+
+    /*  Counters for the tile and frame times, or NULL. Only updated if       *
+     *  SBH_STATS is defined, see sbh_stats.h. It needs at least              *
+     *  sbh_render_thread_count threads and sbh_render_tile_count tiles.      */
+    struct sbh_stats *stats;
+
+    /*  Progress counters and the cancel flag, or NULL, see sbh_progress.h.   *
+     *  Unlike stats these do not depend on the tiles, so renders made of     *
+     *  several frames of different sizes pass them on to every frame.        */
+    struct sbh_progress *progress;
+};
+
+/*  The range of tiles owned by a worker thread.                              */
+struct sbh_render_queue {
+
+    /*  The tiles begin <= n < end have not been started yet.                 */
+    size_t begin, end;
+
+#if SBH_RENDER_HAS_THREADS
+    pthread_mutex_t lock;
+#endif
+};
+
+/*  Shared state for the workers rendering a frame.                           */
+struct sbh_render_pool {
+    const struct sbh_render_params *params;
+    sbh_render_tile_callback callback;
+    void *data;
+    struct sbh_render_queue *queues;
+    unsigned int threads;
+
+    /*  With progress counters, the tiles that ran without being cancelled.   */
+    unsigned long int finished;
+};
+
+/*  The argument passed to each worker.                                       */
+struct sbh_render_worker {
+    struct sbh_render_pool *pool;
+    unsigned int id;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_default_params                                             *
+ *  Purpose:                                                                  *
+ *      Creates reasonable render parameters for an image.                    *
+ *  Arguments:                                                                *
+ *      width (size_t):                                                       *
+ *          The width of the image.                                           *
+ *      height (size_t):                                                      *
+ *          The height of the image.                                          *
+ *  Outputs:                                                                  *
+ *      params (struct sbh_render_params):                                    *
+ *          16x16 tiles, one thread per processor, no counters.               *
+ ******************************************************************************/
+SBH_INLINE struct sbh_render_params
+sbh_render_default_params(size_t width, size_t height)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_render_params params;
+
+    /*  Set the defaults and return.                                          */
+    params.width = width;
+    params.height = height;
+    params.tile_width = 16;
+    params.tile_height = 16;
+    params.threads = 0U;
+    params.stats = NULL;
+    params.progress = NULL;
+    return params;
+}
+/*  End of sbh_render_default_params.                                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_hardware_threads                                           *
+ *  Purpose:                                                                  *
+ *      Returns the number of processors available.                           *
+ *  Arguments:                                                                *
+ *      None (void).                                                          *
+ *  Outputs:                                                                  *
+ *      threads (unsigned int):                                               *
+ *          The number of online processors, or 1 if it cannot be found or    *
+ *          threads are disabled.                                             *
+ ******************************************************************************/
+SBH_INLINE unsigned int sbh_render_hardware_threads(void)
+{
+#if SBH_RENDER_HAS_THREADS && defined(_SC_NPROCESSORS_ONLN)
+    const long int threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (threads > 0L)
+        return (unsigned int)threads;
+#endif
+
+    return 1U;
+}
+/*  End of sbh_render_hardware_threads.                                       */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_tile_count                                                 *
+ *  Purpose:                                                                  *
+ *      Computes the number of tiles in a frame.                              *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_render_params *):                            *
+ *          The render parameters. The tile sizes must be positive.           *
+ *  Outputs:                                                                  *
+ *      count (size_t):                                                       *
+ *          The number of tiles.                                              *
+ ******************************************************************************/
+SBH_INLINE size_t sbh_render_tile_count(const struct sbh_render_params *params)
+{
+    const size_t columns = (params->width + params->tile_width - 1) /
+                           params->tile_width;
+    const size_t rows = (params->height + params->tile_height - 1) /
+                        params->tile_height;
+
+    return columns * rows;
+}
+/*  End of sbh_render_tile_count.                                             */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_get_tile                                                   *
+ *  Purpose:                                                                  *
+ *      Computes the pixels covered by a tile.                                *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_render_params *):                            *
+ *          The render parameters.                                            *
+ *      index (size_t):                                                       *
+ *          The index of the tile, less than sbh_render_tile_count(params).   *
+ *  Outputs:                                                                  *
+ *      tile (struct sbh_render_tile):                                        *
+ *          The tile, cropped to the image.                                   *
+ ******************************************************************************/
+SBH_INLINE struct sbh_render_tile
+sbh_render_get_tile(const struct sbh_render_params *params, size_t index)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_render_tile tile;
+    const size_t columns = (params->width + params->tile_width - 1) /
+                           params->tile_width;
+
+    /*  Locate the tile and crop it to the edges of the image.                */
+    tile.index = index;
+    tile.x = (index % columns) * params->tile_width;
+    tile.y = (index / columns) * params->tile_height;
+    tile.width = params->width - tile.x;
+    tile.height = params->height - tile.y;
+
+    if (tile.width > params->tile_width)
+        tile.width = params->tile_width;
+
+    if (tile.height > params->tile_height)
+        tile.height = params->tile_height;
+
+    return tile;
+}
+/*  End of sbh_render_get_tile.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_end_tile                                                   *
+ *  Purpose:                                                                  *
+ *      Counts a tile whose callback has returned.                            *
+ *  Arguments:                                                                *
+ *      pool (struct sbh_render_pool *):                                      *
+ *          The pool.                                                         *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      The callback may have returned early because the render was           *
+ *      cancelled, so the tile is only complete if the flag is still clear.   *
+ *      It is read before sbh_progress_finish_tile, whose callback may set    *
+ *      it, so a cancel after the last pixel does not void the frame.         *
+ ******************************************************************************/
+SBH_INLINE void sbh_render_end_tile(struct sbh_render_pool *pool)
+{
+    struct sbh_progress *const progress = pool->params->progress;
+
+    if (progress && !sbh_progress_cancelled(progress))
+        SBH_PROGRESS_ADD(pool->finished, 1UL);
+
+    sbh_progress_finish_tile(progress);
+}
+/*  End of sbh_render_end_tile.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_run_tile                                                   *
+ *  Purpose:                                                                  *
+ *      Renders a single tile with the pool's callback.                       *
+ *  Arguments:                                                                *
+ *      pool (struct sbh_render_pool *):                                      *
+ *          The pool.                                                         *
+ *      index (size_t):                                                       *
+ *          The index of the tile.                                            *
+ *      thread (unsigned int):                                                *
+ *          The index of the worker.                                          *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_render_run_tile(struct sbh_render_pool *pool, size_t index,
+                    unsigned int thread)
+{
+    const struct sbh_render_tile tile = sbh_render_get_tile(pool->params,
+                                                            index);
+
+#if SBH_STATS_ENABLED
+    /*  Each tile index is run once and each thread has its own counters, so  *
+     *  no locking is needed.                                                 */
+    struct sbh_stats *const stats = pool->params->stats;
+
+    if (stats)
+    {
+        const double start = sbh_stats_seconds();
+        double seconds;
+
+        pool->callback(&tile, thread, pool->data);
+        seconds = sbh_stats_seconds() - start;
+        stats->tile_seconds[index] += seconds;
+        stats->thread[thread].busy += seconds;
+        ++stats->thread[thread].tiles;
+        sbh_render_end_tile(pool);
+        return;
+    }
+#endif
+
+    pool->callback(&tile, thread, pool->data);
+    sbh_render_end_tile(pool);
+}
+/*  End of sbh_render_run_tile.                                               */
+
+#if SBH_RENDER_HAS_THREADS
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_pop                                                        *
+ *  Purpose:                                                                  *
+ *      Takes the next tile from the front of a worker's own range.           *
+ *  Arguments:                                                                *
+ *      queue (struct sbh_render_queue *):                                    *
+ *          The worker's queue.                                               *
+ *      index (size_t *):                                                     *
+ *          The index of the tile taken.                                      *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if a tile was taken, 0 if the range is empty.                   *
+ ******************************************************************************/
+SBH_INLINE int sbh_render_pop(struct sbh_render_queue *queue, size_t *index)
+{
+    /*  Declare necessary variables.                                          */
+    int success = 0;
+
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->begin < queue->end)
+    {
+        *index = queue->begin;
+        ++queue->begin;
+        success = 1;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return success;
+}
+/*  End of sbh_render_pop.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_steal                                                      *
+ *  Purpose:                                                                  *
+ *      Takes work from another worker once a worker's own range is empty.    *
+ *  Arguments:                                                                *
+ *      pool (struct sbh_render_pool *):                                      *
+ *          The pool.                                                         *
+ *      id (unsigned int):                                                    *
+ *          The index of the thief.                                           *
+ *      index (size_t *):                                                     *
+ *          The index of the first stolen tile, to be rendered at once.       *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if work was stolen, 0 if every range is empty.                  *
+ *  Method:                                                                   *
+ *      Visit the other workers in turn, starting after the thief. The back   *
+ *      half of the first non-empty range is moved to the thief's range,      *
+ *      except for its first tile which is returned. Taking the back keeps    *
+ *      the victim working on tiles that are next to each other in memory.    *
+ *  Notes:                                                                    *
+ *      Stolen tiles are in no range while they are moved, so another thief   *
+ *      may miss them and finish early. This costs a little balance at the    *
+ *      very end of a frame, but no tile is ever lost or rendered twice.      *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_render_steal(struct sbh_render_pool *pool, unsigned int id, size_t *index)
+{
+    /*  Declare necessary variables.                                          */
+    unsigned int offset;
+
+    for (offset = 1U; offset < pool->threads; ++offset)
+    {
+        struct sbh_render_queue *victim;
+        struct sbh_render_queue *const own = pool->queues + id;
+        size_t start, end;
+
+        victim = pool->queues + (id + offset) % pool->threads;
+        pthread_mutex_lock(&victim->lock);
+
+        if (victim->begin >= victim->end)
+        {
+            pthread_mutex_unlock(&victim->lock);
+            continue;
+        }
+
+        /*  Take the back half, rounding up so a single tile can be stolen.   */
+        end = victim->end;
+        start = end - (end - victim->begin + 1) / 2;
+        victim->end = start;
+        pthread_mutex_unlock(&victim->lock);
+
+        /*  Keep the first tile and put the rest into the thief's own range.  */
+        pthread_mutex_lock(&own->lock);
+        own->begin = start + 1;
+        own->end = end;
+        pthread_mutex_unlock(&own->lock);
+
+        *index = start;
+        return 1;
+    }
+
+    return 0;
+}
+/*  End of sbh_render_steal.                                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_worker_main                                                *
+ *  Purpose:                                                                  *
+ *      The main loop of a worker thread.                                     *
+ *  Arguments:                                                                *
+ *      arg (void *):                                                         *
+ *          A pointer to the worker's struct sbh_render_worker.               *
+ *  Outputs:                                                                  *
+ *      NULL (void *).                                                        *
+ *  Method:                                                                   *
+ *      Render the tiles of the worker's own range, then steal until no       *
+ *      worker has tiles left. Work is never added, so once every range is    *
+ *      seen empty the worker may exit. A cancelled render leaves the rest of *
+ *      the tiles in their ranges, and every worker exits at its next tile.   *
+ ******************************************************************************/
+SBH_INLINE void *sbh_render_worker_main(void *arg)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_render_worker *const worker =
+        (const struct sbh_render_worker *)arg;
+    struct sbh_render_pool *const pool = worker->pool;
+    size_t index;
+
+    for (;;)
+    {
+        if (sbh_progress_cancelled(pool->params->progress))
+            break;
+
+        if (!sbh_render_pop(pool->queues + worker->id, &index))
+            if (!sbh_render_steal(pool, worker->id, &index))
+                break;
+
+        sbh_render_run_tile(pool, index, worker->id);
+    }
+
+    return NULL;
+}
+/*  End of sbh_render_worker_main.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_frame_threaded                                             *
+ *  Purpose:                                                                  *
+ *      Renders a frame with a pool of threads.                               *
+ *  Arguments:                                                                *
+ *      pool (struct sbh_render_pool *):                                      *
+ *          The pool, with params, callback, data, and threads set.           *
+ *      tiles (size_t):                                                       *
+ *          The number of tiles in the frame.                                 *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the frame was rendered, 0 if memory could not be allocated.  *
+ *  Notes:                                                                    *
+ *      The calling thread is worker 0. If a thread cannot be created its     *
+ *      range is stolen by the others, so the frame is still completed.       *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_render_frame_threaded(struct sbh_render_pool *pool, size_t tiles)
+{
+    /*  Declare necessary variables.                                          */
+    const unsigned int threads = pool->threads;
+    struct sbh_render_worker *workers;
+    pthread_t *handles;
+    int *started;
+    unsigned int n;
+
+    pool->queues = (struct sbh_render_queue *)
+        malloc(sizeof(*pool->queues) * threads);
+    workers = (struct sbh_render_worker *)malloc(sizeof(*workers) * threads);
+    handles = (pthread_t *)malloc(sizeof(*handles) * threads);
+    started = (int *)malloc(sizeof(*started) * threads);
+
+    if (!pool->queues || !workers || !handles || !started)
+    {
+        free(pool->queues);
+        free(workers);
+        free(handles);
+        free(started);
+        return 0;
+    }
+
+    /*  Give each worker an equal contiguous range of tiles.                  */
+    for (n = 0U; n < threads; ++n)
+    {
+        pool->queues[n].begin = tiles * n / threads;
+        pool->queues[n].end = tiles * (n + 1U) / threads;
+        pthread_mutex_init(&pool->queues[n].lock, NULL);
+        workers[n].pool = pool;
+        workers[n].id = n;
+    }
+
+    for (n = 1U; n < threads; ++n)
+        started[n] = !pthread_create(handles + n, NULL,
+                                     sbh_render_worker_main, workers + n);
+
+    sbh_render_worker_main(workers);
+
+    for (n = 1U; n < threads; ++n)
+        if (started[n])
+            pthread_join(handles[n], NULL);
+
+    for (n = 0U; n < threads; ++n)
+        pthread_mutex_destroy(&pool->queues[n].lock);
+
+    free(pool->queues);
+    free(workers);
+    free(handles);
+    free(started);
+    pool->queues = NULL;
+    return 1;
+}
+/*  End of sbh_render_frame_threaded.                                         */
+
+#endif
+/*  End of #if SBH_RENDER_HAS_THREADS.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_thread_count                                               *
+ *  Purpose:                                                                  *
+ *      Returns the number of threads sbh_render_frame will use, so that      *
+ *      per-thread data can be allocated before rendering.                    *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_render_params *):                            *
+ *          The render parameters. The tile sizes must be positive.           *
+ *  Outputs:                                                                  *
+ *      threads (unsigned int):                                               *
+ *          The number of threads. Callbacks get thread indices below this.   *
+ ******************************************************************************/
+SBH_INLINE unsigned int
+sbh_render_thread_count(const struct sbh_render_params *params)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t tiles = sbh_render_tile_count(params);
+    unsigned int threads = params->threads;
+
+    if (threads == 0U)
+        threads = sbh_render_hardware_threads();
+
+    if ((size_t)threads > tiles)
+        threads = (unsigned int)tiles;
+
+#if !SBH_RENDER_HAS_THREADS
+    threads = 1U;
+#endif
+
+    return threads;
+}
+/*  End of sbh_render_thread_count.                                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_render_frame                                                      *
+ *  Purpose:                                                                  *
+ *      Renders every tile of a frame.                                        *
+ *  Arguments:                                                                *
+ *      params (const struct sbh_render_params *):                            *
+ *          The render parameters.                                            *
+ *      callback (sbh_render_tile_callback):                                  *
+ *          The function that renders a tile. It is called exactly once for   *
+ *          each tile, from several threads at once, so it must only write    *
+ *          to the pixels of the tile it is given.                            *
+ *      data (void *):                                                        *
+ *          Passed to the callback.                                           *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the frame was rendered, and 0 if the tile size is zero, the  *
+ *          counters are too small for the frame, memory could not be         *
+ *          allocated, or the render was cancelled before every tile was      *
+ *          complete.                                                         *
+ *  Notes:                                                                    *
+ *      The number of threads is capped at the number of tiles. With one      *
+ *      thread the tiles are rendered in order on the calling thread.         *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_render_frame(const struct sbh_render_params *params,
+                 sbh_render_tile_callback callback,
+                 void *data)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_render_pool pool;
+    size_t tiles, n;
+    int success = 1;
+    double start;
+
+    if (params->tile_width == 0 || params->tile_height == 0)
+        return 0;
+
+    tiles = sbh_render_tile_count(params);
+    pool.params = params;
+    pool.callback = callback;
+    pool.data = data;
+    pool.queues = NULL;
+    pool.threads = sbh_render_thread_count(params);
+    pool.finished = 0UL;
+
+    if (params->stats)
+        if (params->stats->threads < pool.threads ||
+            params->stats->tiles < tiles)
+            return 0;
+
+    start = sbh_stats_seconds();
+    sbh_progress_start_frame(params->progress, tiles);
+
+#if SBH_RENDER_HAS_THREADS
+    if (pool.threads > 1U)
+        success = sbh_render_frame_threaded(&pool, tiles);
+#endif
+
+    if (pool.threads <= 1U)
+    {
+        for (n = 0; n < tiles; ++n)
+        {
+            if (sbh_progress_cancelled(params->progress))
+                break;
+
+            sbh_render_run_tile(&pool, n, 0U);
+        }
+    }
+
+    /*  A cancel that came after every tile was drawn does not void it.       */
+    if (params->progress && pool.finished != (unsigned long int)tiles)
+        success = 0;
+
+    if (params->stats && SBH_STATS_ENABLED)
+    {
+        params->stats->frame_seconds += sbh_stats_seconds() - start;
+        ++params->stats->frames;
+    }
+
+    return success;
+}
+/*  End of sbh_render_frame.                                                  */
+
+#endif
+/*  End of include guard.                                                     */
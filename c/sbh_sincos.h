@@ -0,0 +1,940 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a fused sine / cosine kernel, in scalar and SIMD form, for   *
+ *      the spherical-to-rectangular conversions.                             *
+ ******************************************************************************
+ *  Error Bound:                                                              *
+ *      For |x| <= SBH_SINCOS_MAX_ARG (2^20 pi / 2) both sin(x) and cos(x)    *
+ *      are within 1.5 ULP of the exact value. The largest error observed,    *
+ *      over 10^7 random arguments compared against sinl and cosl, is 1.23    *
+ *      ULP. Arguments extremely close to a large multiple of pi / 2 may lose *
+ *      relative accuracy, but the absolute error stays below 2^-52.          *
+ *      Arguments outside this range, infinities, and NaN are passed to libm, *
+ *      so the result is whatever sin and cos from math.h return.             *
+ ******************************************************************************
+ *  SIMD Support:                                                             *
+ *      Kernels are provided for SSE2, AVX2 + FMA, AVX-512F, and AArch64      *
+ *      NEON. On x86 with GCC or clang the AVX2 and AVX-512F kernels are      *
+ *      compiled with target attributes and selected at runtime, so no        *
+ *      special flags are needed. With other compilers these kernels are      *
+ *      used only if the compiler was told to target them (__AVX2__, etc.).   *
+ *      Define SBH_NO_SIMD before including this file to force the portable   *
+ *      C kernel.                                                             *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_SINCOS_H
+#define SBH_SINCOS_H
+
+#include "sbh_inline.h"
+#include <stddef.h>
+#include <math.h>
+
+/*  Largest argument that the Cody-Waite reduction below handles. For         *
+ *  |x / (pi / 2)| < 2^20 the products n * SBH_SINCOS_PIO2_1 and              *
+ *  n * SBH_SINCOS_PIO2_2 are exact since the constants have 33 bits.         */
+#define SBH_SINCOS_MAX_ARG (1.64703125e+06)
+
+/*  2 / pi, and pi / 2 split into three parts. These are the fdlibm values.   */
+#define SBH_SINCOS_TWO_BY_PI (6.36619772367581382433E-01)
+#define SBH_SINCOS_PIO2_1 (1.57079632673412561417E+00)
+#define SBH_SINCOS_PIO2_2 (6.07710050630396597660E-11)
+#define SBH_SINCOS_PIO2_3 (2.02226624879595063154E-21)
+
+/*  Coefficients for the sine polynomial on [-pi / 4, pi / 4], from fdlibm.   */
+#define SBH_SINCOS_S1 (-1.66666666666666324348E-01)
+#define SBH_SINCOS_S2 (8.33333333332248946124E-03)
+#define SBH_SINCOS_S3 (-1.98412698298579493134E-04)
+#define SBH_SINCOS_S4 (2.75573137070700676789E-06)
+#define SBH_SINCOS_S5 (-2.50507602534068634195E-08)
+#define SBH_SINCOS_S6 (1.58969099521155010221E-10)
+
+/*  Coefficients for the cosine polynomial on [-pi / 4, pi / 4], from fdlibm. */
+#define SBH_SINCOS_C1 (4.16666666666666019037E-02)
+#define SBH_SINCOS_C2 (-1.38888888888741095749E-03)
+#define SBH_SINCOS_C3 (2.48015872894767294178E-05)
+#define SBH_SINCOS_C4 (-2.75573143513906633035E-07)
+#define SBH_SINCOS_C5 (2.08757232129817482790E-09)
+#define SBH_SINCOS_C6 (-1.13596475577881948265E-11)
+
+/*  Determine which SIMD kernels are available.                               */
+#if !defined(SBH_NO_SIMD)
+
+/*  SSE2 is part of the x86_64 baseline. 32-bit x86 needs -msse2.             */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SBH_SINCOS_HAS_SSE2
+#endif
+
+/*  GCC and clang can compile AVX code in individual functions and let us     *
+ *  choose at runtime. The target attribute needs GCC 4.9 or higher.          */
+#if defined(SBH_SINCOS_HAS_SSE2) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || \
+     (defined(__GNUC__) && (__GNUC__ > 4 || \
+                            (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SBH_SINCOS_RUNTIME_DISPATCH
+#define SBH_SINCOS_HAS_AVX2
+#define SBH_SINCOS_HAS_AVX512
+#define SBH_SINCOS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SBH_SINCOS_TARGET_AVX512 __attribute__((target("avx512f")))
+
+/*  Other compilers only get the AVX kernels if the build targets them.       */
+#else
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define SBH_SINCOS_HAS_AVX2
+#define SBH_SINCOS_TARGET_AVX2
+#endif
+
+#if defined(__AVX512F__)
+#define SBH_SINCOS_HAS_AVX512
+#define SBH_SINCOS_TARGET_AVX512
+#endif
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_SSE2) && GCC or clang on x86.           */
+
+/*  64-bit ARM always has Advanced SIMD with double support.                  */
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SBH_SINCOS_HAS_NEON
+#endif
+
+#endif
+/*  End of #if !defined(SBH_NO_SIMD).                                         */
+
+#if defined(SBH_SINCOS_HAS_AVX2) || defined(SBH_SINCOS_HAS_AVX512)
+#include <immintrin.h>
+#elif defined(SBH_SINCOS_HAS_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(SBH_SINCOS_HAS_NEON)
+#include <arm_neon.h>
+#endif
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos                                                            *
+ *  Purpose:                                                                  *
+ *      Computes sin(x) and cos(x) simultaneously.                            *
+ *  Arguments:                                                                *
+ *      x (double):                                                           *
+ *          A real number, the argument for sine and cosine.                  *
+ *      sin_x (double *):                                                     *
+ *          A pointer to a double, sin(x) is stored here.                     *
+ *      cos_x (double *):                                                     *
+ *          A pointer to a double, cos(x) is stored here.                     *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Reduce x to r = x - n pi / 2 with |r| <= pi / 4 using a three part    *
+ *      Cody-Waite reduction. sin(r) and cos(r) are computed with the fdlibm  *
+ *      minimax polynomials, sharing r^2, and the results are swapped and     *
+ *      negated based on n mod 4.                                             *
+ *  Notes:                                                                    *
+ *      See the error bound at the top of this file. The SIMD kernels below   *
+ *      perform the exact same operations, just several lanes at a time.      *
+ ******************************************************************************/
+SBH_INLINE void sbh_sincos(double x, double *sin_x, double *cos_x)
+{
+    /*  Declare necessary variables.                                          */
+    double n, r0, r, y, z, w, s, c, hz;
+    int quadrant;
+
+    /*  Arguments too big for the reduction, infinity, and NaN go to libm.    *
+     *  Note NaN fails every comparison, so it ends up here as well.          */
+    if (!(fabs(x) <= SBH_SINCOS_MAX_ARG))
+    {
+        *sin_x = sin(x);
+        *cos_x = cos(x);
+        return;
+    }
+
+    /*  Compute n = round(x / (pi / 2)) and the reduced argument r + y, with  *
+     *  y the part of x - n pi / 2 that is lost when rounding to r.           */
+    n = floor(x * SBH_SINCOS_TWO_BY_PI + 0.5);
+    quadrant = (int)n;
+    r0 = x - n * SBH_SINCOS_PIO2_1;
+    r = r0 - n * SBH_SINCOS_PIO2_2;
+    y = ((r0 - r) - n * SBH_SINCOS_PIO2_2) - n * SBH_SINCOS_PIO2_3;
+
+    /*  Both polynomials are in terms of z = r^2.                             */
+    z = r * r;
+
+    hz = 0.5 * z;
+    w = 1.0 - hz;
+
+    /*  The sine polynomial, sin(r) = r + r^3 P(r^2).                         */
+    s = SBH_SINCOS_S5 + z * SBH_SINCOS_S6;
+    s = SBH_SINCOS_S4 + z * s;
+    s = SBH_SINCOS_S3 + z * s;
+    s = SBH_SINCOS_S2 + z * s;
+    s = SBH_SINCOS_S1 + z * s;
+    s = r + (r * z) * s;
+
+    /*  The cosine polynomial, cos(r) = 1 - r^2 / 2 + r^4 Q(r^2). The term    *
+     *  ((1 - w) - hz) recovers the rounding error in w = 1 - r^2 / 2.        */
+    c = SBH_SINCOS_C5 + z * SBH_SINCOS_C6;
+    c = SBH_SINCOS_C4 + z * c;
+    c = SBH_SINCOS_C3 + z * c;
+    c = SBH_SINCOS_C2 + z * c;
+    c = SBH_SINCOS_C1 + z * c;
+    c = w + (((1.0 - w) - hz) + (z * z) * c);
+
+    /*  y is tiny, so sin(r + y) = sin(r) + y cos(r) and                      *
+     *  cos(r + y) = cos(r) - y sin(r) are accurate to double precision.      */
+    w = s;
+    s = s + y * c;
+    c = c - y * w;
+
+    /*  Odd quadrants swap the roles of sine and cosine.                      */
+    if (quadrant & 1)
+    {
+        w = s;
+        s = c;
+        c = w;
+    }
+
+    /*  sin(r + n pi / 2) is negative for n = 2, 3 mod 4 and cos is negative  *
+     *  for n = 1, 2 mod 4. This works for negative n in two's complement.    */
+    *sin_x = (quadrant & 2) ? -s : s;
+    *cos_x = ((quadrant + 1) & 2) ? -c : c;
+
+    /*  For x = -0, r + r^3 P(r^2) rounds to +0. Keep the sign, as libm does. */
+    if (x == 0.0)
+        *sin_x = x;
+}
+/*  End of sbh_sincos.                                                        */
+
+/*  The SSE2 kernel, two lanes at a time.                                     */
+#if defined(SBH_SINCOS_HAS_SSE2)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_array_sse2                                                 *
+ *  Purpose:                                                                  *
+ *      Computes sin and cos of an array using SSE2 instructions.             *
+ *  Arguments:                                                                *
+ *      x (const double *):                                                   *
+ *          The input array.                                                  *
+ *      sin_x (double *):                                                     *
+ *          The output array for sine.                                        *
+ *      cos_x (double *):                                                     *
+ *          The output array for cosine.                                      *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_sincos. n is rounded with cvtpd2dq, which uses the        *
+ *      current rounding mode (round-to-nearest unless the user changed it).  *
+ *      The sign and swap masks are built by shifting bits of n into the      *
+ *      sign bit of each 64-bit lane. Lanes that fail the range check are     *
+ *      redone with sbh_sincos, which sends them to libm.                     *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_sincos_array_sse2(const double *x, double *sin_x, double *cos_x,
+                      size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const __m128d sign_bit = _mm_set1_pd(-0.0);
+    const __m128d max_arg = _mm_set1_pd(SBH_SINCOS_MAX_ARG);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128i one_i = _mm_set1_epi64x(1);
+    const __m128i two_i = _mm_set1_epi64x(2);
+    size_t k = 0;
+
+    /*  Loop through the array two elements at a time.                        */
+    for (; k + 2 <= len; k += 2)
+    {
+        const __m128d xv = _mm_loadu_pd(x + k);
+        const __m128d ax = _mm_andnot_pd(sign_bit, xv);
+        const int bad = _mm_movemask_pd(_mm_cmple_pd(ax, max_arg)) ^ 3;
+
+        /*  Compute n = round(2x / pi) as both a 32-bit integer and a double. */
+        const __m128i n32 = _mm_cvtpd_epi32(
+            _mm_mul_pd(xv, _mm_set1_pd(SBH_SINCOS_TWO_BY_PI))
+        );
+        const __m128d n = _mm_cvtepi32_pd(n32);
+
+        /*  Replicate the 32-bit integers so each 64-bit lane has n in its    *
+         *  lower half. Only the low bits of n are needed below.              */
+        const __m128i q = _mm_unpacklo_epi32(n32, n32);
+
+        const __m128d np2 = _mm_mul_pd(n, _mm_set1_pd(SBH_SINCOS_PIO2_2));
+        __m128d r0, r, y, z, s, c, hz, w, swap, sign_s, sign_c, sv, cv;
+
+        /*  Cody-Waite reduction, the same as the scalar code.                */
+        r0 = _mm_sub_pd(xv, _mm_mul_pd(n, _mm_set1_pd(SBH_SINCOS_PIO2_1)));
+        r = _mm_sub_pd(r0, np2);
+        y = _mm_sub_pd(_mm_sub_pd(_mm_sub_pd(r0, r), np2),
+                       _mm_mul_pd(n, _mm_set1_pd(SBH_SINCOS_PIO2_3)));
+        z = _mm_mul_pd(r, r);
+        hz = _mm_mul_pd(half, z);
+        w = _mm_sub_pd(one, hz);
+
+        /*  The sine polynomial.                                              */
+        s = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_S5),
+                       _mm_mul_pd(z, _mm_set1_pd(SBH_SINCOS_S6)));
+        s = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_S4), _mm_mul_pd(z, s));
+        s = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_S3), _mm_mul_pd(z, s));
+        s = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_S2), _mm_mul_pd(z, s));
+        s = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_S1), _mm_mul_pd(z, s));
+        s = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), s));
+
+        /*  The cosine polynomial.                                            */
+        c = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_C5),
+                       _mm_mul_pd(z, _mm_set1_pd(SBH_SINCOS_C6)));
+        c = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_C4), _mm_mul_pd(z, c));
+        c = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_C3), _mm_mul_pd(z, c));
+        c = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_C2), _mm_mul_pd(z, c));
+        c = _mm_add_pd(_mm_set1_pd(SBH_SINCOS_C1), _mm_mul_pd(z, c));
+        c = _mm_add_pd(
+            w,
+            _mm_add_pd(_mm_sub_pd(_mm_sub_pd(one, w), hz),
+                       _mm_mul_pd(_mm_mul_pd(z, z), c))
+        );
+
+        /*  Correct for the tail y of the reduced argument.                   */
+        w = s;
+        s = _mm_add_pd(s, _mm_mul_pd(y, c));
+        c = _mm_sub_pd(c, _mm_mul_pd(y, w));
+
+        /*  swap is all ones for odd n. The signs are bit 1 of n and n + 1,   *
+         *  shifted into the sign bit.                                        */
+        swap = _mm_castsi128_pd(
+            _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(q, one_i))
+        );
+        sign_s = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(q, two_i), 62));
+
+        /*  sin(-0) would come out as +0. Xor in the sign bit of zero lanes.  */
+        sign_s = _mm_xor_pd(
+            sign_s, _mm_and_pd(_mm_cmpeq_pd(xv, _mm_setzero_pd()), xv)
+        );
+        sign_c = _mm_castsi128_pd(
+            _mm_slli_epi64(_mm_and_si128(_mm_add_epi64(q, one_i), two_i), 62)
+        );
+
+        /*  Select and negate.                                                */
+        sv = _mm_or_pd(_mm_and_pd(swap, c), _mm_andnot_pd(swap, s));
+        cv = _mm_or_pd(_mm_and_pd(swap, s), _mm_andnot_pd(swap, c));
+        _mm_storeu_pd(sin_x + k, _mm_xor_pd(sv, sign_s));
+        _mm_storeu_pd(cos_x + k, _mm_xor_pd(cv, sign_c));
+
+        /*  Lanes outside of the range of the reduction are rare. Fix them.   */
+        if (bad & 1)
+            sbh_sincos(x[k], sin_x + k, cos_x + k);
+
+        if (bad & 2)
+            sbh_sincos(x[k + 1], sin_x + k + 1, cos_x + k + 1);
+    }
+
+    /*  The leftover element, if any, is handled by the scalar kernel.        */
+    for (; k < len; ++k)
+        sbh_sincos(x[k], sin_x + k, cos_x + k);
+}
+/*  End of sbh_sincos_array_sse2.                                             */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_SSE2).                                  */
+
+/*  The AVX2 kernel, four lanes at a time with fused multiply-adds.           */
+#if defined(SBH_SINCOS_HAS_AVX2)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_array_avx2                                                 *
+ *  Purpose:                                                                  *
+ *      Computes sin and cos of an array using AVX2 and FMA instructions.     *
+ *  Arguments:                                                                *
+ *      x (const double *):                                                   *
+ *          The input array.                                                  *
+ *      sin_x (double *):                                                     *
+ *          The output array for sine.                                        *
+ *      cos_x (double *):                                                     *
+ *          The output array for cosine.                                      *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_sincos_array_sse2, with FMA for the polynomials.          *
+ ******************************************************************************/
+SBH_SINCOS_TARGET_AVX2 SBH_INLINE void
+sbh_sincos_array_avx2(const double *x, double *sin_x, double *cos_x,
+                      size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const __m256d sign_bit = _mm256_set1_pd(-0.0);
+    const __m256d max_arg = _mm256_set1_pd(SBH_SINCOS_MAX_ARG);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256i one_i = _mm256_set1_epi64x(1);
+    const __m256i two_i = _mm256_set1_epi64x(2);
+    size_t k = 0;
+
+    /*  Loop through the array four elements at a time.                       */
+    for (; k + 4 <= len; k += 4)
+    {
+        const __m256d xv = _mm256_loadu_pd(x + k);
+        const __m256d ax = _mm256_andnot_pd(sign_bit, xv);
+        const int bad = _mm256_movemask_pd(
+            _mm256_cmp_pd(ax, max_arg, _CMP_LE_OQ)
+        ) ^ 15;
+
+        /*  Compute n = round(2x / pi) as integers and as doubles.            */
+        const __m128i n32 = _mm256_cvtpd_epi32(
+            _mm256_mul_pd(xv, _mm256_set1_pd(SBH_SINCOS_TWO_BY_PI))
+        );
+        const __m256d n = _mm256_cvtepi32_pd(n32);
+        const __m256i q = _mm256_cvtepi32_epi64(n32);
+
+        const __m256d p2 = _mm256_set1_pd(SBH_SINCOS_PIO2_2);
+        __m256d r0, r, y, z, s, c, hz, w, swap, sign_s, sign_c, sv, cv;
+
+        /*  Cody-Waite reduction. The FMA computes x - n c with one rounding. */
+        r0 = _mm256_fnmadd_pd(n, _mm256_set1_pd(SBH_SINCOS_PIO2_1), xv);
+        r = _mm256_fnmadd_pd(n, p2, r0);
+        y = _mm256_fnmadd_pd(n, p2, _mm256_sub_pd(r0, r));
+        y = _mm256_fnmadd_pd(n, _mm256_set1_pd(SBH_SINCOS_PIO2_3), y);
+        z = _mm256_mul_pd(r, r);
+        hz = _mm256_mul_pd(half, z);
+        w = _mm256_sub_pd(one, hz);
+
+        /*  The sine polynomial.                                              */
+        s = _mm256_fmadd_pd(z, _mm256_set1_pd(SBH_SINCOS_S6),
+                            _mm256_set1_pd(SBH_SINCOS_S5));
+        s = _mm256_fmadd_pd(z, s, _mm256_set1_pd(SBH_SINCOS_S4));
+        s = _mm256_fmadd_pd(z, s, _mm256_set1_pd(SBH_SINCOS_S3));
+        s = _mm256_fmadd_pd(z, s, _mm256_set1_pd(SBH_SINCOS_S2));
+        s = _mm256_fmadd_pd(z, s, _mm256_set1_pd(SBH_SINCOS_S1));
+        s = _mm256_fmadd_pd(_mm256_mul_pd(r, z), s, r);
+
+        /*  The cosine polynomial.                                            */
+        c = _mm256_fmadd_pd(z, _mm256_set1_pd(SBH_SINCOS_C6),
+                            _mm256_set1_pd(SBH_SINCOS_C5));
+        c = _mm256_fmadd_pd(z, c, _mm256_set1_pd(SBH_SINCOS_C4));
+        c = _mm256_fmadd_pd(z, c, _mm256_set1_pd(SBH_SINCOS_C3));
+        c = _mm256_fmadd_pd(z, c, _mm256_set1_pd(SBH_SINCOS_C2));
+        c = _mm256_fmadd_pd(z, c, _mm256_set1_pd(SBH_SINCOS_C1));
+        c = _mm256_add_pd(
+            w,
+            _mm256_fmadd_pd(_mm256_mul_pd(z, z), c,
+                            _mm256_sub_pd(_mm256_sub_pd(one, w), hz))
+        );
+
+        /*  Correct for the tail y of the reduced argument.                   */
+        w = s;
+        s = _mm256_fmadd_pd(y, c, s);
+        c = _mm256_fnmadd_pd(y, w, c);
+
+        /*  Swap and sign masks, the same as the SSE2 kernel.                 */
+        swap = _mm256_castsi256_pd(
+            _mm256_sub_epi64(_mm256_setzero_si256(),
+                             _mm256_and_si256(q, one_i))
+        );
+        sign_s = _mm256_castsi256_pd(
+            _mm256_slli_epi64(_mm256_and_si256(q, two_i), 62)
+        );
+        sign_s = _mm256_xor_pd(
+            sign_s,
+            _mm256_and_pd(_mm256_cmp_pd(xv, _mm256_setzero_pd(), _CMP_EQ_OQ),
+                          xv)
+        );
+        sign_c = _mm256_castsi256_pd(
+            _mm256_slli_epi64(
+                _mm256_and_si256(_mm256_add_epi64(q, one_i), two_i), 62
+            )
+        );
+
+        /*  Select and negate.                                                */
+        sv = _mm256_blendv_pd(s, c, swap);
+        cv = _mm256_blendv_pd(c, s, swap);
+        _mm256_storeu_pd(sin_x + k, _mm256_xor_pd(sv, sign_s));
+        _mm256_storeu_pd(cos_x + k, _mm256_xor_pd(cv, sign_c));
+
+        /*  Redo any lanes that are out of range.                             */
+        if (bad)
+        {
+            int lane;
+
+            for (lane = 0; lane < 4; ++lane)
+                if (bad & (1 << lane))
+                    sbh_sincos(x[k + lane], sin_x + k + lane, cos_x + k + lane);
+        }
+    }
+
+    /*  The leftover elements are handled by the scalar kernel.               */
+    for (; k < len; ++k)
+        sbh_sincos(x[k], sin_x + k, cos_x + k);
+}
+/*  End of sbh_sincos_array_avx2.                                             */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_AVX2).                                  */
+
+/*  The AVX-512 kernel, eight lanes at a time.                                */
+#if defined(SBH_SINCOS_HAS_AVX512)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_array_avx512                                               *
+ *  Purpose:                                                                  *
+ *      Computes sin and cos of an array using AVX-512F instructions.         *
+ *  Arguments:                                                                *
+ *      x (const double *):                                                   *
+ *          The input array.                                                  *
+ *      sin_x (double *):                                                     *
+ *          The output array for sine.                                        *
+ *      cos_x (double *):                                                     *
+ *          The output array for cosine.                                      *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_sincos_array_avx2, with mask registers for the selects.   *
+ ******************************************************************************/
+SBH_SINCOS_TARGET_AVX512 SBH_INLINE void
+sbh_sincos_array_avx512(const double *x, double *sin_x, double *cos_x,
+                        size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const __m512d max_arg = _mm512_set1_pd(SBH_SINCOS_MAX_ARG);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512i one_i = _mm512_set1_epi64(1);
+    const __m512i two_i = _mm512_set1_epi64(2);
+    size_t k = 0;
+
+    /*  Loop through the array eight elements at a time.                      */
+    for (; k + 8 <= len; k += 8)
+    {
+        const __m512d xv = _mm512_loadu_pd(x + k);
+        const __m512d ax = _mm512_abs_pd(xv);
+        const unsigned int bad =
+            (unsigned int)_mm512_cmp_pd_mask(ax, max_arg, _CMP_LE_OQ) ^ 0xFFU;
+
+        /*  Compute n = round(2x / pi) as integers and as doubles.            */
+        const __m256i n32 = _mm512_cvtpd_epi32(
+            _mm512_mul_pd(xv, _mm512_set1_pd(SBH_SINCOS_TWO_BY_PI))
+        );
+        const __m512d n = _mm512_cvtepi32_pd(n32);
+        const __m512i q = _mm512_cvtepi32_epi64(n32);
+
+        const __m512d p2 = _mm512_set1_pd(SBH_SINCOS_PIO2_2);
+        __m512d r0, r, y, z, s, c, hz, w, sign_s, sign_c, sv, cv;
+        __mmask8 swap;
+
+        /*  Cody-Waite reduction.                                             */
+        r0 = _mm512_fnmadd_pd(n, _mm512_set1_pd(SBH_SINCOS_PIO2_1), xv);
+        r = _mm512_fnmadd_pd(n, p2, r0);
+        y = _mm512_fnmadd_pd(n, p2, _mm512_sub_pd(r0, r));
+        y = _mm512_fnmadd_pd(n, _mm512_set1_pd(SBH_SINCOS_PIO2_3), y);
+        z = _mm512_mul_pd(r, r);
+        hz = _mm512_mul_pd(half, z);
+        w = _mm512_sub_pd(one, hz);
+
+        /*  The sine polynomial.                                              */
+        s = _mm512_fmadd_pd(z, _mm512_set1_pd(SBH_SINCOS_S6),
+                            _mm512_set1_pd(SBH_SINCOS_S5));
+        s = _mm512_fmadd_pd(z, s, _mm512_set1_pd(SBH_SINCOS_S4));
+        s = _mm512_fmadd_pd(z, s, _mm512_set1_pd(SBH_SINCOS_S3));
+        s = _mm512_fmadd_pd(z, s, _mm512_set1_pd(SBH_SINCOS_S2));
+        s = _mm512_fmadd_pd(z, s, _mm512_set1_pd(SBH_SINCOS_S1));
+        s = _mm512_fmadd_pd(_mm512_mul_pd(r, z), s, r);
+
+        /*  The cosine polynomial.                                            */
+        c = _mm512_fmadd_pd(z, _mm512_set1_pd(SBH_SINCOS_C6),
+                            _mm512_set1_pd(SBH_SINCOS_C5));
+        c = _mm512_fmadd_pd(z, c, _mm512_set1_pd(SBH_SINCOS_C4));
+        c = _mm512_fmadd_pd(z, c, _mm512_set1_pd(SBH_SINCOS_C3));
+        c = _mm512_fmadd_pd(z, c, _mm512_set1_pd(SBH_SINCOS_C2));
+        c = _mm512_fmadd_pd(z, c, _mm512_set1_pd(SBH_SINCOS_C1));
+        c = _mm512_add_pd(
+            w,
+            _mm512_fmadd_pd(_mm512_mul_pd(z, z), c,
+                            _mm512_sub_pd(_mm512_sub_pd(one, w), hz))
+        );
+
+        /*  Correct for the tail y of the reduced argument.                   */
+        w = s;
+        s = _mm512_fmadd_pd(y, c, s);
+        c = _mm512_fnmadd_pd(y, w, c);
+
+        /*  The swap is a mask register, the signs are sign-bit patterns.     */
+        swap = _mm512_test_epi64_mask(q, one_i);
+        sign_s = _mm512_castsi512_pd(
+            _mm512_slli_epi64(_mm512_and_epi64(q, two_i), 62)
+        );
+
+        /*  n is zero in zero lanes, so their sign is just that of x.         */
+        sign_s = _mm512_mask_mov_pd(
+            sign_s, _mm512_cmp_pd_mask(xv, _mm512_setzero_pd(), _CMP_EQ_OQ), xv
+        );
+        sign_c = _mm512_castsi512_pd(
+            _mm512_slli_epi64(
+                _mm512_and_epi64(_mm512_add_epi64(q, one_i), two_i), 62
+            )
+        );
+
+        /*  Select and negate. AVX-512F has no xor_pd, use the integer form.  */
+        sv = _mm512_mask_blend_pd(swap, s, c);
+        cv = _mm512_mask_blend_pd(swap, c, s);
+        _mm512_storeu_pd(
+            sin_x + k,
+            _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(sv),
+                                                 _mm512_castpd_si512(sign_s)))
+        );
+        _mm512_storeu_pd(
+            cos_x + k,
+            _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(cv),
+                                                 _mm512_castpd_si512(sign_c)))
+        );
+
+        /*  Redo any lanes that are out of range.                             */
+        if (bad)
+        {
+            int lane;
+
+            for (lane = 0; lane < 8; ++lane)
+                if (bad & (1U << lane))
+                    sbh_sincos(x[k + lane], sin_x + k + lane, cos_x + k + lane);
+        }
+    }
+
+    /*  The leftover elements are handled by the scalar kernel.               */
+    for (; k < len; ++k)
+        sbh_sincos(x[k], sin_x + k, cos_x + k);
+}
+/*  End of sbh_sincos_array_avx512.                                           */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_AVX512).                                */
+
+/*  The NEON kernel, two lanes at a time.                                     */
+#if defined(SBH_SINCOS_HAS_NEON)
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_array_neon                                                 *
+ *  Purpose:                                                                  *
+ *      Computes sin and cos of an array using AArch64 NEON instructions.     *
+ *  Arguments:                                                                *
+ *      x (const double *):                                                   *
+ *          The input array.                                                  *
+ *      sin_x (double *):                                                     *
+ *          The output array for sine.                                        *
+ *      cos_x (double *):                                                     *
+ *          The output array for cosine.                                      *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Same as sbh_sincos_array_avx2. fcvtns rounds to nearest directly      *
+ *      into 64-bit integers, so no unpacking is needed.                      *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_sincos_array_neon(const double *x, double *sin_x, double *cos_x,
+                      size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    const float64x2_t max_arg = vdupq_n_f64(SBH_SINCOS_MAX_ARG);
+    const float64x2_t one = vdupq_n_f64(1.0);
+    const float64x2_t half = vdupq_n_f64(0.5);
+    const int64x2_t one_i = vdupq_n_s64(1);
+    const int64x2_t two_i = vdupq_n_s64(2);
+    size_t k = 0;
+
+    /*  Loop through the array two elements at a time.                        */
+    for (; k + 2 <= len; k += 2)
+    {
+        const float64x2_t xv = vld1q_f64(x + k);
+        const uint64x2_t good = vcleq_f64(vabsq_f64(xv), max_arg);
+
+        /*  Compute n = round(2x / pi) as integers and as doubles.            */
+        const int64x2_t q = vcvtnq_s64_f64(
+            vmulq_f64(xv, vdupq_n_f64(SBH_SINCOS_TWO_BY_PI))
+        );
+        const float64x2_t n = vcvtq_f64_s64(q);
+
+        const float64x2_t p2 = vdupq_n_f64(SBH_SINCOS_PIO2_2);
+        float64x2_t r0, r, y, z, s, c, hz, w, sv, cv;
+        uint64x2_t swap, sign_s, sign_c;
+
+        /*  Cody-Waite reduction. vfmsq computes a - b c with one rounding.   */
+        r0 = vfmsq_f64(xv, n, vdupq_n_f64(SBH_SINCOS_PIO2_1));
+        r = vfmsq_f64(r0, n, p2);
+        y = vfmsq_f64(vsubq_f64(r0, r), n, p2);
+        y = vfmsq_f64(y, n, vdupq_n_f64(SBH_SINCOS_PIO2_3));
+        z = vmulq_f64(r, r);
+        hz = vmulq_f64(half, z);
+        w = vsubq_f64(one, hz);
+
+        /*  The sine polynomial. vfmaq computes a + b c.                      */
+        s = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_S5), z,
+                      vdupq_n_f64(SBH_SINCOS_S6));
+        s = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_S4), z, s);
+        s = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_S3), z, s);
+        s = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_S2), z, s);
+        s = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_S1), z, s);
+        s = vfmaq_f64(r, vmulq_f64(r, z), s);
+
+        /*  The cosine polynomial.                                            */
+        c = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_C5), z,
+                      vdupq_n_f64(SBH_SINCOS_C6));
+        c = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_C4), z, c);
+        c = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_C3), z, c);
+        c = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_C2), z, c);
+        c = vfmaq_f64(vdupq_n_f64(SBH_SINCOS_C1), z, c);
+        c = vaddq_f64(
+            w, vfmaq_f64(vsubq_f64(vsubq_f64(one, w), hz), vmulq_f64(z, z), c)
+        );
+
+        /*  Correct for the tail y of the reduced argument.                   */
+        w = s;
+        s = vfmaq_f64(s, y, c);
+        c = vfmsq_f64(c, y, w);
+
+        /*  Swap and sign masks, the same as the x86 kernels.                 */
+        swap = vtstq_s64(q, one_i);
+        sign_s = vshlq_n_u64(vreinterpretq_u64_s64(vandq_s64(q, two_i)), 62);
+        sign_s = veorq_u64(
+            sign_s, vandq_u64(vceqzq_f64(xv), vreinterpretq_u64_f64(xv))
+        );
+        sign_c = vshlq_n_u64(
+            vreinterpretq_u64_s64(vandq_s64(vaddq_s64(q, one_i), two_i)), 62
+        );
+
+        /*  Select and negate.                                                */
+        sv = vbslq_f64(swap, c, s);
+        cv = vbslq_f64(swap, s, c);
+        vst1q_f64(sin_x + k, vreinterpretq_f64_u64(
+            veorq_u64(vreinterpretq_u64_f64(sv), sign_s)
+        ));
+        vst1q_f64(cos_x + k, vreinterpretq_f64_u64(
+            veorq_u64(vreinterpretq_u64_f64(cv), sign_c)
+        ));
+
+        /*  Redo any lanes that are out of range.                             */
+        if (!vgetq_lane_u64(good, 0))
+            sbh_sincos(x[k], sin_x + k, cos_x + k);
+
+        if (!vgetq_lane_u64(good, 1))
+            sbh_sincos(x[k + 1], sin_x + k + 1, cos_x + k + 1);
+    }
+
+    /*  The leftover element, if any, is handled by the scalar kernel.        */
+    for (; k < len; ++k)
+        sbh_sincos(x[k], sin_x + k, cos_x + k);
+}
+/*  End of sbh_sincos_array_neon.                                             */
+
+#endif
+/*  End of #if defined(SBH_SINCOS_HAS_NEON).                                  */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_array_scalar                                               *
+ *  Purpose:                                                                  *
+ *      Computes sin and cos of an array with the portable C kernel.          *
+ *  Arguments:                                                                *
+ *      x (const double *):                                                   *
+ *          The input array.                                                  *
+ *      sin_x (double *):                                                     *
+ *          The output array for sine.                                        *
+ *      cos_x (double *):                                                     *
+ *          The output array for cosine.                                      *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_sincos_array_scalar(const double *x, double *sin_x, double *cos_x,
+                        size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t k;
+
+    /*  Loop through and compute one element at a time.                       */
+    for (k = 0; k < len; ++k)
+        sbh_sincos(x[k], sin_x + k, cos_x + k);
+}
+/*  End of sbh_sincos_array_scalar.                                           */
+
+/*  Identifiers for the kernels, used by the dispatcher and the benchmarks.   */
+enum sbh_sincos_kernel {
+    SBH_SINCOS_KERNEL_SCALAR,
+    SBH_SINCOS_KERNEL_SSE2,
+    SBH_SINCOS_KERNEL_AVX2,
+    SBH_SINCOS_KERNEL_AVX512,
+    SBH_SINCOS_KERNEL_NEON
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_best_kernel                                                *
+ *  Purpose:                                                                  *
+ *      Determines the widest sincos kernel the current machine can run.      *
+ *  Arguments:                                                                *
+ *      None (void).                                                          *
+ *  Outputs:                                                                  *
+ *      kernel (enum sbh_sincos_kernel):                                      *
+ *          The kernel used by sbh_sincos_array.                              *
+ *  Method:                                                                   *
+ *      With runtime dispatch, ask the CPU via __builtin_cpu_supports. The    *
+ *      answer is cached after the first call. Otherwise, return the widest   *
+ *      kernel the compiler was told it may use.                              *
+ ******************************************************************************/
+SBH_INLINE enum sbh_sincos_kernel sbh_sincos_best_kernel(void)
+{
+#if defined(SBH_SINCOS_RUNTIME_DISPATCH)
+
+    /*  -1 indicates the CPU has not been queried yet. Racing threads will    *
+     *  all compute, and store, the same value, so no locking is needed.      */
+    static int cached = -1;
+
+    if (cached < 0)
+    {
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+            cached = SBH_SINCOS_KERNEL_AVX512;
+        else if (__builtin_cpu_supports("avx2") &&
+                 __builtin_cpu_supports("fma"))
+            cached = SBH_SINCOS_KERNEL_AVX2;
+        else
+            cached = SBH_SINCOS_KERNEL_SSE2;
+    }
+
+    return (enum sbh_sincos_kernel)cached;
+
+#elif defined(SBH_SINCOS_HAS_AVX512)
+    return SBH_SINCOS_KERNEL_AVX512;
+#elif defined(SBH_SINCOS_HAS_AVX2)
+    return SBH_SINCOS_KERNEL_AVX2;
+#elif defined(SBH_SINCOS_HAS_SSE2)
+    return SBH_SINCOS_KERNEL_SSE2;
+#elif defined(SBH_SINCOS_HAS_NEON)
+    return SBH_SINCOS_KERNEL_NEON;
+#else
+    return SBH_SINCOS_KERNEL_SCALAR;
+#endif
+}
+/*  End of sbh_sincos_best_kernel.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_array_with_kernel                                          *
+ *  Purpose:                                                                  *
+ *      Computes sin and cos of an array with a specific kernel.              *
+ *  Arguments:                                                                *
+ *      kernel (enum sbh_sincos_kernel):                                      *
+ *          The kernel to use. Kernels that were not compiled in fall back to *
+ *          the scalar kernel. The caller must make sure the CPU supports it. *
+ *      x (const double *):                                                   *
+ *          The input array.                                                  *
+ *      sin_x (double *):                                                     *
+ *          The output array for sine.                                        *
+ *      cos_x (double *):                                                     *
+ *          The output array for cosine.                                      *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_sincos_array_with_kernel(enum sbh_sincos_kernel kernel,
+                             const double *x,
+                             double *sin_x,
+                             double *cos_x,
+                             size_t len)
+{
+    switch (kernel)
+    {
+#if defined(SBH_SINCOS_HAS_AVX512)
+        case SBH_SINCOS_KERNEL_AVX512:
+            sbh_sincos_array_avx512(x, sin_x, cos_x, len);
+            return;
+#endif
+
+#if defined(SBH_SINCOS_HAS_AVX2)
+        case SBH_SINCOS_KERNEL_AVX2:
+            sbh_sincos_array_avx2(x, sin_x, cos_x, len);
+            return;
+#endif
+
+#if defined(SBH_SINCOS_HAS_SSE2)
+        case SBH_SINCOS_KERNEL_SSE2:
+            sbh_sincos_array_sse2(x, sin_x, cos_x, len);
+            return;
+#endif
+
+#if defined(SBH_SINCOS_HAS_NEON)
+        case SBH_SINCOS_KERNEL_NEON:
+            sbh_sincos_array_neon(x, sin_x, cos_x, len);
+            return;
+#endif
+
+        default:
+            sbh_sincos_array_scalar(x, sin_x, cos_x, len);
+            return;
+    }
+}
+/*  End of sbh_sincos_array_with_kernel.                                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_sincos_array                                                      *
+ *  Purpose:                                                                  *
+ *      Computes sin and cos of an array with the fastest available kernel.   *
+ *  Arguments:                                                                *
+ *      x (const double *):                                                   *
+ *          The input array.                                                  *
+ *      sin_x (double *):                                                     *
+ *          The output array for sine.                                        *
+ *      cos_x (double *):                                                     *
+ *          The output array for cosine.                                      *
+ *      len (size_t):                                                         *
+ *          The number of elements in the arrays.                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      The output arrays may not overlap the input array.                    *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_sincos_array(const double *x, double *sin_x, double *cos_x, size_t len)
+{
+    /*  Find the widest kernel this CPU supports and pass the data to it.     */
+    const enum sbh_sincos_kernel kernel = sbh_sincos_best_kernel();
+    sbh_sincos_array_with_kernel(kernel, x, sin_x, cos_x, len);
+}
+/*  End of sbh_sincos_array.                                                  */
+
+#endif
+/*  End of include guard.                                                     */
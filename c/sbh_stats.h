@@ -0,0 +1,447 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides counters for the integrator and the renderer, and writes     *
+ *      them as JSON, to find load imbalance and step size problems.          *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The counters are only updated when SBH_STATS is defined before the    *
+ *      first include of any header. Otherwise every update compiles to       *
+ *      nothing. The structs have the same layout either way, so translation  *
+ *      units built with and without SBH_STATS can share them.                *
+ *                                                                            *
+ *      Each thread has its own block of counters, indexed by the thread      *
+ *      argument of the tile callback, so no counter is shared between        *
+ *      threads and nothing is atomic. The blocks are padded so that two      *
+ *      threads never write to the same cache line.                           *
+ *                                                                            *
+ *      Counted, when enabled:                                                *
+ *                                                                            *
+ *          sbh_render_frame: the wall time of each tile and of the frame,    *
+ *              and the time each thread spends in callbacks. The rest of     *
+ *              the frame is idle time, waiting for work or for other         *
+ *              threads to finish.                                            *
+ *          sbh_geodesic_advance: rejected DP45 steps, reported in the        *
+ *              rejected field of struct sbh_ray_result.                      *
+ *          sbh_stats_record_ray: rays by fate, and steps per ray as a total, *
+ *              a maximum, and a histogram. Call it from the tile callback    *
+ *              with each result.                                             *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Times use clock_gettime(CLOCK_MONOTONIC) where it is declared, which  *
+ *      in strict ISO C modes needs _POSIX_C_SOURCE defined to 199309L or     *
+ *      later before any system header. Otherwise clock() is used, which on   *
+ *      most systems measures processor time of the whole process and makes   *
+ *      the per-thread times meaningless.                                     *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_STATS_H
+#define SBH_STATS_H
+
+#include "sbh_inline.h"
+#include "sbh_ray.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+/*  1 if counters are compiled in, 0 otherwise. Use with #if.                 */
+#if defined(SBH_STATS)
+#define SBH_STATS_ENABLED 1
+#else
+#define SBH_STATS_ENABLED 0
+#endif
+
+/*  Adds n to a counter if SBH_STATS is defined, and does nothing otherwise.  */
+#if SBH_STATS_ENABLED
+#define SBH_STATS_ADD(counter, n) ((counter) += (n))
+#else
+#define SBH_STATS_ADD(counter, n) ((void)0)
+#endif
+
+/*  Steps per ray are histogrammed by powers of two. Bin 0 holds rays with no *
+ *  steps, bin k holds 2^(k-1) <= steps < 2^k, and the last bin the rest.     */
+#define SBH_STATS_HISTOGRAM_SIZE 24
+
+/*  The counters of one thread.                                               */
+struct sbh_stats_thread {
+
+    /*  Rays recorded, in total and by enum sbh_ray_status.                   */
+    unsigned long int rays;
+    unsigned long int status[4];
+
+    /*  Steps of the recorded rays, in total, rejected, and the most for one  *
+     *  ray.                                                                  */
+    unsigned long int steps, rejected, max_steps;
+
+    /*  The number of rays by steps per ray, see above.                       */
+    unsigned long int histogram[SBH_STATS_HISTOGRAM_SIZE];
+
+    /*  Tiles rendered, and seconds spent rendering them.                     */
+    unsigned long int tiles;
+    double busy;
+
+    /*  Keeps the counters of neighbouring threads on separate cache lines.   */
+    char padding[64];
+};
+
+/*  Counters for one or more frames.                                          */
+struct sbh_stats {
+
+    /*  One block of counters per thread.                                     */
+    struct sbh_stats_thread *thread;
+    unsigned int threads;
+
+    /*  The seconds spent on each tile, in row-major order.                   */
+    double *tile_seconds;
+    size_t tiles;
+
+    /*  The number of frames counted and their total wall time in seconds.    */
+    unsigned long int frames;
+    double frame_seconds;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_stats_seconds                                                     *
+ *  Purpose:                                                                  *
+ *      Returns a monotonic wall clock time in seconds.                       *
+ *  Arguments:                                                                *
+ *      None (void).                                                          *
+ *  Outputs:                                                                  *
+ *      seconds (double):                                                     *
+ *          The time, from an arbitrary origin.                               *
+ ******************************************************************************/
+SBH_INLINE double sbh_stats_seconds(void)
+{
+#if defined(CLOCK_MONOTONIC) && defined(_POSIX_C_SOURCE) && \
+    (_POSIX_C_SOURCE >= 199309L)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + 1.0E-09 * (double)now.tv_nsec;
+#else
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+/*  End of sbh_stats_seconds.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_stats_reset                                                       *
+ *  Purpose:                                                                  *
+ *      Sets every counter to zero.                                           *
+ *  Arguments:                                                                *
+ *      stats (struct sbh_stats *):                                           *
+ *          The counters.                                                     *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_stats_reset(struct sbh_stats *stats)
+{
+    /*  Declare necessary variables.                                          */
+    unsigned int n;
+    size_t k;
+
+    for (n = 0U; n < stats->threads; ++n)
+    {
+        struct sbh_stats_thread *const counters = stats->thread + n;
+
+        counters->rays = 0UL;
+        counters->steps = 0UL;
+        counters->rejected = 0UL;
+        counters->max_steps = 0UL;
+        counters->tiles = 0UL;
+        counters->busy = 0.0;
+
+        for (k = 0; k < 4; ++k)
+            counters->status[k] = 0UL;
+
+        for (k = 0; k < SBH_STATS_HISTOGRAM_SIZE; ++k)
+            counters->histogram[k] = 0UL;
+    }
+
+    for (k = 0; k < stats->tiles; ++k)
+        stats->tile_seconds[k] = 0.0;
+
+    stats->frames = 0UL;
+    stats->frame_seconds = 0.0;
+}
+/*  End of sbh_stats_reset.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_stats_destroy                                                     *
+ *  Purpose:                                                                  *
+ *      Frees the memory of a set of counters.                                *
+ *  Arguments:                                                                *
+ *      stats (struct sbh_stats *):                                           *
+ *          The counters. Safe to call after a failed sbh_stats_init.         *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_stats_destroy(struct sbh_stats *stats)
+{
+    free(stats->thread);
+    free(stats->tile_seconds);
+    stats->thread = NULL;
+    stats->tile_seconds = NULL;
+    stats->threads = 0U;
+    stats->tiles = 0;
+}
+/*  End of sbh_stats_destroy.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_stats_init                                                        *
+ *  Purpose:                                                                  *
+ *      Allocates a set of counters, all zero.                                *
+ *  Arguments:                                                                *
+ *      stats (struct sbh_stats *):                                           *
+ *          The counters to initialize.                                       *
+ *      threads (unsigned int):                                               *
+ *          The number of threads, from sbh_render_thread_count.              *
+ *      tiles (size_t):                                                       *
+ *          The number of tiles, from sbh_render_tile_count.                  *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if memory could not be allocated.                 *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_stats_init(struct sbh_stats *stats, unsigned int threads, size_t tiles)
+{
+    stats->threads = threads;
+    stats->tiles = tiles;
+    stats->thread = (struct sbh_stats_thread *)
+        malloc(sizeof(*stats->thread) * (threads > 0U ? threads : 1U));
+    stats->tile_seconds = (double *)
+        malloc(sizeof(*stats->tile_seconds) * (tiles > 0 ? tiles : 1));
+
+    if (!stats->thread || !stats->tile_seconds)
+    {
+        sbh_stats_destroy(stats);
+        return 0;
+    }
+
+    sbh_stats_reset(stats);
+    return 1;
+}
+/*  End of sbh_stats_init.                                                    */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_stats_record_ray                                                  *
+ *  Purpose:                                                                  *
+ *      Counts a traced ray.                                                  *
+ *  Arguments:                                                                *
+ *      stats (struct sbh_stats *):                                           *
+ *          The counters. May be NULL.                                        *
+ *      thread (unsigned int):                                                *
+ *          The thread argument of the tile callback.                         *
+ *      result (const struct sbh_ray_result *):                               *
+ *          The result from any of the engines.                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      Does nothing unless SBH_STATS is defined.                             *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_stats_record_ray(struct sbh_stats *stats, unsigned int thread,
+                     const struct sbh_ray_result *result)
+{
+#if SBH_STATS_ENABLED
+    /*  Declare necessary variables.                                          */
+    struct sbh_stats_thread *counters;
+    unsigned long int steps = result->steps;
+    unsigned int bin = 0U;
+
+    if (!stats || thread >= stats->threads)
+        return;
+
+    counters = stats->thread + thread;
+    ++counters->rays;
+    ++counters->status[(unsigned int)result->status & 3U];
+    counters->steps += steps;
+    counters->rejected += result->rejected;
+
+    if (steps > counters->max_steps)
+        counters->max_steps = steps;
+
+    while (steps > 0UL && bin < SBH_STATS_HISTOGRAM_SIZE - 1U)
+    {
+        steps >>= 1;
+        ++bin;
+    }
+
+    ++counters->histogram[bin];
+#else
+    (void)stats;
+    (void)thread;
+    (void)result;
+#endif
+}
+/*  End of sbh_stats_record_ray.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_stats_total                                                       *
+ *  Purpose:                                                                  *
+ *      Sums the counters of every thread.                                    *
+ *  Arguments:                                                                *
+ *      stats (const struct sbh_stats *):                                     *
+ *          The counters.                                                     *
+ *  Outputs:                                                                  *
+ *      total (struct sbh_stats_thread):                                      *
+ *          The sums. max_steps is the largest over the threads.              *
+ ******************************************************************************/
+SBH_INLINE struct sbh_stats_thread
+sbh_stats_total(const struct sbh_stats *stats)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_stats_thread total;
+    unsigned int n;
+    size_t k;
+
+    total.rays = total.steps = total.rejected = total.max_steps = 0UL;
+    total.tiles = 0UL;
+    total.busy = 0.0;
+
+    for (k = 0; k < 4; ++k)
+        total.status[k] = 0UL;
+
+    for (k = 0; k < SBH_STATS_HISTOGRAM_SIZE; ++k)
+        total.histogram[k] = 0UL;
+
+    for (n = 0U; n < stats->threads; ++n)
+    {
+        const struct sbh_stats_thread *const counters = stats->thread + n;
+
+        total.rays += counters->rays;
+        total.steps += counters->steps;
+        total.rejected += counters->rejected;
+        total.tiles += counters->tiles;
+        total.busy += counters->busy;
+
+        if (counters->max_steps > total.max_steps)
+            total.max_steps = counters->max_steps;
+
+        for (k = 0; k < 4; ++k)
+            total.status[k] += counters->status[k];
+
+        for (k = 0; k < SBH_STATS_HISTOGRAM_SIZE; ++k)
+            total.histogram[k] += counters->histogram[k];
+    }
+
+    return total;
+}
+/*  End of sbh_stats_total.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_stats_write_json                                                  *
+ *  Purpose:                                                                  *
+ *      Writes the counters as a JSON object.                                 *
+ *  Arguments:                                                                *
+ *      stats (const struct sbh_stats *):                                     *
+ *          The counters.                                                     *
+ *      stream (FILE *):                                                      *
+ *          The output.                                                       *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if writing failed.                                *
+ *  Notes:                                                                    *
+ *      The object has the keys enabled, frames, frame_seconds, rays, steps,  *
+ *      tiles, and threads. tiles holds the time of every tile, and threads   *
+ *      the counters of every thread, with idle_seconds the frame time minus  *
+ *      the busy time. The tile times are summed over the counted frames.     *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_stats_write_json(const struct sbh_stats *stats, FILE *stream)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_stats_thread total = sbh_stats_total(stats);
+    const double mean = (total.rays > 0UL ?
+                         (double)total.steps / (double)total.rays : 0.0);
+    double tile_min = 0.0, tile_max = 0.0, tile_sum = 0.0;
+    unsigned int n;
+    size_t k;
+
+    for (k = 0; k < stats->tiles; ++k)
+    {
+        const double seconds = stats->tile_seconds[k];
+
+        if (k == 0 || seconds < tile_min)
+            tile_min = seconds;
+
+        if (k == 0 || seconds > tile_max)
+            tile_max = seconds;
+
+        tile_sum += seconds;
+    }
+
+    fprintf(stream, "{\n  \"enabled\": %s,\n", (SBH_STATS_ENABLED ? "true" :
+                                                                 "false"));
+    fprintf(stream, "  \"frames\": %lu,\n  \"frame_seconds\": %.9g,\n",
+            stats->frames, stats->frame_seconds);
+    fprintf(stream, "  \"rays\": {\"total\": %lu, \"incomplete\": %lu, "
+                    "\"escaped\": %lu, \"captured\": %lu, \"disk\": %lu},\n",
+            total.rays, total.status[SBH_RAY_INCOMPLETE],
+            total.status[SBH_RAY_ESCAPED], total.status[SBH_RAY_CAPTURED],
+            total.status[SBH_RAY_DISK]);
+    fprintf(stream, "  \"steps\": {\"total\": %lu, \"rejected\": %lu, "
+                    "\"max\": %lu, \"mean\": %.9g, \"histogram\": [",
+            total.steps, total.rejected, total.max_steps, mean);
+
+    for (k = 0; k < SBH_STATS_HISTOGRAM_SIZE; ++k)
+        fprintf(stream, "%s%lu", (k ? ", " : ""), total.histogram[k]);
+
+    fprintf(stream, "]},\n  \"tiles\": {\"count\": %lu, \"min_seconds\": "
+                    "%.9g, \"max_seconds\": %.9g, \"mean_seconds\": %.9g, "
+                    "\"seconds\": [",
+            (unsigned long int)stats->tiles, tile_min, tile_max,
+            (stats->tiles > 0 ? tile_sum / (double)stats->tiles : 0.0));
+
+    for (k = 0; k < stats->tiles; ++k)
+        fprintf(stream, "%s%.6g", (k ? ", " : ""), stats->tile_seconds[k]);
+
+    fprintf(stream, "]},\n  \"threads\": [");
+
+    for (n = 0U; n < stats->threads; ++n)
+    {
+        const struct sbh_stats_thread *const counters = stats->thread + n;
+
+        fprintf(stream, "%s\n    {\"tiles\": %lu, \"rays\": %lu, "
+                        "\"steps\": %lu, \"rejected\": %lu, "
+                        "\"busy_seconds\": %.9g, \"idle_seconds\": %.9g}",
+                (n ? "," : ""), counters->tiles, counters->rays,
+                counters->steps, counters->rejected, counters->busy,
+                stats->frame_seconds - counters->busy);
+    }
+
+    fprintf(stream, "\n  ]\n}\n");
+    return !ferror(stream);
+}
+/*  End of sbh_stats_write_json.                                              */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,547 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Fills a geometry buffer from a single radial line of rays, for        *
+ *      cameras that look straight toward or away from the black hole.        *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      Schwarzschild spacetime is spherically symmetric, so a camera at rest *
+ *      whose line of sight passes through the center sees an image that is   *
+ *      symmetric under rotations about the center of the image. The ray a    *
+ *      distance rho from the center, at an angle alpha from the right axis,  *
+ *      is the ray at (rho, 0) rotated by alpha about the line of sight.      *
+ *                                                                            *
+ *      The rays at (rho, 0) are traced for rho from 0 to the distance to the *
+ *      farthest corner, a few per pixel. Each escape direction is stored as  *
+ *      its angle psi from the line of sight, in the plane of the line of     *
+ *      sight and the right axis. Every sample of the buffer then gets psi    *
+ *      interpolated at its rho, and the direction                            *
+ *                                                                            *
+ *          d = cos(psi) F + sin(psi) (cos(alpha) R + sin(alpha) U),          *
+ *                                                                            *
+ *      with F, R, and U the forward, right, and up axes of the camera. A     *
+ *      frame of N x N pixels costs about N rays instead of N^2.              *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      The accretion disk of sbh_disk.h is only symmetric when seen from the *
+ *      polar axis, where sbh_camera_init does not allow a camera, so this is *
+ *      for frames of the black hole against the sky. Disk samples of the     *
+ *      profile are copied unchanged, see sbh_symmetric_sample.               *
+ *                                                                            *
+ *      Across the edge of the shadow the fate changes and psi diverges,      *
+ *      so samples there take the nearest ray of the profile instead of       *
+ *      interpolating. Increasing the density of the profile narrows the band *
+ *      of the photon ring this affects.                                      *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_SYMMETRIC_H
+#define SBH_SYMMETRIC_H
+
+#include "sbh_inline.h"
+#include "sbh_constants.h"
+#include "sbh_vec4.h"
+#include "sbh_fvec4.h"
+#include "sbh_ray.h"
+#include "sbh_camera.h"
+#include "sbh_render.h"
+#include "sbh_gbuffer.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*  The rays along one radius of the image.                                   */
+struct sbh_symmetric_profile {
+
+    /*  The center of the image in pixel coordinates, and the distance in     *
+     *  pixels between consecutive rays. Ray k is at (x + k spacing, y).      */
+    double x, y, spacing;
+
+    /*  The forward, right, and up axes of the camera, Cartesian unit         *
+     *  vectors.                                                              */
+    struct sbh_vec4 forward, right, up;
+
+    /*  The samples, and for escaped samples the angle psi of the direction   *
+     *  from forward toward right, unwrapped along the profile.               */
+    struct sbh_gbuffer_sample *samples;
+    double *angles;
+    size_t count;
+};
+
+/*  The state shared by the tiles of a pass.                                  */
+struct sbh_symmetric_pass {
+    struct sbh_symmetric_profile *profile;
+    struct sbh_gbuffer *gbuffer;
+    sbh_gbuffer_trace_callback trace;
+    void *data;
+
+    /*  The progress counters of the render, or NULL.                         */
+    struct sbh_progress *progress;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_camera_check                                            *
+ *  Purpose:                                                                  *
+ *      Determines if the image of a camera is rotationally symmetric.        *
+ *  Arguments:                                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera.                                                       *
+ *      tolerance (double):                                                   *
+ *          The largest allowed sine of the angle between the line of sight   *
+ *          and the radial direction. Zero only accepts exact alignment.      *
+ *  Outputs:                                                                  *
+ *      symmetric (int):                                                      *
+ *          1 if the camera looks toward or away from the black hole to       *
+ *          within the tolerance, 0 otherwise.                                *
+ *  Notes:                                                                    *
+ *      A camera aimed at (0, 0, 0, 0) with sbh_camera_init is aligned to     *
+ *      within rounding error, about 1E-15.                                   *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_symmetric_camera_check(const struct sbh_camera *camera, double tolerance)
+{
+    /*  camera->forward is a unit vector in the (r, phi, theta) frame.        */
+    const double off_axis = sqrt(camera->forward[1] * camera->forward[1] +
+                                 camera->forward[2] * camera->forward[2]);
+
+    return off_axis <= tolerance;
+}
+/*  End of sbh_symmetric_camera_check.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_init                                                    *
+ *  Purpose:                                                                  *
+ *      Allocates a profile for the image of a camera.                        *
+ *  Arguments:                                                                *
+ *      profile (struct sbh_symmetric_profile *):                             *
+ *          The profile to initialize.                                        *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera. It should pass sbh_symmetric_camera_check.            *
+ *      density (unsigned int):                                               *
+ *          The number of rays per pixel along the radius, at least 1. The    *
+ *          samples per pixel of the geometry buffer along each axis is a     *
+ *          reasonable choice.                                                *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if density is zero or memory could not be         *
+ *          allocated. On failure the profile may still be passed to          *
+ *          sbh_symmetric_destroy.                                            *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_symmetric_init(struct sbh_symmetric_profile *profile,
+                   const struct sbh_camera *camera,
+                   unsigned int density)
+{
+    /*  Declare necessary variables.                                          */
+    const double half_width = 0.5 * (double)camera->width;
+    const double half_height = 0.5 * (double)camera->height;
+    const double radius = sqrt(half_width * half_width +
+                               half_height * half_height);
+    struct sbh_vec4 right, up;
+
+    profile->samples = NULL;
+    profile->angles = NULL;
+    profile->count = 0;
+
+    if (density == 0U)
+        return 0;
+
+    /*  The camera axes in Cartesian coordinates, as in sbh_camera_init.      */
+    profile->forward = sbh_vec4_linear_combination(
+        camera->forward[0], camera->basis, camera->forward[1],
+        camera->basis + 1, camera->forward[2], camera->basis + 2
+    );
+
+    right = sbh_vec4_linear_combination(
+        camera->right[0], camera->basis, camera->right[1],
+        camera->basis + 1, camera->right[2], camera->basis + 2
+    );
+
+    up = sbh_vec4_linear_combination(
+        camera->up[0], camera->basis, camera->up[1],
+        camera->basis + 1, camera->up[2], camera->basis + 2
+    );
+
+    profile->forward = sbh_vec4_spatial_normalize(&profile->forward);
+    profile->right = sbh_vec4_spatial_normalize(&right);
+    profile->up = sbh_vec4_spatial_normalize(&up);
+
+    /*  One ray past the farthest corner, so every sample lies between two.   */
+    profile->x = half_width;
+    profile->y = half_height;
+    profile->spacing = 1.0 / (double)density;
+    profile->count = (size_t)(radius * (double)density) + 2;
+
+    profile->samples = (struct sbh_gbuffer_sample *)
+        malloc(sizeof(*profile->samples) * profile->count);
+    profile->angles = (double *)malloc(sizeof(*profile->angles) *
+                                       profile->count);
+
+    return profile->samples != NULL && profile->angles != NULL;
+}
+/*  End of sbh_symmetric_init.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_destroy                                                 *
+ *  Purpose:                                                                  *
+ *      Frees the memory of a profile.                                        *
+ *  Arguments:                                                                *
+ *      profile (struct sbh_symmetric_profile *):                             *
+ *          The profile.                                                      *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_symmetric_destroy(struct sbh_symmetric_profile *profile)
+{
+    free(profile->samples);
+    free(profile->angles);
+    profile->samples = NULL;
+    profile->angles = NULL;
+    profile->count = 0;
+}
+/*  End of sbh_symmetric_destroy.                                             */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_trace_tile                                              *
+ *  Purpose:                                                                  *
+ *      Traces a range of the rays of a profile.                              *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile, of a frame with one pixel per ray and a single row.     *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The pass, a struct sbh_symmetric_pass.                            *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_symmetric_trace_tile(const struct sbh_render_tile *tile,
+                         unsigned int thread,
+                         void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_symmetric_pass *pass =
+        (const struct sbh_symmetric_pass *)data;
+    struct sbh_symmetric_profile *profile = pass->profile;
+    size_t k;
+
+    for (k = tile->x; k < tile->x + tile->width; ++k)
+    {
+        const double x = profile->x + (double)k * profile->spacing;
+
+        if (sbh_progress_cancelled(pass->progress))
+            return;
+
+        pass->trace(x, profile->y, thread, profile->samples + k, pass->data);
+    }
+
+    sbh_progress_add_rays(pass->progress, (unsigned long)tile->width);
+}
+/*  End of sbh_symmetric_trace_tile.                                          */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_unwrap                                                  *
+ *  Purpose:                                                                  *
+ *      Computes the angles of the escaped rays of a traced profile.          *
+ *  Arguments:                                                                *
+ *      profile (struct sbh_symmetric_profile *):                             *
+ *          The profile, with every sample traced.                            *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      atan2 gives psi in [-pi, pi]. Rays that wind around the black hole    *
+ *      turn by more than that, so multiples of 2 pi are added to keep each   *
+ *      angle within pi of the previous escaped ray, and interpolation        *
+ *      between neighbours does not cross the branch cut.                     *
+ ******************************************************************************/
+SBH_INLINE void sbh_symmetric_unwrap(struct sbh_symmetric_profile *profile)
+{
+    /*  Declare necessary variables.                                          */
+    double previous = 0.0;
+    int has_previous = 0;
+    size_t k;
+
+    for (k = 0; k < profile->count; ++k)
+    {
+        const struct sbh_gbuffer_sample *sample = profile->samples + k;
+        struct sbh_vec4 d;
+        double psi;
+
+        if (sample->status != (unsigned char)SBH_RAY_ESCAPED)
+        {
+            profile->angles[k] = 0.0;
+            has_previous = 0;
+            continue;
+        }
+
+        d = sbh_fvec4_to_vec4(&sample->dat);
+        psi = atan2(sbh_vec4_spatial_dot(&d, &profile->right),
+                    sbh_vec4_spatial_dot(&d, &profile->forward));
+
+        if (has_previous)
+            psi += SBH_TWO_PI * floor((previous - psi) / SBH_TWO_PI + 0.5);
+
+        profile->angles[k] = psi;
+        previous = psi;
+        has_previous = 1;
+    }
+}
+/*  End of sbh_symmetric_unwrap.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_sample                                                  *
+ *  Purpose:                                                                  *
+ *      Computes the sample at a point of the image from a profile.           *
+ *  Arguments:                                                                *
+ *      profile (const struct sbh_symmetric_profile *):                       *
+ *          The profile, traced and unwrapped.                                *
+ *      x (double):                                                           *
+ *          The horizontal pixel coordinate, inside the image.                *
+ *      y (double):                                                           *
+ *          The vertical pixel coordinate, inside the image.                  *
+ *  Outputs:                                                                  *
+ *      sample (struct sbh_gbuffer_sample):                                   *
+ *          The sample, as the trace callback would have produced it for the  *
+ *          ray through (x, y).                                               *
+ *  Method:                                                                   *
+ *      If both rays of the profile around the distance from the center       *
+ *      escaped, interpolate psi linearly and rotate. Otherwise take the      *
+ *      nearest ray, rotating its direction if it escaped. Other samples do   *
+ *      not depend on the direction and are copied.                           *
+ ******************************************************************************/
+SBH_INLINE struct sbh_gbuffer_sample
+sbh_symmetric_sample(const struct sbh_symmetric_profile *profile,
+                     double x, double y)
+{
+    /*  Declare necessary variables.                                          */
+    const double a = x - profile->x;
+    const double b = profile->y - y;
+    const double rho = sqrt(a * a + b * b);
+    const double t = rho / profile->spacing;
+    const unsigned char escaped = (unsigned char)SBH_RAY_ESCAPED;
+    struct sbh_gbuffer_sample sample;
+    struct sbh_vec4 across, d;
+    double fraction, psi, cos_alpha, sin_alpha;
+    size_t k = (size_t)t;
+
+    /*  Rays outside the image are clamped to the last pair.                  */
+    if (k > profile->count - 2)
+        k = profile->count - 2;
+
+    fraction = t - (double)k;
+
+    if (profile->samples[k].status == escaped &&
+        profile->samples[k + 1].status == escaped)
+    {
+        sample = profile->samples[k];
+        psi = profile->angles[k] +
+              fraction * (profile->angles[k + 1] - profile->angles[k]);
+    }
+    else
+    {
+        if (fraction >= 0.5)
+            ++k;
+
+        sample = profile->samples[k];
+
+        if (sample.status != escaped)
+            return sample;
+
+        psi = profile->angles[k];
+    }
+
+    /*  The direction of the ray at (rho, 0) rotated by alpha.                */
+    if (rho > 0.0)
+    {
+        cos_alpha = a / rho;
+        sin_alpha = b / rho;
+    }
+    else
+    {
+        cos_alpha = 1.0;
+        sin_alpha = 0.0;
+    }
+
+    across = sbh_vec4_linear_combination(cos_alpha, &profile->right,
+                                         sin_alpha, &profile->up,
+                                         0.0, &profile->up);
+
+    d = sbh_vec4_linear_combination(cos(psi), &profile->forward,
+                                    sin(psi), &across, 0.0, &across);
+
+    sample.dat = sbh_fvec4_from_vec4(&d);
+    return sample;
+}
+/*  End of sbh_symmetric_sample.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_fill_tile                                               *
+ *  Purpose:                                                                  *
+ *      Fills the samples of the pixels of a tile from a profile.             *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile.                                                         *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread, unused.                           *
+ *      data (void *):                                                        *
+ *          The pass, a struct sbh_symmetric_pass.                            *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      The samples are at the same points as in sbh_gbuffer_build_tile. No   *
+ *      rays are traced, so none are counted, but the tile stops early if the *
+ *      render is cancelled.                                                  *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_symmetric_fill_tile(const struct sbh_render_tile *tile,
+                        unsigned int thread,
+                        void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_symmetric_pass *pass =
+        (const struct sbh_symmetric_pass *)data;
+    const struct sbh_gbuffer *gbuffer = pass->gbuffer;
+    const unsigned int grid = gbuffer->grid;
+    const size_t per_pixel = (size_t)grid * (size_t)grid;
+    const double spacing = 1.0 / (double)grid;
+    size_t i, j;
+    unsigned int a, b;
+
+    (void)thread;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            struct sbh_gbuffer_sample *sample =
+                gbuffer->samples + (j * gbuffer->width + i) * per_pixel;
+
+            if (sbh_progress_cancelled(pass->progress))
+                return;
+
+            for (b = 0U; b < grid; ++b)
+            {
+                const double y = (double)j + ((double)b + 0.5) * spacing;
+
+                for (a = 0U; a < grid; ++a)
+                {
+                    const double x = (double)i + ((double)a + 0.5) * spacing;
+                    *sample = sbh_symmetric_sample(pass->profile, x, y);
+                    ++sample;
+                }
+            }
+        }
+    }
+}
+/*  End of sbh_symmetric_fill_tile.                                           */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_symmetric_build                                                   *
+ *  Purpose:                                                                  *
+ *      Fills a geometry buffer from a radial profile, in place of            *
+ *      sbh_gbuffer_build.                                                    *
+ *  Arguments:                                                                *
+ *      gbuffer (struct sbh_gbuffer *):                                       *
+ *          The buffer. Its size must match render and the camera.            *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry and number of threads.                         *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera. It should pass sbh_symmetric_camera_check.            *
+ *      density (unsigned int):                                               *
+ *          The number of rays per pixel along the radius.                    *
+ *      trace (sbh_gbuffer_trace_callback):                                   *
+ *          Traces a ray, as for sbh_gbuffer_build. It is called from several *
+ *          threads at once, along the row through the center of the image,   *
+ *          with x possibly past the right edge.                              *
+ *      data (void *):                                                        *
+ *          Passed to trace.                                                  *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if the sizes of the buffer and the frame differ,  *
+ *          density is zero, memory could not be allocated, sbh_render_frame  *
+ *          failed, or the render was cancelled.                              *
+ *  Notes:                                                                    *
+ *      The profile is traced with the tile width and number of threads of    *
+ *      render. Its tiles are not those of the frame and are not counted, but *
+ *      its rays are, and it stops if the render is cancelled. The tiles of   *
+ *      the filling pass are counted as those of the frame.                   *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_symmetric_build(struct sbh_gbuffer *gbuffer,
+                    const struct sbh_render_params *render,
+                    const struct sbh_camera *camera,
+                    unsigned int density,
+                    sbh_gbuffer_trace_callback trace,
+                    void *data)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_symmetric_profile profile;
+    struct sbh_symmetric_pass pass;
+    struct sbh_render_params line = *render;
+    int success;
+
+    if (gbuffer->width != render->width || gbuffer->height != render->height)
+        return 0;
+
+    success = sbh_symmetric_init(&profile, camera, density);
+
+    pass.profile = &profile;
+    pass.gbuffer = gbuffer;
+    pass.trace = trace;
+    pass.data = data;
+    pass.progress = render->progress;
+
+    /*  The profile as a frame of one row, one pixel per ray.                 */
+    line.width = profile.count;
+    line.height = 1;
+    line.tile_height = 1;
+    line.stats = NULL;
+    line.progress = NULL;
+
+    /*  A cancelled profile is partly traced, and must not be unwrapped.      */
+    success = success &&
+              sbh_render_frame(&line, sbh_symmetric_trace_tile, &pass) &&
+              !sbh_progress_cancelled(render->progress);
+
+    if (success)
+        sbh_symmetric_unwrap(&profile);
+
+    success = success &&
+              sbh_render_frame(render, sbh_symmetric_fill_tile, &pass);
+
+    sbh_symmetric_destroy(&profile);
+    return success;
+}
+/*  End of sbh_symmetric_build.                                               */
+
+#endif
+/*  End of include guard.                                                     */
@@ -0,0 +1,546 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a temporal cache for animations. Each frame reuses the       *
+ *      samples of the previous frame where they are still accurate, and      *
+ *      only traces the rest.                                                 *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      The black hole and an equatorial disk are unchanged by rotations      *
+ *      about the z axis. A camera that moved by an angle dphi in azimuth     *
+ *      sees the same rays as a camera rotated back by -dphi, with the        *
+ *      results rotated forward by dphi. Each frame is therefore compared     *
+ *      with the previous one in a frame co-rotating with the camera, which   *
+ *      makes orbits around the black hole free.                              *
+ *                                                                            *
+ *      For every sample of the new frame the initial direction of its ray    *
+ *      is rotated back and projected into the previous camera, giving the    *
+ *      nearest previous sample. The error made by reusing it is estimated    *
+ *      as the angle between the two initial directions, plus the parallax    *
+ *      |dx| / r from the remaining change in camera position dx, since the   *
+ *      lensed image is centered on the black hole at a distance r. A         *
+ *      previous sample that was itself reused was not traced at its center,  *
+ *      so the error it carries is added, and kept with the new sample. If    *
+ *      the sum is below the tolerance, and the neighbors of the sample all   *
+ *      share its fate, so it is not on the edge of the shadow or the disk,   *
+ *      the sample is reused. Otherwise it is traced.                         *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      The tolerance is in pixels. A still camera, a camera turning in place *
+ *      by whole pixels, or one orbiting the z axis reuses every sample away  *
+ *      from the edges of the shadow and the disk, which are retraced. A      *
+ *      camera moving towards the black hole by more than the tolerance per   *
+ *      frame, in units of r per pixel, retraces the whole frame.             *
+ *                                                                            *
+ *      The cache assumes the scene is fixed. Call sbh_temporal_reset if the  *
+ *      disk or the mass changes. Textures may change freely, since they only *
+ *      enter through sbh_gbuffer_shade.                                      *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_TEMPORAL_H
+#define SBH_TEMPORAL_H
+
+#include "sbh_inline.h"
+#include "sbh_vec4.h"
+#include "sbh_ray.h"
+#include "sbh_camera.h"
+#include "sbh_gbuffer.h"
+#include "sbh_render.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*  The last two frames of an animation.                                      */
+struct sbh_temporal {
+
+    /*  The samples and cameras of the frames. current is the newest.         */
+    struct sbh_gbuffer frames[2];
+    struct sbh_camera cameras[2];
+    unsigned int current;
+
+    /*  For each sample of the frames, the error in radians it carries from   *
+     *  the frames it was reused through. Zero for traced samples.            */
+    float *errors[2];
+
+    /*  Zero before the first frame and after sbh_temporal_reset.             */
+    int has_previous;
+
+    /*  The largest error allowed for a reused sample, in pixels.             */
+    double tolerance;
+
+    /*  The number of rays traced for each tile in the last frame.            */
+    unsigned long *tile_rays;
+    size_t tiles;
+};
+
+/*  The state shared by the tiles of a frame.                                 */
+struct sbh_temporal_pass {
+    const struct sbh_camera *camera;
+    const struct sbh_camera *previous;
+    const struct sbh_gbuffer *source;
+    struct sbh_gbuffer *target;
+    const float *source_errors;
+    float *target_errors;
+    sbh_gbuffer_trace_callback trace;
+    void *data;
+    unsigned long *tile_rays;
+
+    /*  The progress counters of the render, or NULL.                         */
+    struct sbh_progress *progress;
+
+    /*  The rotation of the camera about the z axis, and the errors in        *
+     *  radians that are allowed and that come from the camera translation.   */
+    double cos_dphi, sin_dphi, dphi;
+    double tolerance, parallax;
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_temporal_init                                                     *
+ *  Purpose:                                                                  *
+ *      Allocates a temporal cache.                                           *
+ *  Arguments:                                                                *
+ *      temporal (struct sbh_temporal *):                                     *
+ *          The cache to initialize.                                          *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry, which must be the same for every frame.       *
+ *      grid (unsigned int):                                                  *
+ *          The samples per pixel along each axis, see sbh_gbuffer.h.         *
+ *      tolerance (double):                                                   *
+ *          The largest error allowed for a reused sample, in pixels. A       *
+ *          quarter of a pixel is hard to see. Zero disables reuse.           *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 on failure. The cache may be passed to            *
+ *          sbh_temporal_destroy either way.                                  *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_temporal_init(struct sbh_temporal *temporal,
+                  const struct sbh_render_params *render,
+                  unsigned int grid,
+                  double tolerance)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t width = render->width;
+    const size_t height = render->height;
+    const size_t count = width * height * grid * grid;
+    int success;
+
+    temporal->current = 0U;
+    temporal->has_previous = 0;
+    temporal->tolerance = tolerance;
+    temporal->tiles = sbh_render_tile_count(render);
+    temporal->tile_rays = (unsigned long *)
+        malloc(sizeof(*temporal->tile_rays) * (temporal->tiles + 1));
+    temporal->errors[0] = (float *)malloc(sizeof(float) * (count + 1));
+    temporal->errors[1] = (float *)malloc(sizeof(float) * (count + 1));
+
+    success = sbh_gbuffer_init(temporal->frames, width, height, grid);
+
+    if (!sbh_gbuffer_init(temporal->frames + 1, width, height, grid))
+        success = 0;
+
+    return success && temporal->tile_rays != NULL &&
+           temporal->errors[0] != NULL && temporal->errors[1] != NULL;
+}
+/*  End of sbh_temporal_init.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_temporal_destroy                                                  *
+ *  Purpose:                                                                  *
+ *      Frees the memory of a temporal cache.                                 *
+ *  Arguments:                                                                *
+ *      temporal (struct sbh_temporal *):                                     *
+ *          The cache.                                                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_temporal_destroy(struct sbh_temporal *temporal)
+{
+    sbh_gbuffer_destroy(temporal->frames);
+    sbh_gbuffer_destroy(temporal->frames + 1);
+    free(temporal->tile_rays);
+    free(temporal->errors[0]);
+    free(temporal->errors[1]);
+    temporal->tile_rays = NULL;
+    temporal->errors[0] = temporal->errors[1] = NULL;
+}
+/*  End of sbh_temporal_destroy.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_temporal_reset                                                    *
+ *  Purpose:                                                                  *
+ *      Forgets the previous frame, so the next frame is traced in full.      *
+ *  Arguments:                                                                *
+ *      temporal (struct sbh_temporal *):                                     *
+ *          The cache.                                                        *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_temporal_reset(struct sbh_temporal *temporal)
+{
+    temporal->has_previous = 0;
+}
+/*  End of sbh_temporal_reset.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_temporal_frame                                                    *
+ *  Purpose:                                                                  *
+ *      Returns the samples of the newest frame, for sbh_gbuffer_shade.       *
+ *  Arguments:                                                                *
+ *      temporal (const struct sbh_temporal *):                               *
+ *          The cache.                                                        *
+ *  Outputs:                                                                  *
+ *      gbuffer (const struct sbh_gbuffer *):                                 *
+ *          The samples of the newest frame.                                  *
+ ******************************************************************************/
+SBH_INLINE const struct sbh_gbuffer *
+sbh_temporal_frame(const struct sbh_temporal *temporal)
+{
+    return temporal->frames + temporal->current;
+}
+/*  End of sbh_temporal_frame.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_temporal_reuse                                                    *
+ *  Purpose:                                                                  *
+ *      Tries to reuse a previous sample for a ray of the new frame.          *
+ *  Arguments:                                                                *
+ *      pass (const struct sbh_temporal_pass *):                              *
+ *          The frame.                                                        *
+ *      x (double):                                                           *
+ *          The horizontal pixel coordinate of the ray.                       *
+ *      y (double):                                                           *
+ *          The vertical pixel coordinate of the ray.                         *
+ *      sample (struct sbh_gbuffer_sample *):                                 *
+ *          Set to the reused sample on success.                              *
+ *      carried (float *):                                                    *
+ *          Set to the error of the reused sample on success, in radians.     *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if a previous sample was accurate enough, 0 otherwise.          *
+ *  Notes:                                                                    *
+ *      The error of a reused sample adds to the error the previous sample    *
+ *      already carried, so a sample passed on over many frames is retraced   *
+ *      once the sum reaches the tolerance, however small each step is.       *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_temporal_reuse(const struct sbh_temporal_pass *pass,
+                   double x, double y,
+                   struct sbh_gbuffer_sample *sample,
+                   float *carried)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_gbuffer *source = pass->source;
+    const unsigned int grid = source->grid;
+    const long int columns = (long int)(source->width * grid);
+    const long int rows = (long int)(source->height * grid);
+    const struct sbh_vec4 d = sbh_camera_direction(pass->camera, x, y);
+    const struct sbh_gbuffer_sample *nearest;
+    struct sbh_vec4 rotated, cached, offset;
+    double px, py, cx, cy, error;
+    long int sx, sy, dx, dy;
+    size_t index;
+
+    /*  The direction in the frame co-rotating with the camera.               */
+    rotated = sbh_vec4_rect(
+        pass->cos_dphi * d.dat[0] + pass->sin_dphi * d.dat[1],
+        pass->cos_dphi * d.dat[1] - pass->sin_dphi * d.dat[0],
+        d.dat[2], 0.0
+    );
+
+    if (!sbh_camera_project(pass->previous, &rotated, &px, &py))
+        return 0;
+
+    /*  The nearest previous sample, on the grid of sample centers.           */
+    if (!(px >= 0.0 && py >= 0.0))
+        return 0;
+
+    sx = (long int)(px * (double)grid);
+    sy = (long int)(py * (double)grid);
+
+    if (sx >= columns || sy >= rows)
+        return 0;
+
+    /*  Pixel rows hold grid rows of samples. Find the sample at (sx, sy).    */
+    index = (((size_t)sy / grid) * source->width + (size_t)sx / grid) *
+            grid * grid + ((size_t)sy % grid) * grid + (size_t)sx % grid;
+    nearest = source->samples + index;
+
+    cx = ((double)sx + 0.5) / (double)grid;
+    cy = ((double)sy + 0.5) / (double)grid;
+    cached = sbh_camera_direction(pass->previous, cx, cy);
+    offset = sbh_vec4_linear_combination(1.0, &rotated, -1.0, &cached,
+                                         0.0, &cached);
+
+    /*  The center of the previous sample is only where it was traced if it   *
+     *  was not itself reused, so its own error is added.                     */
+    error = sqrt(sbh_vec4_spatial_dot(&offset, &offset)) + pass->parallax +
+            (double)pass->source_errors[index];
+
+    if (!(error <= pass->tolerance))
+        return 0;
+
+    /*  Reject samples on the edge between two fates.                         */
+    for (dy = -1; dy <= 1; ++dy)
+    {
+        for (dx = -1; dx <= 1; ++dx)
+        {
+            const long int nx = sx + dx;
+            const long int ny = sy + dy;
+            const struct sbh_gbuffer_sample *neighbor;
+
+            if ((dx != 0 && dy != 0) || (dx == 0 && dy == 0))
+                continue;
+
+            if (nx < 0 || ny < 0 || nx >= columns || ny >= rows)
+                continue;
+
+            neighbor = source->samples +
+                (((size_t)ny / grid) * source->width + (size_t)nx / grid) *
+                grid * grid + ((size_t)ny % grid) * grid + (size_t)nx % grid;
+
+            if (neighbor->status != nearest->status)
+                return 0;
+        }
+    }
+
+    /*  Rotate the result forward to the new camera.                          */
+    *sample = *nearest;
+
+    if (sample->status == (unsigned char)SBH_RAY_ESCAPED)
+    {
+        const double u = (double)nearest->dat.dat[0];
+        const double v = (double)nearest->dat.dat[1];
+        sample->dat.dat[0] = (float)(pass->cos_dphi * u - pass->sin_dphi * v);
+        sample->dat.dat[1] = (float)(pass->sin_dphi * u + pass->cos_dphi * v);
+    }
+
+    else if (sample->status == (unsigned char)SBH_RAY_DISK)
+        sample->dat.dat[1] = (float)((double)nearest->dat.dat[1] + pass->dphi);
+
+    *carried = (float)error;
+    return 1;
+}
+/*  End of sbh_temporal_reuse.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_temporal_tile                                                     *
+ *  Purpose:                                                                  *
+ *      Fills the samples of a tile of the new frame.                         *
+ *  Arguments:                                                                *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile.                                                         *
+ *      thread (unsigned int):                                                *
+ *          The index of the render thread.                                   *
+ *      data (void *):                                                        *
+ *          The frame, a struct sbh_temporal_pass.                            *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_temporal_tile(const struct sbh_render_tile *tile,
+                  unsigned int thread,
+                  void *data)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_temporal_pass *pass =
+        (const struct sbh_temporal_pass *)data;
+    const struct sbh_gbuffer *target = pass->target;
+    const unsigned int grid = target->grid;
+    const double spacing = 1.0 / (double)grid;
+    unsigned long rays = 0UL;
+    size_t i, j;
+    unsigned int a, b;
+
+    for (j = tile->y; j < tile->y + tile->height; ++j)
+    {
+        const unsigned long row = rays;
+
+        for (i = tile->x; i < tile->x + tile->width; ++i)
+        {
+            const size_t index =
+                (j * target->width + i) * (size_t)grid * (size_t)grid;
+            struct sbh_gbuffer_sample *sample = target->samples + index;
+            float *carried = pass->target_errors + index;
+
+            if (sbh_progress_cancelled(pass->progress))
+                return;
+
+            for (b = 0U; b < grid; ++b)
+            {
+                const double y = (double)j + ((double)b + 0.5) * spacing;
+
+                for (a = 0U; a < grid; ++a)
+                {
+                    const double x = (double)i + ((double)a + 0.5) * spacing;
+
+                    if (!sbh_temporal_reuse(pass, x, y, sample, carried))
+                    {
+                        pass->trace(x, y, thread, sample, pass->data);
+                        *carried = 0.0F;
+                        ++rays;
+                    }
+
+                    ++sample;
+                    ++carried;
+                }
+            }
+        }
+
+        /*  Only the rays traced are counted, not the samples reused.         */
+        sbh_progress_add_rays(pass->progress, rays - row);
+    }
+
+    pass->tile_rays[tile->index] = rays;
+}
+/*  End of sbh_temporal_tile.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_temporal_render                                                   *
+ *  Purpose:                                                                  *
+ *      Computes the samples of the next frame of an animation.               *
+ *  Arguments:                                                                *
+ *      temporal (struct sbh_temporal *):                                     *
+ *          The cache.                                                        *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry and number of threads, as given to             *
+ *          sbh_temporal_init.                                                *
+ *      camera (const struct sbh_camera *):                                   *
+ *          The camera of the new frame. trace must use this camera.          *
+ *      trace (sbh_gbuffer_trace_callback):                                   *
+ *          Traces a ray. It is called from several threads at once.          *
+ *      data (void *):                                                        *
+ *          Passed to trace.                                                  *
+ *      rays (unsigned long *):                                               *
+ *          If not NULL, set to the number of rays traced.                    *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if the frame was rendered, 0 if the frame geometry does not     *
+ *          match the cache or sbh_render_frame failed.                       *
+ *  Notes:                                                                    *
+ *      The samples are read with sbh_temporal_frame. If rendering fails the  *
+ *      cache is reset, and the next frame is traced in full.                 *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_temporal_render(struct sbh_temporal *temporal,
+                    const struct sbh_render_params *render,
+                    const struct sbh_camera *camera,
+                    sbh_gbuffer_trace_callback trace,
+                    void *data,
+                    unsigned long *rays)
+{
+    /*  Declare necessary variables.                                          */
+    const unsigned int next = 1U - temporal->current;
+    const unsigned int grid = temporal->frames[next].grid;
+    const size_t count = render->width * render->height * grid * grid;
+    struct sbh_temporal_pass pass;
+    unsigned long total = 0UL;
+    size_t n;
+    int success;
+
+    if (render->width != temporal->frames[next].width ||
+        render->height != temporal->frames[next].height ||
+        sbh_render_tile_count(render) != temporal->tiles)
+        return 0;
+
+    temporal->cameras[next] = *camera;
+
+    if (!temporal->has_previous || !(temporal->tolerance > 0.0))
+    {
+        success = sbh_gbuffer_build(temporal->frames + next, render,
+                                    trace, data);
+        total = (unsigned long)count;
+
+        for (n = 0; n < count; ++n)
+            temporal->errors[next][n] = 0.0F;
+    }
+
+    else
+    {
+        const struct sbh_camera *previous = temporal->cameras +
+                                            temporal->current;
+        const struct sbh_vec4 back = sbh_vec4_rect_from_schwarzschild(
+            camera->position.dat[0], previous->position.dat[1],
+            camera->position.dat[2], 0.0
+        );
+        const struct sbh_vec4 old = sbh_vec4_rect_from_schwarzschild(
+            previous->position.dat[0], previous->position.dat[1],
+            previous->position.dat[2], 0.0
+        );
+        const struct sbh_vec4 moved =
+            sbh_vec4_linear_combination(1.0, &back, -1.0, &old, 0.0, &old);
+
+        /*  One pixel subtends the length of right at unit distance.          */
+        const double pixel = sqrt(camera->right[0]*camera->right[0] +
+                                  camera->right[1]*camera->right[1] +
+                                  camera->right[2]*camera->right[2]);
+
+        pass.camera = camera;
+        pass.previous = previous;
+        pass.source = temporal->frames + temporal->current;
+        pass.target = temporal->frames + next;
+        pass.source_errors = temporal->errors[temporal->current];
+        pass.target_errors = temporal->errors[next];
+        pass.trace = trace;
+        pass.data = data;
+        pass.tile_rays = temporal->tile_rays;
+        pass.progress = render->progress;
+        pass.dphi = camera->position.dat[1] - previous->position.dat[1];
+        pass.cos_dphi = cos(pass.dphi);
+        pass.sin_dphi = sin(pass.dphi);
+        pass.tolerance = temporal->tolerance * pixel;
+        pass.parallax = sqrt(sbh_vec4_spatial_dot(&moved, &moved)) /
+                        camera->position.dat[0];
+
+        success = sbh_render_frame(render, sbh_temporal_tile, &pass);
+
+        for (n = 0; success && n < temporal->tiles; ++n)
+            total += temporal->tile_rays[n];
+    }
+
+    if (!success)
+    {
+        temporal->has_previous = 0;
+        return 0;
+    }
+
+    temporal->current = next;
+    temporal->has_previous = 1;
+
+    if (rays)
+        *rays = total;
+
+    return 1;
+}
+/*  End of sbh_temporal_render.                                               */
+
+#endif
+/*  End of include guard.                                                     */
@@ -151,5 +151,240 @@ sbh_vec4_convert_schwarzschild_to_rect(struct sbh_vec4 *p)
 }
 /*  End of sbh_vec4_convert_schwarzschild_to_rect.                            */
 
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_schwarzschild_from_rect                                      *
+ *  Purpose:                                                                  *
+ *      Given the Cartesian coordinates of a point p, returns the vector in   *
+ *      R^4 with the corresponding Schwarzschild coordinates.                 *
+ *  Arguments:                                                                *
+ *      x (double):                                                           *
+ *          The x component of the point.                                     *
+ *      y (double):                                                           *
+ *          The y component of the point.                                     *
+ *      z (double):                                                           *
+ *          The z component of the point.                                     *
+ *      t (double):                                                           *
+ *          The time component of the vector.                                 *
+ *  Outputs:                                                                  *
+ *      v (struct sbh_vec4):                                                  *
+ *          The vector (r, phi, theta, t), with -pi <= phi <= pi and          *
+ *          0 <= theta <= pi.                                                 *
+ *  Method:                                                                   *
+ *      r is the Euclidean norm and phi = atan2(y, x). The polar angle is     *
+ *      computed as atan2(rho, z), rho = sqrt(x^2 + y^2), and not as          *
+ *      acos(z / r). acos loses about half of its digits near the poles,      *
+ *      where its derivative is unbounded, while atan2 does not.              *
+ *  Notes:                                                                    *
+ *      The origin maps to (0, 0, 0, t).                                      *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_vec4_schwarzschild_from_rect(double x, double y, double z, double t)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_vec4 p;
+    const double rho_sq = x * x + y * y;
+
+    /*  Compute the spherical coordinates (r, phi, theta) of (x, y, z).       */
+    p.dat[0] = sqrt(rho_sq + z * z);
+    p.dat[1] = atan2(y, x);
+    p.dat[2] = atan2(sqrt(rho_sq), z);
+
+    /*  The time factor is the same in both coordinate systems.               */
+    p.dat[3] = t;
+    return p;
+}
+/*  End of sbh_vec4_schwarzschild_from_rect.                                  */
+
+SBH_INLINE struct sbh_vec4
+sbh_vec4_rect_to_schwarzschild(const struct sbh_vec4 *q)
+{
+    /*  The input vector is in Cartesian coordinates. Pass them to the        *
+     *  schwarzschild_from_rect function and return.                          */
+    return sbh_vec4_schwarzschild_from_rect(
+        q->dat[0], q->dat[1], q->dat[2], q->dat[3]
+    );
+}
+
+SBH_INLINE void
+sbh_vec4_convert_rect_to_schwarzschild(struct sbh_vec4 *p)
+{
+    /*  Avoid overwriting data. Save the spatial part of the input.           */
+    const double x = p->dat[0];
+    const double y = p->dat[1];
+    const double z = p->dat[2];
+    const double rho_sq = x * x + y * y;
+
+    /*  Compute Schwarzschild coordinates from the spatial part (x, y, z).    *
+     *  The time part is the same in both systems, no need to change.         */
+    p->dat[0] = sqrt(rho_sq + z * z);
+    p->dat[1] = atan2(y, x);
+    p->dat[2] = atan2(sqrt(rho_sq), z);
+}
+/*  End of sbh_vec4_convert_rect_to_schwarzschild.                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_rect_velocity_from_schwarzschild                             *
+ *  Purpose:                                                                  *
+ *      Given a point p and a tangent vector v at p, both in Schwarzschild    *
+ *      coordinates, returns the tangent vector in Cartesian coordinates.     *
+ *  Arguments:                                                                *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The point (r, phi, theta, t).                                     *
+ *      v (const struct sbh_vec4 *):                                          *
+ *          The vector (dr, dphi, dtheta, dt) at p.                           *
+ *  Outputs:                                                                  *
+ *      w (struct sbh_vec4):                                                  *
+ *          The vector (dx, dy, dz, dt).                                      *
+ *  Method:                                                                   *
+ *      Apply the Jacobian of the spherical-to-rectangular map. That is,      *
+ *      dr e_r + r dtheta e_theta + r sin(theta) dphi e_phi, where e_r,       *
+ *      e_theta, and e_phi are the usual orthonormal spherical basis vectors. *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_vec4_rect_velocity_from_schwarzschild(const struct sbh_vec4 *p,
+                                          const struct sbh_vec4 *v)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_vec4 w;
+    const double r = p->dat[0];
+    const double sin_phi = sin(p->dat[1]);
+    const double cos_phi = cos(p->dat[1]);
+    const double sin_theta = sin(p->dat[2]);
+    const double cos_theta = cos(p->dat[2]);
+
+    /*  The components of v along the orthonormal spherical basis.            */
+    const double v_r = v->dat[0];
+    const double v_phi = r * sin_theta * v->dat[1];
+    const double v_theta = r * v->dat[2];
+
+    /*  The part of v_r e_r + v_theta e_theta that lies in the xy-plane.      */
+    const double v_rho = v_r * sin_theta + v_theta * cos_theta;
+
+    /*  Sum the contributions of e_r, e_theta, and e_phi.                     */
+    w.dat[0] = v_rho * cos_phi - v_phi * sin_phi;
+    w.dat[1] = v_rho * sin_phi + v_phi * cos_phi;
+    w.dat[2] = v_r * cos_theta - v_theta * sin_theta;
+
+    /*  The time component is the same in both coordinate systems.            */
+    w.dat[3] = v->dat[3];
+    return w;
+}
+/*  End of sbh_vec4_rect_velocity_from_schwarzschild.                         */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_spatial_dot                                                  *
+ *  Purpose:                                                                  *
+ *      Computes the Euclidean dot product of the spatial parts of two        *
+ *      Cartesian vectors, ignoring the time components.                      *
+ *  Arguments:                                                                *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The first vector.                                                 *
+ *      q (const struct sbh_vec4 *):                                          *
+ *          The second vector.                                                *
+ *  Outputs:                                                                  *
+ *      dot (double):                                                         *
+ *          p_x q_x + p_y q_y + p_z q_z.                                      *
+ ******************************************************************************/
+SBH_INLINE double
+sbh_vec4_spatial_dot(const struct sbh_vec4 *p, const struct sbh_vec4 *q)
+{
+    return p->dat[0]*q->dat[0] + p->dat[1]*q->dat[1] + p->dat[2]*q->dat[2];
+}
+/*  End of sbh_vec4_spatial_dot.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_spatial_cross                                                *
+ *  Purpose:                                                                  *
+ *      Computes the cross product of the spatial parts of two Cartesian      *
+ *      vectors. The time component of the result is zero.                    *
+ *  Arguments:                                                                *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The first vector.                                                 *
+ *      q (const struct sbh_vec4 *):                                          *
+ *          The second vector.                                                *
+ *  Outputs:                                                                  *
+ *      cross (struct sbh_vec4):                                              *
+ *          The vector (p x q, 0).                                            *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_vec4_spatial_cross(const struct sbh_vec4 *p, const struct sbh_vec4 *q)
+{
+    return sbh_vec4_rect(
+        p->dat[1]*q->dat[2] - p->dat[2]*q->dat[1],
+        p->dat[2]*q->dat[0] - p->dat[0]*q->dat[2],
+        p->dat[0]*q->dat[1] - p->dat[1]*q->dat[0],
+        0.0
+    );
+}
+/*  End of sbh_vec4_spatial_cross.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_spatial_normalize                                            *
+ *  Purpose:                                                                  *
+ *      Scales the spatial part of a Cartesian vector to unit length and      *
+ *      sets the time component to zero.                                      *
+ *  Arguments:                                                                *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The vector. Its spatial part should be non-zero.                  *
+ *  Outputs:                                                                  *
+ *      u (struct sbh_vec4):                                                  *
+ *          The unit vector (p / |p|, 0).                                     *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_vec4_spatial_normalize(const struct sbh_vec4 *p)
+{
+    /*  Compute the reciprocal of the norm once and scale by it.              */
+    const double rcpr_norm = 1.0 / sqrt(sbh_vec4_spatial_dot(p, p));
+    return sbh_vec4_rect(
+        p->dat[0] * rcpr_norm, p->dat[1] * rcpr_norm, p->dat[2] * rcpr_norm, 0.0
+    );
+}
+/*  End of sbh_vec4_spatial_normalize.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_linear_combination                                           *
+ *  Purpose:                                                                  *
+ *      Computes a p + b q + c s for three vectors, all four components.      *
+ *      Used for changing between orthonormal bases.                          *
+ *  Arguments:                                                                *
+ *      a (double):                                                           *
+ *          The coefficient for p.                                            *
+ *      p (const struct sbh_vec4 *):                                          *
+ *          The first vector.                                                 *
+ *      b (double):                                                           *
+ *          The coefficient for q.                                            *
+ *      q (const struct sbh_vec4 *):                                          *
+ *          The second vector.                                                *
+ *      c (double):                                                           *
+ *          The coefficient for s.                                            *
+ *      s (const struct sbh_vec4 *):                                          *
+ *          The third vector.                                                 *
+ *  Outputs:                                                                  *
+ *      w (struct sbh_vec4):                                                  *
+ *          The vector a p + b q + c s.                                       *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4
+sbh_vec4_linear_combination(double a, const struct sbh_vec4 *p,
+                            double b, const struct sbh_vec4 *q,
+                            double c, const struct sbh_vec4 *s)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_vec4 w;
+    int n;
+
+    /*  Combine component by component and return.                            */
+    for (n = 0; n < 4; ++n)
+        w.dat[n] = a * p->dat[n] + b * q->dat[n] + c * s->dat[n];
+
+    return w;
+}
+/*  End of sbh_vec4_linear_combination.                                       */
+
 #endif
 /*  End of include guard.                                                     */
@@ -0,0 +1,433 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides structure-of-arrays routines for 4D vectors. These convert   *
+ *      many points at once and are laid out so the compiler can vectorize.   *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_VEC4_ARRAY_H
+#define SBH_VEC4_ARRAY_H
+
+#include "sbh_inline.h"
+#include "sbh_restrict.h"
+#include "sbh_vec4.h"
+#include "sbh_sincos.h"
+#include "sbh_atan2.h"
+#include <stddef.h>
+
+/*  The batch routines compute sine and cosine, or atan2, in blocks of this   *
+ *  many points, using stack buffers. 256 points is 8 kB of scratch, which    *
+ *  stays in L1.                                                              */
+#define SBH_VEC4_ARRAY_BLOCK_SIZE (256)
+
+/*  Struct for working with many four-dimensional points at once.             */
+struct sbh_vec4_array {
+
+    /*  This mirrors the dat array of struct sbh_vec4, but in                 *
+     *  structure-of-arrays form. dat[k][n] is the kth component of the nth   *
+     *  point. Keeping each component contiguous lets the compiler load       *
+     *  several points into a single vector register, which the array-of-     *
+     *  structs layout of struct sbh_vec4 does not allow.                     */
+    double *dat[4];
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_array_create                                                 *
+ *  Purpose:                                                                  *
+ *      Creates a structure-of-arrays from four user-provided buffers.        *
+ *  Arguments:                                                                *
+ *      a0 (double *):                                                        *
+ *          The buffer for the zeroth component of the points.                *
+ *      a1 (double *):                                                        *
+ *          The buffer for the first component of the points.                 *
+ *      a2 (double *):                                                        *
+ *          The buffer for the second component of the points.                *
+ *      a3 (double *):                                                        *
+ *          The buffer for the time component of the points.                  *
+ *  Outputs:                                                                  *
+ *      arr (struct sbh_vec4_array):                                          *
+ *          The array with dat = {a0, a1, a2, a3}.                            *
+ *  Notes:                                                                    *
+ *      The buffers are not copied, the struct simply points to them. The     *
+ *      caller owns the memory and is responsible for freeing it.             *
+ ******************************************************************************/
+SBH_INLINE struct sbh_vec4_array
+sbh_vec4_array_create(double *a0, double *a1, double *a2, double *a3)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_vec4_array arr;
+
+    /*  Set the pointers and return.                                          */
+    arr.dat[0] = a0;
+    arr.dat[1] = a1;
+    arr.dat[2] = a2;
+    arr.dat[3] = a3;
+    return arr;
+}
+/*  End of sbh_vec4_array_create.                                             */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_array_rect_from_schwarzschild                                *
+ *  Purpose:                                                                  *
+ *      Given an array of points in Schwarzschild coordinates, computes the   *
+ *      corresponding Cartesian coordinates, storing them in a second array.  *
+ *  Arguments:                                                                *
+ *      out (struct sbh_vec4_array *):                                        *
+ *          The output array, points are stored as (x, y, z, t).              *
+ *      in (const struct sbh_vec4_array *):                                   *
+ *          The input array, points are given as (r, phi, theta, t).          *
+ *      len (size_t):                                                         *
+ *          The number of points in the arrays.                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Apply the formulas in sbh_vec4_rect_from_schwarzschild one            *
+ *      component array at a time. The sines and cosines are computed in      *
+ *      blocks with sbh_sincos_array, which uses SIMD when available. The     *
+ *      time component is copied.                                             *
+ *  Notes:                                                                    *
+ *      The buffers for out must not overlap the buffers for in. To convert   *
+ *      an array in place use sbh_vec4_array_convert_schwarzschild_to_rect.   *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_vec4_array_rect_from_schwarzschild(struct sbh_vec4_array *out,
+                                       const struct sbh_vec4_array *in,
+                                       size_t len)
+{
+    /*  Declare necessary variables. The restrict-qualified pointers tell the *
+     *  compiler the buffers do not alias, allowing it to vectorize the loop. */
+    const double * SBH_RESTRICT r = in->dat[0];
+    const double * SBH_RESTRICT phi = in->dat[1];
+    const double * SBH_RESTRICT theta = in->dat[2];
+    const double * SBH_RESTRICT t_in = in->dat[3];
+    double * SBH_RESTRICT x = out->dat[0];
+    double * SBH_RESTRICT y = out->dat[1];
+    double * SBH_RESTRICT z = out->dat[2];
+    double * SBH_RESTRICT t_out = out->dat[3];
+    double sin_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double sin_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    size_t start, n;
+
+    /*  Loop through the points one block at a time.                          */
+    for (start = 0; start < len; start += SBH_VEC4_ARRAY_BLOCK_SIZE)
+    {
+        /*  The last block may be smaller than the others.                    */
+        const size_t remaining = len - start;
+        const size_t size = (remaining < SBH_VEC4_ARRAY_BLOCK_SIZE ?
+                             remaining : SBH_VEC4_ARRAY_BLOCK_SIZE);
+
+        /*  Compute the conversion factors for the entire block.              */
+        sbh_sincos_array(phi + start, sin_phi, cos_phi, size);
+        sbh_sincos_array(theta + start, sin_theta, cos_theta, size);
+
+        /*  Perform the spherical-to-rectangular conversion, the same as      *
+         *  sbh_vec4_rect_from_schwarzschild. This loop is only multiplies.   */
+        for (n = 0; n < size; ++n)
+        {
+            const double r_sin_theta = r[start + n] * sin_theta[n];
+            x[start + n] = r_sin_theta * cos_phi[n];
+            y[start + n] = r_sin_theta * sin_phi[n];
+            z[start + n] = r[start + n] * cos_theta[n];
+        }
+    }
+
+    /*  The time factor is the same in both coordinate systems. Copy it.      */
+    for (n = 0; n < len; ++n)
+        t_out[n] = t_in[n];
+}
+/*  End of sbh_vec4_array_rect_from_schwarzschild.                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_array_convert_schwarzschild_to_rect                          *
+ *  Purpose:                                                                  *
+ *      Converts an array of points from Schwarzschild coordinates to         *
+ *      Cartesian coordinates in place.                                       *
+ *  Arguments:                                                                *
+ *      p (struct sbh_vec4_array *):                                          *
+ *          The array of points, given as (r, phi, theta, t). On output the   *
+ *          points are stored as (x, y, z, t).                                *
+ *      len (size_t):                                                         *
+ *          The number of points in the array.                                *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Apply the formulas in sbh_vec4_convert_schwarzschild_to_rect one      *
+ *      component array at a time, computing sines and cosines in blocks.     *
+ *      The time component is left untouched.                                 *
+ *  Notes:                                                                    *
+ *      The four component buffers of p must be distinct.                     *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_vec4_array_convert_schwarzschild_to_rect(struct sbh_vec4_array *p,
+                                             size_t len)
+{
+    /*  Each buffer is read and written at the same index, which is fine,     *
+     *  but the three buffers may not alias each other.                       */
+    double * SBH_RESTRICT r_x = p->dat[0];
+    double * SBH_RESTRICT phi_y = p->dat[1];
+    double * SBH_RESTRICT theta_z = p->dat[2];
+    double sin_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_phi[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double sin_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double cos_theta[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    size_t start, n;
+
+    /*  Loop through the points one block at a time.                          */
+    for (start = 0; start < len; start += SBH_VEC4_ARRAY_BLOCK_SIZE)
+    {
+        /*  The last block may be smaller than the others.                    */
+        const size_t remaining = len - start;
+        const size_t size = (remaining < SBH_VEC4_ARRAY_BLOCK_SIZE ?
+                             remaining : SBH_VEC4_ARRAY_BLOCK_SIZE);
+
+        /*  The angles are read into the scratch buffers before any of the    *
+         *  inputs are overwritten, so converting in place is safe.           */
+        sbh_sincos_array(phi_y + start, sin_phi, cos_phi, size);
+        sbh_sincos_array(theta_z + start, sin_theta, cos_theta, size);
+
+        /*  Perform the conversion, the same as the single-point version.     */
+        for (n = 0; n < size; ++n)
+        {
+            const double r = r_x[start + n];
+            const double r_sin_theta = r * sin_theta[n];
+
+            r_x[start + n] = r_sin_theta * cos_phi[n];
+            phi_y[start + n] = r_sin_theta * sin_phi[n];
+            theta_z[start + n] = r * cos_theta[n];
+        }
+    }
+}
+/*  End of sbh_vec4_array_convert_schwarzschild_to_rect.                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_array_schwarzschild_from_rect                                *
+ *  Purpose:                                                                  *
+ *      Given an array of points in Cartesian coordinates, computes the       *
+ *      corresponding Schwarzschild coordinates, storing them in a second     *
+ *      array.                                                                *
+ *  Arguments:                                                                *
+ *      out (struct sbh_vec4_array *):                                        *
+ *          The output array, points are stored as (r, phi, theta, t).        *
+ *      in (const struct sbh_vec4_array *):                                   *
+ *          The input array, points are given as (x, y, z, t).                *
+ *      len (size_t):                                                         *
+ *          The number of points in the arrays.                               *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Apply the formulas in sbh_vec4_schwarzschild_from_rect one component  *
+ *      array at a time. r and rho = sqrt(x^2 + y^2) are written directly,    *
+ *      the square roots vectorize, and the angles are computed in blocks     *
+ *      with sbh_atan2_array, which uses SIMD when available. The time        *
+ *      component is copied.                                                  *
+ *  Notes:                                                                    *
+ *      The buffers for out must not overlap the buffers for in. To convert   *
+ *      an array in place use sbh_vec4_array_convert_rect_to_schwarzschild.   *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_vec4_array_schwarzschild_from_rect(struct sbh_vec4_array *out,
+                                       const struct sbh_vec4_array *in,
+                                       size_t len)
+{
+    /*  Declare necessary variables. The restrict-qualified pointers tell the *
+     *  compiler the buffers do not alias, allowing it to vectorize the loop. */
+    const double * SBH_RESTRICT x = in->dat[0];
+    const double * SBH_RESTRICT y = in->dat[1];
+    const double * SBH_RESTRICT z = in->dat[2];
+    const double * SBH_RESTRICT t_in = in->dat[3];
+    double * SBH_RESTRICT r = out->dat[0];
+    double * SBH_RESTRICT phi = out->dat[1];
+    double * SBH_RESTRICT theta = out->dat[2];
+    double * SBH_RESTRICT t_out = out->dat[3];
+    double rho[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    size_t start, n;
+
+    /*  Loop through the points one block at a time.                          */
+    for (start = 0; start < len; start += SBH_VEC4_ARRAY_BLOCK_SIZE)
+    {
+        /*  The last block may be smaller than the others.                    */
+        const size_t remaining = len - start;
+        const size_t size = (remaining < SBH_VEC4_ARRAY_BLOCK_SIZE ?
+                             remaining : SBH_VEC4_ARRAY_BLOCK_SIZE);
+
+        /*  The radii. This loop is only multiplies, adds, and square roots.  */
+        for (n = 0; n < size; ++n)
+        {
+            const double rho_sq = x[start + n] * x[start + n] +
+                                  y[start + n] * y[start + n];
+
+            rho[n] = sqrt(rho_sq);
+            r[start + n] = sqrt(rho_sq + z[start + n] * z[start + n]);
+        }
+
+        /*  The azimuthal and polar angles for the entire block.              */
+        sbh_atan2_array(y + start, x + start, phi + start, size);
+        sbh_atan2_array(rho, z + start, theta + start, size);
+    }
+
+    /*  The time factor is the same in both coordinate systems. Copy it.      */
+    for (n = 0; n < len; ++n)
+        t_out[n] = t_in[n];
+}
+/*  End of sbh_vec4_array_schwarzschild_from_rect.                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_array_convert_rect_to_schwarzschild                          *
+ *  Purpose:                                                                  *
+ *      Converts an array of points from Cartesian coordinates to             *
+ *      Schwarzschild coordinates in place.                                   *
+ *  Arguments:                                                                *
+ *      p (struct sbh_vec4_array *):                                          *
+ *          The array of points, given as (x, y, z, t). On output the points  *
+ *          are stored as (r, phi, theta, t).                                 *
+ *      len (size_t):                                                         *
+ *          The number of points in the array.                                *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Method:                                                                   *
+ *      Apply the formulas in sbh_vec4_convert_rect_to_schwarzschild one      *
+ *      component array at a time, computing the angles in blocks. The time   *
+ *      component is left untouched.                                          *
+ *  Notes:                                                                    *
+ *      The four component buffers of p must be distinct.                     *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_vec4_array_convert_rect_to_schwarzschild(struct sbh_vec4_array *p,
+                                             size_t len)
+{
+    /*  Each buffer is read and written at the same index, which is fine,     *
+     *  but the three buffers may not alias each other.                       */
+    double * SBH_RESTRICT x_r = p->dat[0];
+    double * SBH_RESTRICT y_phi = p->dat[1];
+    double * SBH_RESTRICT z_theta = p->dat[2];
+    double rho[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    double r[SBH_VEC4_ARRAY_BLOCK_SIZE];
+    size_t start, n;
+
+    /*  Loop through the points one block at a time.                          */
+    for (start = 0; start < len; start += SBH_VEC4_ARRAY_BLOCK_SIZE)
+    {
+        /*  The last block may be smaller than the others.                    */
+        const size_t remaining = len - start;
+        const size_t size = (remaining < SBH_VEC4_ARRAY_BLOCK_SIZE ?
+                             remaining : SBH_VEC4_ARRAY_BLOCK_SIZE);
+
+        /*  x is needed for phi, so the radii go to scratch for now.          */
+        for (n = 0; n < size; ++n)
+        {
+            const double rho_sq = x_r[start + n] * x_r[start + n] +
+                                  y_phi[start + n] * y_phi[start + n];
+
+            rho[n] = sqrt(rho_sq);
+            r[n] = sqrt(rho_sq + z_theta[start + n] * z_theta[start + n]);
+        }
+
+        /*  sbh_atan2_array reads each lane before writing it, so the angles  *
+         *  may overwrite the y and z inputs they are computed from.          */
+        sbh_atan2_array(y_phi + start, x_r + start, y_phi + start, size);
+        sbh_atan2_array(rho, z_theta + start, z_theta + start, size);
+
+        for (n = 0; n < size; ++n)
+            x_r[start + n] = r[n];
+    }
+}
+/*  End of sbh_vec4_array_convert_rect_to_schwarzschild.                      */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_array_load                                                   *
+ *  Purpose:                                                                  *
+ *      Copies an array of struct sbh_vec4 into structure-of-arrays form.     *
+ *  Arguments:                                                                *
+ *      out (struct sbh_vec4_array *):                                        *
+ *          The output array.                                                 *
+ *      in (const struct sbh_vec4 *):                                         *
+ *          The input points.                                                 *
+ *      len (size_t):                                                         *
+ *          The number of points.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_vec4_array_load(struct sbh_vec4_array *out,
+                    const struct sbh_vec4 *in,
+                    size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t n;
+
+    /*  Transpose the array-of-structs into the structure-of-arrays.          */
+    for (n = 0; n < len; ++n)
+    {
+        out->dat[0][n] = in[n].dat[0];
+        out->dat[1][n] = in[n].dat[1];
+        out->dat[2][n] = in[n].dat[2];
+        out->dat[3][n] = in[n].dat[3];
+    }
+}
+/*  End of sbh_vec4_array_load.                                               */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_vec4_array_store                                                  *
+ *  Purpose:                                                                  *
+ *      Copies a structure-of-arrays into an array of struct sbh_vec4.        *
+ *  Arguments:                                                                *
+ *      out (struct sbh_vec4 *):                                              *
+ *          The output points.                                                *
+ *      in (const struct sbh_vec4_array *):                                   *
+ *          The input array.                                                  *
+ *      len (size_t):                                                         *
+ *          The number of points.                                             *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_vec4_array_store(struct sbh_vec4 *out,
+                     const struct sbh_vec4_array *in,
+                     size_t len)
+{
+    /*  Declare necessary variables.                                          */
+    size_t n;
+
+    /*  Transpose the structure-of-arrays back into array-of-structs form.    */
+    for (n = 0; n < len; ++n)
+    {
+        out[n].dat[0] = in->dat[0][n];
+        out[n].dat[1] = in->dat[1][n];
+        out[n].dat[2] = in->dat[2][n];
+        out[n].dat[3] = in->dat[3][n];
+    }
+}
+/*  End of sbh_vec4_array_store.                                              */
+
+#endif
+/*  End of include guard.                                                     */
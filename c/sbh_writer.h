@@ -0,0 +1,598 @@
+/******************************************************************************
+ *                                  LICENSE                                   *
+ ******************************************************************************
+ *  This file is part of schwarzschild_black_holes.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is free software: you can redistribute it       *
+ *  and/or modify it under the terms of the GNU General Public License as     *
+ *  published by the Free Software Foundation, either version 3 of the        *
+ *  License, or (at your option) any later version.                           *
+ *                                                                            *
+ *  schwarzschild_black_holes is distributed in the hope that it will be      *
+ *  useful but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+ *  GNU General Public License for more details.                              *
+ *                                                                            *
+ *  You should have received a copy of the GNU General Public License         *
+ *  along with schwarzschild_black_holes.  If not, see                        *
+ *  <https://www.gnu.org/licenses/>.                                          *
+ ******************************************************************************
+ *  Purpose:                                                                  *
+ *      Provides a writer thread that streams rendered tiles to disk or to a  *
+ *      pipe as binary PPM images, so output overlaps with rendering.         *
+ ******************************************************************************
+ *  Method:                                                                   *
+ *      Render threads submit each finished tile. The tile is rounded to      *
+ *      8-bit RGB by the submitting thread and copied into a slot of a        *
+ *      bounded ring buffer. If every slot is taken, the submitter waits,     *
+ *      which bounds memory when the disk is slower than the renderer.        *
+ *                                                                            *
+ *      The writer thread takes slots in order and copies them into an image  *
+ *      buffer. As soon as every tile of a row of tiles has arrived, and all  *
+ *      rows above have been written, the rows are written out. By the time   *
+ *      the last tile of a frame arrives most of the frame is already on      *
+ *      disk, and the writes of one frame run while the next is rendered.     *
+ *                                                                            *
+ *      Frames are told apart by counting tiles, so every tile of a frame     *
+ *      must be submitted before any tile of the next, which is the case for  *
+ *      consecutive calls to sbh_render_frame.                                *
+ ******************************************************************************
+ *  Notes:                                                                    *
+ *      Only PPM is written. PNG and EXR need zlib and OpenEXR, which this    *
+ *      project does not depend on. Pipe the PPM stream into a converter,     *
+ *      for example  ffmpeg -f image2pipe -c:v ppm -i - out.mp4  for          *
+ *      animations. Without threads, see sbh_render.h, tiles are written      *
+ *      synchronously by sbh_writer_submit.                                   *
+ ******************************************************************************
+ *  Author: Ryan Maguire                                                      *
+ *  Date:   2026/10/14                                                        *
+ ******************************************************************************/
+
+/*  Include guard to prevent including this file twice.                       */
+#ifndef SBH_WRITER_H
+#define SBH_WRITER_H
+
+#include "sbh_inline.h"
+#include "sbh_render.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*  A queued tile. pixels holds width * height RGB triples, row-major.        */
+struct sbh_writer_slot {
+    struct sbh_render_tile tile;
+    unsigned char *pixels;
+
+    /*  Set once the submitter has finished filling the slot.                 */
+    int ready;
+};
+
+/*  The writer. Create with sbh_writer_init and finish with sbh_writer_close. */
+struct sbh_writer {
+
+    /*  The frame geometry, the same as given to sbh_render_frame.            */
+    struct sbh_render_params render;
+    size_t columns, rows;
+
+    /*  Output goes to stream if it is not NULL. Otherwise each frame is      *
+     *  written to its own file, named by path_format and the frame number.   */
+    FILE *stream;
+    char *path_format;
+    char *path;
+    FILE *file;
+    unsigned long int frame;
+
+    /*  The frame being assembled, 3 bytes per pixel, and the number of tiles *
+     *  received for each row of tiles.                                       */
+    unsigned char *image;
+    size_t *row_tiles;
+    size_t next_row, tiles_received;
+
+    /*  The ring buffer. head is the oldest slot, reserved counts the slots   *
+     *  handed to submitters and not yet consumed by the writer thread.       */
+    struct sbh_writer_slot *slots;
+    unsigned char *slot_pixels;
+    size_t capacity, head, reserved;
+
+    /*  error is set by the writer thread if a write fails, and copied to     *
+     *  failed, which is guarded by the lock, for the submitters to see.      *
+     *  closing is set by sbh_writer_close.                                   */
+    int error, failed, closing;
+
+#if SBH_RENDER_HAS_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+    pthread_t thread;
+#endif
+};
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_to_byte                                                    *
+ *  Purpose:                                                                  *
+ *      Converts a color channel to 8 bits.                                   *
+ *  Arguments:                                                                *
+ *      value (float):                                                        *
+ *          The channel, nominally in [0, 1].                                 *
+ *  Outputs:                                                                  *
+ *      byte (unsigned char):                                                 *
+ *          The value clamped to [0, 1], scaled to [0, 255] and rounded. NaN  *
+ *          becomes 0.                                                        *
+ ******************************************************************************/
+SBH_INLINE unsigned char sbh_writer_to_byte(float value)
+{
+    if (!(value > 0.0F))
+        return 0;
+
+    if (value >= 1.0F)
+        return 255;
+
+    return (unsigned char)(255.0F * value + 0.5F);
+}
+/*  End of sbh_writer_to_byte.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_begin_frame                                                *
+ *  Purpose:                                                                  *
+ *      Opens the output for a new frame and writes the PPM header.           *
+ *  Arguments:                                                                *
+ *      writer (struct sbh_writer *):                                         *
+ *          The writer.                                                       *
+ *  Outputs:                                                                  *
+ *      None (void). Failures set writer->error.                              *
+ ******************************************************************************/
+SBH_INLINE void sbh_writer_begin_frame(struct sbh_writer *writer)
+{
+    writer->file = writer->stream;
+
+    if (!writer->file)
+    {
+        sprintf(writer->path, writer->path_format, writer->frame);
+        writer->file = fopen(writer->path, "wb");
+    }
+
+    if (!writer->file)
+    {
+        writer->error = 1;
+        return;
+    }
+
+    if (fprintf(writer->file, "P6\n%lu %lu\n255\n",
+                (unsigned long int)writer->render.width,
+                (unsigned long int)writer->render.height) < 0)
+        writer->error = 1;
+}
+/*  End of sbh_writer_begin_frame.                                            */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_end_frame                                                  *
+ *  Purpose:                                                                  *
+ *      Closes or flushes the output once a frame is complete.                *
+ *  Arguments:                                                                *
+ *      writer (struct sbh_writer *):                                         *
+ *          The writer.                                                       *
+ *  Outputs:                                                                  *
+ *      None (void). Failures set writer->error.                              *
+ ******************************************************************************/
+SBH_INLINE void sbh_writer_end_frame(struct sbh_writer *writer)
+{
+    size_t n;
+
+    if (writer->file)
+    {
+        if (writer->file == writer->stream)
+        {
+            if (fflush(writer->file) != 0)
+                writer->error = 1;
+        }
+        else if (fclose(writer->file) != 0)
+            writer->error = 1;
+    }
+
+    writer->file = NULL;
+    writer->next_row = 0;
+    writer->tiles_received = 0;
+    ++writer->frame;
+
+    for (n = 0; n < writer->rows; ++n)
+        writer->row_tiles[n] = 0;
+}
+/*  End of sbh_writer_end_frame.                                              */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_consume                                                    *
+ *  Purpose:                                                                  *
+ *      Adds a tile to the frame and writes every row that is complete.       *
+ *  Arguments:                                                                *
+ *      writer (struct sbh_writer *):                                         *
+ *          The writer.                                                       *
+ *      slot (const struct sbh_writer_slot *):                                *
+ *          The tile.                                                         *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ *  Notes:                                                                    *
+ *      Only the writer thread calls this, it needs no locking.               *
+ ******************************************************************************/
+SBH_INLINE void
+sbh_writer_consume(struct sbh_writer *writer,
+                   const struct sbh_writer_slot *slot)
+{
+    /*  Declare necessary variables.                                          */
+    const struct sbh_render_tile *tile = &slot->tile;
+    const size_t line = 3 * writer->render.width;
+    size_t j;
+
+    /*  The first tile of a frame opens the frame.                            */
+    if (writer->tiles_received == 0)
+        sbh_writer_begin_frame(writer);
+
+    /*  Copy the tile into the frame, one line of the tile at a time.         */
+    for (j = 0; j < tile->height; ++j)
+        memcpy(writer->image + (tile->y + j) * line + 3 * tile->x,
+               slot->pixels + 3 * j * tile->width, 3 * tile->width);
+
+    ++writer->row_tiles[tile->y / writer->render.tile_height];
+    ++writer->tiles_received;
+
+    /*  Stream out the complete rows of tiles, in order.                      */
+    while (writer->next_row < writer->rows &&
+           writer->row_tiles[writer->next_row] == writer->columns)
+    {
+        const size_t y = writer->next_row * writer->render.tile_height;
+        size_t height = writer->render.height - y;
+
+        if (height > writer->render.tile_height)
+            height = writer->render.tile_height;
+
+        if (!writer->error && writer->file)
+            if (fwrite(writer->image + y * line, 1, height * line,
+                       writer->file) != height * line)
+                writer->error = 1;
+
+        ++writer->next_row;
+    }
+
+    if (writer->tiles_received == writer->columns * writer->rows)
+        sbh_writer_end_frame(writer);
+}
+/*  End of sbh_writer_consume.                                                */
+
+#if SBH_RENDER_HAS_THREADS
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_main                                                       *
+ *  Purpose:                                                                  *
+ *      The main loop of the writer thread.                                   *
+ *  Arguments:                                                                *
+ *      arg (void *):                                                         *
+ *          A pointer to the struct sbh_writer.                               *
+ *  Outputs:                                                                  *
+ *      NULL (void *).                                                        *
+ *  Method:                                                                   *
+ *      Wait for the oldest slot to be ready, consume it without holding the  *
+ *      lock, and only then release it to the submitters. Exit once closing   *
+ *      is set and every reserved slot has been consumed.                     *
+ ******************************************************************************/
+SBH_INLINE void *sbh_writer_main(void *arg)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_writer *const writer = (struct sbh_writer *)arg;
+
+    pthread_mutex_lock(&writer->lock);
+
+    for (;;)
+    {
+        struct sbh_writer_slot *slot;
+
+        while (!(writer->reserved > 0 && writer->slots[writer->head].ready))
+        {
+            if (writer->closing && writer->reserved == 0)
+            {
+                pthread_mutex_unlock(&writer->lock);
+                return NULL;
+            }
+
+            pthread_cond_wait(&writer->not_empty, &writer->lock);
+        }
+
+        /*  Submitters only fill slots past the reserved range, so this slot  *
+         *  can be read without the lock.                                     */
+        slot = writer->slots + writer->head;
+        pthread_mutex_unlock(&writer->lock);
+        sbh_writer_consume(writer, slot);
+        pthread_mutex_lock(&writer->lock);
+
+        writer->failed = writer->error;
+        slot->ready = 0;
+        writer->head = (writer->head + 1) % writer->capacity;
+        --writer->reserved;
+        pthread_cond_signal(&writer->not_full);
+    }
+}
+/*  End of sbh_writer_main.                                                   */
+
+#endif
+/*  End of #if SBH_RENDER_HAS_THREADS.                                        */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_destroy                                                    *
+ *  Purpose:                                                                  *
+ *      Frees the memory of a writer. Used by init and close.                 *
+ *  Arguments:                                                                *
+ *      writer (struct sbh_writer *):                                         *
+ *          The writer.                                                       *
+ *  Outputs:                                                                  *
+ *      None (void).                                                          *
+ ******************************************************************************/
+SBH_INLINE void sbh_writer_destroy(struct sbh_writer *writer)
+{
+    free(writer->path_format);
+    free(writer->path);
+    free(writer->image);
+    free(writer->row_tiles);
+    free(writer->slots);
+    free(writer->slot_pixels);
+    writer->path_format = NULL;
+    writer->path = NULL;
+    writer->image = NULL;
+    writer->row_tiles = NULL;
+    writer->slots = NULL;
+    writer->slot_pixels = NULL;
+}
+/*  End of sbh_writer_destroy.                                                */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_init                                                       *
+ *  Purpose:                                                                  *
+ *      Creates a writer and starts its thread.                               *
+ *  Arguments:                                                                *
+ *      writer (struct sbh_writer *):                                         *
+ *          The writer to initialize.                                         *
+ *      render (const struct sbh_render_params *):                            *
+ *          The frame geometry. Only the image and tile sizes are used.       *
+ *      capacity (size_t):                                                    *
+ *          The number of tiles that may be queued. Zero means one row of     *
+ *          tiles per render thread, enough that the renderer rarely waits.   *
+ *      stream (FILE *):                                                      *
+ *          If not NULL, every frame is written to this stream, one PPM       *
+ *          after the other. The stream is not closed by the writer.          *
+ *      path_format (const char *):                                           *
+ *          Used if stream is NULL. A printf format with one %lu, for the     *
+ *          frame number starting at 0, for example "frame_%05lu.ppm". The    *
+ *          field width must not be more than 20.                             *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 on success, 0 if memory could not be allocated or the thread    *
+ *          could not be started.                                             *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_writer_init(struct sbh_writer *writer,
+                const struct sbh_render_params *render,
+                size_t capacity,
+                FILE *stream,
+                const char *path_format)
+{
+    /*  Declare necessary variables.                                          */
+    const size_t tile_size = 3 * render->tile_width * render->tile_height;
+    size_t n;
+
+    memset(writer, 0, sizeof(*writer));
+
+    if (render->tile_width == 0 || render->tile_height == 0)
+        return 0;
+
+    if (!stream && !path_format)
+        return 0;
+
+    writer->render = *render;
+    writer->stream = stream;
+    writer->columns = (render->width + render->tile_width - 1) /
+                      render->tile_width;
+    writer->rows = (render->height + render->tile_height - 1) /
+                   render->tile_height;
+
+    if (capacity == 0)
+    {
+        const unsigned int threads = (render->threads == 0U ?
+                                      sbh_render_hardware_threads() :
+                                      render->threads);
+
+        capacity = writer->columns * (size_t)threads;
+    }
+
+    writer->capacity = capacity;
+
+    /*  The path buffer has room for the format plus the digits of a number.  */
+    if (path_format)
+    {
+        const size_t length = strlen(path_format) + 1;
+
+        writer->path_format = (char *)malloc(length);
+        writer->path = (char *)malloc(length + 32);
+
+        if (writer->path_format)
+            memcpy(writer->path_format, path_format, length);
+    }
+
+    writer->image = (unsigned char *)
+        malloc(3 * render->width * render->height + 1);
+    writer->row_tiles = (size_t *)malloc(sizeof(*writer->row_tiles) *
+                                         (writer->rows + 1));
+    writer->slots = (struct sbh_writer_slot *)
+        malloc(sizeof(*writer->slots) * capacity);
+    writer->slot_pixels = (unsigned char *)malloc(tile_size * capacity);
+
+    if ((path_format && (!writer->path_format || !writer->path)) ||
+        !writer->image || !writer->row_tiles ||
+        !writer->slots || !writer->slot_pixels)
+    {
+        sbh_writer_destroy(writer);
+        return 0;
+    }
+
+    for (n = 0; n < writer->rows; ++n)
+        writer->row_tiles[n] = 0;
+
+    for (n = 0; n < capacity; ++n)
+    {
+        writer->slots[n].pixels = writer->slot_pixels + n * tile_size;
+        writer->slots[n].ready = 0;
+    }
+
+#if SBH_RENDER_HAS_THREADS
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->not_empty, NULL);
+    pthread_cond_init(&writer->not_full, NULL);
+
+    if (pthread_create(&writer->thread, NULL, sbh_writer_main, writer) != 0)
+    {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->not_empty);
+        pthread_cond_destroy(&writer->not_full);
+        sbh_writer_destroy(writer);
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+/*  End of sbh_writer_init.                                                   */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_submit                                                     *
+ *  Purpose:                                                                  *
+ *      Queues a finished tile for writing.                                   *
+ *  Arguments:                                                                *
+ *      writer (struct sbh_writer *):                                         *
+ *          The writer.                                                       *
+ *      tile (const struct sbh_render_tile *):                                *
+ *          The tile, as given to the render callback.                        *
+ *      rgb (const float *):                                                  *
+ *          The colors of the tile. Pixel (i, j) of the tile has its red,     *
+ *          green, and blue values at rgb[3 (j stride + i) + 0, 1, 2].        *
+ *          Values are clamped to [0, 1], apply any tone mapping first.       *
+ *      stride (size_t):                                                      *
+ *          The number of pixels between rows of rgb. Use tile->width for a   *
+ *          tile sized buffer, or the image width for a pointer into a full   *
+ *          frame buffer.                                                     *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          0 if an earlier write has failed, and 1 otherwise.                *
+ *  Notes:                                                                    *
+ *      Safe to call from several render threads at once. Blocks while the    *
+ *      queue is full.                                                        *
+ ******************************************************************************/
+SBH_INLINE int
+sbh_writer_submit(struct sbh_writer *writer,
+                  const struct sbh_render_tile *tile,
+                  const float *rgb,
+                  size_t stride)
+{
+    /*  Declare necessary variables.                                          */
+    struct sbh_writer_slot *slot;
+    size_t i, j;
+
+#if SBH_RENDER_HAS_THREADS
+    /*  Reserve the next free slot.                                           */
+    pthread_mutex_lock(&writer->lock);
+
+    while (writer->reserved == writer->capacity && !writer->failed)
+        pthread_cond_wait(&writer->not_full, &writer->lock);
+
+    if (writer->failed)
+    {
+        pthread_mutex_unlock(&writer->lock);
+        return 0;
+    }
+
+    slot = writer->slots + (writer->head + writer->reserved) % writer->capacity;
+    ++writer->reserved;
+    pthread_mutex_unlock(&writer->lock);
+#else
+    if (writer->error)
+        return 0;
+
+    slot = writer->slots;
+#endif
+
+    /*  Convert the tile to bytes outside of the lock, in parallel with the   *
+     *  other render threads.                                                 */
+    slot->tile = *tile;
+
+    for (j = 0; j < tile->height; ++j)
+    {
+        const float *src = rgb + 3 * j * stride;
+        unsigned char *dst = slot->pixels + 3 * j * tile->width;
+
+        for (i = 0; i < 3 * tile->width; ++i)
+            dst[i] = sbh_writer_to_byte(src[i]);
+    }
+
+#if SBH_RENDER_HAS_THREADS
+    pthread_mutex_lock(&writer->lock);
+    slot->ready = 1;
+    pthread_cond_signal(&writer->not_empty);
+    pthread_mutex_unlock(&writer->lock);
+#else
+    sbh_writer_consume(writer, slot);
+#endif
+
+    return 1;
+}
+/*  End of sbh_writer_submit.                                                 */
+
+/******************************************************************************
+ *  Function:                                                                 *
+ *      sbh_writer_close                                                      *
+ *  Purpose:                                                                  *
+ *      Writes every queued tile, stops the thread, and frees the writer.     *
+ *  Arguments:                                                                *
+ *      writer (struct sbh_writer *):                                         *
+ *          The writer.                                                       *
+ *  Outputs:                                                                  *
+ *      success (int):                                                        *
+ *          1 if every write succeeded, and 0 otherwise.                      *
+ *  Notes:                                                                    *
+ *      Call once every submitter is done. A frame that was not completed is  *
+ *      left truncated after its last complete row of tiles.                  *
+ ******************************************************************************/
+SBH_INLINE int sbh_writer_close(struct sbh_writer *writer)
+{
+    /*  Declare necessary variables.                                          */
+    int success;
+
+#if SBH_RENDER_HAS_THREADS
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = 1;
+    pthread_cond_signal(&writer->not_empty);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->not_empty);
+    pthread_cond_destroy(&writer->not_full);
+#else
+    writer->closing = 1;
+#endif
+
+    /*  Close the file of a partial frame.                                    */
+    if (writer->file && writer->file != writer->stream)
+        if (fclose(writer->file) != 0)
+            writer->error = 1;
+
+    writer->file = NULL;
+    success = !writer->error;
+    sbh_writer_destroy(writer);
+    return success;
+}
+/*  End of sbh_writer_close.                                                  */
+
+#endif
+/*  End of include guard.                                                     */